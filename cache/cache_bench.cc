@@ -14,6 +14,9 @@ int main() {
 #include <stdio.h>
 #include <sys/types.h>
 #include <cinttypes>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 #include <limits>
 
 #include "port/port.h"
@@ -25,6 +28,7 @@ int main() {
 #include "util/hash.h"
 #include "util/mutexlock.h"
 #include "util/random.h"
+#include "util/string_util.h"
 
 using GFLAGS_NAMESPACE::ParseCommandLineFlags;
 
@@ -56,7 +60,32 @@ DEFINE_uint32(lookup_percent, 10,
 DEFINE_uint32(erase_percent, 1,
               "Ratio of erase to total workload (expressed as a percentage)");
 
-DEFINE_bool(use_clock_cache, false, "");
+DEFINE_bool(use_clock_cache, false, "Same as --cache_type=clock_cache");
+DEFINE_string(cache_type, "lru_cache", "Type of cache: lru_cache or clock_cache");
+DEFINE_string(thread_scaling, "",
+              "If non-empty, a comma separated list of thread counts, e.g. "
+              "\"1,2,4,8,16\". The benchmark is run once per thread count for "
+              "both lru_cache and clock_cache, and a throughput table is "
+              "printed. Overrides --threads and --cache_type.");
+DEFINE_bool(tiny_lfu_admission, false,
+            "Enable TinyLFU admission in lru_cache, see "
+            "LRUCacheOptions::tiny_lfu_admission.");
+DEFINE_double(zipf_alpha, 0.0,
+              "If > 0, keys of the point operations follow a Zipf "
+              "distribution with this exponent instead of --skew.");
+DEFINE_uint32(scan_percent, 0,
+              "Percentage of operations, on top of the other percentages, "
+              "that are steps of a sequential scan. A scan looks up keys "
+              "that are never read again and inserts them on a miss, like "
+              "an iterator filling the block cache.");
+DEFINE_bool(compare_admission, false,
+            "Run the workload against lru_cache with and without TinyLFU "
+            "admission and print the hit rate of the point lookups of "
+            "both. Overrides --cache_type and --tiny_lfu_admission.");
+DEFINE_bool(numa_aware, false,
+            "Split the shards of lru_cache among the NUMA nodes, see "
+            "LRUCacheOptions::numa_aware, and report the lookups that hit "
+            "on the node of the caller and on another node.");
 
 namespace ROCKSDB_NAMESPACE {
 
@@ -94,9 +123,11 @@ class SharedState {
     num_done_++;
   }
 
-  bool AllInitialized() const { return num_initialized_ >= FLAGS_threads; }
+  bool AllInitialized() const { return num_initialized_ >= num_threads_; }
 
-  bool AllDone() const { return num_done_ >= FLAGS_threads; }
+  bool AllDone() const { return num_done_ >= num_threads_; }
+
+  void SetNumThreads(uint32_t num_threads) { num_threads_ = num_threads; }
 
   void SetStart() {
     start_ = true;
@@ -113,6 +144,14 @@ class SharedState {
   uint64_t num_initialized_;
   bool start_;
   uint64_t num_done_;
+  uint32_t num_threads_ = FLAGS_threads;
+
+ public:
+  // Point lookups and how many of them hit, summed over all threads.
+  uint64_t lookups = 0;
+  uint64_t hits = 0;
+
+ private:
 
   CacheBench* cache_bench_;
 };
@@ -123,20 +162,48 @@ struct ThreadState {
   Random64 rnd;
   SharedState* shared;
 
+  // Next key of the scan of this thread. Scans use keys from max_key up,
+  // disjoint per thread, so that none of them is looked up twice.
+  uint64_t scan_key;
+
   ThreadState(uint32_t index, SharedState* _shared)
-      : tid(index), rnd(1000 + index), shared(_shared) {}
+      : tid(index),
+        rnd(1000 + index),
+        shared(_shared),
+        scan_key(uint64_t{index} << 40) {}
 };
 
 struct KeyGen {
   char key_data[27];
 
+  // Cumulative probabilities of a Zipf distribution over the key ranks, or
+  // empty if --zipf_alpha is not set.
+  const std::vector<double>* zipf_cdf = nullptr;
+
   Slice GetRand(Random64& rnd, uint64_t max_key) {
-    uint64_t raw = rnd.Next();
-    // Skew according to setting
-    for (uint32_t i = 0; i < FLAGS_skew; ++i) {
-      raw = std::min(raw, rnd.Next());
+    uint64_t key;
+    if (zipf_cdf != nullptr && !zipf_cdf->empty()) {
+      double u = static_cast<double>(rnd.Next() >> 11) * (1.0 / (1ULL << 53));
+      uint64_t rank = static_cast<uint64_t>(
+          std::lower_bound(zipf_cdf->begin(), zipf_cdf->end(), u) -
+          zipf_cdf->begin());
+      // Map the ranks to keys spread over the key space, so that the hot
+      // keys do not end up in the same shard.
+      key = FastRange64(NPHash64(reinterpret_cast<const char*>(&rank),
+                                 sizeof(rank)),
+                        max_key);
+    } else {
+      uint64_t raw = rnd.Next();
+      // Skew according to setting
+      for (uint32_t i = 0; i < FLAGS_skew; ++i) {
+        raw = std::min(raw, rnd.Next());
+      }
+      key = FastRange64(raw, max_key);
     }
-    uint64_t key = FastRange64(raw, max_key);
+    return Get(key);
+  }
+
+  Slice Get(uint64_t key) {
     // Variable size and alignment
     size_t off = key % 8;
     key_data[0] = char{42};
@@ -168,7 +235,8 @@ class CacheBench {
       std::numeric_limits<uint64_t>::max() / 100U;
 
  public:
-  CacheBench()
+  explicit CacheBench(const std::string& cache_type,
+                      bool tiny_lfu_admission = FLAGS_tiny_lfu_admission)
       : max_key_(static_cast<uint64_t>(FLAGS_cache_size / FLAGS_resident_ratio /
                                        FLAGS_value_bytes)),
         lookup_insert_threshold_(kHundredthUint64 *
@@ -178,19 +246,45 @@ class CacheBench {
         lookup_threshold_(insert_threshold_ +
                           kHundredthUint64 * FLAGS_lookup_percent),
         erase_threshold_(lookup_threshold_ +
-                         kHundredthUint64 * FLAGS_erase_percent) {
+                         kHundredthUint64 * FLAGS_erase_percent),
+        scan_threshold_(FLAGS_scan_percent >= 100
+                            ? std::numeric_limits<uint64_t>::max()
+                            : kHundredthUint64 * FLAGS_scan_percent) {
     if (erase_threshold_ != 100U * kHundredthUint64) {
       fprintf(stderr, "Percentages must add to 100.\n");
       exit(1);
     }
-    if (FLAGS_use_clock_cache) {
-      cache_ = NewClockCache(FLAGS_cache_size, FLAGS_num_shard_bits);
+    if (FLAGS_zipf_alpha > 0) {
+      // Precompute the CDF, so that drawing a key is a binary search.
+      zipf_cdf_.resize(max_key_);
+      double sum = 0;
+      for (uint64_t i = 0; i < max_key_; i++) {
+        sum += 1.0 / std::pow(static_cast<double>(i + 1), FLAGS_zipf_alpha);
+        zipf_cdf_[i] = sum;
+      }
+      for (uint64_t i = 0; i < max_key_; i++) {
+        zipf_cdf_[i] /= sum;
+      }
+    }
+    if (cache_type == "clock_cache") {
+      cache_ = NewClockCache(FLAGS_cache_size, FLAGS_num_shard_bits,
+                             false /* strict_capacity_limit */,
+                             kDefaultCacheMetadataChargePolicy,
+                             FLAGS_value_bytes);
       if (!cache_) {
         fprintf(stderr, "Clock cache not supported.\n");
         exit(1);
       }
+    } else if (cache_type == "lru_cache") {
+      LRUCacheOptions opts(FLAGS_cache_size, FLAGS_num_shard_bits,
+                           false /* strict_capacity_limit */,
+                           0.0 /* high_pri_pool_ratio */);
+      opts.tiny_lfu_admission = tiny_lfu_admission;
+      opts.numa_aware = FLAGS_numa_aware;
+      cache_ = NewLRUCache(opts);
     } else {
-      cache_ = NewLRUCache(FLAGS_cache_size, FLAGS_num_shard_bits);
+      fprintf(stderr, "Cache type not supported: %s\n", cache_type.c_str());
+      exit(1);
     }
     if (FLAGS_ops_per_thread == 0) {
       FLAGS_ops_per_thread = 5 * max_key_;
@@ -202,19 +296,25 @@ class CacheBench {
   void PopulateCache() {
     Random64 rnd(1);
     KeyGen keygen;
+    keygen.zipf_cdf = &zipf_cdf_;
     for (uint64_t i = 0; i < 2 * FLAGS_cache_size; i += FLAGS_value_bytes) {
       cache_->Insert(keygen.GetRand(rnd, max_key_), createValue(rnd),
                      FLAGS_value_bytes, &deleter);
     }
   }
 
-  bool Run() {
+  // Run the benchmark with the given number of threads. If qps is not
+  // nullptr, the measured throughput is stored in it, and if hit_rate is not
+  // nullptr, the hit rate of the point lookups.
+  bool Run(uint32_t num_threads, uint32_t* qps_out = nullptr,
+           double* hit_rate_out = nullptr) {
     ROCKSDB_NAMESPACE::Env* env = ROCKSDB_NAMESPACE::Env::Default();
 
-    PrintEnv();
+    PrintEnv(num_threads);
     SharedState shared(this);
-    std::vector<std::unique_ptr<ThreadState> > threads(FLAGS_threads);
-    for (uint32_t i = 0; i < FLAGS_threads; i++) {
+    shared.SetNumThreads(num_threads);
+    std::vector<std::unique_ptr<ThreadState> > threads(num_threads);
+    for (uint32_t i = 0; i < num_threads; i++) {
       threads[i].reset(new ThreadState(i, &shared));
       env->StartThread(ThreadBody, threads[i].get());
     }
@@ -239,8 +339,28 @@ class CacheBench {
       uint64_t end_time = env->NowMicros();
       double elapsed = static_cast<double>(end_time - start_time) * 1e-6;
       uint32_t qps = static_cast<uint32_t>(
-          static_cast<double>(FLAGS_threads * FLAGS_ops_per_thread) / elapsed);
-      fprintf(stdout, "Complete in %.3f s; QPS = %u\n", elapsed, qps);
+          static_cast<double>(num_threads * FLAGS_ops_per_thread) / elapsed);
+      double hit_rate = shared.lookups == 0 ? 0.0
+                                            : 100.0 * shared.hits /
+                                                  shared.lookups;
+      fprintf(stdout, "Complete in %.3f s; QPS = %u; Hit rate = %.2f%%\n",
+              elapsed, qps, hit_rate);
+      uint64_t local_hits, remote_hits;
+      if (cache_->GetNumaHitCounts(&local_hits, &remote_hits)) {
+        fprintf(stdout,
+                "NUMA hits: local = %" PRIu64 "; remote = %" PRIu64
+                "; local rate = %.2f%%\n",
+                local_hits, remote_hits,
+                local_hits + remote_hits == 0
+                    ? 0.0
+                    : 100.0 * local_hits / (local_hits + remote_hits));
+      }
+      if (qps_out != nullptr) {
+        *qps_out = qps;
+      }
+      if (hit_rate_out != nullptr) {
+        *hit_rate_out = hit_rate;
+      }
     }
     return true;
   }
@@ -253,6 +373,8 @@ class CacheBench {
   const uint64_t insert_threshold_;
   const uint64_t lookup_threshold_;
   const uint64_t erase_threshold_;
+  const uint64_t scan_threshold_;
+  std::vector<double> zipf_cdf_;
 
   static void ThreadBody(void* v) {
     ThreadState* thread = static_cast<ThreadState*>(v);
@@ -285,7 +407,22 @@ class CacheBench {
     // To hold handles for a non-trivial amount of time
     Cache::Handle* handle = nullptr;
     KeyGen gen;
+    gen.zipf_cdf = &zipf_cdf_;
+    uint64_t lookups = 0;
+    uint64_t hits = 0;
     for (uint64_t i = 0; i < FLAGS_ops_per_thread; i++) {
+      if (scan_threshold_ > 0 && thread->rnd.Next() < scan_threshold_) {
+        // do one step of the scan
+        Slice key = gen.Get(max_key_ + thread->scan_key++);
+        Cache::Handle* scan_handle = cache_->Lookup(key);
+        if (scan_handle) {
+          cache_->Release(scan_handle);
+        } else {
+          cache_->Insert(key, createValue(thread->rnd), FLAGS_value_bytes,
+                         &deleter);
+        }
+        continue;
+      }
       Slice key = gen.GetRand(thread->rnd, max_key_);
       uint64_t random_op = thread->rnd.Next();
       if (random_op < lookup_insert_threshold_) {
@@ -295,7 +432,9 @@ class CacheBench {
         }
         // do lookup
         handle = cache_->Lookup(key);
+        lookups++;
         if (handle) {
+          hits++;
           // do something with the data
           result += NPHash64(static_cast<char*>(cache_->Value(handle)),
                              FLAGS_value_bytes);
@@ -319,7 +458,9 @@ class CacheBench {
         }
         // do lookup
         handle = cache_->Lookup(key);
+        lookups++;
         if (handle) {
+          hits++;
           // do something with the data
           result += NPHash64(static_cast<char*>(cache_->Value(handle)),
                              FLAGS_value_bytes);
@@ -336,17 +477,24 @@ class CacheBench {
       cache_->Release(handle);
       handle = nullptr;
     }
+    MutexLock l(thread->shared->GetMutex());
+    thread->shared->lookups += lookups;
+    thread->shared->hits += hits;
   }
 
-  void PrintEnv() const {
+  void PrintEnv(uint32_t num_threads) const {
     printf("RocksDB version     : %d.%d\n", kMajorVersion, kMinorVersion);
-    printf("Number of threads   : %u\n", FLAGS_threads);
+    printf("Cache type          : %s\n", cache_->Name());
+    printf("Number of threads   : %u\n", num_threads);
     printf("Ops per thread      : %" PRIu64 "\n", FLAGS_ops_per_thread);
     printf("Cache size          : %" PRIu64 "\n", FLAGS_cache_size);
     printf("Num shard bits      : %u\n", FLAGS_num_shard_bits);
     printf("Max key             : %" PRIu64 "\n", max_key_);
     printf("Resident ratio      : %g\n", FLAGS_resident_ratio);
     printf("Skew degree         : %u\n", FLAGS_skew);
+    printf("Zipf alpha          : %g\n", FLAGS_zipf_alpha);
+    printf("Scan percentage     : %u%%\n", FLAGS_scan_percent);
+    printf("NUMA aware          : %d\n", int{FLAGS_numa_aware});
     printf("Populate cache      : %d\n", int{FLAGS_populate_cache});
     printf("Lookup+Insert pct   : %u%%\n", FLAGS_lookup_insert_percent);
     printf("Insert percentage   : %u%%\n", FLAGS_insert_percent);
@@ -355,23 +503,96 @@ class CacheBench {
     printf("----------------------------\n");
   }
 };
+
+// Run the same workload against LRUCache and ClockCache for each thread count
+// in --thread_scaling, and print how the throughput scales.
+int RunThreadScaling() {
+  std::vector<uint32_t> thread_counts;
+  for (const std::string& t : StringSplit(FLAGS_thread_scaling, ',')) {
+    int n = std::atoi(t.c_str());
+    if (n <= 0) {
+      fprintf(stderr, "Invalid thread count in --thread_scaling: %s\n",
+              t.c_str());
+      return 1;
+    }
+    thread_counts.push_back(static_cast<uint32_t>(n));
+  }
+  const std::vector<std::string> cache_types = {"lru_cache", "clock_cache"};
+  // qps[i][j] is the throughput of cache_types[i] with thread_counts[j].
+  std::vector<std::vector<uint32_t>> qps(cache_types.size());
+  for (size_t i = 0; i < cache_types.size(); i++) {
+    for (uint32_t num_threads : thread_counts) {
+      CacheBench bench(cache_types[i]);
+      if (FLAGS_populate_cache) {
+        bench.PopulateCache();
+      }
+      uint32_t result = 0;
+      if (!bench.Run(num_threads, &result)) {
+        return 1;
+      }
+      qps[i].push_back(result);
+    }
+  }
+  printf("----------------------------\n");
+  printf("%8s %16s %16s %8s\n", "Threads", "LRUCache QPS", "ClockCache QPS",
+         "Ratio");
+  for (size_t j = 0; j < thread_counts.size(); j++) {
+    printf("%8u %16u %16u %8.2f\n", thread_counts[j], qps[0][j], qps[1][j],
+           qps[0][j] == 0 ? 0.0 : 1.0 * qps[1][j] / qps[0][j]);
+  }
+  return 0;
+}
+
+// Run the same workload against LRUCache without and with TinyLFU admission,
+// and print the hit rates of the point lookups. Most useful with --zipf_alpha
+// and --scan_percent, to see how well admission protects the hot keys from
+// being flushed out by scans.
+int RunCompareAdmission() {
+  const bool admission[2] = {false, true};
+  uint32_t qps[2] = {0, 0};
+  double hit_rate[2] = {0, 0};
+  for (int i = 0; i < 2; i++) {
+    CacheBench bench("lru_cache", admission[i]);
+    if (FLAGS_populate_cache) {
+      bench.PopulateCache();
+    }
+    if (!bench.Run(FLAGS_threads, &qps[i], &hit_rate[i])) {
+      return 1;
+    }
+  }
+  printf("----------------------------\n");
+  printf("%10s %16s %12s\n", "Admission", "Hit rate", "QPS");
+  for (int i = 0; i < 2; i++) {
+    printf("%10s %15.2f%% %12u\n", admission[i] ? "TinyLFU" : "none",
+           hit_rate[i], qps[i]);
+  }
+  return 0;
+}
 }  // namespace ROCKSDB_NAMESPACE
 
 int main(int argc, char** argv) {
   ParseCommandLineFlags(&argc, &argv, true);
 
+  if (!FLAGS_thread_scaling.empty()) {
+    return ROCKSDB_NAMESPACE::RunThreadScaling();
+  }
+  if (FLAGS_compare_admission) {
+    return ROCKSDB_NAMESPACE::RunCompareAdmission();
+  }
+
   if (FLAGS_threads <= 0) {
     fprintf(stderr, "threads number <= 0\n");
     exit(1);
   }
 
-  ROCKSDB_NAMESPACE::CacheBench bench;
+  ROCKSDB_NAMESPACE::CacheBench bench(
+      FLAGS_use_clock_cache ? "clock_cache" : FLAGS_cache_type);
   if (FLAGS_populate_cache) {
     bench.PopulateCache();
     printf("Population complete\n");
     printf("----------------------------\n");
   }
-  if (bench.Run()) {
+  if (bench.Run(FLAGS_threads)) {
     return 0;
   } else {
     return 1;
@@ -0,0 +1,110 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "cache/cache_reservation_manager.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace ROCKSDB_NAMESPACE {
+
+CacheReservationManager::CacheReservationHandle::CacheReservationHandle(
+    size_t incremental_memory_used,
+    std::shared_ptr<CacheReservationManager> mgr)
+    : incremental_memory_used_(incremental_memory_used),
+      mgr_(std::move(mgr)) {
+  assert(mgr_ != nullptr);
+}
+
+CacheReservationManager::CacheReservationHandle::~CacheReservationHandle() {
+  std::lock_guard<std::mutex> lock(mgr_->mutex_);
+  size_t memory_used = mgr_->memory_used_.load(std::memory_order_relaxed);
+  assert(memory_used >= incremental_memory_used_);
+  // Giving back memory only releases dummy entries, which cannot fail.
+  mgr_->UpdateCacheReservationLocked(memory_used - incremental_memory_used_)
+      .PermitUncheckedError();
+}
+
+CacheReservationManager::CacheReservationManager(std::shared_ptr<Cache> cache,
+                                                 bool delayed_decrease)
+    : cache_(std::move(cache)),
+      delayed_decrease_(delayed_decrease),
+      memory_used_(0),
+      cache_allocated_size_(0) {
+  assert(cache_ != nullptr);
+  memset(cache_key_, 0, kCacheKeyPrefixSize);
+  EncodeVarint64(cache_key_, cache_->NewId());
+}
+
+CacheReservationManager::~CacheReservationManager() {
+  for (Cache::Handle* handle : dummy_handles_) {
+    cache_->Release(handle, true /* force_erase */);
+  }
+}
+
+Status CacheReservationManager::UpdateCacheReservation(
+    size_t new_memory_used) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return UpdateCacheReservationLocked(new_memory_used);
+}
+
+Status CacheReservationManager::MakeCacheReservation(
+    size_t incremental_memory_used,
+    std::unique_ptr<CacheReservationHandle>* handle) {
+  assert(handle != nullptr);
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t memory_used = memory_used_.load(std::memory_order_relaxed);
+  Status s = UpdateCacheReservationLocked(memory_used + incremental_memory_used);
+  if (!s.ok()) {
+    UpdateCacheReservationLocked(memory_used).PermitUncheckedError();
+    return s;
+  }
+  handle->reset(
+      new CacheReservationHandle(incremental_memory_used, shared_from_this()));
+  return s;
+}
+
+Status CacheReservationManager::UpdateCacheReservationLocked(
+    size_t new_memory_used) {
+  memory_used_.store(new_memory_used, std::memory_order_relaxed);
+  size_t allocated = cache_allocated_size_.load(std::memory_order_relaxed);
+  const size_t target =
+      (new_memory_used + kSizeDummyEntry - 1) / kSizeDummyEntry *
+      kSizeDummyEntry;
+  Status s;
+  if (target > allocated) {
+    while (allocated < target) {
+      Cache::Handle* handle = nullptr;
+      s = cache_->Insert(GetNextCacheKey(), nullptr, kSizeDummyEntry,
+                         nullptr /* deleter */, &handle);
+      if (!s.ok()) {
+        break;
+      }
+      // A handle is always returned, even if the dummy entry was not kept in
+      // the cache: it is charged to the cache until released.
+      assert(handle != nullptr);
+      dummy_handles_.push_back(handle);
+      allocated += kSizeDummyEntry;
+    }
+  } else if (!delayed_decrease_ || new_memory_used < allocated / 4 * 3) {
+    while (allocated > target) {
+      assert(!dummy_handles_.empty());
+      cache_->Release(dummy_handles_.back(), true /* force_erase */);
+      dummy_handles_.pop_back();
+      allocated -= kSizeDummyEntry;
+    }
+  }
+  cache_allocated_size_.store(allocated, std::memory_order_relaxed);
+  return s;
+}
+
+Slice CacheReservationManager::GetNextCacheKey() {
+  memset(cache_key_ + kCacheKeyPrefixSize, 0, kMaxVarint64Length);
+  char* end =
+      EncodeVarint64(cache_key_ + kCacheKeyPrefixSize, next_cache_key_id_++);
+  return Slice(cache_key_, static_cast<size_t>(end - cache_key_));
+}
+
+}  // namespace ROCKSDB_NAMESPACE
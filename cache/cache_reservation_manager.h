@@ -0,0 +1,99 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "rocksdb/cache.h"
+#include "rocksdb/slice.h"
+#include "rocksdb/status.h"
+#include "util/coding.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+// CacheReservationManager charges memory that is not otherwise tracked by a
+// Cache to it, by inserting dummy entries of kSizeDummyEntry bytes each, the
+// same way WriteBufferManager charges memtables. The reservation is kept a
+// multiple of kSizeDummyEntry at least as large as the memory used, so that
+// the memory counted against the cache capacity bounds both.
+//
+// Thread safe.
+class CacheReservationManager
+    : public std::enable_shared_from_this<CacheReservationManager> {
+ public:
+  // A part of the memory reserved through a CacheReservationManager, which is
+  // given back when the handle is destroyed.
+  class CacheReservationHandle {
+   public:
+    CacheReservationHandle(size_t incremental_memory_used,
+                           std::shared_ptr<CacheReservationManager> mgr);
+    ~CacheReservationHandle();
+
+    CacheReservationHandle(const CacheReservationHandle&) = delete;
+    CacheReservationHandle& operator=(const CacheReservationHandle&) = delete;
+
+   private:
+    size_t incremental_memory_used_;
+    std::shared_ptr<CacheReservationManager> mgr_;
+  };
+
+  static const size_t kSizeDummyEntry = 256 * 1024;
+
+  // With delayed_decrease, the reservation only shrinks once the memory used
+  // falls below 3/4 of it, as WriteBufferManager does, which saves cache
+  // operations when the memory used goes up and down around a boundary.
+  explicit CacheReservationManager(std::shared_ptr<Cache> cache,
+                                   bool delayed_decrease = false);
+  ~CacheReservationManager();
+
+  CacheReservationManager(const CacheReservationManager&) = delete;
+  CacheReservationManager& operator=(const CacheReservationManager&) = delete;
+
+  // Make the reservation cover new_memory_used bytes. On failure to insert a
+  // dummy entry, e.g. a full cache with strict_capacity_limit, returns the
+  // status of the insertion and the reservation may be smaller than
+  // new_memory_used, but the memory used is still recorded.
+  Status UpdateCacheReservation(size_t new_memory_used);
+
+  // Add incremental_memory_used bytes to the memory used, which are released
+  // when *handle is destroyed. On failure the memory used is unchanged and
+  // *handle is not set.
+  // REQUIRES: this is owned by a std::shared_ptr.
+  Status MakeCacheReservation(
+      size_t incremental_memory_used,
+      std::unique_ptr<CacheReservationHandle>* handle);
+
+  size_t GetTotalReservedCacheSize() const {
+    return cache_allocated_size_.load(std::memory_order_relaxed);
+  }
+  size_t GetTotalMemoryUsed() const {
+    return memory_used_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  // REQUIRES: mutex_ held
+  Status UpdateCacheReservationLocked(size_t new_memory_used);
+  Slice GetNextCacheKey();
+
+  // The keys of the dummy entries are longer than the keys of the blocks of
+  // table files, so they do not conflict.
+  static const size_t kCacheKeyPrefixSize = kMaxVarint64Length * 4 + 1;
+
+  std::shared_ptr<Cache> cache_;
+  const bool delayed_decrease_;
+  std::mutex mutex_;
+  std::atomic<size_t> memory_used_;
+  std::atomic<size_t> cache_allocated_size_;
+  std::vector<Cache::Handle*> dummy_handles_;
+  char cache_key_[kCacheKeyPrefixSize + kMaxVarint64Length];
+  uint64_t next_cache_key_id_ = 0;
+};
+
+}  // namespace ROCKSDB_NAMESPACE
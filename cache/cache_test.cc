@@ -9,6 +9,7 @@
 
 #include "rocksdb/cache.h"
 
+#include <atomic>
 #include <forward_list>
 #include <functional>
 #include <iostream>
@@ -18,6 +19,7 @@
 #include "cache/lru_cache.h"
 #include "test_util/testharness.h"
 #include "util/coding.h"
+#include "util/random.h"
 #include "util/string_util.h"
 
 namespace ROCKSDB_NAMESPACE {
@@ -100,12 +102,22 @@ class CacheTest : public testing::TestWithParam<std::string> {
       return NewLRUCache(co);
     }
     if (type == kClock) {
+      // Entries in these tests are charged only a few bytes each.
       return NewClockCache(capacity, num_shard_bits, strict_capacity_limit,
-                           charge_policy);
+                           charge_policy, 1 /* estimated_entry_charge */);
     }
     return nullptr;
   }
 
+  // Number of inserts into cache_ after which entries without external
+  // references have been evicted, unless they keep being looked up. The
+  // CLOCK hand walks the slots of a hash table rather than the insertion
+  // order, so it takes a few times the capacity to be sure it went over
+  // every entry often enough.
+  int FlushingInserts() const {
+    return GetParam() == kClock ? 8 * kCacheSize : 2 * kCacheSize;
+  }
+
   int Lookup(std::shared_ptr<Cache> cache, int key) {
     Cache::Handle* handle = cache->Lookup(EncodeKey(key));
     const int r = (handle == nullptr) ? -1 : DecodeValue(cache->Value(handle));
@@ -367,7 +379,7 @@ TEST_P(CacheTest, EvictionPolicy) {
   Insert(200, 201);
 
   // Frequently used entry must be kept around
-  for (int i = 0; i < kCacheSize * 2; i++) {
+  for (int i = 0; i < FlushingInserts(); i++) {
     Insert(1000+i, 2000+i);
     ASSERT_EQ(101, Lookup(100));
   }
@@ -391,7 +403,7 @@ TEST_P(CacheTest, ExternalRefPinsEntries) {
     }
     // double cache size because the usage bit in block cache prevents 100 from
     // being evicted in the first kCacheSize iterations
-    for (int j = 0; j < 2 * kCacheSize + 100; j++) {
+    for (int j = 0; j < FlushingInserts() + 100; j++) {
       Insert(1000 + j, 2000 + j);
     }
     if (i < 2) {
@@ -420,7 +432,7 @@ TEST_P(CacheTest, EvictionPolicyRef) {
   Insert(303, 104);
 
   // Insert entries much more than Cache capacity
-  for (int i = 0; i < kCacheSize * 2; i++) {
+  for (int i = 0; i < FlushingInserts(); i++) {
     Insert(1000 + i, 2000 + i);
   }
 
@@ -757,9 +769,61 @@ TEST_P(CacheTest, GetCharge) {
   cache_->Release(h1);
 }
 
+TEST_P(CacheTest, ConcurrentInsertLookupErase) {
+  // Small cache with many more keys than fit, so that concurrent lookups,
+  // inserts, overwrites, erases and evictions all race on the same entries.
+  const int kNumThreads = 8;
+  const int kOpsPerThread = 20000;
+  const int kNumKeys = 2000;
+  std::shared_ptr<Cache> cache = NewCache(500, 2, false);
+  std::atomic<int> mismatches(0);
+  std::vector<port::Thread> threads;
+  for (int t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&, t]() {
+      Random rnd(301 + t);
+      for (int i = 0; i < kOpsPerThread; i++) {
+        int k = static_cast<int>(rnd.Uniform(kNumKeys));
+        std::string key = EncodeKey(k);
+        switch (rnd.Uniform(4)) {
+          case 0: {
+            Cache::Handle* h = nullptr;
+            Status s = cache->Insert(key, new Value(k), 1, &deleter, &h);
+            if (s.ok()) {
+              cache->Release(h);
+            }
+            break;
+          }
+          case 1:
+            cache->Erase(key);
+            break;
+          default: {
+            Cache::Handle* h = cache->Lookup(key);
+            if (h != nullptr) {
+              if (static_cast<Value*>(cache->Value(h))->v_ !=
+                  static_cast<size_t>(k)) {
+                mismatches++;
+              }
+              cache->Release(h, rnd.OneIn(10) /* force_erase */);
+            }
+            break;
+          }
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  ASSERT_EQ(0, mismatches.load());
+  ASSERT_EQ(0U, cache->GetPinnedUsage());
+  ASSERT_LE(cache->GetUsage(), cache->GetCapacity());
+  cache->EraseUnRefEntries();
+  ASSERT_EQ(0U, cache->GetUsage());
+}
+
 #ifdef SUPPORT_CLOCK_CACHE
 std::shared_ptr<Cache> (*new_clock_cache_func)(
-    size_t, int, bool, CacheMetadataChargePolicy) = NewClockCache;
+    size_t, int, bool, CacheMetadataChargePolicy, size_t) = NewClockCache;
 INSTANTIATE_TEST_CASE_P(CacheTestInstance, CacheTest,
                         testing::Values(kLRU, kClock));
 #else
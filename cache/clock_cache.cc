@@ -15,7 +15,8 @@ namespace ROCKSDB_NAMESPACE {
 
 std::shared_ptr<Cache> NewClockCache(
     size_t /*capacity*/, int /*num_shard_bits*/, bool /*strict_capacity_limit*/,
-    CacheMetadataChargePolicy /*metadata_charge_policy*/) {
+    CacheMetadataChargePolicy /*metadata_charge_policy*/,
+    size_t /*estimated_entry_charge*/) {
   // Clock cache not supported.
   return nullptr;
 }
@@ -26,191 +27,90 @@ std::shared_ptr<Cache> NewClockCache(
 
 #include <assert.h>
 #include <atomic>
-#include <deque>
-
-// "tbb/concurrent_hash_map.h" requires RTTI if exception is enabled.
-// Disable it so users can chooose to disable RTTI.
-#ifndef ROCKSDB_USE_RTTI
-#define TBB_USE_EXCEPTIONS 0
-#endif
-#include "tbb/concurrent_hash_map.h"
+#include <memory>
 
 #include "cache/sharded_cache.h"
 #include "port/malloc.h"
 #include "port/port.h"
-#include "util/autovector.h"
-#include "util/mutexlock.h"
 
 namespace ROCKSDB_NAMESPACE {
 
 namespace {
 
-// An implementation of the Cache interface based on CLOCK algorithm, with
-// better concurrent performance than LRUCache. The idea of CLOCK algorithm
-// is to maintain all cache entries in a circular list, and an iterator
-// (the "head") pointing to the last examined entry. Eviction starts from the
-// current head. Each entry is given a second chance before eviction, if it
-// has been access since last examine. In contrast to LRU, no modification
-// to the internal data-structure (except for flipping the usage bit) needs
-// to be done upon lookup. This gives us oppertunity to implement a cache
-// with better concurrency.
-//
-// Each cache entry is represented by a cache handle, and all the handles
-// are arranged in a circular list, as describe above. Upon erase of an entry,
-// we never remove the handle. Instead, the handle is put into a recycle bin
-// to be re-use. This is to avoid memory dealocation, which is hard to deal
-// with in concurrent environment.
-//
-// The cache also maintains a concurrent hash map for lookup. Any concurrent
-// hash map implementation should do the work. We currently use
-// tbb::concurrent_hash_map because it supports concurrent erase.
-//
-// Each cache handle has the following flags and counters, which are squeeze
-// in an atomic interger, to make sure the handle always be in a consistent
-// state:
-//
-//   * In-cache bit: whether the entry is reference by the cache itself. If
-//     an entry is in cache, its key would also be available in the hash map.
-//   * Usage bit: whether the entry has been access by user since last
-//     examine for eviction. Can be reset by eviction.
-//   * Reference count: reference count by user.
-//
-// An entry can be reference only when it's in cache. An entry can be evicted
-// only when it is in cache, has no usage since last examine, and reference
-// count is zero.
-//
-// The follow figure shows a possible layout of the cache. Boxes represents
-// cache handles and numbers in each box being in-cache bit, usage bit and
-// reference count respectively.
-//
-//    hash map:
-//      +-------+--------+
-//      |  key  | handle |
-//      +-------+--------+
-//      | "foo" |    5   |-------------------------------------+
-//      +-------+--------+                                     |
-//      | "bar" |    2   |--+                                  |
-//      +-------+--------+  |                                  |
-//                          |                                  |
-//                     head |                                  |
-//                       |  |                                  |
-//    circular list:     |  |                                  |
-//         +-------+   +-------+   +-------+   +-------+   +-------+   +-------
-//         |(0,0,0)|---|(1,1,0)|---|(0,0,0)|---|(0,1,3)|---|(1,0,0)|---|  ...
-//         +-------+   +-------+   +-------+   +-------+   +-------+   +-------
-//             |                       |
-//             +-------+   +-----------+
-//                     |   |
-//                   +---+---+
-//    recycle bin:   | 1 | 3 |
-//                   +---+---+
+// An implementation of the Cache interface based on the CLOCK algorithm, in
+// which no operation takes a lock. The idea of CLOCK algorithm is to arrange
+// all cache entries in a circle, and an iterator (the "hand") pointing to the
+// next entry to examine. Eviction starts from the current hand. Each entry is
+// given a few more chances before eviction if it has been accessed since it
+// was last examined. In contrast to LRU, no modification to the internal
+// data structure (except for resetting a small countdown) needs to be done
+// upon lookup.
 //
-// Suppose we try to insert "baz" into the cache at this point and the cache is
-// full. The cache will first look for entries to evict, starting from where
-// head points to (the second entry). It resets usage bit of the second entry,
-// skips the third and fourth entry since they are not in cache, and finally
-// evict the fifth entry ("foo"). It looks at recycle bin for available handle,
-// grabs handle 3, and insert the key into the handle. The following figure
-// shows the resulting layout.
+// Each shard keeps its entries in a fixed size, open addressed hash table.
+// The slots of that table are also the circle walked by the clock hand, so
+// there is no separate list and no recycle bin to protect with a mutex. The
+// table is sized at construction from the shard capacity and an estimate of
+// the average entry charge, so that it stays at most kLoadFactor full. If the
+// table runs out of slots before the capacity is used up, entries are evicted
+// to make room just as if the cache were full.
 //
-//    hash map:
-//      +-------+--------+
-//      |  key  | handle |
-//      +-------+--------+
-//      | "baz" |    3   |-------------+
-//      +-------+--------+             |
-//      | "bar" |    2   |--+          |
-//      +-------+--------+  |          |
-//                          |          |
-//                          |          |                                 head
-//                          |          |                                   |
-//    circular list:        |          |                                   |
-//         +-------+   +-------+   +-------+   +-------+   +-------+   +-------
-//         |(0,0,0)|---|(1,0,0)|---|(1,0,0)|---|(0,1,3)|---|(0,0,0)|---|  ...
-//         +-------+   +-------+   +-------+   +-------+   +-------+   +-------
-//             |                                               |
-//             +-------+   +-----------------------------------+
-//                     |   |
-//                   +---+---+
-//    recycle bin:   | 1 | 5 |
-//                   +---+---+
+// The state of a slot is packed into a single 64-bit atomic word, which is
+// only ever changed with atomic read-modify-write operations:
 //
-// A global mutex guards the circular list, the head, and the recycle bin.
-// We additionally require that modifying the hash map needs to hold the mutex.
-// As such, Modifying the cache (such as Insert() and Erase()) require to
-// hold the mutex. Lookup() only access the hash map and the flags associated
-// with each handle, and don't require explicit locking. Release() has to
-// acquire the mutex only when it releases the last reference to the entry and
-// the entry has been erased from cache explicitly. A future improvement could
-// be to remove the mutex completely.
+//   * State (2 bits): one of
+//       - kEmpty: the slot holds nothing and can be claimed by an insert;
+//       - kConstruction: a thread owns the slot exclusively, either to fill
+//         it with a new entry or to tear down an entry it evicted;
+//       - kVisible: the entry is in cache and can be found by Lookup();
+//       - kInvisible: the entry has been erased or overwritten, but is still
+//         referenced by users. It is freed on last Release().
+//   * Countdown (2 bits): set to kMaxCountdown on every Lookup() and
+//     decremented each time the clock hand passes over the entry. An entry is
+//     evicted only when its countdown is 0 and it has no references.
+//   * Reference count (the remaining bits): references held by users.
 //
-// Benchmark:
-// We run readrandom db_bench on a test DB of size 13GB, with size of each
-// level:
+// Lookup() takes a reference with a compare-and-swap that requires the slot
+// to be kVisible, and only compares the key after the reference is held, so
+// the slot cannot be torn down and reused under it. Eviction, Erase() and the
+// last Release() of an erased entry free a slot by moving it from a
+// reference-free kVisible or kInvisible state to kConstruction with a single
+// compare-and-swap; whoever wins that race is the only thread touching the
+// slot until it is published as kEmpty again.
 //
-//    Level    Files   Size(MB)
-//    -------------------------
-//      L0        1       0.01
-//      L1       18      17.32
-//      L2      230     182.94
-//      L3     1186    1833.63
-//      L4     4602    8140.30
+// Probing uses double hashing over the 32-bit key hash. Each slot counts how
+// many live entries have probed past it ("displacements"), so Lookup() can
+// stop at the first slot that no entry was displaced from, instead of
+// scanning the whole table on a miss.
 //
-// We test with both 32 and 16 read threads, with 2GB cache size (the whole DB
-// doesn't fits in) and 64GB cache size (the whole DB can fit in cache), and
-// whether to put index and filter blocks in block cache. The benchmark runs
-// with
-// with RocksDB 4.10. We got the following result:
+// If an entry must be handed out while the table is completely full and the
+// capacity is not strict, it is allocated outside the table as a "detached"
+// handle, which is never visible to Lookup() and is freed on last Release().
 //
-// Threads Cache     Cache               ClockCache               LRUCache
-//         Size  Index/Filter Throughput(MB/s)   Hit Throughput(MB/s)    Hit
-//     32   2GB       yes               466.7  85.9%           433.7   86.5%
-//     32   2GB       no                529.9  72.7%           532.7   73.9%
-//     32  64GB       yes               649.9  99.9%           507.9   99.9%
-//     32  64GB       no                740.4  99.9%           662.8   99.9%
-//     16   2GB       yes               278.4  85.9%           283.4   86.5%
-//     16   2GB       no                318.6  72.7%           335.8   73.9%
-//     16  64GB       yes               391.9  99.9%           353.3   99.9%
-//     16  64GB       no                433.8  99.8%           419.4   99.8%
+// Two concurrent inserts of the same key may briefly leave two visible
+// entries for it; each insert hides any older duplicate it finds after
+// publishing its own entry, so the cache converges to a single copy (or, in
+// the worst case, to none, which is just a cache miss).
 
 // Cache entry meta data.
-struct CacheHandle {
+struct ClockHandle {
+  // State, countdown and reference count, see above.
+  std::atomic<uint64_t> meta{0};
+  // Number of entries that probed past this slot to be inserted elsewhere.
+  std::atomic<uint32_t> displacements{0};
+  uint32_t hash = 0;
   Slice key;
-  uint32_t hash;
-  void* value;
-  size_t charge;
-  void (*deleter)(const Slice&, void* value);
-
-  // Flags and counters associated with the cache handle:
-  //   lowest bit: in-cache bit
-  //   second lowest bit: usage bit
-  //   the rest bits: reference count
-  // The handle is unused when flags equals to 0. The thread decreases the count
-  // to 0 is responsible to put the handle back to recycle_ and cleanup memory.
-  std::atomic<uint32_t> flags;
-
-  CacheHandle() = default;
-
-  CacheHandle(const CacheHandle& a) { *this = a; }
-
-  CacheHandle(const Slice& k, void* v,
-              void (*del)(const Slice& key, void* value))
-      : key(k), value(v), deleter(del) {}
-
-  CacheHandle& operator=(const CacheHandle& a) {
-    // Only copy members needed for deletion.
-    key = a.key;
-    value = a.value;
-    deleter = a.deleter;
-    return *this;
-  }
+  void* value = nullptr;
+  size_t charge = 0;
+  void (*deleter)(const Slice& key, void* value) = nullptr;
+  // Whether the handle lives outside of the hash table.
+  bool detached = false;
 
   inline static size_t CalcTotalCharge(
       Slice key, size_t charge,
       CacheMetadataChargePolicy metadata_charge_policy) {
     size_t meta_charge = 0;
     if (metadata_charge_policy == kFullChargeCacheMetadata) {
-      meta_charge += sizeof(CacheHandle);
+      meta_charge += sizeof(ClockHandle);
 #ifdef ROCKSDB_MALLOC_USABLE_SIZE
       meta_charge +=
           malloc_usable_size(static_cast<void*>(const_cast<char*>(key.data())));
@@ -222,176 +122,182 @@ struct CacheHandle {
   }
 
   inline size_t CalcTotalCharge(
-      CacheMetadataChargePolicy metadata_charge_policy) {
+      CacheMetadataChargePolicy metadata_charge_policy) const {
     return CalcTotalCharge(key, charge, metadata_charge_policy);
   }
 };
 
-// Key of hash map. We store hash value with the key for convenience.
-struct CacheKey {
-  Slice key;
-  uint32_t hash_value;
-
-  CacheKey() = default;
-
-  CacheKey(const Slice& k, uint32_t h) {
-    key = k;
-    hash_value = h;
-  }
-
-  static bool equal(const CacheKey& a, const CacheKey& b) {
-    return a.hash_value == b.hash_value && a.key == b.key;
-  }
-
-  static size_t hash(const CacheKey& a) {
-    return static_cast<size_t>(a.hash_value);
-  }
-};
-
-struct CleanupContext {
-  // List of values to be deleted, along with the key and deleter.
-  autovector<CacheHandle> to_delete_value;
-
-  // List of keys to be deleted.
-  autovector<const char*> to_delete_key;
-};
-
 // A cache shard which maintains its own CLOCK cache.
 class ClockCacheShard final : public CacheShard {
  public:
-  // Hash map type.
-  typedef tbb::concurrent_hash_map<CacheKey, CacheHandle*, CacheKey> HashTable;
-
-  ClockCacheShard();
+  ClockCacheShard(size_t capacity, size_t estimated_entry_charge,
+                  bool strict_capacity_limit,
+                  CacheMetadataChargePolicy metadata_charge_policy);
   ~ClockCacheShard() override;
 
   // Interfaces
+  using CacheShard::Insert;
+  using CacheShard::Lookup;
   void SetCapacity(size_t capacity) override;
   void SetStrictCapacityLimit(bool strict_capacity_limit) override;
   Status Insert(const Slice& key, uint32_t hash, void* value, size_t charge,
                 void (*deleter)(const Slice& key, void* value),
                 Cache::Handle** handle, Cache::Priority priority) override;
   Cache::Handle* Lookup(const Slice& key, uint32_t hash) override;
-  // If the entry in in cache, increase reference count and return true.
-  // Return false otherwise.
-  //
-  // Not necessary to hold mutex_ before being called.
+  // The caller must already hold a reference of the handle, so this never
+  // fails.
   bool Ref(Cache::Handle* handle) override;
   bool Release(Cache::Handle* handle, bool force_erase = false) override;
   void Erase(const Slice& key, uint32_t hash) override;
-  bool EraseAndConfirm(const Slice& key, uint32_t hash,
-                       CleanupContext* context);
   size_t GetUsage() const override;
   size_t GetPinnedUsage() const override;
   void EraseUnRefEntries() override;
   void ApplyToAllCacheEntries(void (*callback)(void*, size_t),
                               bool thread_safe) override;
+  void ApplyToAllEntries(
+      const std::function<void(const Slice& key, void* value, size_t charge)>&
+          callback) override;
+  std::string GetPrintableOptions() const override;
 
  private:
-  static const uint32_t kInCacheBit = 1;
-  static const uint32_t kUsageBit = 2;
-  static const uint32_t kRefsOffset = 2;
-  static const uint32_t kOneRef = 1 << kRefsOffset;
-
-  // Helper functions to extract cache handle flags and counters.
-  static bool InCache(uint32_t flags) { return flags & kInCacheBit; }
-  static bool HasUsage(uint32_t flags) { return flags & kUsageBit; }
-  static uint32_t CountRefs(uint32_t flags) { return flags >> kRefsOffset; }
-
-  // Decrease reference count of the entry. If this decreases the count to 0,
-  // recycle the entry. If set_usage is true, also set the usage bit.
-  //
-  // returns true if a value is erased.
-  //
-  // Not necessary to hold mutex_ before being called.
-  bool Unref(CacheHandle* handle, bool set_usage, CleanupContext* context);
-
-  // Unset in-cache bit of the entry. Recycle the handle if necessary.
-  //
-  // returns true if a value is erased.
-  //
-  // Has to hold mutex_ before being called.
-  bool UnsetInCache(CacheHandle* handle, CleanupContext* context);
-
-  // Put the handle back to recycle_ list, and put the value associated with
-  // it into to-be-deleted list. It doesn't cleanup the key as it might be
-  // reused by another handle.
-  //
-  // Has to hold mutex_ before being called.
-  void RecycleHandle(CacheHandle* handle, CleanupContext* context);
-
-  // Delete keys and values in to-be-deleted list. Call the method without
-  // holding mutex, as destructors can be expensive.
-  void Cleanup(const CleanupContext& context);
-
-  // Examine the handle for eviction. If the handle is in cache, usage bit is
-  // not set, and referece count is 0, evict it from cache. Otherwise unset
-  // the usage bit.
-  //
-  // Has to hold mutex_ before being called.
-  bool TryEvict(CacheHandle* value, CleanupContext* context);
-
-  // Scan through the circular list, evict entries until we get enough capacity
-  // for new cache entry of specific size. Return true if success, false
-  // otherwise.
-  //
-  // Has to hold mutex_ before being called.
-  bool EvictFromCache(size_t charge, CleanupContext* context);
-
-  CacheHandle* Insert(const Slice& key, uint32_t hash, void* value,
-                      size_t change,
-                      void (*deleter)(const Slice& key, void* value),
-                      bool hold_reference, CleanupContext* context,
-                      bool* overwritten);
-
-  // Guards list_, head_, and recycle_. In addition, updating table_ also has
-  // to hold the mutex, to avoid the cache being in inconsistent state.
-  mutable port::Mutex mutex_;
-
-  // The circular list of cache handles. Initially the list is empty. Once a
-  // handle is needed by insertion, and no more handles are available in
-  // recycle bin, one more handle is appended to the end.
-  //
-  // We use std::deque for the circular list because we want to make sure
-  // pointers to handles are valid through out the life-cycle of the cache
-  // (in contrast to std::vector), and be able to grow the list (in contrast
-  // to statically allocated arrays).
-  std::deque<CacheHandle> list_;
-
-  // Pointer to the next handle in the circular list to be examine for
-  // eviction.
-  size_t head_;
-
-  // Recycle bin of cache handles.
-  autovector<CacheHandle*> recycle_;
+  static const uint64_t kStateMask = 3;
+  static const uint64_t kEmpty = 0;
+  static const uint64_t kConstruction = 1;
+  static const uint64_t kVisible = 2;
+  static const uint64_t kInvisible = 3;
+  static const uint32_t kCountdownShift = 2;
+  static const uint64_t kCountdownMask = uint64_t{3} << kCountdownShift;
+  static const uint64_t kMaxCountdown = 3;
+  static const uint32_t kRefsShift = 4;
+  static const uint64_t kOneRef = uint64_t{1} << kRefsShift;
+
+  // Maximum fraction of the slots which may be occupied at the same time.
+  static constexpr double kLoadFactor = 0.7;
+  // Number of slots the clock hand examines per atomic step.
+  static const size_t kClockStep = 4;
+
+  // Helper functions to extract slot state and counters.
+  static uint64_t State(uint64_t meta) { return meta & kStateMask; }
+  static uint64_t Countdown(uint64_t meta) {
+    return (meta & kCountdownMask) >> kCountdownShift;
+  }
+  static uint64_t CountRefs(uint64_t meta) { return meta >> kRefsShift; }
+
+  // Index of the i-th slot on the probe sequence of the given hash.
+  size_t Probe(uint32_t hash, size_t i) const {
+    // Rotate so the increment does not depend only on the low bits that
+    // already chose the home slot. It must be odd to visit every slot.
+    uint32_t increment = ((hash << 19) | (hash >> 13)) | 1;
+    return (hash + i * increment) & slot_mask_;
+  }
+
+  // Take a reference of a visible slot. Returns false if the slot is not
+  // visible.
+  bool TryRef(ClockHandle* h);
+
+  // Drop one reference. If erase is set, the entry is erased from cache
+  // first. Frees the entry if it was the last reference and the entry is
+  // either erased or the cache is over capacity. Returns true if the entry
+  // is freed.
+  bool Unref(ClockHandle* h, bool erase);
+
+  // Make an entry invisible, so it can no longer be found and gets freed on
+  // last Release(). The caller must hold a reference of the entry, otherwise
+  // the slot could be reused for another entry in between.
+  void MarkInvisible(ClockHandle* h);
+
+  // Move a slot without references from `expected` state to kConstruction,
+  // and free it. Returns true if this thread won the race to free it.
+  bool TryFree(ClockHandle* h, uint64_t expected);
+
+  // Call the deleter, release key memory and return the slot to the table.
+  // The slot must be in kConstruction state owned by the caller, or a
+  // detached handle.
+  void FreeEntry(ClockHandle* h);
+
+  // Examine the slot for eviction. If the entry is visible, has no
+  // references and its countdown reached zero, evict it. Otherwise decrement
+  // the countdown. Returns true if the entry is evicted.
+  bool TryEvict(ClockHandle* h);
+
+  // Move the clock hand, evicting entries until there is room for `charge`
+  // more bytes or, if need_slot is set, until a slot is free. Return true if
+  // success, false otherwise.
+  bool EvictFromClock(size_t charge, bool need_slot);
+
+  // Reserve a slot in the occupancy count, evicting if necessary.
+  bool ReserveSlot();
+
+  // Hide every visible entry with the given key other than `keep`. Returns
+  // true if any was found.
+  bool EraseDuplicates(const Slice& key, uint32_t hash, ClockHandle* keep);
+
+  // Total number of slots and the mask to compute slot indexes.
+  const size_t num_slots_;
+  const size_t slot_mask_;
+  // Maximum number of occupied slots, num_slots_ * kLoadFactor.
+  const size_t occupancy_limit_;
+  // Slots of the open addressed hash table, also the circle of the clock.
+  std::unique_ptr<ClockHandle[]> slots_;
+  const size_t estimated_entry_charge_;
 
   // Maximum cache size.
   std::atomic<size_t> capacity_;
 
-  // Current total size of the cache.
-  std::atomic<size_t> usage_;
-
-  // Total un-released cache size.
-  std::atomic<size_t> pinned_usage_;
-
   // Whether allow insert into cache if cache is full.
   std::atomic<bool> strict_capacity_limit_;
 
-  // Hash table (tbb::concurrent_hash_map) for lookup.
-  HashTable table_;
+  // Frequently modified counters are put on their own cache lines to avoid
+  // false sharing with the read-mostly members above.
+  // Position of the clock hand. Only its value modulo num_slots_ matters.
+  ALIGN_AS(CACHE_LINE_SIZE) std::atomic<size_t> clock_hand_;
+
+  // Number of occupied slots, including those under construction.
+  ALIGN_AS(CACHE_LINE_SIZE) std::atomic<size_t> occupancy_;
+
+  // Current total size of the cache.
+  ALIGN_AS(CACHE_LINE_SIZE) std::atomic<size_t> usage_;
+
+  // Total un-released cache size.
+  ALIGN_AS(CACHE_LINE_SIZE) std::atomic<size_t> pinned_usage_;
 };
 
-ClockCacheShard::ClockCacheShard()
-    : head_(0), usage_(0), pinned_usage_(0), strict_capacity_limit_(false) {}
+size_t CalcNumSlots(size_t capacity, size_t estimated_entry_charge,
+                    double load_factor) {
+  size_t min_slots = static_cast<size_t>(
+      static_cast<double>(capacity / estimated_entry_charge) / load_factor);
+  size_t num_slots = 16;
+  while (num_slots < min_slots) {
+    num_slots *= 2;
+  }
+  return num_slots;
+}
+
+ClockCacheShard::ClockCacheShard(
+    size_t capacity, size_t estimated_entry_charge, bool strict_capacity_limit,
+    CacheMetadataChargePolicy metadata_charge_policy)
+    : num_slots_(CalcNumSlots(capacity, estimated_entry_charge, kLoadFactor)),
+      slot_mask_(num_slots_ - 1),
+      occupancy_limit_(static_cast<size_t>(num_slots_ * kLoadFactor)),
+      slots_(new ClockHandle[num_slots_]),
+      estimated_entry_charge_(estimated_entry_charge),
+      capacity_(capacity),
+      strict_capacity_limit_(strict_capacity_limit),
+      clock_hand_(0),
+      occupancy_(0),
+      usage_(0),
+      pinned_usage_(0) {
+  set_metadata_charge_policy(metadata_charge_policy);
+}
 
 ClockCacheShard::~ClockCacheShard() {
-  for (auto& handle : list_) {
-    uint32_t flags = handle.flags.load(std::memory_order_relaxed);
-    if (InCache(flags) || CountRefs(flags) > 0) {
-      if (handle.deleter != nullptr) {
-        (*handle.deleter)(handle.key, handle.value);
+  for (size_t i = 0; i < num_slots_; i++) {
+    ClockHandle* h = &slots_[i];
+    if (State(h->meta.load(std::memory_order_relaxed)) != kEmpty) {
+      if (h->deleter != nullptr) {
+        (*h->deleter)(h->key, h->value);
       }
-      delete[] handle.key.data();
+      delete[] h->key.data();
     }
   }
 }
@@ -404,63 +310,27 @@ size_t ClockCacheShard::GetPinnedUsage() const {
   return pinned_usage_.load(std::memory_order_relaxed);
 }
 
-void ClockCacheShard::ApplyToAllCacheEntries(void (*callback)(void*, size_t),
-                                             bool thread_safe) {
-  if (thread_safe) {
-    mutex_.Lock();
-  }
-  for (auto& handle : list_) {
-    // Use relaxed semantics instead of acquire semantics since we are either
-    // holding mutex, or don't have thread safe requirement.
-    uint32_t flags = handle.flags.load(std::memory_order_relaxed);
-    if (InCache(flags)) {
-      callback(handle.value, handle.charge);
-    }
-  }
-  if (thread_safe) {
-    mutex_.Unlock();
-  }
-}
-
-void ClockCacheShard::RecycleHandle(CacheHandle* handle,
-                                    CleanupContext* context) {
-  mutex_.AssertHeld();
-  assert(!InCache(handle->flags) && CountRefs(handle->flags) == 0);
-  context->to_delete_key.push_back(handle->key.data());
-  context->to_delete_value.emplace_back(*handle);
-  size_t total_charge = handle->CalcTotalCharge(metadata_charge_policy_);
-  handle->key.clear();
-  handle->value = nullptr;
-  handle->deleter = nullptr;
-  recycle_.push_back(handle);
-  usage_.fetch_sub(total_charge, std::memory_order_relaxed);
-}
-
-void ClockCacheShard::Cleanup(const CleanupContext& context) {
-  for (const CacheHandle& handle : context.to_delete_value) {
-    if (handle.deleter) {
-      (*handle.deleter)(handle.key, handle.value);
-    }
-  }
-  for (const char* key : context.to_delete_key) {
-    delete[] key;
-  }
+std::string ClockCacheShard::GetPrintableOptions() const {
+  const int kBufferSize = 200;
+  char buffer[kBufferSize];
+  snprintf(buffer, kBufferSize,
+           "    estimated_entry_charge : %" ROCKSDB_PRIszt
+           "\n    num_slots_per_shard : %" ROCKSDB_PRIszt "\n",
+           estimated_entry_charge_, num_slots_);
+  return std::string(buffer);
 }
 
-bool ClockCacheShard::Ref(Cache::Handle* h) {
-  auto handle = reinterpret_cast<CacheHandle*>(h);
-  // CAS loop to increase reference count.
-  uint32_t flags = handle->flags.load(std::memory_order_relaxed);
-  while (InCache(flags)) {
+bool ClockCacheShard::TryRef(ClockHandle* h) {
+  uint64_t meta = h->meta.load(std::memory_order_acquire);
+  while (State(meta) == kVisible) {
     // Use acquire semantics on success, as further operations on the cache
     // entry has to be order after reference count is increased.
-    if (handle->flags.compare_exchange_weak(flags, flags + kOneRef,
-                                            std::memory_order_acquire,
-                                            std::memory_order_relaxed)) {
-      if (CountRefs(flags) == 0) {
-        // No reference count before the operation.
-        size_t total_charge = handle->CalcTotalCharge(metadata_charge_policy_);
-        pinned_usage_.fetch_add(total_charge, std::memory_order_relaxed);
+    if (h->meta.compare_exchange_weak(meta, meta + kOneRef,
+                                      std::memory_order_acquire,
+                                      std::memory_order_acquire)) {
+      if (CountRefs(meta) == 0) {
+        pinned_usage_.fetch_add(h->CalcTotalCharge(metadata_charge_policy_),
+                                std::memory_order_relaxed);
       }
       return true;
     }
@@ -468,93 +338,170 @@ bool ClockCacheShard::Ref(Cache::Handle* h) {
   return false;
 }
 
-bool ClockCacheShard::Unref(CacheHandle* handle, bool set_usage,
-                            CleanupContext* context) {
-  if (set_usage) {
-    handle->flags.fetch_or(kUsageBit, std::memory_order_relaxed);
+bool ClockCacheShard::Ref(Cache::Handle* handle) {
+  auto h = reinterpret_cast<ClockHandle*>(handle);
+  uint64_t meta = h->meta.fetch_add(kOneRef, std::memory_order_acquire);
+  assert(CountRefs(meta) > 0);
+  (void)meta;
+  return true;
+}
+
+bool ClockCacheShard::Unref(ClockHandle* h, bool erase) {
+  if (erase) {
+    MarkInvisible(h);
   }
+  // Compute the charge before giving up the reference, as the entry may be
+  // freed by another thread right after.
+  size_t total_charge = h->CalcTotalCharge(metadata_charge_policy_);
   // Use acquire-release semantics as previous operations on the cache entry
-  // has to be order before reference count is decreased, and potential cleanup
-  // of the entry has to be order after.
-  uint32_t flags = handle->flags.fetch_sub(kOneRef, std::memory_order_acq_rel);
-  assert(CountRefs(flags) > 0);
-  if (CountRefs(flags) == 1) {
-    // this is the last reference.
-    size_t total_charge = handle->CalcTotalCharge(metadata_charge_policy_);
-    pinned_usage_.fetch_sub(total_charge, std::memory_order_relaxed);
-    // Cleanup if it is the last reference.
-    if (!InCache(flags)) {
-      MutexLock l(&mutex_);
-      RecycleHandle(handle, context);
+  // has to be order before reference count is decreased, and potential
+  // cleanup of the entry has to be order after.
+  uint64_t meta = h->meta.fetch_sub(kOneRef, std::memory_order_acq_rel);
+  assert(CountRefs(meta) > 0);
+  if (CountRefs(meta) != 1) {
+    return false;
+  }
+  // This was the last reference.
+  pinned_usage_.fetch_sub(total_charge, std::memory_order_relaxed);
+  uint64_t expected = meta - kOneRef;
+  if (State(expected) == kInvisible ||
+      usage_.load(std::memory_order_relaxed) >
+          capacity_.load(std::memory_order_relaxed)) {
+    // Cleanup if the entry is erased, or get rid of it right away if the
+    // cache is over capacity. The latter fails harmlessly if a new reference
+    // sneaks in, the clock hand will get to it later.
+    return TryFree(h, expected);
+  }
+  return false;
+}
+
+void ClockCacheShard::MarkInvisible(ClockHandle* h) {
+  // kVisible | kInvisible == kInvisible. Holding a reference guarantees the
+  // slot is in one of these two states.
+  assert(CountRefs(h->meta.load(std::memory_order_relaxed)) > 0);
+  h->meta.fetch_or(kInvisible, std::memory_order_acq_rel);
+}
+
+bool ClockCacheShard::TryFree(ClockHandle* h, uint64_t expected) {
+  assert(CountRefs(expected) == 0);
+  if (!h->meta.compare_exchange_strong(expected, kConstruction,
+                                       std::memory_order_acquire,
+                                       std::memory_order_relaxed)) {
+    return false;
+  }
+  FreeEntry(h);
+  return true;
+}
+
+void ClockCacheShard::FreeEntry(ClockHandle* h) {
+  size_t total_charge = h->CalcTotalCharge(metadata_charge_policy_);
+  if (!h->detached) {
+    // Roll back the displacements recorded when this entry was inserted.
+    size_t index = static_cast<size_t>(h - slots_.get());
+    for (size_t i = 0;; i++) {
+      size_t probe = Probe(h->hash, i);
+      if (probe == index) {
+        break;
+      }
+      slots_[probe].displacements.fetch_sub(1, std::memory_order_relaxed);
     }
   }
-  return context->to_delete_value.size();
+  if (h->deleter != nullptr) {
+    (*h->deleter)(h->key, h->value);
+  }
+  delete[] h->key.data();
+  usage_.fetch_sub(total_charge, std::memory_order_relaxed);
+  if (h->detached) {
+    delete h;
+  } else {
+    h->key.clear();
+    h->value = nullptr;
+    h->deleter = nullptr;
+    h->meta.store(kEmpty, std::memory_order_release);
+    occupancy_.fetch_sub(1, std::memory_order_relaxed);
+  }
 }
 
-bool ClockCacheShard::UnsetInCache(CacheHandle* handle,
-                                   CleanupContext* context) {
-  mutex_.AssertHeld();
-  // Use acquire-release semantics as previous operations on the cache entry
-  // has to be order before reference count is decreased, and potential cleanup
-  // of the entry has to be order after.
-  uint32_t flags =
-      handle->flags.fetch_and(~kInCacheBit, std::memory_order_acq_rel);
-  // Cleanup if it is the last reference.
-  if (InCache(flags) && CountRefs(flags) == 0) {
-    RecycleHandle(handle, context);
-  }
-  return context->to_delete_value.size();
+bool ClockCacheShard::TryEvict(ClockHandle* h) {
+  uint64_t meta = h->meta.load(std::memory_order_relaxed);
+  if (State(meta) != kVisible || CountRefs(meta) != 0) {
+    return false;
+  }
+  if (Countdown(meta) > 0) {
+    h->meta.compare_exchange_strong(meta, meta - (1 << kCountdownShift),
+                                    std::memory_order_relaxed);
+    return false;
+  }
+  return TryFree(h, meta);
 }
 
-bool ClockCacheShard::TryEvict(CacheHandle* handle, CleanupContext* context) {
-  mutex_.AssertHeld();
-  uint32_t flags = kInCacheBit;
-  if (handle->flags.compare_exchange_strong(flags, 0, std::memory_order_acquire,
-                                            std::memory_order_relaxed)) {
-    bool erased __attribute__((__unused__)) =
-        table_.erase(CacheKey(handle->key, handle->hash));
-    assert(erased);
-    RecycleHandle(handle, context);
+bool ClockCacheShard::EvictFromClock(size_t charge, bool need_slot) {
+  // Every entry can survive kMaxCountdown passes of the hand, so after one
+  // more pass than that only referenced entries remain.
+  const size_t max_steps = (kMaxCountdown + 1) * num_slots_ / kClockStep + 1;
+  auto enough = [&]() {
+    if (need_slot) {
+      return occupancy_.load(std::memory_order_relaxed) < occupancy_limit_;
+    }
+    return usage_.load(std::memory_order_relaxed) + charge <=
+           capacity_.load(std::memory_order_relaxed);
+  };
+  if (enough()) {
     return true;
   }
-  handle->flags.fetch_and(~kUsageBit, std::memory_order_relaxed);
+  for (size_t step = 0; step < max_steps; step++) {
+    size_t start = clock_hand_.fetch_add(kClockStep, std::memory_order_relaxed);
+    for (size_t i = 0; i < kClockStep; i++) {
+      // Check after each eviction, so as not to evict more than needed.
+      if (TryEvict(&slots_[(start + i) & slot_mask_]) && enough()) {
+        return true;
+      }
+    }
+    // Other threads may have made room in the meantime.
+    if (enough()) {
+      return true;
+    }
+  }
   return false;
 }
 
-bool ClockCacheShard::EvictFromCache(size_t charge, CleanupContext* context) {
-  size_t usage = usage_.load(std::memory_order_relaxed);
-  size_t capacity = capacity_.load(std::memory_order_relaxed);
-  if (usage == 0) {
-    return charge <= capacity;
-  }
-  size_t new_head = head_;
-  bool second_iteration = false;
-  while (usage + charge > capacity) {
-    assert(new_head < list_.size());
-    if (TryEvict(&list_[new_head], context)) {
-      usage = usage_.load(std::memory_order_relaxed);
-    }
-    new_head = (new_head + 1 >= list_.size()) ? 0 : new_head + 1;
-    if (new_head == head_) {
-      if (second_iteration) {
+bool ClockCacheShard::ReserveSlot() {
+  size_t occupancy = occupancy_.load(std::memory_order_relaxed);
+  for (;;) {
+    if (occupancy < occupancy_limit_) {
+      if (occupancy_.compare_exchange_weak(occupancy, occupancy + 1,
+                                           std::memory_order_relaxed)) {
+        return true;
+      }
+    } else {
+      if (!EvictFromClock(0, true /* need_slot */)) {
         return false;
-      } else {
-        second_iteration = true;
       }
+      occupancy = occupancy_.load(std::memory_order_relaxed);
     }
   }
-  head_ = new_head;
-  return true;
 }
 
-void ClockCacheShard::SetCapacity(size_t capacity) {
-  CleanupContext context;
-  {
-    MutexLock l(&mutex_);
-    capacity_.store(capacity, std::memory_order_relaxed);
-    EvictFromCache(0, &context);
+bool ClockCacheShard::EraseDuplicates(const Slice& key, uint32_t hash,
+                                      ClockHandle* keep) {
+  bool found = false;
+  for (size_t i = 0; i < num_slots_; i++) {
+    ClockHandle* h = &slots_[Probe(hash, i)];
+    if (h != keep && TryRef(h)) {
+      bool match = h->hash == hash && h->key == key;
+      found = found || match;
+      Unref(h, match /* erase */);
+    }
+    if (h->displacements.load(std::memory_order_relaxed) == 0) {
+      break;
+    }
   }
-  Cleanup(context);
+  return found;
+}
+
+void ClockCacheShard::SetCapacity(size_t capacity) {
+  capacity_.store(capacity, std::memory_order_relaxed);
+  EvictFromClock(0, false /* need_slot */);
 }
 
 void ClockCacheShard::SetStrictCapacityLimit(bool strict_capacity_limit) {
@@ -562,167 +509,187 @@ void ClockCacheShard::SetStrictCapacityLimit(bool strict_capacity_limit) {
                                std::memory_order_relaxed);
 }
 
-CacheHandle* ClockCacheShard::Insert(
-    const Slice& key, uint32_t hash, void* value, size_t charge,
-    void (*deleter)(const Slice& key, void* value), bool hold_reference,
-    CleanupContext* context, bool* overwritten) {
-  assert(overwritten != nullptr && *overwritten == false);
-  size_t total_charge =
-      CacheHandle::CalcTotalCharge(key, charge, metadata_charge_policy_);
-  MutexLock l(&mutex_);
-  bool success = EvictFromCache(total_charge, context);
-  bool strict = strict_capacity_limit_.load(std::memory_order_relaxed);
-  if (!success && (strict || !hold_reference)) {
-    context->to_delete_key.push_back(key.data());
-    if (!hold_reference) {
-      context->to_delete_value.emplace_back(key, value, deleter);
-    }
-    return nullptr;
-  }
-  // Grab available handle from recycle bin. If recycle bin is empty, create
-  // and append new handle to end of circular list.
-  CacheHandle* handle = nullptr;
-  if (!recycle_.empty()) {
-    handle = recycle_.back();
-    recycle_.pop_back();
-  } else {
-    list_.emplace_back();
-    handle = &list_.back();
-  }
-  // Fill handle.
-  handle->key = key;
-  handle->hash = hash;
-  handle->value = value;
-  handle->charge = charge;
-  handle->deleter = deleter;
-  uint32_t flags = hold_reference ? kInCacheBit + kOneRef : kInCacheBit;
-  handle->flags.store(flags, std::memory_order_relaxed);
-  HashTable::accessor accessor;
-  if (table_.find(accessor, CacheKey(key, hash))) {
-    *overwritten = true;
-    CacheHandle* existing_handle = accessor->second;
-    table_.erase(accessor);
-    UnsetInCache(existing_handle, context);
-  }
-  table_.insert(HashTable::value_type(CacheKey(key, hash), handle));
-  if (hold_reference) {
-    pinned_usage_.fetch_add(total_charge, std::memory_order_relaxed);
-  }
-  usage_.fetch_add(total_charge, std::memory_order_relaxed);
-  return handle;
-}
-
 Status ClockCacheShard::Insert(const Slice& key, uint32_t hash, void* value,
                                size_t charge,
                                void (*deleter)(const Slice& key, void* value),
                                Cache::Handle** out_handle,
                                Cache::Priority /*priority*/) {
-  CleanupContext context;
-  HashTable::accessor accessor;
   char* key_data = new char[key.size()];
   memcpy(key_data, key.data(), key.size());
   Slice key_copy(key_data, key.size());
-  bool overwritten = false;
-  CacheHandle* handle = Insert(key_copy, hash, value, charge, deleter,
-                               out_handle != nullptr, &context, &overwritten);
-  Status s;
+  size_t total_charge =
+      ClockHandle::CalcTotalCharge(key_copy, charge, metadata_charge_policy_);
+  bool strict = strict_capacity_limit_.load(std::memory_order_relaxed);
+
+  // Unless the capacity is strict, an entry the caller wants a handle of is
+  // inserted even if nothing could be evicted to make room for it.
+  bool must_fit = strict || out_handle == nullptr;
+  bool has_slot = false;
+  if (EvictFromClock(total_charge, false /* need_slot */) || !must_fit) {
+    has_slot = ReserveSlot();
+  }
+  if (!has_slot && must_fit) {
+    // Don't insert the entry but still return ok, as if the entry inserted
+    // into cache and get evicted immediately.
+    delete[] key_data;
+    if (out_handle == nullptr) {
+      if (deleter != nullptr) {
+        (*deleter)(key, value);
+      }
+      return Status::OK();
+    }
+    *out_handle = nullptr;
+    return Status::Incomplete("Insert failed due to CLOCK cache being full.");
+  }
+
+  usage_.fetch_add(total_charge, std::memory_order_relaxed);
+  uint64_t initial_meta = kVisible;
   if (out_handle != nullptr) {
-    if (handle == nullptr) {
-      s = Status::Incomplete("Insert failed due to LRU cache being full.");
-    } else {
-      *out_handle = reinterpret_cast<Cache::Handle*>(handle);
+    initial_meta += kOneRef;
+    pinned_usage_.fetch_add(total_charge, std::memory_order_relaxed);
+  }
+
+  ClockHandle* h = nullptr;
+  if (has_slot) {
+    // A slot is reserved for us, so an empty one must turn up on the probe
+    // sequence, unless concurrent inserts are momentarily holding claimed
+    // slots that they already gave up on.
+    for (size_t i = 0; i < num_slots_; i++) {
+      ClockHandle* candidate = &slots_[Probe(hash, i)];
+      uint64_t expected = kEmpty;
+      if (candidate->meta.compare_exchange_strong(
+              expected, kConstruction, std::memory_order_acquire,
+              std::memory_order_relaxed)) {
+        h = candidate;
+        break;
+      }
+      candidate->displacements.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (h == nullptr) {
+      // Roll back the displacements of the full probe sequence.
+      for (size_t i = 0; i < num_slots_; i++) {
+        slots_[Probe(hash, i)].displacements.fetch_sub(
+            1, std::memory_order_relaxed);
+      }
+      occupancy_.fetch_sub(1, std::memory_order_relaxed);
     }
   }
-  if (overwritten) {
-    assert(s.ok());
-    s = Status::OkOverwritten();
+  if (h == nullptr) {
+    // Only reachable when the caller asked for a handle and the capacity is
+    // not strict: hand out an entry that lives outside of the table.
+    assert(!must_fit);
+    h = new ClockHandle();
+    h->detached = true;
+    initial_meta = kInvisible + kOneRef;
   }
-  Cleanup(context);
-  return s;
+
+  h->hash = hash;
+  h->key = key_copy;
+  h->value = value;
+  h->charge = charge;
+  h->deleter = deleter;
+  h->meta.store(initial_meta, std::memory_order_release);
+
+  bool overwritten = EraseDuplicates(key_copy, hash, h);
+  if (out_handle != nullptr) {
+    *out_handle = reinterpret_cast<Cache::Handle*>(h);
+  }
+  return overwritten ? Status::OkOverwritten() : Status::OK();
 }
 
 Cache::Handle* ClockCacheShard::Lookup(const Slice& key, uint32_t hash) {
-  HashTable::const_accessor accessor;
-  if (!table_.find(accessor, CacheKey(key, hash))) {
-    return nullptr;
-  }
-  CacheHandle* handle = accessor->second;
-  accessor.release();
-  // Ref() could fail if another thread sneak in and evict/erase the cache
-  // entry before we are able to hold reference.
-  if (!Ref(reinterpret_cast<Cache::Handle*>(handle))) {
-    return nullptr;
-  }
-  // Double check the key since the handle may now representing another key
-  // if other threads sneak in, evict/erase the entry and re-used the handle
-  // for another cache entry.
-  if (hash != handle->hash || key != handle->key) {
-    CleanupContext context;
-    Unref(handle, false, &context);
-    // It is possible Unref() delete the entry, so we need to cleanup.
-    Cleanup(context);
-    return nullptr;
-  }
-  return reinterpret_cast<Cache::Handle*>(handle);
+  for (size_t i = 0; i < num_slots_; i++) {
+    ClockHandle* h = &slots_[Probe(hash, i)];
+    if (TryRef(h)) {
+      // The slot may hold any key, we only know it will not change as long
+      // as we hold the reference.
+      if (h->hash == hash && h->key == key) {
+        // Mark the entry as recently used.
+        if (Countdown(h->meta.load(std::memory_order_relaxed)) <
+            kMaxCountdown) {
+          h->meta.fetch_or(kCountdownMask, std::memory_order_relaxed);
+        }
+        return reinterpret_cast<Cache::Handle*>(h);
+      }
+      Unref(h, false);
+    }
+    if (h->displacements.load(std::memory_order_relaxed) == 0) {
+      break;
+    }
+  }
+  return nullptr;
 }
 
-bool ClockCacheShard::Release(Cache::Handle* h, bool force_erase) {
-  CleanupContext context;
-  CacheHandle* handle = reinterpret_cast<CacheHandle*>(h);
-  bool erased = Unref(handle, true, &context);
-  if (force_erase && !erased) {
-    erased = EraseAndConfirm(handle->key, handle->hash, &context);
-  }
-  Cleanup(context);
-  return erased;
+bool ClockCacheShard::Release(Cache::Handle* handle, bool force_erase) {
+  return Unref(reinterpret_cast<ClockHandle*>(handle), force_erase);
 }
 
 void ClockCacheShard::Erase(const Slice& key, uint32_t hash) {
-  CleanupContext context;
-  EraseAndConfirm(key, hash, &context);
-  Cleanup(context);
+  EraseDuplicates(key, hash, nullptr);
 }
 
-bool ClockCacheShard::EraseAndConfirm(const Slice& key, uint32_t hash,
-                                      CleanupContext* context) {
-  MutexLock l(&mutex_);
-  HashTable::accessor accessor;
-  bool erased = false;
-  if (table_.find(accessor, CacheKey(key, hash))) {
-    CacheHandle* handle = accessor->second;
-    table_.erase(accessor);
-    erased = UnsetInCache(handle, context);
-  }
-  return erased;
+void ClockCacheShard::EraseUnRefEntries() {
+  for (size_t i = 0; i < num_slots_; i++) {
+    ClockHandle* h = &slots_[i];
+    uint64_t meta = h->meta.load(std::memory_order_relaxed);
+    if (State(meta) == kVisible && CountRefs(meta) == 0) {
+      TryFree(h, meta);
+    }
+  }
 }
 
-void ClockCacheShard::EraseUnRefEntries() {
-  CleanupContext context;
-  {
-    MutexLock l(&mutex_);
-    table_.clear();
-    for (auto& handle : list_) {
-      UnsetInCache(&handle, &context);
+void ClockCacheShard::ApplyToAllCacheEntries(void (*callback)(void*, size_t),
+                                             bool thread_safe) {
+  for (size_t i = 0; i < num_slots_; i++) {
+    ClockHandle* h = &slots_[i];
+    if (thread_safe) {
+      if (TryRef(h)) {
+        callback(h->value, h->charge);
+        Unref(h, false);
+      }
+    } else if (State(h->meta.load(std::memory_order_relaxed)) == kVisible) {
+      callback(h->value, h->charge);
+    }
+  }
+}
+
+void ClockCacheShard::ApplyToAllEntries(
+    const std::function<void(const Slice& key, void* value, size_t charge)>&
+        callback) {
+  for (size_t i = 0; i < num_slots_; i++) {
+    ClockHandle* h = &slots_[i];
+    if (TryRef(h)) {
+      callback(h->key, h->value, h->charge);
+      Unref(h, false);
     }
   }
-  Cleanup(context);
 }
 
 class ClockCache final : public ShardedCache {
  public:
   ClockCache(size_t capacity, int num_shard_bits, bool strict_capacity_limit,
-             CacheMetadataChargePolicy metadata_charge_policy)
+             CacheMetadataChargePolicy metadata_charge_policy,
+             size_t estimated_entry_charge)
       : ShardedCache(capacity, num_shard_bits, strict_capacity_limit) {
-    int num_shards = 1 << num_shard_bits;
-    shards_ = new ClockCacheShard[num_shards];
-    for (int i = 0; i < num_shards; i++) {
-      shards_[i].set_metadata_charge_policy(metadata_charge_policy);
+    num_shards_ = 1 << num_shard_bits;
+    shards_ = reinterpret_cast<ClockCacheShard*>(
+        port::cacheline_aligned_alloc(sizeof(ClockCacheShard) * num_shards_));
+    size_t per_shard = (capacity + (num_shards_ - 1)) / num_shards_;
+    for (int i = 0; i < num_shards_; i++) {
+      new (&shards_[i])
+          ClockCacheShard(per_shard, estimated_entry_charge,
+                          strict_capacity_limit, metadata_charge_policy);
     }
-    SetCapacity(capacity);
-    SetStrictCapacityLimit(strict_capacity_limit);
   }
 
-  ~ClockCache() override { delete[] shards_; }
+  ~ClockCache() override {
+    if (shards_ != nullptr) {
+      for (int i = 0; i < num_shards_; i++) {
+        shards_[i].~ClockCacheShard();
+      }
+      port::cacheline_aligned_free(shards_);
+    }
+  }
 
   const char* Name() const override { return "ClockCache"; }
 
@@ -735,33 +702,46 @@ class ClockCache final : public ShardedCache {
   }
 
   void* Value(Handle* handle) override {
-    return reinterpret_cast<const CacheHandle*>(handle)->value;
+    return reinterpret_cast<const ClockHandle*>(handle)->value;
   }
 
   size_t GetCharge(Handle* handle) const override {
-    return reinterpret_cast<const CacheHandle*>(handle)->charge;
+    return reinterpret_cast<const ClockHandle*>(handle)->charge;
   }
 
   uint32_t GetHash(Handle* handle) const override {
-    return reinterpret_cast<const CacheHandle*>(handle)->hash;
+    return reinterpret_cast<const ClockHandle*>(handle)->hash;
   }
 
-  void DisownData() override { shards_ = nullptr; }
+  void DisownData() override {
+    shards_ = nullptr;
+    num_shards_ = 0;
+  }
 
  private:
-  ClockCacheShard* shards_;
+  ClockCacheShard* shards_ = nullptr;
+  int num_shards_ = 0;
 };
 
 }  // end anonymous namespace
 
 std::shared_ptr<Cache> NewClockCache(
     size_t capacity, int num_shard_bits, bool strict_capacity_limit,
-    CacheMetadataChargePolicy metadata_charge_policy) {
+    CacheMetadataChargePolicy metadata_charge_policy,
+    size_t estimated_entry_charge) {
+  if (num_shard_bits >= 20) {
+    return nullptr;  // the cache cannot be sharded into too many fine pieces
+  }
   if (num_shard_bits < 0) {
     num_shard_bits = GetDefaultCacheShardBits(capacity);
   }
-  return std::make_shared<ClockCache>(
-      capacity, num_shard_bits, strict_capacity_limit, metadata_charge_policy);
+  if (estimated_entry_charge == 0) {
+    estimated_entry_charge = kDefaultClockCacheEstimatedEntryCharge;
+  }
+  return std::make_shared<ClockCache>(capacity, num_shard_bits,
+                                      strict_capacity_limit,
+                                      metadata_charge_policy,
+                                      estimated_entry_charge);
 }
 
 }  // namespace ROCKSDB_NAMESPACE
@@ -0,0 +1,154 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "cache/compressed_secondary_cache.h"
+
+#include <stdio.h>
+#include <string>
+
+#include "memory/memory_allocator.h"
+#include "util/compression.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+namespace {
+
+// Same format version as the block based table, the uncompressed size is
+// encoded in front of the compressed data.
+const uint32_t kCompressFormatVersion = 2;
+
+void DeleteEntry(const Slice& /*key*/, void* value) {
+  delete reinterpret_cast<std::string*>(value);
+}
+
+// Same threshold as the block based table builder: keep the compressed form
+// only if it saves at least 12.5%.
+bool GoodCompressionRatio(size_t compressed_size, size_t raw_size) {
+  return compressed_size < raw_size - (raw_size / 8u);
+}
+
+}  // namespace
+
+CompressedSecondaryCache::CompressedSecondaryCache(
+    const CompressedSecondaryCacheOptions& opts)
+    : opts_(opts) {
+  if (!CompressionTypeSupported(opts_.compression_type)) {
+    opts_.compression_type = kNoCompression;
+  }
+  cache_ = NewLRUCache(opts_.capacity, opts_.num_shard_bits,
+                       false /* strict_capacity_limit */,
+                       0.0 /* high_pri_pool_ratio */, nullptr,
+                       kDefaultToAdaptiveMutex, opts_.metadata_charge_policy);
+}
+
+CompressedSecondaryCache::~CompressedSecondaryCache() {}
+
+Status CompressedSecondaryCache::Insert(const Slice& key, void* value,
+                                        const Cache::CacheItemHelper* helper) {
+  assert(helper != nullptr);
+  if (helper->size_cb == nullptr || helper->saveto_cb == nullptr) {
+    return Status::InvalidArgument("Entry is not secondary cache compatible");
+  }
+  size_t size = (*helper->size_cb)(value);
+  std::string raw;
+  raw.resize(size);
+  Status s = (*helper->saveto_cb)(value, 0, size, &raw[0]);
+  if (!s.ok()) {
+    return s;
+  }
+
+  CompressionType type = opts_.compression_type;
+  std::string compressed;
+  if (type != kNoCompression) {
+    CompressionOptions compression_opts;
+    CompressionContext context(type);
+    CompressionInfo info(compression_opts, context,
+                         CompressionDict::GetEmptyDict(), type,
+                         0 /* sample_for_compression */);
+    if (!CompressData(raw, info, kCompressFormatVersion, &compressed) ||
+        !GoodCompressionRatio(compressed.size(), raw.size())) {
+      type = kNoCompression;
+    }
+  }
+  const std::string& payload = type == kNoCompression ? raw : compressed;
+  std::unique_ptr<std::string> entry(new std::string);
+  entry->reserve(payload.size() + 1);
+  entry->push_back(static_cast<char>(type));
+  entry->append(payload);
+
+  size_t charge = entry->size();
+  s = cache_->Insert(key, entry.get(), charge, &DeleteEntry);
+  if (s.ok()) {
+    entry.release();
+  }
+  return s;
+}
+
+Status CompressedSecondaryCache::Lookup(const Slice& key,
+                                        const Cache::CreateCallback& create_cb,
+                                        void** value, size_t* charge) {
+  assert(value != nullptr);
+  assert(charge != nullptr);
+  Cache::Handle* handle = cache_->Lookup(key);
+  if (handle == nullptr) {
+    return Status::NotFound();
+  }
+
+  const std::string* entry =
+      reinterpret_cast<const std::string*>(cache_->Value(handle));
+  assert(!entry->empty());
+  CompressionType type = static_cast<CompressionType>((*entry)[0]);
+  const char* data = entry->data() + 1;
+  size_t size = entry->size() - 1;
+
+  Status s;
+  CacheAllocationPtr uncompressed;
+  if (type != kNoCompression) {
+    UncompressionContext context(type);
+    UncompressionInfo info(context, UncompressionDict::GetEmptyDict(), type);
+    size_t uncompressed_size = 0;
+    uncompressed =
+        UncompressData(info, data, size, &uncompressed_size,
+                       kCompressFormatVersion, opts_.memory_allocator.get());
+    if (!uncompressed) {
+      s = Status::Corruption("Failed to uncompress secondary cache entry");
+    }
+    data = uncompressed.get();
+    size = uncompressed_size;
+  }
+  if (s.ok()) {
+    s = create_cb(data, size, value, charge);
+  }
+  uncompressed.reset();
+  cache_->Release(handle);
+  if (s.ok()) {
+    // The caller promotes the object to the primary cache.
+    cache_->Erase(key);
+  }
+  return s;
+}
+
+void CompressedSecondaryCache::Erase(const Slice& key) { cache_->Erase(key); }
+
+std::string CompressedSecondaryCache::GetPrintableOptions() const {
+  std::string ret;
+  const int kBufferSize = 200;
+  char buffer[kBufferSize];
+  snprintf(buffer, kBufferSize, "    compression_type : %s\n",
+           CompressionTypeToString(opts_.compression_type).c_str());
+  ret.append(buffer);
+  ret.append(cache_->GetPrintableOptions());
+  return ret;
+}
+
+std::shared_ptr<SecondaryCache> NewCompressedSecondaryCache(
+    const CompressedSecondaryCacheOptions& opts) {
+  if (opts.num_shard_bits >= 20) {
+    return nullptr;  // the cache cannot be sharded into too many fine pieces
+  }
+  return std::make_shared<CompressedSecondaryCache>(opts);
+}
+
+}  // namespace ROCKSDB_NAMESPACE
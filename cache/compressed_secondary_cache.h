@@ -0,0 +1,51 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "rocksdb/cache.h"
+#include "rocksdb/secondary_cache.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+// An in-memory SecondaryCache which keeps the serialized entries in an
+// LRUCache, compressed with CompressedSecondaryCacheOptions::compression_type.
+//
+// Each cached value is a string whose first byte is the CompressionType of
+// the rest of it. Entries are erased on a successful Lookup(), since the
+// primary cache owns them again after the promotion.
+class CompressedSecondaryCache : public SecondaryCache {
+ public:
+  explicit CompressedSecondaryCache(
+      const CompressedSecondaryCacheOptions& opts);
+  virtual ~CompressedSecondaryCache() override;
+
+  virtual const char* Name() const override {
+    return "CompressedSecondaryCache";
+  }
+
+  virtual Status Insert(const Slice& key, void* value,
+                        const Cache::CacheItemHelper* helper) override;
+
+  virtual Status Lookup(const Slice& key,
+                        const Cache::CreateCallback& create_cb, void** value,
+                        size_t* charge) override;
+
+  virtual void Erase(const Slice& key) override;
+
+  virtual std::string GetPrintableOptions() const override;
+
+  // The cache holding the compressed entries, for unit tests.
+  Cache* TEST_GetCache() const { return cache_.get(); }
+
+ private:
+  std::shared_ptr<Cache> cache_;
+  CompressedSecondaryCacheOptions opts_;
+};
+
+}  // namespace ROCKSDB_NAMESPACE
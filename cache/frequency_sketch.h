@@ -0,0 +1,127 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+
+#include "rocksdb/rocksdb_namespace.h"
+#include "util/math.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+// A count-min sketch that estimates how often a hash was seen recently, used
+// as the TinyLFU admission filter of LRUCacheShard.
+//
+// Each 64-bit word of the table holds 16 4-bit counters. A hash selects one
+// group of 4 counters in each of 4 words, and its frequency is the minimum of
+// these counters. After sample_size increments, every counter is halved so
+// that the sketch ages out entries which are no longer popular.
+//
+// This class is not thread-safe.
+class FrequencySketch {
+ public:
+  FrequencySketch() : table_mask_(0), sample_size_(0), size_(0) {}
+
+  // Size the sketch for about max_entries distinct hashes. All counters are
+  // reset.
+  void EnsureCapacity(size_t max_entries) {
+    size_t length = 64;
+    while (length < max_entries && length < (size_t{1} << 30)) {
+      length <<= 1;
+    }
+    table_.reset(new uint64_t[length]());
+    table_mask_ = length - 1;
+    sample_size_ = 10 * length;
+    size_ = 0;
+  }
+
+  bool IsInitialized() const { return table_ != nullptr; }
+
+  // Estimated number of recent occurrences of hash, in [0, 15].
+  uint32_t Frequency(uint32_t hash) const {
+    if (table_ == nullptr) {
+      return 0;
+    }
+    uint64_t h = Spread(hash);
+    uint32_t start = static_cast<uint32_t>(h & 3) << 2;
+    uint32_t frequency = kMaxCount;
+    for (uint32_t i = 0; i < 4; i++) {
+      uint64_t word = table_[IndexOf(h, i)];
+      uint32_t count =
+          static_cast<uint32_t>(word >> ((start + i) << 2)) & kMaxCount;
+      if (count < frequency) {
+        frequency = count;
+      }
+    }
+    return frequency;
+  }
+
+  // Record one occurrence of hash.
+  void Increment(uint32_t hash) {
+    if (table_ == nullptr) {
+      return;
+    }
+    uint64_t h = Spread(hash);
+    uint32_t start = static_cast<uint32_t>(h & 3) << 2;
+    bool added = false;
+    for (uint32_t i = 0; i < 4; i++) {
+      added |= IncrementAt(IndexOf(h, i), start + i);
+    }
+    if (added && ++size_ >= sample_size_) {
+      Age();
+    }
+  }
+
+  // Halve all counters.
+  void Age() {
+    uint64_t odd = 0;
+    for (size_t i = 0; i <= table_mask_; i++) {
+      odd += static_cast<uint64_t>(BitsSetToOne(table_[i] & kOneMask));
+      table_[i] = (table_[i] >> 1) & kResetMask;
+    }
+    size_ = (size_ - (odd >> 2)) >> 1;
+  }
+
+ private:
+  static const uint32_t kMaxCount = 15;
+  static const uint64_t kResetMask = 0x7777777777777777ULL;
+  static const uint64_t kOneMask = 0x1111111111111111ULL;
+
+  static uint64_t Spread(uint32_t hash) {
+    uint64_t h = (hash + 0x9E3779B97F4A7C15ULL) * 0xBF58476D1CE4E5B9ULL;
+    return h ^ (h >> 31);
+  }
+
+  size_t IndexOf(uint64_t h, uint32_t i) const {
+    static const uint64_t kSeeds[4] = {0xc3a5c85c97cb3127ULL,
+                                       0xb492b66fbe98f273ULL,
+                                       0x9ae16a3b2f90404fULL,
+                                       0xcbf29ce484222325ULL};
+    uint64_t x = (h + kSeeds[i]) * kSeeds[i];
+    x += x >> 32;
+    return static_cast<size_t>(x) & table_mask_;
+  }
+
+  // Increment the counter_index-th 4-bit counter of table_[i], unless it is
+  // saturated. Return true if it was incremented.
+  bool IncrementAt(size_t i, uint32_t counter_index) {
+    uint32_t offset = counter_index << 2;
+    uint64_t mask = uint64_t{kMaxCount} << offset;
+    if ((table_[i] & mask) != mask) {
+      table_[i] += uint64_t{1} << offset;
+      return true;
+    }
+    return false;
+  }
+
+  std::unique_ptr<uint64_t[]> table_;
+  size_t table_mask_;
+  size_t sample_size_;
+  size_t size_;
+};
+
+}  // namespace ROCKSDB_NAMESPACE
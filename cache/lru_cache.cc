@@ -12,12 +12,23 @@
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <algorithm>
 #include <string>
 
+#include "monitoring/statistics.h"
+#include "rocksdb/memory_allocator.h"
 #include "util/mutexlock.h"
 
 namespace ROCKSDB_NAMESPACE {
 
+const std::string kDefaultCachePartitionName = "default";
+
+namespace {
+// The frequency sketch is sized for the number of entries the capacity
+// holds if they are of about the size of a data block.
+const size_t kTinyLFUEstimatedEntryCharge = 4 << 10;
+}  // namespace
+
 LRUHandleTable::LRUHandleTable() : list_(nullptr), length_(0), elems_(0) {
   Resize();
 }
@@ -98,20 +109,43 @@ void LRUHandleTable::Resize() {
 LRUCacheShard::LRUCacheShard(size_t capacity, bool strict_capacity_limit,
                              double high_pri_pool_ratio,
                              bool use_adaptive_mutex,
-                             CacheMetadataChargePolicy metadata_charge_policy)
+                             CacheMetadataChargePolicy metadata_charge_policy,
+                             SecondaryCache* secondary_cache,
+                             bool tiny_lfu_admission,
+                             const std::vector<CachePartitionOptions>& partitions,
+                             int num_shards)
     : capacity_(0),
-      high_pri_pool_usage_(0),
       strict_capacity_limit_(strict_capacity_limit),
       high_pri_pool_ratio_(high_pri_pool_ratio),
-      high_pri_pool_capacity_(0),
+      secondary_cache_(secondary_cache),
+      tiny_lfu_admission_(tiny_lfu_admission),
       usage_(0),
       lru_usage_(0),
+      partitions_(partitions.size() + 1),
       mutex_(use_adaptive_mutex) {
   set_metadata_charge_policy(metadata_charge_policy);
-  // Make empty circular linked list
-  lru_.next = &lru_;
-  lru_.prev = &lru_;
-  lru_low_pri_ = &lru_;
+  assert(num_shards > 0);
+  for (size_t i = 0; i < partitions_.size(); i++) {
+    Partition& p = partitions_[i];
+    // Make empty circular linked list
+    p.lru.next = &p.lru;
+    p.lru.prev = &p.lru;
+    p.lru_low_pri = &p.lru;
+    p.usage = 0;
+    p.lru_usage = 0;
+    p.high_pri_pool_usage = 0;
+    p.high_pri_pool_capacity = 0;
+    p.reserved_capacity = 0;
+    p.max_capacity = 0;
+    if (i > 0) {
+      // Round up, so that the sum over the shards is not below the options.
+      const CachePartitionOptions& opts = partitions[i - 1];
+      p.reserved_capacity = (opts.reserved_capacity + num_shards - 1) /
+                            static_cast<size_t>(num_shards);
+      p.max_capacity =
+          (opts.max_capacity + num_shards - 1) / static_cast<size_t>(num_shards);
+    }
+  }
   SetCapacity(capacity);
 }
 
@@ -119,17 +153,17 @@ void LRUCacheShard::EraseUnRefEntries() {
   autovector<LRUHandle*> last_reference_list;
   {
     MutexLock l(&mutex_);
-    while (lru_.next != &lru_) {
-      LRUHandle* old = lru_.next;
-      // LRU list contains only elements which can be evicted
-      assert(old->InCache() && !old->HasRefs());
-      LRU_Remove(old);
-      table_.Remove(old->key(), old->hash);
-      old->SetInCache(false);
-      size_t total_charge = old->CalcTotalCharge(metadata_charge_policy_);
-      assert(usage_ >= total_charge);
-      usage_ -= total_charge;
-      last_reference_list.push_back(old);
+    for (Partition& p : partitions_) {
+      while (p.lru.next != &p.lru) {
+        LRUHandle* old = p.lru.next;
+        // LRU list contains only elements which can be evicted
+        assert(old->InCache() && !old->HasRefs());
+        LRU_Remove(old);
+        table_.Remove(old->key(), old->hash);
+        old->SetInCache(false);
+        SubtractUsage(old, old->CalcTotalCharge(metadata_charge_policy_));
+        last_reference_list.push_back(old);
+      }
     }
   }
 
@@ -153,19 +187,30 @@ void LRUCacheShard::ApplyToAllCacheEntries(void (*callback)(void*, size_t),
   }
 }
 
+void LRUCacheShard::ApplyToAllEntries(
+    const std::function<void(const Slice& key, void* value, size_t charge)>&
+        callback) {
+  MutexLock l(&mutex_);
+  table_.ApplyToAllCacheEntries([&callback](LRUHandle* h) {
+    callback(h->key(), h->value, h->charge);
+  });
+}
+
 void LRUCacheShard::TEST_GetLRUList(LRUHandle** lru, LRUHandle** lru_low_pri) {
   MutexLock l(&mutex_);
-  *lru = &lru_;
-  *lru_low_pri = lru_low_pri_;
+  *lru = &partitions_[0].lru;
+  *lru_low_pri = partitions_[0].lru_low_pri;
 }
 
 size_t LRUCacheShard::TEST_GetLRUSize() {
   MutexLock l(&mutex_);
-  LRUHandle* lru_handle = lru_.next;
   size_t lru_size = 0;
-  while (lru_handle != &lru_) {
-    lru_size++;
-    lru_handle = lru_handle->next;
+  for (const Partition& p : partitions_) {
+    const LRUHandle* lru_handle = p.lru.next;
+    while (lru_handle != &p.lru) {
+      lru_size++;
+      lru_handle = lru_handle->next;
+    }
   }
   return lru_size;
 }
@@ -178,8 +223,9 @@ double LRUCacheShard::GetHighPriPoolRatio() {
 void LRUCacheShard::LRU_Remove(LRUHandle* e) {
   assert(e->next != nullptr);
   assert(e->prev != nullptr);
-  if (lru_low_pri_ == e) {
-    lru_low_pri_ = e->prev;
+  Partition& p = partitions_[e->partition];
+  if (p.lru_low_pri == e) {
+    p.lru_low_pri = e->prev;
   }
   e->next->prev = e->prev;
   e->prev->next = e->next;
@@ -187,9 +233,11 @@ void LRUCacheShard::LRU_Remove(LRUHandle* e) {
   size_t total_charge = e->CalcTotalCharge(metadata_charge_policy_);
   assert(lru_usage_ >= total_charge);
   lru_usage_ -= total_charge;
+  assert(p.lru_usage >= total_charge);
+  p.lru_usage -= total_charge;
   if (e->InHighPriPool()) {
-    assert(high_pri_pool_usage_ >= total_charge);
-    high_pri_pool_usage_ -= total_charge;
+    assert(p.high_pri_pool_usage >= total_charge);
+    p.high_pri_pool_usage -= total_charge;
   }
 }
 
@@ -197,68 +245,149 @@ void LRUCacheShard::LRU_Insert(LRUHandle* e) {
   assert(e->next == nullptr);
   assert(e->prev == nullptr);
   size_t total_charge = e->CalcTotalCharge(metadata_charge_policy_);
+  Partition& p = partitions_[e->partition];
   if (high_pri_pool_ratio_ > 0 && (e->IsHighPri() || e->HasHit())) {
     // Inset "e" to head of LRU list.
-    e->next = &lru_;
-    e->prev = lru_.prev;
+    e->next = &p.lru;
+    e->prev = p.lru.prev;
     e->prev->next = e;
     e->next->prev = e;
     e->SetInHighPriPool(true);
-    high_pri_pool_usage_ += total_charge;
-    MaintainPoolSize();
+    p.high_pri_pool_usage += total_charge;
+    MaintainPoolSize(&p);
   } else {
     // Insert "e" to the head of low-pri pool. Note that when
     // high_pri_pool_ratio is 0, head of low-pri pool is also head of LRU list.
-    e->next = lru_low_pri_->next;
-    e->prev = lru_low_pri_;
+    e->next = p.lru_low_pri->next;
+    e->prev = p.lru_low_pri;
     e->prev->next = e;
     e->next->prev = e;
     e->SetInHighPriPool(false);
-    lru_low_pri_ = e;
+    p.lru_low_pri = e;
   }
   lru_usage_ += total_charge;
+  p.lru_usage += total_charge;
 }
 
-void LRUCacheShard::MaintainPoolSize() {
-  while (high_pri_pool_usage_ > high_pri_pool_capacity_) {
+void LRUCacheShard::MaintainPoolSize(Partition* p) {
+  while (p->high_pri_pool_usage > p->high_pri_pool_capacity) {
     // Overflow last entry in high-pri pool to low-pri pool.
-    lru_low_pri_ = lru_low_pri_->next;
-    assert(lru_low_pri_ != &lru_);
-    lru_low_pri_->SetInHighPriPool(false);
+    p->lru_low_pri = p->lru_low_pri->next;
+    assert(p->lru_low_pri != &p->lru);
+    p->lru_low_pri->SetInHighPriPool(false);
     size_t total_charge =
-        lru_low_pri_->CalcTotalCharge(metadata_charge_policy_);
-    assert(high_pri_pool_usage_ >= total_charge);
-    high_pri_pool_usage_ -= total_charge;
+        p->lru_low_pri->CalcTotalCharge(metadata_charge_policy_);
+    assert(p->high_pri_pool_usage >= total_charge);
+    p->high_pri_pool_usage -= total_charge;
+  }
+}
+
+void LRUCacheShard::UpdateHighPriPoolCapacity() {
+  for (Partition& p : partitions_) {
+    size_t capacity = p.max_capacity == 0
+                          ? capacity_
+                          : std::min(p.max_capacity, capacity_);
+    p.high_pri_pool_capacity = capacity * high_pri_pool_ratio_;
+    MaintainPoolSize(&p);
   }
 }
 
 void LRUCacheShard::EvictFromLRU(size_t charge,
-                                 autovector<LRUHandle*>* deleted) {
-  while ((usage_ + charge) > capacity_ && lru_.next != &lru_) {
-    LRUHandle* old = lru_.next;
+                                 autovector<LRUHandle*>* deleted,
+                                 int partition) {
+  while ((usage_ + charge) > capacity_) {
+    LRUHandle* old = GetEvictionCandidate(partition, charge);
+    if (old == nullptr) {
+      break;
+    }
     // LRU list contains only elements which can be evicted
     assert(old->InCache() && !old->HasRefs());
     LRU_Remove(old);
     table_.Remove(old->key(), old->hash);
     old->SetInCache(false);
-    size_t old_total_charge = old->CalcTotalCharge(metadata_charge_policy_);
-    assert(usage_ >= old_total_charge);
-    usage_ -= old_total_charge;
+    SubtractUsage(old, old->CalcTotalCharge(metadata_charge_policy_));
     deleted->push_back(old);
   }
 }
 
+LRUHandle* LRUCacheShard::GetEvictionCandidate(int partition,
+                                               size_t charge) const {
+  if (partitions_.size() == 1) {
+    const Partition& p = partitions_[0];
+    return p.lru.next != &p.lru ? p.lru.next : nullptr;
+  }
+  // Rank the partitions by how far they are over their max capacity, then
+  // over their reserved capacity, then by usage, counting the charge of the
+  // entry being inserted.
+  const Partition* victim = nullptr;
+  int victim_rank = -1;
+  size_t victim_excess = 0;
+  for (size_t i = 0; i < partitions_.size(); i++) {
+    const Partition& p = partitions_[i];
+    if (p.lru.next == &p.lru) {
+      continue;
+    }
+    size_t usage =
+        p.usage + (static_cast<size_t>(partition) == i ? charge : 0);
+    size_t max_capacity = p.max_capacity == 0 ? capacity_ : p.max_capacity;
+    int rank;
+    size_t excess;
+    if (usage > max_capacity) {
+      rank = 2;
+      excess = usage - max_capacity;
+    } else if (usage > p.reserved_capacity) {
+      rank = 1;
+      excess = usage - p.reserved_capacity;
+    } else {
+      rank = 0;
+      excess = usage;
+    }
+    if (rank > victim_rank || (rank == victim_rank && excess > victim_excess)) {
+      victim = &p;
+      victim_rank = rank;
+      victim_excess = excess;
+    }
+  }
+  return victim != nullptr ? victim->lru.next : nullptr;
+}
+
+bool LRUCacheShard::Admit(LRUHandle* e) const {
+  if (!tiny_lfu_admission_ || e->IsHighPri()) {
+    return true;
+  }
+  LRUHandle* victim = GetEvictionCandidate(
+      e->partition, e->CalcTotalCharge(metadata_charge_policy_));
+  if (victim == nullptr) {
+    return true;
+  }
+  // Ties go to the victim, so that keys seen once do not replace each other.
+  return sketch_.Frequency(e->hash) > sketch_.Frequency(victim->hash);
+}
+
+void LRUCacheShard::SaveToSecondaryCache(LRUHandle* e) {
+  if (secondary_cache_ != nullptr && e->IsSecondaryCacheCompatible()) {
+    // Failing to save the entry is the same as evicting it without a
+    // secondary cache.
+    secondary_cache_->Insert(e->key(), e->value, e->helper)
+        .PermitUncheckedError();
+  }
+}
+
 void LRUCacheShard::SetCapacity(size_t capacity) {
   autovector<LRUHandle*> last_reference_list;
   {
     MutexLock l(&mutex_);
     capacity_ = capacity;
-    high_pri_pool_capacity_ = capacity_ * high_pri_pool_ratio_;
+    UpdateHighPriPoolCapacity();
+    if (tiny_lfu_admission_) {
+      sketch_.EnsureCapacity(capacity_ / kTinyLFUEstimatedEntryCharge);
+    }
     EvictFromLRU(0, &last_reference_list);
   }
 
   // Free the entries outside of mutex for performance reasons
   for (auto entry : last_reference_list) {
+    SaveToSecondaryCache(entry);
     entry->Free();
   }
 }
@@ -270,6 +399,10 @@ void LRUCacheShard::SetStrictCapacityLimit(bool strict_capacity_limit) {
 
 Cache::Handle* LRUCacheShard::Lookup(const Slice& key, uint32_t hash) {
   MutexLock l(&mutex_);
+  if (tiny_lfu_admission_) {
+    // Count misses too, as a missed key is usually inserted right after.
+    sketch_.Increment(hash);
+  }
   LRUHandle* e = table_.Lookup(key, hash);
   if (e != nullptr) {
     assert(e->InCache());
@@ -283,6 +416,38 @@ Cache::Handle* LRUCacheShard::Lookup(const Slice& key, uint32_t hash) {
   return reinterpret_cast<Cache::Handle*>(e);
 }
 
+Cache::Handle* LRUCacheShard::Lookup(const Slice& key, uint32_t hash,
+                                     const Cache::CacheItemHelper* helper,
+                                     const Cache::CreateCallback& create_cb,
+                                     Cache::Priority priority,
+                                     Statistics* stats) {
+  Cache::Handle* handle = Lookup(key, hash);
+  if (handle != nullptr || secondary_cache_ == nullptr || helper == nullptr ||
+      !create_cb) {
+    return handle;
+  }
+
+  void* value = nullptr;
+  size_t charge = 0;
+  Status s = secondary_cache_->Lookup(key, create_cb, &value, &charge);
+  if (!s.ok()) {
+    RecordTick(stats, SECONDARY_CACHE_MISSES);
+    return nullptr;
+  }
+  RecordTick(stats, SECONDARY_CACHE_HITS);
+
+  // Promote the entry. If another thread promoted the same key concurrently,
+  // this one overwrites it, which is harmless.
+  s = Insert(key, hash, value, charge, helper->del_cb, helper, &handle,
+             priority);
+  if (!s.ok()) {
+    assert(handle == nullptr);
+    (*helper->del_cb)(key, value);
+    return nullptr;
+  }
+  return handle;
+}
+
 bool LRUCacheShard::Ref(Cache::Handle* h) {
   LRUHandle* e = reinterpret_cast<LRUHandle*>(h);
   MutexLock l(&mutex_);
@@ -295,8 +460,7 @@ bool LRUCacheShard::Ref(Cache::Handle* h) {
 void LRUCacheShard::SetHighPriorityPoolRatio(double high_pri_pool_ratio) {
   MutexLock l(&mutex_);
   high_pri_pool_ratio_ = high_pri_pool_ratio;
-  high_pri_pool_capacity_ = capacity_ * high_pri_pool_ratio_;
-  MaintainPoolSize();
+  UpdateHighPriPoolCapacity();
 }
 
 bool LRUCacheShard::Release(Cache::Handle* handle, bool force_erase) {
@@ -305,14 +469,16 @@ bool LRUCacheShard::Release(Cache::Handle* handle, bool force_erase) {
   }
   LRUHandle* e = reinterpret_cast<LRUHandle*>(handle);
   bool last_reference = false;
+  bool evicted = false;
   {
     MutexLock l(&mutex_);
     last_reference = e->Unref();
     if (last_reference && e->InCache()) {
       // The item is still in cache, and nobody else holds a reference to it
       if (usage_ > capacity_ || force_erase) {
-        // The LRU list must be empty since the cache is full
-        assert(lru_.next == &lru_ || force_erase);
+        evicted = !force_erase;
+        // The LRU lists must be empty since the cache is full
+        assert(GetEvictionCandidate(0, 0) == nullptr || force_erase);
         // Take this opportunity and remove the item
         table_.Remove(e->key(), e->hash);
         e->SetInCache(false);
@@ -323,13 +489,14 @@ bool LRUCacheShard::Release(Cache::Handle* handle, bool force_erase) {
       }
     }
     if (last_reference) {
-      size_t total_charge = e->CalcTotalCharge(metadata_charge_policy_);
-      assert(usage_ >= total_charge);
-      usage_ -= total_charge;
+      SubtractUsage(e, e->CalcTotalCharge(metadata_charge_policy_));
     }
   }
 
   // Free the entry here outside of mutex for performance reasons
+  if (evicted) {
+    SaveToSecondaryCache(e);
+  }
   if (last_reference) {
     e->Free();
   }
@@ -340,19 +507,51 @@ Status LRUCacheShard::Insert(const Slice& key, uint32_t hash, void* value,
                              size_t charge,
                              void (*deleter)(const Slice& key, void* value),
                              Cache::Handle** handle, Cache::Priority priority) {
+  return Insert(key, hash, value, charge, deleter, nullptr, handle, priority);
+}
+
+Status LRUCacheShard::Insert(const Slice& key, uint32_t hash, void* value,
+                             const Cache::CacheItemHelper* helper,
+                             size_t charge, Cache::Handle** handle,
+                             Cache::Priority priority) {
+  assert(helper != nullptr);
+  return Insert(key, hash, value, charge, helper->del_cb, helper, handle,
+                priority);
+}
+
+Status LRUCacheShard::InsertIntoPartition(
+    const Slice& key, uint32_t hash, void* value, size_t charge,
+    void (*deleter)(const Slice& key, void* value),
+    const Cache::CacheItemHelper* helper, Cache::Handle** handle,
+    Cache::Priority priority, int partition) {
+  return Insert(key, hash, value, charge, deleter, helper, handle, priority,
+                partition);
+}
+
+Status LRUCacheShard::Insert(const Slice& key, uint32_t hash, void* value,
+                             size_t charge,
+                             void (*deleter)(const Slice& key, void* value),
+                             const Cache::CacheItemHelper* helper,
+                             Cache::Handle** handle, Cache::Priority priority,
+                             int partition) {
+  assert(partition >= 0 &&
+         static_cast<size_t>(partition) < partitions_.size());
   // Allocate the memory here outside of the mutex
   // If the cache is full, we'll have to release it
   // It shouldn't happen very often though.
   LRUHandle* e = reinterpret_cast<LRUHandle*>(
       new char[sizeof(LRUHandle) - 1 + key.size()]);
   Status s = Status::OK();
+  autovector<LRUHandle*> evicted_list;
   autovector<LRUHandle*> last_reference_list;
 
   e->value = value;
   e->deleter = deleter;
+  e->helper = helper;
   e->charge = charge;
   e->key_length = key.size();
   e->flags = 0;
+  e->partition = static_cast<uint8_t>(partition);
   e->hash = hash;
   e->refs = 0;
   e->next = e->prev = nullptr;
@@ -364,12 +563,22 @@ Status LRUCacheShard::Insert(const Slice& key, uint32_t hash, void* value,
   {
     MutexLock l(&mutex_);
 
-    // Free the space following strict LRU policy until enough space
-    // is freed or the lru list is empty
-    EvictFromLRU(total_charge, &last_reference_list);
+    bool admitted = (usage_ + total_charge) <= capacity_ || Admit(e);
+    if (admitted) {
+      // Free the space following strict LRU policy until enough space
+      // is freed or the lru list is empty
+      EvictFromLRU(total_charge, &evicted_list, partition);
+    }
 
-    if ((usage_ + total_charge) > capacity_ &&
-        (strict_capacity_limit_ || handle == nullptr)) {
+    if (!admitted && handle != nullptr && !strict_capacity_limit_) {
+      // Hand out the entry without putting it into the cache, as if it was
+      // inserted and then erased. It is freed on last Release().
+      e->SetInCache(false);
+      e->Ref();
+      AddUsage(e, total_charge);
+      *handle = reinterpret_cast<Cache::Handle*>(e);
+    } else if (!admitted || ((usage_ + total_charge) > capacity_ &&
+                             (strict_capacity_limit_ || handle == nullptr))) {
       if (handle == nullptr) {
         // Don't insert the entry but still return ok, as if the entry inserted
         // into cache and get evicted immediately.
@@ -384,7 +593,7 @@ Status LRUCacheShard::Insert(const Slice& key, uint32_t hash, void* value,
       // Insert into the cache. Note that the cache might get larger than its
       // capacity if not enough space was freed up.
       LRUHandle* old = table_.Insert(e);
-      usage_ += total_charge;
+      AddUsage(e, total_charge);
       if (old != nullptr) {
         s = Status::OkOverwritten();
         assert(old->InCache());
@@ -392,10 +601,7 @@ Status LRUCacheShard::Insert(const Slice& key, uint32_t hash, void* value,
         if (!old->HasRefs()) {
           // old is on LRU because it's in cache and its reference count is 0
           LRU_Remove(old);
-          size_t old_total_charge =
-              old->CalcTotalCharge(metadata_charge_policy_);
-          assert(usage_ >= old_total_charge);
-          usage_ -= old_total_charge;
+          SubtractUsage(old, old->CalcTotalCharge(metadata_charge_policy_));
           last_reference_list.push_back(old);
         }
       }
@@ -409,6 +615,10 @@ Status LRUCacheShard::Insert(const Slice& key, uint32_t hash, void* value,
   }
 
   // Free the entries here outside of mutex for performance reasons
+  for (auto entry : evicted_list) {
+    SaveToSecondaryCache(entry);
+    entry->Free();
+  }
   for (auto entry : last_reference_list) {
     entry->Free();
   }
@@ -428,9 +638,7 @@ void LRUCacheShard::Erase(const Slice& key, uint32_t hash) {
       if (!e->HasRefs()) {
         // The entry is in LRU since it's in hash and has no external references
         LRU_Remove(e);
-        size_t total_charge = e->CalcTotalCharge(metadata_charge_policy_);
-        assert(usage_ >= total_charge);
-        usage_ -= total_charge;
+        SubtractUsage(e, e->CalcTotalCharge(metadata_charge_policy_));
         last_reference = true;
       }
     }
@@ -454,13 +662,27 @@ size_t LRUCacheShard::GetPinnedUsage() const {
   return usage_ - lru_usage_;
 }
 
+void LRUCacheShard::AddPartitionUsage(int partition, size_t* usage,
+                                      size_t* pinned_usage) const {
+  MutexLock l(&mutex_);
+  if (partition < 0 || static_cast<size_t>(partition) >= partitions_.size()) {
+    return;
+  }
+  const Partition& p = partitions_[partition];
+  assert(p.usage >= p.lru_usage);
+  *usage += p.usage;
+  *pinned_usage += p.usage - p.lru_usage;
+}
+
 std::string LRUCacheShard::GetPrintableOptions() const {
   const int kBufferSize = 200;
   char buffer[kBufferSize];
   {
     MutexLock l(&mutex_);
-    snprintf(buffer, kBufferSize, "    high_pri_pool_ratio: %.3lf\n",
-             high_pri_pool_ratio_);
+    snprintf(buffer, kBufferSize,
+             "    high_pri_pool_ratio: %.3lf\n"
+             "    tiny_lfu_admission: %d\n",
+             high_pri_pool_ratio_, tiny_lfu_admission_);
   }
   return std::string(buffer);
 }
@@ -469,36 +691,66 @@ LRUCache::LRUCache(size_t capacity, int num_shard_bits,
                    bool strict_capacity_limit, double high_pri_pool_ratio,
                    std::shared_ptr<MemoryAllocator> allocator,
                    bool use_adaptive_mutex,
-                   CacheMetadataChargePolicy metadata_charge_policy)
+                   CacheMetadataChargePolicy metadata_charge_policy,
+                   std::shared_ptr<SecondaryCache> secondary_cache,
+                   bool tiny_lfu_admission,
+                   const std::vector<CachePartitionOptions>& partitions,
+                   bool numa_aware)
     : ShardedCache(capacity, num_shard_bits, strict_capacity_limit,
-                   std::move(allocator)) {
+                   std::move(allocator), numa_aware),
+      secondary_cache_(std::move(secondary_cache)),
+      partitions_(partitions) {
   num_shards_ = 1 << num_shard_bits;
-  shards_ = reinterpret_cast<LRUCacheShard*>(
-      port::cacheline_aligned_alloc(sizeof(LRUCacheShard) * num_shards_));
+  const int num_groups = 1 << GetNumaNodeBits();
+  shard_group_bits_ = num_shard_bits - GetNumaNodeBits();
+  const int group_size = 1 << shard_group_bits_;
+  shard_groups_.resize(num_groups);
+  shard_group_allocators_.resize(num_groups);
   size_t per_shard = (capacity + (num_shards_ - 1)) / num_shards_;
-  for (int i = 0; i < num_shards_; i++) {
-    new (&shards_[i])
-        LRUCacheShard(per_shard, strict_capacity_limit, high_pri_pool_ratio,
-                      use_adaptive_mutex, metadata_charge_policy);
+  for (int g = 0; g < num_groups; g++) {
+    if (num_groups > 1) {
+      // Without NUMA support the group is allocated as usual and its pages
+      // are placed on first touch.
+      NewNumaMemoryAllocator(g, &shard_group_allocators_[g])
+          .PermitUncheckedError();
+    }
+    size_t group_bytes = sizeof(LRUCacheShard) * group_size;
+    if (shard_group_allocators_[g] != nullptr) {
+      shard_groups_[g] = reinterpret_cast<LRUCacheShard*>(
+          shard_group_allocators_[g]->Allocate(group_bytes));
+    } else {
+      shard_groups_[g] = reinterpret_cast<LRUCacheShard*>(
+          port::cacheline_aligned_alloc(group_bytes));
+    }
+    for (int i = 0; i < group_size; i++) {
+      new (&shard_groups_[g][i])
+          LRUCacheShard(per_shard, strict_capacity_limit, high_pri_pool_ratio,
+                        use_adaptive_mutex, metadata_charge_policy,
+                        secondary_cache_.get(), tiny_lfu_admission,
+                        partitions_, num_shards_);
+    }
   }
 }
 
 LRUCache::~LRUCache() {
-  if (shards_ != nullptr) {
-    assert(num_shards_ > 0);
-    for (int i = 0; i < num_shards_; i++) {
-      shards_[i].~LRUCacheShard();
+  for (size_t g = 0; g < shard_groups_.size(); g++) {
+    for (int i = 0; i < (1 << shard_group_bits_); i++) {
+      shard_groups_[g][i].~LRUCacheShard();
+    }
+    if (shard_group_allocators_[g] != nullptr) {
+      shard_group_allocators_[g]->Deallocate(shard_groups_[g]);
+    } else {
+      port::cacheline_aligned_free(shard_groups_[g]);
     }
-    port::cacheline_aligned_free(shards_);
   }
 }
 
-CacheShard* LRUCache::GetShard(int shard) {
-  return reinterpret_cast<CacheShard*>(&shards_[shard]);
+CacheShard* LRUCache::GetShard(int i) {
+  return reinterpret_cast<CacheShard*>(shard(i));
 }
 
-const CacheShard* LRUCache::GetShard(int shard) const {
-  return reinterpret_cast<CacheShard*>(&shards_[shard]);
+const CacheShard* LRUCache::GetShard(int i) const {
+  return reinterpret_cast<CacheShard*>(shard(i));
 }
 
 void* LRUCache::Value(Handle* handle) {
@@ -517,21 +769,78 @@ void LRUCache::DisownData() {
 // Do not drop data if compile with ASAN to suppress leak warning.
 #if defined(__clang__)
 #if !defined(__has_feature) || !__has_feature(address_sanitizer)
-  shards_ = nullptr;
+  shard_groups_.clear();
   num_shards_ = 0;
 #endif
 #else  // __clang__
 #ifndef __SANITIZE_ADDRESS__
-  shards_ = nullptr;
+  shard_groups_.clear();
   num_shards_ = 0;
 #endif  // !__SANITIZE_ADDRESS__
 #endif  // __clang__
 }
 
+std::string LRUCache::GetPrintableOptions() const {
+  std::string ret = ShardedCache::GetPrintableOptions();
+  if (secondary_cache_ != nullptr) {
+    ret.append("    secondary_cache : ");
+    ret.append(secondary_cache_->Name());
+    ret.append("\n");
+    ret.append(secondary_cache_->GetPrintableOptions());
+  }
+  if (!partitions_.empty()) {
+    const int kBufferSize = 200;
+    char buffer[kBufferSize];
+    ret.append("    partitions :\n");
+    for (const CachePartitionOptions& p : partitions_) {
+      snprintf(buffer, kBufferSize,
+               "      %s: reserved_capacity %" ROCKSDB_PRIszt
+               ", max_capacity %" ROCKSDB_PRIszt "\n",
+               p.name.c_str(), p.reserved_capacity, p.max_capacity);
+      ret.append(buffer);
+    }
+  }
+  return ret;
+}
+
+int LRUCache::GetPartitionIndex(const std::string& name) const {
+  if (name == kDefaultCachePartitionName) {
+    return 0;
+  }
+  for (size_t i = 0; i < partitions_.size(); i++) {
+    if (partitions_[i].name == name) {
+      return static_cast<int>(i + 1);
+    }
+  }
+  return -1;
+}
+
+void LRUCache::GetPartitionUsage(
+    std::vector<CachePartitionUsage>* usage) const {
+  if (partitions_.empty()) {
+    return;
+  }
+  size_t first = usage->size();
+  usage->resize(first + partitions_.size() + 1);
+  for (size_t i = 0; i <= partitions_.size(); i++) {
+    CachePartitionUsage& u = (*usage)[first + i];
+    if (i == 0) {
+      u.name = kDefaultCachePartitionName;
+      u.reserved_capacity = 0;
+      u.max_capacity = 0;
+    } else {
+      u.name = partitions_[i - 1].name;
+      u.reserved_capacity = partitions_[i - 1].reserved_capacity;
+      u.max_capacity = partitions_[i - 1].max_capacity;
+    }
+    GetUsageOfPartition(static_cast<int>(i), &u.usage, &u.pinned_usage);
+  }
+}
+
 size_t LRUCache::TEST_GetLRUSize() {
   size_t lru_size_of_all_shards = 0;
   for (int i = 0; i < num_shards_; i++) {
-    lru_size_of_all_shards += shards_[i].TEST_GetLRUSize();
+    lru_size_of_all_shards += shard(i)->TEST_GetLRUSize();
   }
   return lru_size_of_all_shards;
 }
@@ -539,37 +848,61 @@ size_t LRUCache::TEST_GetLRUSize() {
 double LRUCache::GetHighPriPoolRatio() {
   double result = 0.0;
   if (num_shards_ > 0) {
-    result = shards_[0].GetHighPriPoolRatio();
+    result = shard(0)->GetHighPriPoolRatio();
   }
   return result;
 }
 
 std::shared_ptr<Cache> NewLRUCache(const LRUCacheOptions& cache_opts) {
-  return NewLRUCache(cache_opts.capacity, cache_opts.num_shard_bits,
-                     cache_opts.strict_capacity_limit,
-                     cache_opts.high_pri_pool_ratio,
-                     cache_opts.memory_allocator, cache_opts.use_adaptive_mutex,
-                     cache_opts.metadata_charge_policy);
-}
-
-std::shared_ptr<Cache> NewLRUCache(
-    size_t capacity, int num_shard_bits, bool strict_capacity_limit,
-    double high_pri_pool_ratio,
-    std::shared_ptr<MemoryAllocator> memory_allocator, bool use_adaptive_mutex,
-    CacheMetadataChargePolicy metadata_charge_policy) {
-  if (num_shard_bits >= 20) {
+  if (cache_opts.num_shard_bits >= 20) {
     return nullptr;  // the cache cannot be sharded into too many fine pieces
   }
-  if (high_pri_pool_ratio < 0.0 || high_pri_pool_ratio > 1.0) {
+  if (cache_opts.high_pri_pool_ratio < 0.0 ||
+      cache_opts.high_pri_pool_ratio > 1.0) {
     // invalid high_pri_pool_ratio
     return nullptr;
   }
+  if (cache_opts.partitions.size() >= 256) {
+    // the partition index of an entry is a byte, with 0 the default
+    return nullptr;
+  }
+  for (size_t i = 0; i < cache_opts.partitions.size(); i++) {
+    const std::string& name = cache_opts.partitions[i].name;
+    if (name.empty() || name == kDefaultCachePartitionName) {
+      return nullptr;
+    }
+    for (size_t j = 0; j < i; j++) {
+      if (cache_opts.partitions[j].name == name) {
+        return nullptr;
+      }
+    }
+  }
+  int num_shard_bits = cache_opts.num_shard_bits;
   if (num_shard_bits < 0) {
-    num_shard_bits = GetDefaultCacheShardBits(capacity);
+    num_shard_bits = GetDefaultCacheShardBits(cache_opts.capacity);
+  }
+  if (cache_opts.numa_aware) {
+    // At least one shard per node.
+    num_shard_bits = std::max(
+        num_shard_bits, GetNumaNodeBits(port::GetNumaNodeCount(), 19));
   }
   return std::make_shared<LRUCache>(
+      cache_opts.capacity, num_shard_bits, cache_opts.strict_capacity_limit,
+      cache_opts.high_pri_pool_ratio, cache_opts.memory_allocator,
+      cache_opts.use_adaptive_mutex, cache_opts.metadata_charge_policy,
+      cache_opts.secondary_cache, cache_opts.tiny_lfu_admission,
+      cache_opts.partitions, cache_opts.numa_aware);
+}
+
+std::shared_ptr<Cache> NewLRUCache(
+    size_t capacity, int num_shard_bits, bool strict_capacity_limit,
+    double high_pri_pool_ratio,
+    std::shared_ptr<MemoryAllocator> memory_allocator, bool use_adaptive_mutex,
+    CacheMetadataChargePolicy metadata_charge_policy) {
+  return NewLRUCache(LRUCacheOptions(
       capacity, num_shard_bits, strict_capacity_limit, high_pri_pool_ratio,
-      std::move(memory_allocator), use_adaptive_mutex, metadata_charge_policy);
+      std::move(memory_allocator), use_adaptive_mutex,
+      metadata_charge_policy));
 }
 
 }  // namespace ROCKSDB_NAMESPACE
@@ -9,11 +9,14 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
+#include "cache/frequency_sketch.h"
 #include "cache/sharded_cache.h"
 
 #include "port/malloc.h"
 #include "port/port.h"
+#include "rocksdb/secondary_cache.h"
 #include "util/autovector.h"
 
 namespace ROCKSDB_NAMESPACE {
@@ -50,6 +53,8 @@ namespace ROCKSDB_NAMESPACE {
 struct LRUHandle {
   void* value;
   void (*deleter)(const Slice&, void* value);
+  // Non-null if the entry can be saved to the secondary cache on eviction.
+  const Cache::CacheItemHelper* helper;
   LRUHandle* next_hash;
   LRUHandle* next;
   LRUHandle* prev;
@@ -73,6 +78,10 @@ struct LRUHandle {
 
   uint8_t flags;
 
+  // Index of the partition the entry is charged to, see
+  // LRUCacheOptions::partitions.
+  uint8_t partition;
+
   // Beginning of the key (MUST BE THE LAST FIELD IN THIS STRUCT!)
   char key_data[1];
 
@@ -95,6 +104,7 @@ struct LRUHandle {
   bool IsHighPri() const { return flags & IS_HIGH_PRI; }
   bool InHighPriPool() const { return flags & IN_HIGH_PRI_POOL; }
   bool HasHit() const { return flags & HAS_HIT; }
+  bool IsSecondaryCacheCompatible() const { return helper != nullptr; }
 
   void SetInCache(bool in_cache) {
     if (in_cache) {
@@ -193,7 +203,11 @@ class ALIGN_AS(CACHE_LINE_SIZE) LRUCacheShard final : public CacheShard {
  public:
   LRUCacheShard(size_t capacity, bool strict_capacity_limit,
                 double high_pri_pool_ratio, bool use_adaptive_mutex,
-                CacheMetadataChargePolicy metadata_charge_policy);
+                CacheMetadataChargePolicy metadata_charge_policy,
+                SecondaryCache* secondary_cache = nullptr,
+                bool tiny_lfu_admission = false,
+                const std::vector<CachePartitionOptions>& partitions = {},
+                int num_shards = 1);
   virtual ~LRUCacheShard() override = default;
 
   // Separate from constructor so caller can easily make an array of LRUCache
@@ -213,7 +227,23 @@ class ALIGN_AS(CACHE_LINE_SIZE) LRUCacheShard final : public CacheShard {
                         void (*deleter)(const Slice& key, void* value),
                         Cache::Handle** handle,
                         Cache::Priority priority) override;
+  virtual Status Insert(const Slice& key, uint32_t hash, void* value,
+                        const Cache::CacheItemHelper* helper, size_t charge,
+                        Cache::Handle** handle,
+                        Cache::Priority priority) override;
+  virtual Status InsertIntoPartition(
+      const Slice& key, uint32_t hash, void* value, size_t charge,
+      void (*deleter)(const Slice& key, void* value),
+      const Cache::CacheItemHelper* helper, Cache::Handle** handle,
+      Cache::Priority priority, int partition) override;
   virtual Cache::Handle* Lookup(const Slice& key, uint32_t hash) override;
+  // On a miss, look up the secondary cache, and promote the entry into this
+  // shard if found there.
+  virtual Cache::Handle* Lookup(const Slice& key, uint32_t hash,
+                                const Cache::CacheItemHelper* helper,
+                                const Cache::CreateCallback& create_cb,
+                                Cache::Priority priority,
+                                Statistics* stats) override;
   virtual bool Ref(Cache::Handle* handle) override;
   virtual bool Release(Cache::Handle* handle,
                        bool force_erase = false) override;
@@ -225,10 +255,16 @@ class ALIGN_AS(CACHE_LINE_SIZE) LRUCacheShard final : public CacheShard {
 
   virtual size_t GetUsage() const override;
   virtual size_t GetPinnedUsage() const override;
+  virtual void AddPartitionUsage(int partition, size_t* usage,
+                                 size_t* pinned_usage) const override;
 
   virtual void ApplyToAllCacheEntries(void (*callback)(void*, size_t),
                                       bool thread_safe) override;
 
+  virtual void ApplyToAllEntries(
+      const std::function<void(const Slice& key, void* value, size_t charge)>&
+          callback) override;
+
   virtual void EraseUnRefEntries() override;
 
   virtual std::string GetPrintableOptions() const override;
@@ -243,42 +279,99 @@ class ALIGN_AS(CACHE_LINE_SIZE) LRUCacheShard final : public CacheShard {
   double GetHighPriPoolRatio();
 
  private:
+  // The LRU list and the usage of a partition in this shard, see
+  // LRUCacheOptions::partitions. partitions_[0] is the default partition.
+  struct Partition {
+    // Dummy head of LRU list.
+    // lru.prev is newest entry, lru.next is oldest entry.
+    // LRU contains items which can be evicted, ie reference only by cache
+    LRUHandle lru;
+
+    // Pointer to head of low-pri pool in LRU list.
+    LRUHandle* lru_low_pri;
+
+    // Memory size for entries of the partition residing in the cache, and
+    // residing only in the LRU list.
+    size_t usage;
+    size_t lru_usage;
+
+    // Memory size for entries in high-pri pool.
+    size_t high_pri_pool_usage;
+
+    // High-pri pool size, equals to high_pri_pool_ratio_ times the capacity
+    // the partition may use.
+    double high_pri_pool_capacity;
+
+    // Shares of CachePartitionOptions::reserved_capacity and max_capacity
+    // for this shard. max_capacity == 0 means capacity_.
+    size_t reserved_capacity;
+    size_t max_capacity;
+  };
+
+  Status Insert(const Slice& key, uint32_t hash, void* value, size_t charge,
+                void (*deleter)(const Slice& key, void* value),
+                const Cache::CacheItemHelper* helper, Cache::Handle** handle,
+                Cache::Priority priority, int partition = 0);
+
+  // Hand an evicted entry to the secondary cache, if any, before it is
+  // freed. Called without holding the mutex_.
+  void SaveToSecondaryCache(LRUHandle* e);
+
   void LRU_Remove(LRUHandle* e);
   void LRU_Insert(LRUHandle* e);
 
   // Overflow the last entry in high-pri pool to low-pri pool until size of
   // high-pri pool is no larger than the size specify by high_pri_pool_pct.
-  void MaintainPoolSize();
+  void MaintainPoolSize(Partition* p);
+
+  // Recompute the high-pri pool capacity of the partitions, after a change
+  // of capacity_ or high_pri_pool_ratio_.
+  void UpdateHighPriPoolCapacity();
 
   // Free some space following strict LRU policy until enough space
   // to hold (usage_ + charge) is freed or the lru list is empty
   // This function is not thread safe - it needs to be executed while
   // holding the mutex_
-  void EvictFromLRU(size_t charge, autovector<LRUHandle*>* deleted);
+  void EvictFromLRU(size_t charge, autovector<LRUHandle*>* deleted,
+                    int partition = 0);
+
+  // The entry to evict next to insert an entry of the given charge into the
+  // given partition: the least recently used entry of the partition the
+  // furthest over its max capacity, else over its reserved capacity, else
+  // with the largest usage. nullptr if all the LRU lists are empty.
+  // Needs to be called while holding the mutex_.
+  LRUHandle* GetEvictionCandidate(int partition, size_t charge) const;
+
+  void AddUsage(LRUHandle* e, size_t total_charge) {
+    usage_ += total_charge;
+    partitions_[e->partition].usage += total_charge;
+  }
+  void SubtractUsage(LRUHandle* e, size_t total_charge) {
+    assert(usage_ >= total_charge);
+    usage_ -= total_charge;
+    assert(partitions_[e->partition].usage >= total_charge);
+    partitions_[e->partition].usage -= total_charge;
+  }
+
+  // Return true if e, which needs room to be made for it, may evict the
+  // least recently used entry according to the frequency sketch. Needs to
+  // be called while holding the mutex_.
+  bool Admit(LRUHandle* e) const;
 
   // Initialized before use.
   size_t capacity_;
 
-  // Memory size for entries in high-pri pool.
-  size_t high_pri_pool_usage_;
-
   // Whether to reject insertion if cache reaches its full capacity.
   bool strict_capacity_limit_;
 
   // Ratio of capacity reserved for high priority cache entries.
   double high_pri_pool_ratio_;
 
-  // High-pri pool size, equals to capacity * high_pri_pool_ratio.
-  // Remember the value to avoid recomputing each time.
-  double high_pri_pool_capacity_;
-
-  // Dummy head of LRU list.
-  // lru.prev is newest entry, lru.next is oldest entry.
-  // LRU contains items which can be evicted, ie reference only by cache
-  LRUHandle lru_;
+  // Owned by the LRUCache, may be nullptr.
+  SecondaryCache* secondary_cache_;
 
-  // Pointer to head of low-pri pool in LRU list.
-  LRUHandle* lru_low_pri_;
+  // Whether inserts are filtered by the frequency sketch.
+  const bool tiny_lfu_admission_;
 
   // ------------^^^^^^^^^^^^^-----------
   // Not frequently modified data members
@@ -299,6 +392,13 @@ class ALIGN_AS(CACHE_LINE_SIZE) LRUCacheShard final : public CacheShard {
   // Memory size for entries residing only in the LRU list
   size_t lru_usage_;
 
+  // Never resized after construction, since the LRU lists point to the
+  // dummy heads.
+  std::vector<Partition> partitions_;
+
+  // Estimated lookup frequencies of the keys, if tiny_lfu_admission_.
+  FrequencySketch sketch_;
+
   // mutex_ protects the following state.
   // We don't count mutex_ as the cache's internal state so semantically we
   // don't mind mutex_ invoking the non-const actions.
@@ -316,7 +416,11 @@ class LRUCache
            std::shared_ptr<MemoryAllocator> memory_allocator = nullptr,
            bool use_adaptive_mutex = kDefaultToAdaptiveMutex,
            CacheMetadataChargePolicy metadata_charge_policy =
-               kDontChargeCacheMetadata);
+               kDontChargeCacheMetadata,
+           std::shared_ptr<SecondaryCache> secondary_cache = nullptr,
+           bool tiny_lfu_admission = false,
+           const std::vector<CachePartitionOptions>& partitions = {},
+           bool numa_aware = false);
   virtual ~LRUCache();
   virtual const char* Name() const override { return "LRUCache"; }
   virtual CacheShard* GetShard(int shard) override;
@@ -325,6 +429,10 @@ class LRUCache
   virtual size_t GetCharge(Handle* handle) const override;
   virtual uint32_t GetHash(Handle* handle) const override;
   virtual void DisownData() override;
+  virtual std::string GetPrintableOptions() const override;
+  virtual int GetPartitionIndex(const std::string& name) const override;
+  virtual void GetPartitionUsage(
+      std::vector<CachePartitionUsage>* usage) const override;
 
   //  Retrieves number of elements in LRU, for unit test purpose only
   size_t TEST_GetLRUSize();
@@ -332,8 +440,22 @@ class LRUCache
   double GetHighPriPoolRatio();
 
  private:
-  LRUCacheShard* shards_ = nullptr;
+  LRUCacheShard* shard(int i) const {
+    return &shard_groups_[i >> shard_group_bits_]
+                         [i & ((1 << shard_group_bits_) - 1)];
+  }
+
+  // The shards of each NUMA node group of ShardedCache, contiguous within a
+  // group, or a single group if the cache is not NUMA aware. A group is
+  // allocated by the allocator at the same index, or by
+  // port::cacheline_aligned_alloc() if that is null.
+  std::vector<LRUCacheShard*> shard_groups_;
+  std::vector<std::shared_ptr<MemoryAllocator>> shard_group_allocators_;
+  int shard_group_bits_ = 0;
   int num_shards_ = 0;
+  std::shared_ptr<SecondaryCache> secondary_cache_;
+  // Not including the default partition.
+  const std::vector<CachePartitionOptions> partitions_;
 };
 
 }  // namespace ROCKSDB_NAMESPACE
@@ -7,8 +7,16 @@
 
 #include <string>
 #include <vector>
+#include "cache/cache_reservation_manager.h"
+#include "cache/compressed_secondary_cache.h"
+#include "cache/frequency_sketch.h"
 #include "port/port.h"
+#include "rocksdb/secondary_cache.h"
+#include "test_util/sync_point.h"
 #include "test_util/testharness.h"
+#include "util/compression.h"
+#include "util/random.h"
+#include "util/string_util.h"
 
 namespace ROCKSDB_NAMESPACE {
 
@@ -191,6 +199,470 @@ TEST_F(LRUCacheTest, EntriesWithPriority) {
   ValidateLRUList({"e", "f", "g", "Z", "d"}, 2);
 }
 
+class LRUSecondaryCacheTest : public testing::Test {
+ public:
+  LRUSecondaryCacheTest() {}
+
+  class TestItem {
+   public:
+    TestItem(const char* buf, size_t size) : buf_(buf, size) {}
+    const std::string& Buf() const { return buf_; }
+
+   private:
+    std::string buf_;
+  };
+
+  static size_t SizeCallback(void* obj) {
+    return reinterpret_cast<TestItem*>(obj)->Buf().size();
+  }
+
+  static Status SaveToCallback(void* from_obj, size_t from_offset,
+                               size_t length, void* out) {
+    TestItem* item = reinterpret_cast<TestItem*>(from_obj);
+    memcpy(out, item->Buf().data() + from_offset, length);
+    return Status::OK();
+  }
+
+  static void DeletionCallback(const Slice& /*key*/, void* obj) {
+    delete reinterpret_cast<TestItem*>(obj);
+  }
+
+  static Cache::CacheItemHelper helper_;
+
+  static Status CreateCallback(const void* buf, size_t size, void** out_obj,
+                               size_t* charge) {
+    *out_obj = new TestItem(reinterpret_cast<const char*>(buf), size);
+    *charge = size;
+    return Status::OK();
+  }
+};
+
+Cache::CacheItemHelper LRUSecondaryCacheTest::helper_(
+    LRUSecondaryCacheTest::SizeCallback, LRUSecondaryCacheTest::SaveToCallback,
+    LRUSecondaryCacheTest::DeletionCallback);
+
+TEST_F(LRUSecondaryCacheTest, BasicTest) {
+  LRUCacheOptions opts(1024, 0, false, 0.5, nullptr, kDefaultToAdaptiveMutex,
+                       kDontChargeCacheMetadata);
+  opts.secondary_cache =
+      NewCompressedSecondaryCache(CompressedSecondaryCacheOptions(
+          4096, 0, kLZ4Compression, nullptr, kDontChargeCacheMetadata));
+  std::shared_ptr<Cache> cache = NewLRUCache(opts);
+  std::shared_ptr<Statistics> stats = CreateDBStatistics();
+
+  Random rnd(301);
+  std::string str1 = rnd.RandomString(1020);
+  std::string str2 = rnd.RandomString(1020);
+  ASSERT_OK(cache->Insert("k1", new TestItem(str1.data(), str1.size()),
+                          &LRUSecondaryCacheTest::helper_, str1.size()));
+  // k1 is evicted to the secondary cache.
+  ASSERT_OK(cache->Insert("k2", new TestItem(str2.data(), str2.size()),
+                          &LRUSecondaryCacheTest::helper_, str2.size()));
+
+  // A lookup without the helper does not look at the secondary cache.
+  ASSERT_EQ(cache->Lookup("k1", stats.get()), nullptr);
+  ASSERT_EQ(stats->getTickerCount(SECONDARY_CACHE_HITS), 0);
+
+  Cache::Handle* handle =
+      cache->Lookup("k2", &LRUSecondaryCacheTest::helper_,
+                    LRUSecondaryCacheTest::CreateCallback,
+                    Cache::Priority::LOW, stats.get());
+  ASSERT_NE(handle, nullptr);
+  cache->Release(handle);
+  ASSERT_EQ(stats->getTickerCount(SECONDARY_CACHE_HITS), 0);
+  ASSERT_EQ(stats->getTickerCount(SECONDARY_CACHE_MISSES), 0);
+
+  // k1 is promoted, k2 is evicted to the secondary cache.
+  handle = cache->Lookup("k1", &LRUSecondaryCacheTest::helper_,
+                         LRUSecondaryCacheTest::CreateCallback,
+                         Cache::Priority::LOW, stats.get());
+  ASSERT_NE(handle, nullptr);
+  TestItem* item = reinterpret_cast<TestItem*>(cache->Value(handle));
+  ASSERT_EQ(item->Buf(), str1);
+  cache->Release(handle);
+  ASSERT_EQ(stats->getTickerCount(SECONDARY_CACHE_HITS), 1);
+
+  handle = cache->Lookup("k2", &LRUSecondaryCacheTest::helper_,
+                         LRUSecondaryCacheTest::CreateCallback,
+                         Cache::Priority::LOW, stats.get());
+  ASSERT_NE(handle, nullptr);
+  item = reinterpret_cast<TestItem*>(cache->Value(handle));
+  ASSERT_EQ(item->Buf(), str2);
+  cache->Release(handle);
+  ASSERT_EQ(stats->getTickerCount(SECONDARY_CACHE_HITS), 2);
+
+  handle = cache->Lookup("k3", &LRUSecondaryCacheTest::helper_,
+                         LRUSecondaryCacheTest::CreateCallback,
+                         Cache::Priority::LOW, stats.get());
+  ASSERT_EQ(handle, nullptr);
+  ASSERT_EQ(stats->getTickerCount(SECONDARY_CACHE_MISSES), 1);
+}
+
+TEST_F(LRUSecondaryCacheTest, CompressedSecondaryCache) {
+  for (CompressionType type : {kNoCompression, kZlibCompression,
+                               kLZ4Compression, kSnappyCompression}) {
+    CompressedSecondaryCache secondary_cache(CompressedSecondaryCacheOptions(
+        1 << 20, 0, type, nullptr, kDontChargeCacheMetadata));
+
+    Random rnd(301);
+    std::string str = rnd.HumanReadableString(500) + std::string(3000, 'x');
+    TestItem item(str.data(), str.size());
+    ASSERT_OK(
+        secondary_cache.Insert("k1", &item, &LRUSecondaryCacheTest::helper_));
+    size_t usage = secondary_cache.TEST_GetCache()->GetUsage();
+    if (type != kNoCompression && CompressionTypeSupported(type)) {
+      ASSERT_LT(usage, str.size() / 2);
+    } else {
+      ASSERT_EQ(usage, str.size() + 1);
+    }
+
+    void* value = nullptr;
+    size_t charge = 0;
+    ASSERT_OK(secondary_cache.Lookup(
+        "k1", LRUSecondaryCacheTest::CreateCallback, &value, &charge));
+    std::unique_ptr<TestItem> result(reinterpret_cast<TestItem*>(value));
+    ASSERT_EQ(result->Buf(), str);
+    ASSERT_EQ(charge, str.size());
+
+    // The entry was handed back to the primary cache.
+    ASSERT_TRUE(secondary_cache
+                    .Lookup("k1", LRUSecondaryCacheTest::CreateCallback,
+                            &value, &charge)
+                    .IsNotFound());
+    ASSERT_EQ(secondary_cache.TEST_GetCache()->GetUsage(), 0);
+  }
+}
+
+TEST(FrequencySketchTest, IncrementAndAge) {
+  FrequencySketch sketch;
+  ASSERT_FALSE(sketch.IsInitialized());
+  // Not initialized, nothing is counted.
+  sketch.Increment(1);
+  ASSERT_EQ(sketch.Frequency(1), 0);
+
+  sketch.EnsureCapacity(1024);
+  ASSERT_TRUE(sketch.IsInitialized());
+  for (int i = 0; i < 6; i++) {
+    sketch.Increment(1);
+  }
+  sketch.Increment(2);
+  // A count-min sketch only overestimates.
+  ASSERT_GE(sketch.Frequency(1), 6);
+  ASSERT_GE(sketch.Frequency(2), 1);
+  ASSERT_GT(sketch.Frequency(1), sketch.Frequency(2));
+
+  // Counters saturate at 15.
+  for (int i = 0; i < 100; i++) {
+    sketch.Increment(3);
+  }
+  ASSERT_EQ(sketch.Frequency(3), 15);
+
+  sketch.Age();
+  ASSERT_EQ(sketch.Frequency(3), 7);
+  ASSERT_GE(sketch.Frequency(1), 3);
+}
+
+TEST(LRUCacheTinyLFUTest, ScanResistance) {
+  LRUCacheOptions opts(10 /* capacity */, 0 /* num_shard_bits */,
+                       false /* strict_capacity_limit */,
+                       0.0 /* high_pri_pool_ratio */, nullptr,
+                       kDefaultToAdaptiveMutex, kDontChargeCacheMetadata);
+  opts.tiny_lfu_admission = true;
+  std::shared_ptr<Cache> cache = NewLRUCache(opts);
+
+  auto lookup = [&](const std::string& key) {
+    Cache::Handle* handle = cache->Lookup(key);
+    if (handle != nullptr) {
+      cache->Release(handle);
+      return true;
+    }
+    return false;
+  };
+  // Look up like a reader: insert on a miss.
+  auto read = [&](const std::string& key) {
+    if (!lookup(key)) {
+      ASSERT_OK(cache->Insert(key, nullptr, 1, nullptr));
+    }
+  };
+
+  // Make 10 hot keys.
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < 10; i++) {
+      read("hot" + ToString(i));
+    }
+  }
+  ASSERT_EQ(cache->GetUsage(), 10);
+
+  // A scan over keys that are read only once does not flush them.
+  for (int i = 0; i < 100; i++) {
+    read("scan" + ToString(i));
+  }
+  for (int i = 0; i < 10; i++) {
+    ASSERT_TRUE(lookup("hot" + ToString(i)));
+  }
+  ASSERT_FALSE(lookup("scan99"));
+
+  // A key that becomes more popular than the least recently used entry is
+  // admitted.
+  for (int i = 0; i < 10; i++) {
+    read("new");
+  }
+  ASSERT_TRUE(lookup("new"));
+  ASSERT_EQ(cache->GetUsage(), 10);
+
+  // High priority entries bypass admission.
+  ASSERT_OK(cache->Insert("high", nullptr, 1, nullptr, nullptr,
+                          Cache::Priority::HIGH));
+  ASSERT_TRUE(lookup("high"));
+
+  // A rejected entry inserted with a handle is still usable, but it is not
+  // kept in the cache.
+  Cache::Handle* handle = nullptr;
+  ASSERT_OK(cache->Insert("once", nullptr, 1, nullptr, &handle));
+  ASSERT_NE(handle, nullptr);
+  ASSERT_EQ(cache->GetUsage(), 11);
+  cache->Release(handle);
+  ASSERT_EQ(cache->GetUsage(), 10);
+  ASSERT_FALSE(lookup("once"));
+}
+
+TEST(LRUCachePartitionTest, EvictionOrder) {
+  LRUCacheOptions opts(10 /* capacity */, 0 /* num_shard_bits */,
+                       false /* strict_capacity_limit */,
+                       0.0 /* high_pri_pool_ratio */, nullptr,
+                       kDefaultToAdaptiveMutex, kDontChargeCacheMetadata);
+  opts.partitions.emplace_back("a", 4 /* reserved */, 6 /* max */);
+  opts.partitions.emplace_back("b", 0, 0);
+  std::shared_ptr<Cache> cache = NewLRUCache(opts);
+  ASSERT_NE(cache, nullptr);
+  std::shared_ptr<Cache> a = NewCachePartition(cache, "a");
+  std::shared_ptr<Cache> b = NewCachePartition(cache, "b");
+  ASSERT_NE(a, nullptr);
+  ASSERT_NE(b, nullptr);
+  ASSERT_EQ(NewCachePartition(cache, "c"), nullptr);
+  ASSERT_NE(NewCachePartition(cache, kDefaultCachePartitionName), nullptr);
+
+  auto lookup = [&](const std::string& key) {
+    Cache::Handle* handle = cache->Lookup(key);
+    if (handle != nullptr) {
+      cache->Release(handle);
+      return true;
+    }
+    return false;
+  };
+
+  for (int i = 0; i < 6; i++) {
+    ASSERT_OK(a->Insert("a" + ToString(i), nullptr, 1, nullptr));
+  }
+  for (int i = 0; i < 4; i++) {
+    ASSERT_OK(b->Insert("b" + ToString(i), nullptr, 1, nullptr));
+  }
+  ASSERT_EQ(cache->GetUsage(), 10);
+  ASSERT_EQ(a->GetUsage(), 6);
+  ASSERT_EQ(b->GetUsage(), 4);
+
+  // b is further over its reserve than a, so inserts into b evict from b.
+  for (int i = 4; i < 20; i++) {
+    ASSERT_OK(b->Insert("b" + ToString(i), nullptr, 1, nullptr));
+  }
+  ASSERT_EQ(a->GetUsage(), 6);
+  ASSERT_EQ(b->GetUsage(), 4);
+  for (int i = 0; i < 6; i++) {
+    ASSERT_TRUE(lookup("a" + ToString(i)));
+  }
+  ASSERT_FALSE(lookup("b15"));
+  ASSERT_TRUE(lookup("b16"));
+
+  // a cannot grow over its max capacity at the expense of b.
+  for (int i = 6; i < 9; i++) {
+    ASSERT_OK(a->Insert("a" + ToString(i), nullptr, 1, nullptr));
+  }
+  ASSERT_EQ(a->GetUsage(), 6);
+  ASSERT_EQ(b->GetUsage(), 4);
+  ASSERT_FALSE(lookup("a2"));
+  ASSERT_TRUE(lookup("a3"));
+
+  // Pinned entries count in the pinned usage of their partition.
+  Cache::Handle* handle = cache->Lookup("a3");
+  ASSERT_NE(handle, nullptr);
+  ASSERT_EQ(a->GetPinnedUsage(), 1);
+  ASSERT_EQ(b->GetPinnedUsage(), 0);
+  cache->Release(handle);
+  ASSERT_EQ(a->GetPinnedUsage(), 0);
+
+  // Inserts into the default partition evict from b, the furthest over its
+  // reserve, until the default partition is the furthest over its own.
+  for (int i = 0; i < 10; i++) {
+    ASSERT_OK(cache->Insert("d" + ToString(i), nullptr, 1, nullptr));
+  }
+  std::vector<CachePartitionUsage> usage;
+  cache->GetPartitionUsage(&usage);
+  ASSERT_EQ(usage.size(), 3);
+  ASSERT_EQ(usage[0].name, kDefaultCachePartitionName);
+  ASSERT_EQ(usage[1].name, "a");
+  ASSERT_EQ(usage[1].reserved_capacity, 4);
+  ASSERT_EQ(usage[1].max_capacity, 6);
+  ASSERT_EQ(usage[2].name, "b");
+  ASSERT_EQ(usage[0].usage + usage[1].usage + usage[2].usage, 10);
+  ASSERT_EQ(usage[0].usage, 2);
+  ASSERT_EQ(usage[1].usage, 6);
+  ASSERT_EQ(usage[2].usage, 2);
+}
+
+TEST(LRUCachePartitionTest, InvalidOptions) {
+  LRUCacheOptions opts(10, 0, false, 0.0);
+  opts.partitions.emplace_back("a", 0, 0);
+  opts.partitions.emplace_back("a", 0, 0);
+  ASSERT_EQ(NewLRUCache(opts), nullptr);
+  opts.partitions.pop_back();
+  opts.partitions.emplace_back(kDefaultCachePartitionName, 0, 0);
+  ASSERT_EQ(NewLRUCache(opts), nullptr);
+  opts.partitions.pop_back();
+  opts.partitions.emplace_back("", 0, 0);
+  ASSERT_EQ(NewLRUCache(opts), nullptr);
+  opts.partitions.pop_back();
+  ASSERT_NE(NewLRUCache(opts), nullptr);
+  // A cache without partitions only has the default one.
+  std::shared_ptr<Cache> cache = NewLRUCache(10, 0);
+  ASSERT_EQ(NewCachePartition(cache, "a"), nullptr);
+  std::vector<CachePartitionUsage> usage;
+  cache->GetPartitionUsage(&usage);
+  ASSERT_TRUE(usage.empty());
+}
+
+TEST(LRUCacheNumaTest, NumaNodeBits) {
+  ASSERT_EQ(GetNumaNodeBits(1, 6), 0);
+  ASSERT_EQ(GetNumaNodeBits(2, 6), 1);
+  ASSERT_EQ(GetNumaNodeBits(3, 6), 1);
+  ASSERT_EQ(GetNumaNodeBits(8, 6), 3);
+  ASSERT_EQ(GetNumaNodeBits(8, 2), 2);
+  ASSERT_EQ(GetNumaNodeBits(2, 0), 0);
+
+  std::shared_ptr<Cache> cache = NewLRUCache(10, 0);
+  uint64_t local_hits, remote_hits;
+  ASSERT_FALSE(cache->GetNumaHitCounts(&local_hits, &remote_hits));
+}
+
+#ifndef NDEBUG
+TEST(LRUCacheNumaTest, LocalAndRemoteHits) {
+  // Pretend there are two nodes, and run on the node of current_node.
+  int current_node = 0;
+  SyncPoint::GetInstance()->SetCallBack(
+      "ShardedCache::ShardedCache:NumaNodes",
+      [](void* arg) { *static_cast<int*>(arg) = 2; });
+  SyncPoint::GetInstance()->SetCallBack(
+      "ShardedCache::NumaNodeGroup",
+      [&](void* arg) { *static_cast<int*>(arg) = current_node; });
+  SyncPoint::GetInstance()->EnableProcessing();
+
+  LRUCacheOptions opts(100 /* capacity */, 2 /* num_shard_bits */,
+                       false /* strict_capacity_limit */,
+                       0.0 /* high_pri_pool_ratio */, nullptr,
+                       kDefaultToAdaptiveMutex, kDontChargeCacheMetadata);
+  opts.numa_aware = true;
+  std::shared_ptr<Cache> cache = NewLRUCache(opts);
+  ASSERT_NE(cache, nullptr);
+  ASSERT_EQ(static_cast<ShardedCache*>(cache.get())->GetNumaNodeBits(), 1);
+
+  uint64_t local_hits, remote_hits;
+  ASSERT_TRUE(cache->GetNumaHitCounts(&local_hits, &remote_hits));
+  ASSERT_EQ(local_hits, 0);
+  ASSERT_EQ(remote_hits, 0);
+
+  for (int i = 0; i < 10; i++) {
+    current_node = i % 2;
+    ASSERT_OK(cache->Insert("k" + ToString(i), nullptr, 1, nullptr));
+  }
+  ASSERT_EQ(cache->GetUsage(), 10);
+
+  // Every key is found from both nodes, locally from its own node.
+  for (int node = 0; node < 2; node++) {
+    current_node = node;
+    for (int i = 0; i < 10; i++) {
+      Cache::Handle* handle = cache->Lookup("k" + ToString(i));
+      ASSERT_NE(handle, nullptr);
+      ASSERT_EQ(cache->GetPinnedUsage(), 1);
+      cache->Release(handle);
+      ASSERT_EQ(cache->GetPinnedUsage(), 0);
+    }
+    ASSERT_EQ(cache->Lookup("missing"), nullptr);
+  }
+  ASSERT_TRUE(cache->GetNumaHitCounts(&local_hits, &remote_hits));
+  ASSERT_EQ(local_hits, 10);
+  ASSERT_EQ(remote_hits, 10);
+
+  // A key inserted on both nodes is erased from both.
+  current_node = 1;
+  ASSERT_OK(cache->Insert("k0", nullptr, 1, nullptr));
+  ASSERT_EQ(cache->GetUsage(), 11);
+  cache->Erase("k0");
+  ASSERT_EQ(cache->GetUsage(), 9);
+  for (int node = 0; node < 2; node++) {
+    current_node = node;
+    ASSERT_EQ(cache->Lookup("k0"), nullptr);
+  }
+
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+}
+#endif  // NDEBUG
+
+TEST(CacheReservationManagerTest, UpdateAndHandles) {
+  const size_t kDummy = CacheReservationManager::kSizeDummyEntry;
+  LRUCacheOptions opts(10 * kDummy, 0 /* num_shard_bits */,
+                       true /* strict_capacity_limit */,
+                       0.0 /* high_pri_pool_ratio */, nullptr,
+                       kDefaultToAdaptiveMutex, kDontChargeCacheMetadata);
+  std::shared_ptr<Cache> cache = NewLRUCache(opts);
+  auto mgr = std::make_shared<CacheReservationManager>(cache);
+
+  // The reservation is rounded up to whole dummy entries.
+  ASSERT_OK(mgr->UpdateCacheReservation(1));
+  ASSERT_EQ(mgr->GetTotalReservedCacheSize(), kDummy);
+  ASSERT_EQ(cache->GetUsage(), kDummy);
+  ASSERT_OK(mgr->UpdateCacheReservation(3 * kDummy + 1));
+  ASSERT_EQ(mgr->GetTotalReservedCacheSize(), 4 * kDummy);
+  ASSERT_EQ(cache->GetPinnedUsage(), 4 * kDummy);
+  ASSERT_OK(mgr->UpdateCacheReservation(kDummy));
+  ASSERT_EQ(mgr->GetTotalReservedCacheSize(), kDummy);
+  ASSERT_EQ(cache->GetUsage(), kDummy);
+
+  // A reservation through a handle lasts as long as the handle.
+  std::unique_ptr<CacheReservationManager::CacheReservationHandle> handle;
+  ASSERT_OK(mgr->MakeCacheReservation(2 * kDummy, &handle));
+  ASSERT_EQ(mgr->GetTotalMemoryUsed(), 3 * kDummy);
+  ASSERT_EQ(cache->GetUsage(), 3 * kDummy);
+
+  // With strict_capacity_limit, a reservation that does not fit fails and
+  // leaves the memory used unchanged.
+  std::unique_ptr<CacheReservationManager::CacheReservationHandle> too_large;
+  ASSERT_TRUE(mgr->MakeCacheReservation(8 * kDummy, &too_large).IsIncomplete());
+  ASSERT_EQ(too_large, nullptr);
+  ASSERT_EQ(mgr->GetTotalMemoryUsed(), 3 * kDummy);
+  ASSERT_EQ(cache->GetUsage(), 3 * kDummy);
+
+  handle.reset();
+  ASSERT_EQ(mgr->GetTotalMemoryUsed(), kDummy);
+  ASSERT_EQ(cache->GetUsage(), kDummy);
+
+  mgr.reset();
+  ASSERT_EQ(cache->GetUsage(), 0);
+}
+
+TEST(CacheReservationManagerTest, DelayedDecrease) {
+  const size_t kDummy = CacheReservationManager::kSizeDummyEntry;
+  std::shared_ptr<Cache> cache = NewLRUCache(100 * kDummy, 0);
+  CacheReservationManager mgr(cache, true /* delayed_decrease */);
+
+  ASSERT_OK(mgr.UpdateCacheReservation(8 * kDummy));
+  ASSERT_EQ(mgr.GetTotalReservedCacheSize(), 8 * kDummy);
+  // Not below 3/4 of the reservation yet.
+  ASSERT_OK(mgr.UpdateCacheReservation(6 * kDummy));
+  ASSERT_EQ(mgr.GetTotalReservedCacheSize(), 8 * kDummy);
+  ASSERT_OK(mgr.UpdateCacheReservation(5 * kDummy));
+  ASSERT_EQ(mgr.GetTotalReservedCacheSize(), 5 * kDummy);
+}
+
 }  // namespace ROCKSDB_NAMESPACE
 
 int main(int argc, char** argv) {
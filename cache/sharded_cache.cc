@@ -11,18 +11,73 @@
 
 #include <string>
 
+#include "test_util/sync_point.h"
 #include "util/mutexlock.h"
 
 namespace ROCKSDB_NAMESPACE {
 
 ShardedCache::ShardedCache(size_t capacity, int num_shard_bits,
                            bool strict_capacity_limit,
-                           std::shared_ptr<MemoryAllocator> allocator)
-    : Cache(std::move(allocator)),
+                           std::shared_ptr<MemoryAllocator> allocator,
+                           bool numa_aware)
+    : Cache(allocator),
       num_shard_bits_(num_shard_bits),
+      numa_aware_(numa_aware),
+      numa_node_bits_(0),
       capacity_(capacity),
       strict_capacity_limit_(strict_capacity_limit),
-      last_id_(1) {}
+      last_id_(1),
+      memory_allocator_ptr_(std::move(allocator)) {
+  if (numa_aware_) {
+    int num_nodes = port::GetNumaNodeCount();
+    TEST_SYNC_POINT_CALLBACK("ShardedCache::ShardedCache:NumaNodes",
+                             &num_nodes);
+    numa_node_bits_ =
+        ROCKSDB_NAMESPACE::GetNumaNodeBits(num_nodes, num_shard_bits_);
+    numa_hit_counts_.reset(new CoreLocalArray<NumaHitCounts>());
+  }
+}
+
+int ShardedCache::NumaNodeGroup() const {
+  int node = port::GetCurrentNumaNode();
+  TEST_SYNC_POINT_CALLBACK("ShardedCache::NumaNodeGroup", &node);
+  return node & ((1 << numa_node_bits_) - 1);
+}
+
+Cache::Handle* ShardedCache::NumaLookup(const Slice& key, uint32_t hash) {
+  const int num_groups = 1 << numa_node_bits_;
+  const int local_group = NumaNodeGroup();
+  for (int i = 0; i < num_groups; i++) {
+    int group = (local_group + i) & (num_groups - 1);
+    uint32_t group_hash = NumaHash(hash, group);
+    Handle* handle = GetShard(Shard(group_hash))->Lookup(key, group_hash);
+    if (handle != nullptr) {
+      NumaHitCounts* counts = numa_hit_counts_->Access();
+      if (i == 0) {
+        counts->local_hits.fetch_add(1, std::memory_order_relaxed);
+      } else {
+        counts->remote_hits.fetch_add(1, std::memory_order_relaxed);
+      }
+      return handle;
+    }
+  }
+  return nullptr;
+}
+
+bool ShardedCache::GetNumaHitCounts(uint64_t* local_hits,
+                                    uint64_t* remote_hits) const {
+  if (!numa_aware_) {
+    return false;
+  }
+  *local_hits = 0;
+  *remote_hits = 0;
+  for (size_t i = 0; i < numa_hit_counts_->Size(); i++) {
+    NumaHitCounts* counts = numa_hit_counts_->AccessAtCore(i);
+    *local_hits += counts->local_hits.load(std::memory_order_relaxed);
+    *remote_hits += counts->remote_hits.load(std::memory_order_relaxed);
+  }
+  return true;
+}
 
 void ShardedCache::SetCapacity(size_t capacity) {
   int num_shards = 1 << num_shard_bits_;
@@ -46,16 +101,66 @@ void ShardedCache::SetStrictCapacityLimit(bool strict_capacity_limit) {
 Status ShardedCache::Insert(const Slice& key, void* value, size_t charge,
                             void (*deleter)(const Slice& key, void* value),
                             Handle** handle, Priority priority) {
-  uint32_t hash = HashSlice(key);
+  uint32_t hash = NumaHash(HashSlice(key), NumaNodeGroup());
   return GetShard(Shard(hash))
       ->Insert(key, hash, value, charge, deleter, handle, priority);
 }
 
+Status ShardedCache::Insert(const Slice& key, void* value,
+                            const CacheItemHelper* helper, size_t charge,
+                            Handle** handle, Priority priority) {
+  assert(helper != nullptr);
+  uint32_t hash = NumaHash(HashSlice(key), NumaNodeGroup());
+  return GetShard(Shard(hash))
+      ->Insert(key, hash, value, helper, charge, handle, priority);
+}
+
+Status ShardedCache::InsertIntoPartition(
+    int partition, const Slice& key, void* value, size_t charge,
+    void (*deleter)(const Slice& key, void* value),
+    const CacheItemHelper* helper, Handle** handle, Priority priority) {
+  uint32_t hash = NumaHash(HashSlice(key), NumaNodeGroup());
+  return GetShard(Shard(hash))
+      ->InsertIntoPartition(key, hash, value, charge, deleter, helper, handle,
+                            priority, partition);
+}
+
+void ShardedCache::GetUsageOfPartition(int partition, size_t* usage,
+                                       size_t* pinned_usage) const {
+  int num_shards = 1 << num_shard_bits_;
+  *usage = 0;
+  *pinned_usage = 0;
+  for (int s = 0; s < num_shards; s++) {
+    GetShard(s)->AddPartitionUsage(partition, usage, pinned_usage);
+  }
+}
+
 Cache::Handle* ShardedCache::Lookup(const Slice& key, Statistics* /*stats*/) {
   uint32_t hash = HashSlice(key);
+  if (numa_aware_) {
+    return NumaLookup(key, hash);
+  }
   return GetShard(Shard(hash))->Lookup(key, hash);
 }
 
+Cache::Handle* ShardedCache::Lookup(const Slice& key,
+                                    const CacheItemHelper* helper,
+                                    const CreateCallback& create_cb,
+                                    Priority priority, Statistics* stats) {
+  uint32_t hash = HashSlice(key);
+  if (numa_aware_) {
+    // Look up the secondary cache only once the entry is in no node, and
+    // insert what it finds on the node of the caller.
+    Handle* handle = NumaLookup(key, hash);
+    if (handle != nullptr) {
+      return handle;
+    }
+    hash = NumaHash(hash, NumaNodeGroup());
+  }
+  return GetShard(Shard(hash))
+      ->Lookup(key, hash, helper, create_cb, priority, stats);
+}
+
 bool ShardedCache::Ref(Handle* handle) {
   uint32_t hash = GetHash(handle);
   return GetShard(Shard(hash))->Ref(handle);
@@ -68,6 +173,14 @@ bool ShardedCache::Release(Handle* handle, bool force_erase) {
 
 void ShardedCache::Erase(const Slice& key) {
   uint32_t hash = HashSlice(key);
+  if (numa_aware_) {
+    // The key may have been inserted on more than one node.
+    for (int group = 0; group < (1 << numa_node_bits_); group++) {
+      uint32_t group_hash = NumaHash(hash, group);
+      GetShard(Shard(group_hash))->Erase(key, group_hash);
+    }
+    return;
+  }
   GetShard(Shard(hash))->Erase(key, hash);
 }
 
@@ -117,6 +230,15 @@ void ShardedCache::ApplyToAllCacheEntries(void (*callback)(void*, size_t),
   }
 }
 
+void ShardedCache::ApplyToAllEntries(
+    const std::function<void(const Slice& key, void* value, size_t charge)>&
+        callback) {
+  int num_shards = 1 << num_shard_bits_;
+  for (int s = 0; s < num_shards; s++) {
+    GetShard(s)->ApplyToAllEntries(callback);
+  }
+}
+
 void ShardedCache::EraseUnRefEntries() {
   int num_shards = 1 << num_shard_bits_;
   for (int s = 0; s < num_shards; s++) {
@@ -140,12 +262,123 @@ std::string ShardedCache::GetPrintableOptions() const {
              strict_capacity_limit_);
     ret.append(buffer);
   }
+  snprintf(buffer, kBufferSize, "    numa_aware : %d\n", numa_aware_);
+  ret.append(buffer);
   snprintf(buffer, kBufferSize, "    memory_allocator : %s\n",
            memory_allocator() ? memory_allocator()->Name() : "None");
   ret.append(buffer);
   ret.append(GetShard(0)->GetPrintableOptions());
   return ret;
 }
+
+namespace {
+
+// The view of a partition of a ShardedCache returned by NewCachePartition().
+class CachePartition : public Cache {
+ public:
+  CachePartition(std::shared_ptr<ShardedCache> cache, int partition)
+      : Cache(cache->memory_allocator_ptr()),
+        cache_(std::move(cache)),
+        partition_(partition) {}
+
+  const char* Name() const override { return "CachePartition"; }
+
+  Status Insert(const Slice& key, void* value, size_t charge,
+                void (*deleter)(const Slice& key, void* value),
+                Handle** handle, Priority priority) override {
+    return cache_->InsertIntoPartition(partition_, key, value, charge, deleter,
+                                       nullptr, handle, priority);
+  }
+  Status Insert(const Slice& key, void* value, const CacheItemHelper* helper,
+                size_t charge, Handle** handle, Priority priority) override {
+    assert(helper != nullptr);
+    return cache_->InsertIntoPartition(partition_, key, value, charge,
+                                       helper->del_cb, helper, handle,
+                                       priority);
+  }
+  Handle* Lookup(const Slice& key, Statistics* stats) override {
+    return cache_->Lookup(key, stats);
+  }
+  Handle* Lookup(const Slice& key, const CacheItemHelper* helper,
+                 const CreateCallback& create_cb, Priority priority,
+                 Statistics* stats) override {
+    return cache_->Lookup(key, helper, create_cb, priority, stats);
+  }
+  bool Ref(Handle* handle) override { return cache_->Ref(handle); }
+  bool Release(Handle* handle, bool force_erase) override {
+    return cache_->Release(handle, force_erase);
+  }
+  void* Value(Handle* handle) override { return cache_->Value(handle); }
+  void Erase(const Slice& key) override { cache_->Erase(key); }
+  uint64_t NewId() override { return cache_->NewId(); }
+  void SetCapacity(size_t capacity) override { cache_->SetCapacity(capacity); }
+  void SetStrictCapacityLimit(bool strict_capacity_limit) override {
+    cache_->SetStrictCapacityLimit(strict_capacity_limit);
+  }
+  bool HasStrictCapacityLimit() const override {
+    return cache_->HasStrictCapacityLimit();
+  }
+  size_t GetCapacity() const override { return cache_->GetCapacity(); }
+  size_t GetUsage() const override {
+    size_t usage, pinned_usage;
+    cache_->GetUsageOfPartition(partition_, &usage, &pinned_usage);
+    return usage;
+  }
+  size_t GetUsage(Handle* handle) const override {
+    return cache_->GetUsage(handle);
+  }
+  size_t GetPinnedUsage() const override {
+    size_t usage, pinned_usage;
+    cache_->GetUsageOfPartition(partition_, &usage, &pinned_usage);
+    return pinned_usage;
+  }
+  size_t GetCharge(Handle* handle) const override {
+    return cache_->GetCharge(handle);
+  }
+  void ApplyToAllCacheEntries(void (*callback)(void*, size_t),
+                              bool thread_safe) override {
+    cache_->ApplyToAllCacheEntries(callback, thread_safe);
+  }
+  void ApplyToAllEntries(
+      const std::function<void(const Slice& key, void* value, size_t charge)>&
+          callback) override {
+    cache_->ApplyToAllEntries(callback);
+  }
+  void EraseUnRefEntries() override { cache_->EraseUnRefEntries(); }
+  std::string GetPrintableOptions() const override {
+    return cache_->GetPrintableOptions();
+  }
+
+ private:
+  std::shared_ptr<ShardedCache> cache_;
+  const int partition_;
+};
+
+}  // namespace
+
+std::shared_ptr<Cache> NewCachePartition(std::shared_ptr<Cache> cache,
+                                         const std::string& name) {
+  if (cache == nullptr) {
+    return nullptr;
+  }
+  // Only ShardedCaches have partitions.
+  int partition = cache->GetPartitionIndex(name);
+  if (partition < 0) {
+    return nullptr;
+  }
+  return std::make_shared<CachePartition>(
+      std::static_pointer_cast<ShardedCache>(std::move(cache)), partition);
+}
+
+int GetNumaNodeBits(int num_nodes, int num_shard_bits) {
+  int numa_node_bits = 0;
+  while ((2 << numa_node_bits) <= num_nodes &&
+         numa_node_bits < num_shard_bits) {
+    numa_node_bits++;
+  }
+  return numa_node_bits;
+}
+
 int GetDefaultCacheShardBits(size_t capacity) {
   int num_shard_bits = 0;
   size_t min_shard_size = 512L * 1024L;  // Every shard is at least 512KB.
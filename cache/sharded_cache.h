@@ -14,6 +14,7 @@
 
 #include "port/port.h"
 #include "rocksdb/cache.h"
+#include "util/core_local.h"
 #include "util/hash.h"
 
 namespace ROCKSDB_NAMESPACE {
@@ -28,7 +29,32 @@ class CacheShard {
                         size_t charge,
                         void (*deleter)(const Slice& key, void* value),
                         Cache::Handle** handle, Cache::Priority priority) = 0;
+  // Shards without a secondary cache only need the deleter of helper.
+  virtual Status Insert(const Slice& key, uint32_t hash, void* value,
+                        const Cache::CacheItemHelper* helper, size_t charge,
+                        Cache::Handle** handle, Cache::Priority priority) {
+    return Insert(key, hash, value, charge, helper->del_cb, handle, priority);
+  }
+  // Insert into a partition of the cache, see LRUCacheOptions::partitions.
+  // helper may be nullptr. Shards without partitions ignore partition.
+  virtual Status InsertIntoPartition(
+      const Slice& key, uint32_t hash, void* value, size_t charge,
+      void (*deleter)(const Slice& key, void* value),
+      const Cache::CacheItemHelper* helper, Cache::Handle** handle,
+      Cache::Priority priority, int /*partition*/) {
+    if (helper != nullptr) {
+      return Insert(key, hash, value, helper, charge, handle, priority);
+    }
+    return Insert(key, hash, value, charge, deleter, handle, priority);
+  }
   virtual Cache::Handle* Lookup(const Slice& key, uint32_t hash) = 0;
+  virtual Cache::Handle* Lookup(const Slice& key, uint32_t hash,
+                                const Cache::CacheItemHelper* /*helper*/,
+                                const Cache::CreateCallback& /*create_cb*/,
+                                Cache::Priority /*priority*/,
+                                Statistics* /*stats*/) {
+    return Lookup(key, hash);
+  }
   virtual bool Ref(Cache::Handle* handle) = 0;
   virtual bool Release(Cache::Handle* handle, bool force_erase = false) = 0;
   virtual void Erase(const Slice& key, uint32_t hash) = 0;
@@ -38,8 +64,14 @@ class CacheShard {
   virtual size_t GetPinnedUsage() const = 0;
   virtual void ApplyToAllCacheEntries(void (*callback)(void*, size_t),
                                       bool thread_safe) = 0;
+  virtual void ApplyToAllEntries(
+      const std::function<void(const Slice& key, void* value, size_t charge)>&
+      /*callback*/) {}
   virtual void EraseUnRefEntries() = 0;
   virtual std::string GetPrintableOptions() const { return ""; }
+  // Add the usage and the pinned usage of the partition in this shard.
+  virtual void AddPartitionUsage(int /*partition*/, size_t* /*usage*/,
+                                 size_t* /*pinned_usage*/) const {}
   void set_metadata_charge_policy(
       CacheMetadataChargePolicy metadata_charge_policy) {
     metadata_charge_policy_ = metadata_charge_policy;
@@ -52,10 +84,19 @@ class CacheShard {
 // Generic cache interface which shards cache by hash of keys. 2^num_shard_bits
 // shards will be created, with capacity split evenly to each of the shards.
 // Keys are sharded by the highest num_shard_bits bits of hash value.
+//
+// If numa_aware, the shards are split into 2^GetNumaNodeBits() groups, one
+// per NUMA node (a node beyond the number of groups shares the group of its
+// number modulo the number of groups). The highest bits of the hash of an
+// entry are replaced by the group of the node of the thread inserting it, so
+// that the entry goes to a shard of that group, and Ref() and Release() find
+// the shard from the hash of the handle as usual. A lookup tries the group of
+// the caller first, then the others.
 class ShardedCache : public Cache {
  public:
   ShardedCache(size_t capacity, int num_shard_bits, bool strict_capacity_limit,
-               std::shared_ptr<MemoryAllocator> memory_allocator = nullptr);
+               std::shared_ptr<MemoryAllocator> memory_allocator = nullptr,
+               bool numa_aware = false);
   virtual ~ShardedCache() = default;
   virtual const char* Name() const override = 0;
   virtual CacheShard* GetShard(int shard) = 0;
@@ -72,7 +113,14 @@ class ShardedCache : public Cache {
   virtual Status Insert(const Slice& key, void* value, size_t charge,
                         void (*deleter)(const Slice& key, void* value),
                         Handle** handle, Priority priority) override;
+  virtual Status Insert(const Slice& key, void* value,
+                        const CacheItemHelper* helper, size_t charge,
+                        Handle** handle = nullptr,
+                        Priority priority = Priority::LOW) override;
   virtual Handle* Lookup(const Slice& key, Statistics* stats) override;
+  virtual Handle* Lookup(const Slice& key, const CacheItemHelper* helper,
+                         const CreateCallback& create_cb, Priority priority,
+                         Statistics* stats = nullptr) override;
   virtual bool Ref(Handle* handle) override;
   virtual bool Release(Handle* handle, bool force_erase = false) override;
   virtual void Erase(const Slice& key) override;
@@ -84,28 +132,87 @@ class ShardedCache : public Cache {
   virtual size_t GetPinnedUsage() const override;
   virtual void ApplyToAllCacheEntries(void (*callback)(void*, size_t),
                                       bool thread_safe) override;
+  virtual void ApplyToAllEntries(
+      const std::function<void(const Slice& key, void* value, size_t charge)>&
+          callback) override;
   virtual void EraseUnRefEntries() override;
   virtual std::string GetPrintableOptions() const override;
 
+  virtual bool GetNumaHitCounts(uint64_t* local_hits,
+                                uint64_t* remote_hits) const override;
+
   int GetNumShardBits() const { return num_shard_bits_; }
+  // The shards of NUMA node group g are [g, g + 1) << (GetNumShardBits() -
+  // GetNumaNodeBits()).
+  int GetNumaNodeBits() const { return numa_node_bits_; }
+
+  // Used by the caches returned by NewCachePartition().
+  Status InsertIntoPartition(int partition, const Slice& key, void* value,
+                             size_t charge,
+                             void (*deleter)(const Slice& key, void* value),
+                             const CacheItemHelper* helper, Handle** handle,
+                             Priority priority);
+  void GetUsageOfPartition(int partition, size_t* usage,
+                           size_t* pinned_usage) const;
+  const std::shared_ptr<MemoryAllocator>& memory_allocator_ptr() const {
+    return memory_allocator_ptr_;
+  }
 
  private:
   static inline uint32_t HashSlice(const Slice& s) {
     return static_cast<uint32_t>(GetSliceNPHash64(s));
   }
 
-  uint32_t Shard(uint32_t hash) {
+  uint32_t Shard(uint32_t hash) const {
     // Note, hash >> 32 yields hash in gcc, not the zero we expect!
     return (num_shard_bits_ > 0) ? (hash >> (32 - num_shard_bits_)) : 0;
   }
 
+  // The NUMA node group of the calling thread.
+  int NumaNodeGroup() const;
+
+  // hash, with the group bits of its shard set to group.
+  uint32_t NumaHash(uint32_t hash, int group) const {
+    if (numa_node_bits_ == 0) {
+      return hash;
+    }
+    // numa_node_bits_ <= num_shard_bits_, so the shifts are below 32.
+    const int shard_shift = 32 - num_shard_bits_;
+    const int group_shift = num_shard_bits_ - numa_node_bits_;
+    uint32_t shard = (static_cast<uint32_t>(group) << group_shift) |
+                     (Shard(hash) & ((uint32_t{1} << group_shift) - 1));
+    return (shard << shard_shift) |
+           (hash & ((uint32_t{1} << shard_shift) - 1));
+  }
+
+  // Look up key in the shards of the node group of the caller, then of the
+  // other groups.
+  Handle* NumaLookup(const Slice& key, uint32_t hash);
+
+  // The hits of the lookups of a NUMA aware cache.
+  struct NumaHitCounts {
+    char padding[CACHE_LINE_SIZE - 2 * sizeof(std::atomic<uint64_t>)];
+    std::atomic<uint64_t> local_hits{0};
+    std::atomic<uint64_t> remote_hits{0};
+  };
+
   int num_shard_bits_;
+  const bool numa_aware_;
+  int numa_node_bits_;
+  std::unique_ptr<CoreLocalArray<NumaHitCounts>> numa_hit_counts_;
   mutable port::Mutex capacity_mutex_;
   size_t capacity_;
   bool strict_capacity_limit_;
   std::atomic<uint64_t> last_id_;
+  // The same as memory_allocator(), for the caches of the partitions.
+  std::shared_ptr<MemoryAllocator> memory_allocator_ptr_;
 };
 
 extern int GetDefaultCacheShardBits(size_t capacity);
 
+// The number of bits of the shard index given to the NUMA node groups of a
+// NUMA aware cache: the largest power of 2 that is at most num_nodes, and no
+// more than num_shard_bits.
+extern int GetNumaNodeBits(int num_nodes, int num_shard_bits);
+
 }  // namespace ROCKSDB_NAMESPACE
@@ -54,7 +54,7 @@ TableBuilder* NewTableBuilder(
     int level, const bool skip_filters, const uint64_t creation_time,
     const uint64_t oldest_key_time, const uint64_t target_file_size,
     const uint64_t file_creation_time, const std::string& db_id,
-    const std::string& db_session_id) {
+    const std::string& db_session_id, TableFileCreationReason reason) {
   assert((column_family_id ==
           TablePropertiesCollectorFactory::Context::kUnknownColumnFamily) ==
          column_family_name.empty());
@@ -64,7 +64,7 @@ TableBuilder* NewTableBuilder(
                           sample_for_compression, compression_opts,
                           skip_filters, column_family_name, level,
                           creation_time, oldest_key_time, target_file_size,
-                          file_creation_time, db_id, db_session_id),
+                          file_creation_time, db_id, db_session_id, reason),
       column_family_id, file);
 }
 
@@ -162,7 +162,8 @@ Status BuildTable(
           column_family_name, file_writer.get(), compression,
           sample_for_compression, compression_opts_for_flush, level,
           false /* skip_filters */, creation_time, oldest_key_time,
-          0 /*target_file_size*/, file_creation_time, db_id, db_session_id);
+          0 /*target_file_size*/, file_creation_time, db_id, db_session_id,
+          reason);
     }
 
     MergeHelper merge(env, internal_comparator.user_comparator(),
@@ -1646,7 +1646,7 @@ Status CompactionJob::OpenCompactionOutputFile(
       sub_compact->compaction->output_level(), skip_filters,
       oldest_ancester_time, 0 /* oldest_key_time */,
       sub_compact->compaction->max_output_file_size(), current_time, db_id_,
-      db_session_id_));
+      db_session_id_, TableFileCreationReason::kCompaction));
   LogFlush(db_options_.info_log);
   return s;
 }
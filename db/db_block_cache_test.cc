@@ -8,8 +8,10 @@
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 #include <cstdlib>
 
+#include "cache/cache_reservation_manager.h"
 #include "cache/lru_cache.h"
 #include "db/db_test_util.h"
+#include "file/filename.h"
 #include "port/stack_trace.h"
 #include "util/compression.h"
 #include "util/random.h"
@@ -343,6 +345,160 @@ TEST_F(DBBlockCacheTest, IndexAndFilterBlocksOfNewTableAddedToCache) {
             TestGetTickerCount(options, BLOCK_CACHE_INDEX_HIT));
 }
 
+TEST_F(DBBlockCacheTest, PrepopulateBlockCache) {
+  Options options = CurrentOptions();
+  options.create_if_missing = true;
+  options.disable_auto_compactions = true;
+  options.statistics = ROCKSDB_NAMESPACE::CreateDBStatistics();
+  BlockBasedTableOptions table_options;
+  table_options.block_cache = NewLRUCache(16 << 20);
+  table_options.cache_index_and_filter_blocks = true;
+  table_options.filter_policy.reset(NewBloomFilterPolicy(10, false));
+  table_options.block_size = 1;
+  table_options.prepopulate_block_cache =
+      BlockBasedTableOptions::PrepopulateBlockCache::kFlushOnly;
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  DestroyAndReopen(options);
+
+  // Blocks written by flush are read from the block cache. Every file has
+  // the last key, so that compaction cannot trivially move them.
+  const int kNumKeys = 10;
+  for (int i = 0; i < kNumKeys; i++) {
+    ASSERT_OK(Put(Key(i), "v" + ToString(i)));
+    ASSERT_OK(Put(Key(kNumKeys), "v" + ToString(i)));
+    ASSERT_OK(Flush());
+    ASSERT_EQ(2 * (i + 1), TestGetTickerCount(options, BLOCK_CACHE_DATA_ADD));
+    ASSERT_EQ("v" + ToString(i), Get(Key(i)));
+    ASSERT_EQ(0, TestGetTickerCount(options, BLOCK_CACHE_DATA_MISS));
+    ASSERT_EQ(i + 1, TestGetTickerCount(options, BLOCK_CACHE_DATA_HIT));
+  }
+  ASSERT_EQ(0, TestGetTickerCount(options, BLOCK_CACHE_INDEX_MISS));
+  ASSERT_EQ(0, TestGetTickerCount(options, BLOCK_CACHE_FILTER_MISS));
+
+  // Blocks written by compaction are not.
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  ASSERT_EQ("0,1", FilesPerLevel());
+  ASSERT_EQ(2 * kNumKeys, TestGetTickerCount(options, BLOCK_CACHE_DATA_ADD));
+  for (int i = 0; i < kNumKeys; i++) {
+    ASSERT_EQ("v" + ToString(i), Get(Key(i)));
+  }
+  ASSERT_EQ(kNumKeys, TestGetTickerCount(options, BLOCK_CACHE_DATA_MISS));
+
+  // Unless they are written to a level up to the configured one.
+  table_options.prepopulate_block_cache =
+      BlockBasedTableOptions::PrepopulateBlockCache::kUpToLevel;
+  table_options.prepopulate_block_cache_max_level = 1;
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  options.statistics = ROCKSDB_NAMESPACE::CreateDBStatistics();
+  Reopen(options);
+  CompactRangeOptions cro;
+  cro.bottommost_level_compaction = BottommostLevelCompaction::kForce;
+  ASSERT_OK(db_->CompactRange(cro, nullptr, nullptr));
+  ASSERT_EQ("0,1", FilesPerLevel());
+  ASSERT_EQ(kNumKeys + 1, TestGetTickerCount(options, BLOCK_CACHE_DATA_ADD));
+  // The compaction itself may have missed on blocks of its input file.
+  uint64_t data_miss = TestGetTickerCount(options, BLOCK_CACHE_DATA_MISS);
+  for (int i = 0; i < kNumKeys; i++) {
+    ASSERT_EQ("v" + ToString(i), Get(Key(i)));
+  }
+  ASSERT_EQ(data_miss, TestGetTickerCount(options, BLOCK_CACHE_DATA_MISS));
+
+  table_options.prepopulate_block_cache_max_level = 0;
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  options.statistics = ROCKSDB_NAMESPACE::CreateDBStatistics();
+  Reopen(options);
+  ASSERT_OK(db_->CompactRange(cro, nullptr, nullptr));
+  ASSERT_EQ(0, TestGetTickerCount(options, BLOCK_CACHE_DATA_ADD));
+}
+
+TEST_F(DBBlockCacheTest, ReserveTableReaderMemory) {
+  const size_t kSizeDummyEntry = CacheReservationManager::kSizeDummyEntry;
+  Options options = CurrentOptions();
+  options.create_if_missing = true;
+  options.disable_auto_compactions = true;
+  BlockBasedTableOptions table_options;
+  table_options.block_cache =
+      NewLRUCache(16 << 20, -1, false, 0.0, nullptr, kDefaultToAdaptiveMutex,
+                  kDontChargeCacheMetadata);
+  table_options.filter_policy.reset(NewBloomFilterPolicy(10, false));
+  table_options.reserve_table_builder_memory = true;
+  table_options.reserve_table_reader_memory = true;
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  DestroyAndReopen(options);
+
+  for (int i = 0; i < 3; i++) {
+    ASSERT_OK(Put(Key(i), "v" + ToString(i)));
+    ASSERT_OK(Flush());
+  }
+  // One dummy entry for the table readers, and one for the decompression
+  // contexts. The builders released theirs when they were done.
+  ASSERT_EQ(2 * kSizeDummyEntry, table_options.block_cache->GetPinnedUsage());
+  for (int i = 0; i < 3; i++) {
+    ASSERT_EQ("v" + ToString(i), Get(Key(i)));
+  }
+
+  // Closing the table readers gives back their memory.
+  Close();
+  ASSERT_EQ(kSizeDummyEntry, table_options.block_cache->GetPinnedUsage());
+
+  // A table reader that cannot be charged to a full cache is not opened.
+  table_options.block_cache = NewLRUCache(kSizeDummyEntry / 2, 0, true);
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  ASSERT_TRUE(TryReopen(options).IsMemoryLimit());
+}
+
+TEST_F(DBBlockCacheTest, BlockCachePartition) {
+  Options options = CurrentOptions();
+  options.create_if_missing = true;
+  LRUCacheOptions cache_opts(16 << 20, 0, false, 0.0, nullptr,
+                             kDefaultToAdaptiveMutex,
+                             kDontChargeCacheMetadata);
+  cache_opts.partitions.emplace_back("tenant", 1 << 20, 4 << 20);
+  BlockBasedTableOptions table_options;
+  table_options.block_cache = NewLRUCache(cache_opts);
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  Options tenant_options = options;
+  table_options.block_cache_partition = "tenant";
+  tenant_options.table_factory.reset(
+      NewBlockBasedTableFactory(table_options));
+  DestroyAndReopen(options);
+  CreateColumnFamilies({"pikachu"}, tenant_options);
+  ReopenWithColumnFamilies({"default", "pikachu"},
+                           std::vector<Options>{options, tenant_options});
+
+  ASSERT_OK(Put(1, "foo", "bar"));
+  ASSERT_OK(Flush(1));
+  ASSERT_EQ("bar", Get(1, "foo"));
+
+  // The data block read from the table of pikachu is charged to its
+  // partition.
+  std::map<std::string, std::string> props;
+  ASSERT_TRUE(dbfull()->GetMapProperty(
+      handles_[1], DB::Properties::kBlockCachePartitions, &props));
+  ASSERT_EQ(8, props.size());
+  uint64_t tenant_usage = ParseUint64(props["tenant.usage"]);
+  ASSERT_GT(tenant_usage, 0);
+  ASSERT_EQ(table_options.block_cache->GetUsage(), tenant_usage);
+  ASSERT_EQ("0", props["tenant.pinned-usage"]);
+  ASSERT_EQ(ToString(1 << 20), props["tenant.reserved-capacity"]);
+  ASSERT_EQ(ToString(4 << 20), props["tenant.max-capacity"]);
+  ASSERT_EQ("0", props["default.usage"]);
+  std::string value;
+  ASSERT_TRUE(
+      dbfull()->GetProperty(DB::Properties::kBlockCachePartitions, &value));
+  ASSERT_NE(std::string::npos,
+            value.find("tenant.usage: " + ToString(tenant_usage)));
+
+  // The block cache must have the partition.
+  table_options.block_cache_partition = "nobody";
+  tenant_options.table_factory.reset(
+      NewBlockBasedTableFactory(table_options));
+  ASSERT_TRUE(
+      TryReopenWithColumnFamilies(
+          {"default", "pikachu"}, std::vector<Options>{options, tenant_options})
+          .IsInvalidArgument());
+}
+
 // With fill_cache = false, fills up the cache, then iterates over the entire
 // db, verify dummy entries inserted in `BlockBasedTable::NewDataBlockIterator`
 // does not cause heap-use-after-free errors in COMPILE_WITH_ASAN=1 runs
@@ -446,6 +602,8 @@ class MockCache : public LRUCache {
                  false /*strict_capacity_limit*/, 0.0 /*high_pri_pool_ratio*/) {
   }
 
+  using LRUCache::Lookup;
+
   Status Insert(const Slice& key, void* value, size_t charge,
                 void (*deleter)(const Slice& key, void* value), Handle** handle,
                 Priority priority) override {
@@ -456,6 +614,16 @@ class MockCache : public LRUCache {
     }
     return LRUCache::Insert(key, value, charge, deleter, handle, priority);
   }
+
+  Status Insert(const Slice& key, void* value, const CacheItemHelper* helper,
+                size_t charge, Handle** handle, Priority priority) override {
+    if (priority == Priority::LOW) {
+      low_pri_insert_count++;
+    } else {
+      high_pri_insert_count++;
+    }
+    return LRUCache::Insert(key, value, helper, charge, handle, priority);
+  }
 };
 
 uint32_t MockCache::high_pri_insert_count = 0;
@@ -533,6 +701,8 @@ class LookupLiarCache : public CacheWrapper {
   explicit LookupLiarCache(std::shared_ptr<Cache> target)
       : CacheWrapper(std::move(target)) {}
 
+  using CacheWrapper::Lookup;
+
   Handle* Lookup(const Slice& key, Statistics* stats) override {
     if (nth_lookup_not_found_ == 1) {
       nth_lookup_not_found_ = 0;
@@ -886,6 +1056,51 @@ TEST_F(DBBlockCacheTest, CacheCompressionDict) {
   }
 }
 
+TEST_F(DBBlockCacheTest, PersistBlockCacheKeys) {
+  const int kNumKeys = 100;
+  BlockBasedTableOptions table_options = GetTableOptions();
+  table_options.block_cache = NewLRUCache(4 << 20, 0, false);
+  Options options = GetOptions(table_options);
+  options.persist_block_cache_keys = true;
+  DestroyAndReopen(options);
+
+  std::string value(kValueSize, 'a');
+  for (int i = 0; i < kNumKeys; i++) {
+    ASSERT_OK(Put(Key(i), value));
+  }
+  ASSERT_OK(Flush());
+  for (int i = 0; i < kNumKeys; i += 2) {
+    ASSERT_EQ(value, Get(Key(i)));
+  }
+
+  // Restart with an empty block cache.
+  table_options.block_cache = NewLRUCache(4 << 20, 0, false);
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  Close();
+  ASSERT_OK(env_->FileExists(BlockCacheKeysFileName(dbname_)));
+  Reopen(options);
+  ASSERT_TRUE(env_->FileExists(BlockCacheKeysFileName(dbname_)).IsNotFound());
+  ASSERT_OK(db_->WaitForBlockCacheWarmup());
+
+  // The blocks read before the restart are cached, the others are not.
+  uint64_t misses = TestGetTickerCount(options, BLOCK_CACHE_DATA_MISS);
+  for (int i = 0; i < kNumKeys; i += 2) {
+    ASSERT_EQ(value, Get(Key(i)));
+  }
+  ASSERT_EQ(misses, TestGetTickerCount(options, BLOCK_CACHE_DATA_MISS));
+  for (int i = 1; i < kNumKeys; i += 2) {
+    ASSERT_EQ(value, Get(Key(i)));
+  }
+  ASSERT_EQ(misses + kNumKeys / 2,
+            TestGetTickerCount(options, BLOCK_CACHE_DATA_MISS));
+
+  // Without the option the file is neither written nor replayed.
+  options.persist_block_cache_keys = false;
+  Reopen(options);
+  Close();
+  ASSERT_TRUE(env_->FileExists(BlockCacheKeysFileName(dbname_)).IsNotFound());
+}
+
 #endif  // ROCKSDB_LITE
 
 class DBBlockCachePinningTest
@@ -522,6 +522,106 @@ TEST_F(DBFlushTest, FlushWithBlob) {
 #endif  // ROCKSDB_LITE
 }
 
+TEST_F(DBFlushTest, MemPurge) {
+  Options options = CurrentOptions();
+  options.write_buffer_size = 64 << 10;
+  options.max_write_buffer_number = 4;
+  options.mempurge_threshold = 0.5;
+  options.disable_auto_compactions = true;
+  Reopen(options);
+
+  std::atomic<int> num_purges(0);
+  SyncPoint::GetInstance()->SetCallBack(
+      "FlushJob::MemPurge:Output", [&](void* arg) {
+        if (static_cast<Status*>(arg)->ok()) {
+          num_purges++;
+        }
+      });
+  SyncPoint::GetInstance()->EnableProcessing();
+
+  // Overwrite and delete a few hot keys, so that each full memtable shrinks
+  // to a small fraction of its size.
+  constexpr int kNumKeys = 10;
+  Random rnd(301);
+  std::vector<std::string> values(kNumKeys);
+  // An older version of a key is kept for a snapshot.
+  const Snapshot* snapshot = nullptr;
+  std::string snapshot_value;
+  auto write_hot_keys = [&]() {
+    for (int i = 0; i < 2000; i++) {
+      const int k = i % kNumKeys;
+      if (k == 0 && i % 7 == 0) {
+        ASSERT_OK(Delete(Key(k)));
+        values[k].clear();
+      } else {
+        values[k] = rnd.RandomString(1000);
+        ASSERT_OK(Put(Key(k), values[k]));
+      }
+      if (i == 1000 && snapshot == nullptr) {
+        snapshot = db_->GetSnapshot();
+        snapshot_value = values[1];
+      }
+    }
+    ASSERT_OK(dbfull()->TEST_WaitForCompact());
+  };
+  auto verify = [&]() {
+    for (int k = 0; k < kNumKeys; k++) {
+      ASSERT_EQ(values[k].empty() ? "NOT_FOUND" : values[k], Get(Key(k)));
+    }
+    if (snapshot != nullptr) {
+      ASSERT_EQ(snapshot_value, Get(Key(1), snapshot));
+    }
+  };
+
+  write_hot_keys();
+#ifndef NDEBUG
+  ASSERT_GT(num_purges.load(), 0);
+#endif  // !NDEBUG
+  ASSERT_EQ(0, NumTableFilesAtLevel(0));
+  verify();
+
+  // The purged data is only in memory and in the WAL files, which are
+  // replayed on recovery.
+  db_->ReleaseSnapshot(snapshot);
+  snapshot = nullptr;
+  options.avoid_flush_during_shutdown = true;
+  Reopen(options);
+  verify();
+
+  // Only an explicit flush writes the purged memtable to L0.
+  const int num_files = NumTableFilesAtLevel(0);
+  write_hot_keys();
+  ASSERT_EQ(num_files, NumTableFilesAtLevel(0));
+  verify();
+  ASSERT_OK(Flush());
+  ASSERT_EQ(num_files + 1, NumTableFilesAtLevel(0));
+  verify();
+  db_->ReleaseSnapshot(snapshot);
+
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+}
+
+TEST_F(DBFlushTest, MemPurgeFallsBackToFlush) {
+  Options options = CurrentOptions();
+  options.write_buffer_size = 64 << 10;
+  options.max_write_buffer_number = 4;
+  options.mempurge_threshold = 0.5;
+  options.disable_auto_compactions = true;
+  Reopen(options);
+
+  // Unique keys do not shrink, so every memtable is flushed to L0.
+  Random rnd(301);
+  for (int i = 0; i < 300; i++) {
+    ASSERT_OK(Put(Key(i), rnd.RandomString(1000)));
+  }
+  ASSERT_OK(dbfull()->TEST_WaitForCompact());
+  ASSERT_GT(NumTableFilesAtLevel(0), 0);
+  for (int i = 0; i < 300; i++) {
+    ASSERT_EQ(1000, Get(Key(i)).size());
+  }
+}
+
 class DBFlushTestBlobError : public DBFlushTest,
                              public testing::WithParamInterface<std::string> {
  public:
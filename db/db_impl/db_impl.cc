@@ -497,6 +497,12 @@ Status DBImpl::CloseHelper() {
   }
   mutex_.Unlock();
 
+  StopBlockCacheWarmup();
+  if (persist_block_cache_keys_) {
+    // Errors are logged, a missing dump only costs a cold block cache.
+    DumpBlockCacheKeys().PermitUncheckedError();
+  }
+
   // CancelAllBackgroundWork called with false means we just set the shutdown
   // marker. After this we do a variant of the waiting and unschedule work
   // (to consider: moving all the waiting into CancelAllBackgroundWork(true))
@@ -3873,6 +3879,8 @@ Status DestroyDB(const std::string& dbname, const Options& options,
         }
       }
     }
+    // Not a numbered DB file, so ParseFileName() does not know about it.
+    env->DeleteFile(BlockCacheKeysFileName(dbname)).PermitUncheckedError();
 
     std::set<std::string> paths;
     for (const DbPath& db_path : options.db_paths) {
@@ -434,6 +434,10 @@ class DBImpl : public DB {
   using DB::VerifyChecksum;
   virtual Status VerifyChecksum(const ReadOptions& /*read_options*/) override;
 
+  // Implemented in db_impl_block_cache.cc
+  virtual Status DumpBlockCacheKeys() override;
+  virtual Status WaitForBlockCacheWarmup() override;
+
   using DB::StartTrace;
   virtual Status StartTrace(
       const TraceOptions& options,
@@ -1608,6 +1612,15 @@ class DBImpl : public DB {
 
   void MaybeScheduleFlushOrCompaction();
 
+  // Block cache warm-up, see DBOptions::persist_block_cache_keys.
+  struct BlockCacheWarmupState;
+  // Reads the BLOCK_CACHE_KEYS file left by the last DB::Close() and starts
+  // the threads reading the blocks it lists back into the block cache.
+  void StartBlockCacheWarmup();
+  void BGWorkBlockCacheWarmup(BlockCacheWarmupState* state);
+  // Stops the warm-up threads and waits for them to exit.
+  void StopBlockCacheWarmup();
+
   // A flush request specifies the column families to flush as well as the
   // largest memtable id to persist for each column family. Once all the
   // memtables whose IDs are smaller than or equal to this per-column-family
@@ -2099,6 +2112,11 @@ class DBImpl : public DB {
   // Indicate DB was opened successfully
   bool opened_successfully_;
 
+  // Whether closing the DB records the cached blocks, set by DB::Open().
+  bool persist_block_cache_keys_ = false;
+  std::shared_ptr<BlockCacheWarmupState> block_cache_warmup_;
+  std::vector<port::Thread> block_cache_warmup_threads_;
+
   // The min threshold to triggere bottommost compaction for removing
   // garbages, among all column families.
   SequenceNumber bottommost_files_mark_threshold_ = kMaxSequenceNumber;
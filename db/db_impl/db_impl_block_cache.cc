@@ -0,0 +1,393 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+//
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// Persisting the block cache across restarts (DBOptions::
+// persist_block_cache_keys): DB::Close() records which blocks of the live
+// table files are resident in the block cache into the BLOCK_CACHE_KEYS file,
+// and the next DB::Open() reads them back in background threads.
+//
+// BLOCK_CACHE_KEYS format:
+//   varint32 format version
+//   length prefixed DB id
+//   for each table file:
+//     varint64 file number
+//     varint64 number of blocks
+//     for each block: varint64 offset, 1 byte BlockType
+//   fixed32 masked crc32c of everything above
+#include <algorithm>
+#include <cinttypes>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+
+#include "db/db_impl/db_impl.h"
+#include "db/table_cache.h"
+#include "db/version_set.h"
+#include "file/filename.h"
+#include "logging/logging.h"
+#include "table/table_reader.h"
+#include "util/autovector.h"
+#include "util/coding.h"
+#include "util/crc32c.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+namespace {
+const uint32_t kBlockCacheKeysFormatVersion = 1;
+
+struct WarmupTable {
+  uint64_t file_number = 0;
+  std::vector<CachedBlockInfo> blocks;
+};
+}  // namespace
+
+struct DBImpl::BlockCacheWarmupState {
+  std::vector<WarmupTable> tables;
+  size_t num_blocks = 0;
+  uint64_t start_micros = 0;
+  // Index into `tables` of the next table to load.
+  std::atomic<size_t> next_table{0};
+  std::atomic<bool> stop{false};
+
+  std::mutex mu;
+  std::condition_variable cv;
+  int running_threads = 0;
+};
+
+namespace {
+Status DecodeBlockCacheKeys(const std::string& data, const std::string& db_id,
+                            std::vector<WarmupTable>* tables,
+                            size_t* num_blocks) {
+  if (data.size() < sizeof(uint32_t)) {
+    return Status::Corruption("BLOCK_CACHE_KEYS file too short");
+  }
+  const size_t payload_size = data.size() - sizeof(uint32_t);
+  const uint32_t expected_crc =
+      crc32c::Unmask(DecodeFixed32(data.data() + payload_size));
+  if (crc32c::Value(data.data(), payload_size) != expected_crc) {
+    return Status::Corruption("BLOCK_CACHE_KEYS checksum mismatch");
+  }
+  Slice input(data.data(), payload_size);
+  uint32_t version = 0;
+  Slice file_db_id;
+  if (!GetVarint32(&input, &version) ||
+      !GetLengthPrefixedSlice(&input, &file_db_id)) {
+    return Status::Corruption("BLOCK_CACHE_KEYS bad header");
+  }
+  if (version != kBlockCacheKeysFormatVersion) {
+    return Status::NotSupported("BLOCK_CACHE_KEYS unknown format version",
+                                ToString(version));
+  }
+  if (file_db_id != db_id) {
+    return Status::InvalidArgument("BLOCK_CACHE_KEYS from another DB",
+                                   file_db_id);
+  }
+  *num_blocks = 0;
+  while (!input.empty()) {
+    tables->emplace_back();
+    WarmupTable& table = tables->back();
+    uint64_t count = 0;
+    if (!GetVarint64(&input, &table.file_number) ||
+        !GetVarint64(&input, &count)) {
+      return Status::Corruption("BLOCK_CACHE_KEYS bad table record");
+    }
+    for (uint64_t i = 0; i < count; i++) {
+      CachedBlockInfo block;
+      if (!GetVarint64(&input, &block.offset) || input.empty() ||
+          static_cast<uint8_t>(input[0]) >
+              static_cast<uint8_t>(BlockType::kInvalid)) {
+        return Status::Corruption("BLOCK_CACHE_KEYS bad block record");
+      }
+      block.type = static_cast<BlockType>(input[0]);
+      input.remove_prefix(1);
+      table.blocks.push_back(block);
+    }
+    *num_blocks += table.blocks.size();
+  }
+  return Status::OK();
+}
+}  // namespace
+
+Status DBImpl::DumpBlockCacheKeys() {
+  // A table whose blocks may be in a block cache, pinned in the table cache
+  // until the dump is written.
+  struct OpenTable {
+    uint64_t file_number;
+    TableCache* table_cache;
+    Cache::Handle* handle;
+    TableReader* reader;
+    std::vector<CachedBlockInfo> blocks;
+  };
+
+  autovector<Version*> versions;
+  {
+    InstrumentedMutexLock l(&mutex_);
+    for (auto cfd : *versions_->GetColumnFamilySet()) {
+      if (cfd->IsDropped() || !cfd->initialized()) {
+        continue;
+      }
+      cfd->current()->Ref();
+      versions.push_back(cfd->current());
+    }
+  }
+
+  // Only tables open in the table cache are considered, opening the others
+  // just to learn their cache key prefix is not worth the IO at shutdown.
+  std::deque<OpenTable> tables;
+  std::unordered_map<Cache*, std::unordered_map<std::string, OpenTable*>>
+      tables_by_prefix;
+  const ReadOptions ro;
+  for (Version* v : versions) {
+    ColumnFamilyData* cfd = v->cfd();
+    const VersionStorageInfo* vstorage = v->storage_info();
+    for (int level = 0; level < vstorage->num_non_empty_levels(); level++) {
+      for (FileMetaData* f : vstorage->LevelFiles(level)) {
+        Cache::Handle* handle = nullptr;
+        Status s = cfd->table_cache()->FindTable(
+            ro, file_options_, cfd->internal_comparator(), f->fd, &handle,
+            nullptr /* prefix_extractor */, true /* no_io */);
+        if (!s.ok()) {
+          continue;
+        }
+        TableReader* reader =
+            cfd->table_cache()->GetTableReaderFromHandle(handle);
+        Cache* block_cache = nullptr;
+        std::string prefix;
+        if (reader->GetBlockCacheKeyPrefix(&block_cache, &prefix).ok() &&
+            block_cache != nullptr) {
+          tables.push_back(OpenTable{f->fd.GetNumber(), cfd->table_cache(),
+                                     handle, reader, {}});
+          tables_by_prefix[block_cache][prefix] = &tables.back();
+        } else {
+          cfd->table_cache()->ReleaseHandle(handle);
+        }
+      }
+    }
+  }
+
+  for (auto& cache_tables : tables_by_prefix) {
+    const auto& by_prefix = cache_tables.second;
+    std::set<size_t> prefix_sizes;
+    for (const auto& e : by_prefix) {
+      prefix_sizes.insert(e.first.size());
+    }
+    // The cache key of a block is the table prefix followed by the varint64
+    // encoded block offset, see BlockBasedTable::GetCacheKey().
+    cache_tables.first->ApplyToAllEntries(
+        [&](const Slice& key, void* /*value*/, size_t /*charge*/) {
+          for (size_t prefix_size : prefix_sizes) {
+            if (key.size() <= prefix_size) {
+              break;
+            }
+            auto it = by_prefix.find(std::string(key.data(), prefix_size));
+            if (it == by_prefix.end()) {
+              continue;
+            }
+            Slice rest(key.data() + prefix_size, key.size() - prefix_size);
+            uint64_t offset = 0;
+            if (GetVarint64(&rest, &offset) && rest.empty()) {
+              it->second->blocks.push_back(
+                  CachedBlockInfo{offset, BlockType::kInvalid});
+              break;
+            }
+          }
+        });
+  }
+
+  std::string data;
+  PutVarint32(&data, kBlockCacheKeysFormatVersion);
+  PutLengthPrefixedSlice(&data, db_id_);
+  size_t num_tables = 0;
+  size_t num_blocks = 0;
+  for (OpenTable& table : tables) {
+    if (!table.blocks.empty()) {
+      std::sort(table.blocks.begin(), table.blocks.end(),
+                [](const CachedBlockInfo& a, const CachedBlockInfo& b) {
+                  return a.offset < b.offset;
+                });
+      PutVarint64(&data, table.file_number);
+      PutVarint64(&data, table.blocks.size());
+      for (const CachedBlockInfo& block : table.blocks) {
+        PutVarint64(&data, block.offset);
+        data.push_back(
+            static_cast<char>(table.reader->GetBlockTypeAt(block.offset)));
+      }
+      num_tables++;
+      num_blocks += table.blocks.size();
+    }
+    table.table_cache->ReleaseHandle(table.handle);
+  }
+  PutFixed32(&data, crc32c::Mask(crc32c::Value(data.data(), data.size())));
+
+  {
+    InstrumentedMutexLock l(&mutex_);
+    for (Version* v : versions) {
+      v->Unref();
+    }
+  }
+
+  const std::string tmp_fname =
+      TempFileName(dbname_, versions_->NewFileNumber());
+  Status s = WriteStringToFile(env_, data, tmp_fname, true /* should_sync */);
+  if (s.ok()) {
+    s = env_->RenameFile(tmp_fname, BlockCacheKeysFileName(dbname_));
+  }
+  if (s.ok()) {
+    ROCKS_LOG_INFO(immutable_db_options_.info_log,
+                   "Recorded %" ROCKSDB_PRIszt
+                   " cached blocks of %" ROCKSDB_PRIszt " tables in %s",
+                   num_blocks, num_tables,
+                   BlockCacheKeysFileName(dbname_).c_str());
+  } else {
+    env_->DeleteFile(tmp_fname).PermitUncheckedError();
+    ROCKS_LOG_WARN(immutable_db_options_.info_log,
+                   "Failed to record cached blocks: %s", s.ToString().c_str());
+  }
+  return s;
+}
+
+void DBImpl::StartBlockCacheWarmup() {
+  const std::string fname = BlockCacheKeysFileName(dbname_);
+  if (!env_->FileExists(fname).ok()) {
+    return;
+  }
+  std::string data;
+  Status s = ReadFileToString(env_, fname, &data);
+  // The recorded blocks describe the state at the last close only, never
+  // replay them twice.
+  env_->DeleteFile(fname).PermitUncheckedError();
+  if (!immutable_db_options_.persist_block_cache_keys) {
+    return;
+  }
+
+  auto state = std::make_shared<BlockCacheWarmupState>();
+  if (s.ok()) {
+    s = DecodeBlockCacheKeys(data, db_id_, &state->tables, &state->num_blocks);
+  }
+  if (!s.ok()) {
+    ROCKS_LOG_WARN(immutable_db_options_.info_log,
+                   "Skipping block cache warm-up: %s", s.ToString().c_str());
+    return;
+  }
+  if (state->tables.empty()) {
+    return;
+  }
+
+  const int num_threads = static_cast<int>(
+      std::min(static_cast<size_t>(std::max(
+                   immutable_db_options_.block_cache_warmup_threads, 1)),
+               state->tables.size()));
+  ROCKS_LOG_INFO(immutable_db_options_.info_log,
+                 "Warming up block cache with %" ROCKSDB_PRIszt
+                 " blocks of %" ROCKSDB_PRIszt " tables in %d threads",
+                 state->num_blocks, state->tables.size(), num_threads);
+  state->start_micros = env_->NowMicros();
+  state->running_threads = num_threads;
+  block_cache_warmup_ = state;
+  for (int i = 0; i < num_threads; i++) {
+    block_cache_warmup_threads_.emplace_back(
+        [this, state]() { BGWorkBlockCacheWarmup(state.get()); });
+  }
+}
+
+void DBImpl::BGWorkBlockCacheWarmup(BlockCacheWarmupState* state) {
+  const ReadOptions ro;
+  size_t num_tables = 0;
+  while (!state->stop.load(std::memory_order_relaxed)) {
+    const size_t i = state->next_table.fetch_add(1, std::memory_order_relaxed);
+    if (i >= state->tables.size()) {
+      break;
+    }
+    const WarmupTable& table = state->tables[i];
+
+    Version* version = nullptr;
+    FileMetaData* file = nullptr;
+    int level = -1;
+    std::shared_ptr<const SliceTransform> prefix_extractor;
+    {
+      InstrumentedMutexLock l(&mutex_);
+      for (auto cfd : *versions_->GetColumnFamilySet()) {
+        if (cfd->IsDropped() || !cfd->initialized()) {
+          continue;
+        }
+        const VersionStorageInfo* vstorage = cfd->current()->storage_info();
+        auto location = vstorage->GetFileLocation(table.file_number);
+        if (location.IsValid()) {
+          version = cfd->current();
+          version->Ref();
+          level = location.GetLevel();
+          file = vstorage->LevelFiles(level)[location.GetPosition()];
+          prefix_extractor =
+              cfd->GetLatestMutableCFOptions()->prefix_extractor;
+          break;
+        }
+      }
+    }
+    if (version == nullptr) {
+      // Compacted away since the blocks were recorded.
+      continue;
+    }
+
+    ColumnFamilyData* cfd = version->cfd();
+    Cache::Handle* handle = nullptr;
+    Status s = cfd->table_cache()->FindTable(
+        ro, file_options_, cfd->internal_comparator(), file->fd, &handle,
+        prefix_extractor.get(), false /* no_io */,
+        true /* record_read_stats */, nullptr /* file_read_hist */,
+        false /* skip_filters */, level);
+    if (s.ok()) {
+      s = cfd->table_cache()
+              ->GetTableReaderFromHandle(handle)
+              ->LoadBlocksIntoCache(ro, table.blocks);
+      cfd->table_cache()->ReleaseHandle(handle);
+    }
+    if (s.ok()) {
+      num_tables++;
+    } else {
+      ROCKS_LOG_WARN(immutable_db_options_.info_log,
+                     "Block cache warm-up of table #%" PRIu64 " failed: %s",
+                     table.file_number, s.ToString().c_str());
+    }
+
+    InstrumentedMutexLock l(&mutex_);
+    version->Unref();
+  }
+
+  std::lock_guard<std::mutex> lock(state->mu);
+  if (--state->running_threads == 0) {
+    ROCKS_LOG_INFO(immutable_db_options_.info_log,
+                   "Block cache warm-up %s after %" PRIu64 " ms",
+                   state->stop.load() ? "stopped" : "finished",
+                   (env_->NowMicros() - state->start_micros) / 1000);
+  }
+  state->cv.notify_all();
+}
+
+Status DBImpl::WaitForBlockCacheWarmup() {
+  std::shared_ptr<BlockCacheWarmupState> state = block_cache_warmup_;
+  if (state) {
+    std::unique_lock<std::mutex> lock(state->mu);
+    state->cv.wait(lock, [&] { return state->running_threads == 0; });
+  }
+  return Status::OK();
+}
+
+void DBImpl::StopBlockCacheWarmup() {
+  if (block_cache_warmup_) {
+    block_cache_warmup_->stop.store(true, std::memory_order_relaxed);
+  }
+  for (auto& t : block_cache_warmup_threads_) {
+    t.join();
+  }
+  block_cache_warmup_threads_.clear();
+}
+
+}  // namespace ROCKSDB_NAMESPACE
@@ -21,6 +21,7 @@
 #include "rocksdb/table.h"
 #include "rocksdb/wal_filter.h"
 #include "test_util/sync_point.h"
+#include "util/compression.h"
 #include "util/rate_limiter.h"
 
 namespace ROCKSDB_NAMESPACE {
@@ -238,6 +239,12 @@ Status DBImpl::ValidateOptions(const DBOptions& db_options) {
     return Status::InvalidArgument("keep_log_file_num must be greater than 0");
   }
 
+  if (!StreamingCompressionTypeSupported(db_options.wal_compression)) {
+    return Status::InvalidArgument(
+        "wal_compression is not supported: " +
+        CompressionTypeToString(db_options.wal_compression));
+  }
+
   if (db_options.unordered_write &&
       !db_options.allow_concurrent_memtable_write) {
     return Status::InvalidArgument(
@@ -823,18 +830,82 @@ Status DBImpl::RecoverLogFiles(const std::vector<uint64_t>& log_numbers,
   }
 #endif
 
+  // The logs being replayed. With several WAL streams (num_wal_streams), the
+  // logs of a generation are written to concurrently, so their records are
+  // replayed in the order of their sequence numbers instead of log by log.
+  // A log is opened once the logs before it could hold no earlier record:
+  // the logs of a generation are created together and the first record of
+  // each of them follows the first records of the logs before it. With a
+  // single stream this replays the logs one after the other.
+  struct LogReplay {
+    uint64_t log_number;
+    std::string fname;
+    LogReporter reporter;
+    Status status;
+    std::unique_ptr<log::Reader> reader;
+    std::string scratch;
+    // The next record of the log, if has_record
+    WriteBatch batch;
+    SequenceNumber sequence = 0;
+    bool has_record = false;
+    SequenceNumber first_sequence = kMaxSequenceNumber;
+  };
+  std::deque<std::unique_ptr<LogReplay>> replays;
+  size_t next_log_index = 0;
+
   bool stop_replay_by_wal_filter = false;
   bool stop_replay_for_corruption = false;
   bool flushed = false;
   uint64_t corrupted_log_number = kMaxSequenceNumber;
   uint64_t min_log_number = MinLogNumberToKeep();
-  for (auto log_number : log_numbers) {
+  // Once the records of different logs interleave, a corruption cannot be
+  // skipped by resuming at a later log starting at the expected sequence
+  // number, since the logs before it may have lost records after it.
+  bool interleaved_logs = immutable_db_options_.num_wal_streams > 1;
+
+  auto logFileDropped = [this](const std::string& fname) {
+    uint64_t bytes;
+    if (env_->GetFileSize(fname, &bytes).ok()) {
+      auto info_log = immutable_db_options_.info_log.get();
+      ROCKS_LOG_WARN(info_log, "%s: dropping %d bytes", fname.c_str(),
+                     static_cast<int>(bytes));
+    }
+  };
+  auto readNextRecord = [this](LogReplay* replay) {
+    replay->has_record = false;
+    Slice record;
+    while (replay->status.ok() &&
+           replay->reader->ReadRecord(
+               &record, &replay->scratch,
+               immutable_db_options_.wal_recovery_mode) &&
+           replay->status.ok()) {
+      if (record.size() < WriteBatchInternal::kHeader) {
+        replay->reporter.Corruption(record.size(),
+                                    Status::Corruption("log record too small"));
+        continue;
+      }
+      Status s = WriteBatchInternal::SetContents(&replay->batch, record);
+      if (!s.ok()) {
+        return s;
+      }
+      replay->sequence = WriteBatchInternal::Sequence(&replay->batch);
+      if (replay->first_sequence == kMaxSequenceNumber) {
+        replay->first_sequence = replay->sequence;
+      }
+      replay->has_record = true;
+      break;
+    }
+    return Status::OK();
+  };
+  // Opens the log of log_numbers[next_log_index] and reads its first record
+  auto openNextLog = [&]() {
+    uint64_t log_number = log_numbers[next_log_index++];
     if (log_number < min_log_number) {
       ROCKS_LOG_INFO(immutable_db_options_.info_log,
                      "Skipping log #%" PRIu64
                      " since it is older than min log to keep #%" PRIu64,
                      log_number, min_log_number);
-      continue;
+      return Status::OK();
     }
     // The previous incarnation may not have written any MANIFEST
     // records after allocating this log number.  So we manually
@@ -846,262 +917,99 @@ Status DBImpl::RecoverLogFiles(const std::vector<uint64_t>& log_numbers,
     ROCKS_LOG_INFO(immutable_db_options_.info_log,
                    "Recovering log #%" PRIu64 " mode %d", log_number,
                    static_cast<int>(immutable_db_options_.wal_recovery_mode));
-    auto logFileDropped = [this, &fname]() {
-      uint64_t bytes;
-      if (env_->GetFileSize(fname, &bytes).ok()) {
-        auto info_log = immutable_db_options_.info_log.get();
-        ROCKS_LOG_WARN(info_log, "%s: dropping %d bytes", fname.c_str(),
-                       static_cast<int>(bytes));
-      }
-    };
     if (stop_replay_by_wal_filter) {
-      logFileDropped();
-      continue;
+      logFileDropped(fname);
+      return Status::OK();
     }
 
     std::unique_ptr<SequentialFileReader> file_reader;
     {
       std::unique_ptr<FSSequentialFile> file;
-      status = fs_->NewSequentialFile(fname,
-                                      fs_->OptimizeForLogRead(file_options_),
-                                      &file, nullptr);
-      if (!status.ok()) {
-        MaybeIgnoreError(&status);
-        if (!status.ok()) {
-          return status;
-        } else {
-          // Fail with one log file, but that's ok.
-          // Try next one.
-          continue;
-        }
+      Status s = fs_->NewSequentialFile(
+          fname, fs_->OptimizeForLogRead(file_options_), &file, nullptr);
+      if (!s.ok()) {
+        // Fail with one log file, but that's ok if the error is ignored.
+        // Try next one.
+        MaybeIgnoreError(&s);
+        return s;
       }
       file_reader.reset(new SequentialFileReader(
           std::move(file), fname, immutable_db_options_.log_readahead_size,
           io_tracer_));
     }
 
+    replays.emplace_back(new LogReplay);
+    LogReplay* replay = replays.back().get();
+    replay->log_number = log_number;
+    replay->fname = fname;
+
     // Create the log reader.
-    LogReporter reporter;
+    LogReporter& reporter = replay->reporter;
     reporter.env = env_;
     reporter.info_log = immutable_db_options_.info_log.get();
-    reporter.fname = fname.c_str();
+    reporter.fname = replay->fname.c_str();
     if (!immutable_db_options_.paranoid_checks ||
         immutable_db_options_.wal_recovery_mode ==
             WALRecoveryMode::kSkipAnyCorruptedRecords) {
       reporter.status = nullptr;
     } else {
-      reporter.status = &status;
+      reporter.status = &replay->status;
     }
     // We intentially make log::Reader do checksumming even if
     // paranoid_checks==false so that corruptions cause entire commits
     // to be skipped instead of propagating bad information (like overly
     // large sequence numbers).
-    log::Reader reader(immutable_db_options_.info_log, std::move(file_reader),
-                       &reporter, true /*checksum*/, log_number);
-
-    // Determine if we should tolerate incomplete records at the tail end of the
-    // Read all the records and add to a memtable
-    std::string scratch;
-    Slice record;
-    WriteBatch batch;
+    replay->reader.reset(new log::Reader(immutable_db_options_.info_log,
+                                         std::move(file_reader), &reporter,
+                                         true /*checksum*/, log_number));
 
     TEST_SYNC_POINT_CALLBACK("DBImpl::RecoverLogFiles:BeforeReadWal",
                              /*arg=*/nullptr);
-    while (!stop_replay_by_wal_filter &&
-           reader.ReadRecord(&record, &scratch,
-                             immutable_db_options_.wal_recovery_mode) &&
-           status.ok()) {
-      if (record.size() < WriteBatchInternal::kHeader) {
-        reporter.Corruption(record.size(),
-                            Status::Corruption("log record too small"));
-        continue;
-      }
-
-      status = WriteBatchInternal::SetContents(&batch, record);
-      if (!status.ok()) {
-        return status;
-      }
-      SequenceNumber sequence = WriteBatchInternal::Sequence(&batch);
-
-      if (immutable_db_options_.wal_recovery_mode ==
-          WALRecoveryMode::kPointInTimeRecovery) {
-        // In point-in-time recovery mode, if sequence id of log files are
-        // consecutive, we continue recovery despite corruption. This could
-        // happen when we open and write to a corrupted DB, where sequence id
-        // will start from the last sequence id we recovered.
-        if (sequence == *next_sequence) {
-          stop_replay_for_corruption = false;
-        }
-        if (stop_replay_for_corruption) {
-          logFileDropped();
-          break;
-        }
-      }
-
-#ifndef ROCKSDB_LITE
-      if (immutable_db_options_.wal_filter != nullptr) {
-        WriteBatch new_batch;
-        bool batch_changed = false;
-
-        WalFilter::WalProcessingOption wal_processing_option =
-            immutable_db_options_.wal_filter->LogRecordFound(
-                log_number, fname, batch, &new_batch, &batch_changed);
-
-        switch (wal_processing_option) {
-          case WalFilter::WalProcessingOption::kContinueProcessing:
-            // do nothing, proceeed normally
-            break;
-          case WalFilter::WalProcessingOption::kIgnoreCurrentRecord:
-            // skip current record
-            continue;
-          case WalFilter::WalProcessingOption::kStopReplay:
-            // skip current record and stop replay
-            stop_replay_by_wal_filter = true;
-            continue;
-          case WalFilter::WalProcessingOption::kCorruptedRecord: {
-            status =
-                Status::Corruption("Corruption reported by Wal Filter ",
-                                   immutable_db_options_.wal_filter->Name());
-            MaybeIgnoreError(&status);
-            if (!status.ok()) {
-              reporter.Corruption(record.size(), status);
-              continue;
-            }
-            break;
-          }
-          default: {
-            assert(false);  // unhandled case
-            status = Status::NotSupported(
-                "Unknown WalProcessingOption returned"
-                " by Wal Filter ",
-                immutable_db_options_.wal_filter->Name());
-            MaybeIgnoreError(&status);
-            if (!status.ok()) {
-              return status;
-            } else {
-              // Ignore the error with current record processing.
-              continue;
-            }
-          }
-        }
-
-        if (batch_changed) {
-          // Make sure that the count in the new batch is
-          // within the orignal count.
-          int new_count = WriteBatchInternal::Count(&new_batch);
-          int original_count = WriteBatchInternal::Count(&batch);
-          if (new_count > original_count) {
-            ROCKS_LOG_FATAL(
-                immutable_db_options_.info_log,
-                "Recovering log #%" PRIu64
-                " mode %d log filter %s returned "
-                "more records (%d) than original (%d) which is not allowed. "
-                "Aborting recovery.",
-                log_number,
-                static_cast<int>(immutable_db_options_.wal_recovery_mode),
-                immutable_db_options_.wal_filter->Name(), new_count,
-                original_count);
-            status = Status::NotSupported(
-                "More than original # of records "
-                "returned by Wal Filter ",
-                immutable_db_options_.wal_filter->Name());
-            return status;
-          }
-          // Set the same sequence number in the new_batch
-          // as the original batch.
-          WriteBatchInternal::SetSequence(&new_batch,
-                                          WriteBatchInternal::Sequence(&batch));
-          batch = new_batch;
-        }
-      }
-#endif  // ROCKSDB_LITE
-
-      // If column family was not found, it might mean that the WAL write
-      // batch references to the column family that was dropped after the
-      // insert. We don't want to fail the whole write batch in that case --
-      // we just ignore the update.
-      // That's why we set ignore missing column families to true
-      bool has_valid_writes = false;
-      status = WriteBatchInternal::InsertInto(
-          &batch, column_family_memtables_.get(), &flush_scheduler_,
-          &trim_history_scheduler_, true, log_number, this,
-          false /* concurrent_memtable_writes */, next_sequence,
-          &has_valid_writes, seq_per_batch_, batch_per_txn_);
-      MaybeIgnoreError(&status);
-      if (!status.ok()) {
-        // We are treating this as a failure while reading since we read valid
-        // blocks that do not form coherent data
-        reporter.Corruption(record.size(), status);
-        continue;
-      }
-
-      if (has_valid_writes && !read_only) {
-        // we can do this because this is called before client has access to the
-        // DB and there is only a single thread operating on DB
-        ColumnFamilyData* cfd;
-
-        while ((cfd = flush_scheduler_.TakeNextColumnFamily()) != nullptr) {
-          cfd->UnrefAndTryDelete();
-          // If this asserts, it means that InsertInto failed in
-          // filtering updates to already-flushed column families
-          assert(cfd->GetLogNumber() <= log_number);
-          auto iter = version_edits.find(cfd->GetID());
-          assert(iter != version_edits.end());
-          VersionEdit* edit = &iter->second;
-          status = WriteLevel0TableForRecovery(job_id, cfd, cfd->mem(), edit);
-          if (!status.ok()) {
-            // Reflect errors immediately so that conditions like full
-            // file-systems cause the DB::Open() to fail.
-            return status;
-          }
-          flushed = true;
-
-          cfd->CreateNewMemtable(*cfd->GetLatestMutableCFOptions(),
-                                 *next_sequence);
-        }
-      }
-    }
-
-    if (!status.ok()) {
-      if (status.IsNotSupported()) {
+    return readNextRecord(replay);
+  };
+  // Handles the end of a log, which has been read to the end or to an error
+  auto finishLog = [&](LogReplay* replay) {
+    Status s = replay->status;
+    if (!s.ok()) {
+      if (s.IsNotSupported()) {
         // We should not treat NotSupported as corruption. It is rather a clear
         // sign that we are processing a WAL that is produced by an incompatible
         // version of the code.
-        return status;
+        return s;
       }
       if (immutable_db_options_.wal_recovery_mode ==
           WALRecoveryMode::kSkipAnyCorruptedRecords) {
         // We should ignore all errors unconditionally
-        status = Status::OK();
+        s = Status::OK();
       } else if (immutable_db_options_.wal_recovery_mode ==
                  WALRecoveryMode::kPointInTimeRecovery) {
-        if (status.IsIOError()) {
+        if (s.IsIOError()) {
           ROCKS_LOG_ERROR(immutable_db_options_.info_log,
                           "IOError during point-in-time reading log #%" PRIu64
                           " seq #%" PRIu64
                           ". %s. This likely mean loss of synced WAL, "
                           "thus recovery fails.",
-                          log_number, *next_sequence,
-                          status.ToString().c_str());
-          return status;
+                          replay->log_number, *next_sequence,
+                          s.ToString().c_str());
+          return s;
         }
         // We should ignore the error but not continue replaying
-        status = Status::OK();
+        s = Status::OK();
         stop_replay_for_corruption = true;
-        corrupted_log_number = log_number;
+        corrupted_log_number = replay->log_number;
         if (corrupted_log_found != nullptr) {
           *corrupted_log_found = true;
         }
         ROCKS_LOG_INFO(immutable_db_options_.info_log,
                        "Point in time recovered to log #%" PRIu64
                        " seq #%" PRIu64,
-                       log_number, *next_sequence);
+                       replay->log_number, *next_sequence);
       } else {
         assert(immutable_db_options_.wal_recovery_mode ==
                    WALRecoveryMode::kTolerateCorruptedTailRecords ||
                immutable_db_options_.wal_recovery_mode ==
                    WALRecoveryMode::kAbsoluteConsistency);
-        return status;
+        return s;
       }
     }
 
@@ -1114,6 +1022,224 @@ Status DBImpl::RecoverLogFiles(const std::vector<uint64_t>& log_numbers,
       versions_->SetLastPublishedSequence(last_sequence);
       versions_->SetLastSequence(last_sequence);
     }
+    return s;
+  };
+
+  // The log whose record was replayed last, to be read further
+  LogReplay* replaying = nullptr;
+  while (true) {
+    if (replaying != nullptr) {
+      status = readNextRecord(replaying);
+      if (!status.ok()) {
+        return status;
+      }
+      replaying = nullptr;
+    }
+
+    // Open logs until the newest opened log starts after the next record.
+    LogReplay* next = nullptr;
+    while (true) {
+      next = nullptr;
+      for (auto& replay : replays) {
+        if (replay->has_record &&
+            (next == nullptr || replay->sequence < next->sequence)) {
+          next = replay.get();
+        }
+      }
+      if (next_log_index == log_numbers.size() ||
+          (next != nullptr && replays.back()->has_record &&
+           replays.back()->first_sequence > next->sequence)) {
+        break;
+      }
+      status = openNextLog();
+      if (!status.ok()) {
+        return status;
+      }
+    }
+
+    // Finish the logs that have no more records. A corruption of a log is
+    // handled after the logs before it are finished, unless the logs
+    // interleave.
+    for (auto it = replays.begin(); it != replays.end();) {
+      LogReplay* replay = it->get();
+      if (!replay->has_record &&
+          (replay->status.ok() || it == replays.begin() || interleaved_logs)) {
+        status = finishLog(replay);
+        if (!status.ok()) {
+          return status;
+        }
+        it = replays.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    if (next == nullptr) {
+      if (next_log_index == log_numbers.size()) {
+        assert(replays.empty());
+        break;
+      }
+      continue;
+    }
+    if (next != replays.front().get()) {
+      interleaved_logs = true;
+    }
+
+    replaying = next;
+    const uint64_t log_number = replaying->log_number;
+    const std::string& fname = replaying->fname;
+    LogReporter& reporter = replaying->reporter;
+    WriteBatch& batch = replaying->batch;
+    SequenceNumber sequence = replaying->sequence;
+
+    if (immutable_db_options_.wal_recovery_mode ==
+        WALRecoveryMode::kPointInTimeRecovery) {
+      // In point-in-time recovery mode, if sequence id of log files are
+      // consecutive, we continue recovery despite corruption. This could
+      // happen when we open and write to a corrupted DB, where sequence id
+      // will start from the last sequence id we recovered.
+      if (sequence == *next_sequence && !interleaved_logs) {
+        stop_replay_for_corruption = false;
+      }
+      if (stop_replay_for_corruption) {
+        logFileDropped(fname);
+        replaying->has_record = false;
+        replaying = nullptr;
+        continue;
+      }
+    }
+
+#ifndef ROCKSDB_LITE
+    if (immutable_db_options_.wal_filter != nullptr) {
+      WriteBatch new_batch;
+      bool batch_changed = false;
+
+      WalFilter::WalProcessingOption wal_processing_option =
+          immutable_db_options_.wal_filter->LogRecordFound(
+              log_number, fname, batch, &new_batch, &batch_changed);
+
+      switch (wal_processing_option) {
+        case WalFilter::WalProcessingOption::kContinueProcessing:
+          // do nothing, proceeed normally
+          break;
+        case WalFilter::WalProcessingOption::kIgnoreCurrentRecord:
+          // skip current record
+          continue;
+        case WalFilter::WalProcessingOption::kStopReplay:
+          // skip current record and stop replay
+          stop_replay_by_wal_filter = true;
+          replaying->has_record = false;
+          replaying = nullptr;
+          for (auto& replay : replays) {
+            if (replay->has_record) {
+              logFileDropped(replay->fname);
+              replay->has_record = false;
+            }
+          }
+          continue;
+        case WalFilter::WalProcessingOption::kCorruptedRecord: {
+          replaying->status =
+              Status::Corruption("Corruption reported by Wal Filter ",
+                                 immutable_db_options_.wal_filter->Name());
+          MaybeIgnoreError(&replaying->status);
+          if (!replaying->status.ok()) {
+            reporter.Corruption(WriteBatchInternal::ByteSize(&batch),
+                                replaying->status);
+            continue;
+          }
+          break;
+        }
+        default: {
+          assert(false);  // unhandled case
+          status = Status::NotSupported(
+              "Unknown WalProcessingOption returned"
+              " by Wal Filter ",
+              immutable_db_options_.wal_filter->Name());
+          MaybeIgnoreError(&status);
+          if (!status.ok()) {
+            return status;
+          } else {
+            // Ignore the error with current record processing.
+            continue;
+          }
+        }
+      }
+
+      if (batch_changed) {
+        // Make sure that the count in the new batch is
+        // within the orignal count.
+        int new_count = WriteBatchInternal::Count(&new_batch);
+        int original_count = WriteBatchInternal::Count(&batch);
+        if (new_count > original_count) {
+          ROCKS_LOG_FATAL(
+              immutable_db_options_.info_log,
+              "Recovering log #%" PRIu64
+              " mode %d log filter %s returned "
+              "more records (%d) than original (%d) which is not allowed. "
+              "Aborting recovery.",
+              log_number,
+              static_cast<int>(immutable_db_options_.wal_recovery_mode),
+              immutable_db_options_.wal_filter->Name(), new_count,
+              original_count);
+          status = Status::NotSupported(
+              "More than original # of records "
+              "returned by Wal Filter ",
+              immutable_db_options_.wal_filter->Name());
+          return status;
+        }
+        // Set the same sequence number in the new_batch
+        // as the original batch.
+        WriteBatchInternal::SetSequence(&new_batch,
+                                        WriteBatchInternal::Sequence(&batch));
+        batch = new_batch;
+      }
+    }
+#endif  // ROCKSDB_LITE
+
+    // If column family was not found, it might mean that the WAL write
+    // batch references to the column family that was dropped after the
+    // insert. We don't want to fail the whole write batch in that case --
+    // we just ignore the update.
+    // That's why we set ignore missing column families to true
+    bool has_valid_writes = false;
+    replaying->status = WriteBatchInternal::InsertInto(
+        &batch, column_family_memtables_.get(), &flush_scheduler_,
+        &trim_history_scheduler_, true, log_number, this,
+        false /* concurrent_memtable_writes */, next_sequence,
+        &has_valid_writes, seq_per_batch_, batch_per_txn_);
+    MaybeIgnoreError(&replaying->status);
+    if (!replaying->status.ok()) {
+      // We are treating this as a failure while reading since we read valid
+      // blocks that do not form coherent data
+      reporter.Corruption(WriteBatchInternal::ByteSize(&batch),
+                          replaying->status);
+      continue;
+    }
+
+    if (has_valid_writes && !read_only) {
+      // we can do this because this is called before client has access to the
+      // DB and there is only a single thread operating on DB
+      ColumnFamilyData* cfd;
+
+      while ((cfd = flush_scheduler_.TakeNextColumnFamily()) != nullptr) {
+        cfd->UnrefAndTryDelete();
+        // If this asserts, it means that InsertInto failed in
+        // filtering updates to already-flushed column families
+        assert(cfd->GetLogNumber() <= log_number);
+        auto iter = version_edits.find(cfd->GetID());
+        assert(iter != version_edits.end());
+        VersionEdit* edit = &iter->second;
+        status = WriteLevel0TableForRecovery(job_id, cfd, cfd->mem(), edit);
+        if (!status.ok()) {
+          // Reflect errors immediately so that conditions like full
+          // file-systems cause the DB::Open() to fail.
+          return status;
+        }
+        flushed = true;
+
+        cfd->CreateNewMemtable(*cfd->GetLatestMutableCFOptions(),
+                               *next_sequence);
+      }
+    }
   }
   // Compare the corrupted log number to all columnfamily's current log number.
   // Abort Open() if any column family's log number is greater than
@@ -1478,7 +1604,13 @@ IOStatus DBImpl::CreateWAL(uint64_t log_file_num, uint64_t recycle_log_number,
         nullptr /* stats */, listeners));
     *new_log = new log::Writer(std::move(file_writer), log_file_num,
                                immutable_db_options_.recycle_log_file_num > 0,
-                               immutable_db_options_.manual_wal_flush);
+                               immutable_db_options_.manual_wal_flush,
+                               immutable_db_options_.wal_compression);
+    io_s = (*new_log)->AddCompressionTypeRecord();
+    if (!io_s.ok()) {
+      delete *new_log;
+      *new_log = nullptr;
+    }
   }
   return io_s;
 }
@@ -1781,6 +1913,9 @@ Status DBImpl::Open(const DBOptions& db_options, const std::string& dbname,
   }
   if (s.ok()) {
     impl->StartPeriodicWorkScheduler();
+    impl->persist_block_cache_keys_ =
+        impl->immutable_db_options_.persist_block_cache_keys;
+    impl->StartBlockCacheWarmup();
   } else {
     for (auto* h : *handles) {
       delete h;
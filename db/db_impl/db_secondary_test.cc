@@ -340,6 +340,43 @@ TEST_F(DBSecondaryTest, OpenAsSecondaryWALTailing) {
   verify_db_func("new_foo_value_1", "new_bar_value");
 }
 
+TEST_F(DBSecondaryTest, CompressedWALTailing) {
+  for (CompressionType type : {kZlibCompression, kLZ4Compression, kZSTD}) {
+    if (!StreamingCompressionTypeSupported(type)) {
+      continue;
+    }
+    Options options;
+    options.env = env_;
+    options.wal_compression = type;
+    DestroyAndReopen(options);
+    const std::string value(1000, 'v');
+    for (int i = 0; i < 100; ++i) {
+      ASSERT_OK(Put(Key(i), value + std::to_string(i)));
+    }
+    Options options1;
+    options1.env = env_;
+    options1.max_open_files = -1;
+    OpenSecondary(options1);
+
+    ReadOptions ropts;
+    ropts.verify_checksums = true;
+    std::string result;
+    ASSERT_OK(db_secondary_->Get(ropts, Key(99), &result));
+    ASSERT_EQ(value + "99", result);
+
+    // Records appended to the compressed WAL after the secondary read it.
+    for (int i = 0; i < 100; ++i) {
+      ASSERT_OK(Put(Key(i), value + "new" + std::to_string(i)));
+    }
+    ASSERT_OK(db_secondary_->TryCatchUpWithPrimary());
+    for (int i = 0; i < 100; ++i) {
+      ASSERT_OK(db_secondary_->Get(ropts, Key(i), &result));
+      ASSERT_EQ(value + "new" + std::to_string(i), result);
+    }
+    CloseSecondary();
+  }
+}
+
 TEST_F(DBSecondaryTest, OpenWithNonExistColumnFamily) {
   Options options;
   options.env = env_;
@@ -163,6 +163,34 @@ TEST_F(DBTestXactLogIterator, TransactionLogIteratorStallAtLastRecord) {
   } while (ChangeCompactOptions());
 }
 
+TEST_F(DBTestXactLogIterator, TransactionLogIteratorCompressedWal) {
+  for (CompressionType type : {kZlibCompression, kLZ4Compression, kZSTD}) {
+    if (!StreamingCompressionTypeSupported(type)) {
+      continue;
+    }
+    Options options = OptionsForLogIterTest();
+    options.wal_compression = type;
+    DestroyAndReopen(options);
+    const std::string value(1000, 'v');
+    for (int i = 0; i < 10; i++) {
+      ASSERT_OK(Put(Key(i), value));
+    }
+    {
+      auto iter = OpenTransactionLogIter(0);
+      ExpectRecords(10, iter);
+      // Records appended after the iterator reached the end of the WAL.
+      for (int i = 0; i < 10; i++) {
+        ASSERT_OK(Put(Key(i), value));
+      }
+      iter->Next();
+      ExpectRecords(10, iter);
+    }
+    Reopen(options);
+    auto iter = OpenTransactionLogIter(0);
+    ExpectRecords(20, iter);
+  }
+}
+
 TEST_F(DBTestXactLogIterator, TransactionLogIteratorCheckAfterRestart) {
   do {
     Options options = OptionsForLogIterTest();
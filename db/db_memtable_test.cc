@@ -10,6 +10,7 @@
 #include "db/memtable.h"
 #include "db/range_del_aggregator.h"
 #include "port/stack_trace.h"
+#include "rocksdb/arena_block_pool.h"
 #include "rocksdb/memtablerep.h"
 #include "rocksdb/slice_transform.h"
 
@@ -275,6 +276,315 @@ TEST_F(DBMemTableTest, ConcurrentMergeWrite) {
   delete mem;
 }
 
+// Concurrent inserts into the hash based memtables, with few prefixes so that
+// the buckets are shared, and a hash linked list that changes its buckets
+// into skip lists while they are written, into the adaptive radix tree and
+// into the per-core buffers of a vector.
+TEST_F(DBMemTableTest, ConcurrentRepWrite) {
+  const int kNumThreads = 4;
+  const int kNumKeysPerThread = 500;
+  std::vector<std::shared_ptr<MemTableRepFactory>> factories = {
+      std::shared_ptr<MemTableRepFactory>(NewHashSkipListRepFactory(16)),
+      std::shared_ptr<MemTableRepFactory>(NewHashLinkListRepFactory(
+          16, 0 /* huge_page_tlb_size */,
+          0 /* bucket_entries_logging_threshold */,
+          false /* if_log_bucket_dist_when_flash */,
+          32 /* threshold_use_skiplist */)),
+      std::shared_ptr<MemTableRepFactory>(NewAdaptiveRadixTreeRepFactory()),
+      std::make_shared<VectorRepFactory>()};
+  for (auto& factory : factories) {
+    ASSERT_TRUE(factory->IsInsertConcurrentlySupported());
+    Options options;
+    options.memtable_factory = factory;
+    options.allow_concurrent_memtable_write = true;
+    options.prefix_extractor.reset(NewFixedPrefixTransform(3));
+    InternalKeyComparator cmp(BytewiseComparator());
+    ImmutableCFOptions ioptions(options);
+    WriteBufferManager wb(options.db_write_buffer_size);
+    std::unique_ptr<MemTable> mem(
+        new MemTable(cmp, ioptions, MutableCFOptions(options), &wb,
+                     kMaxSequenceNumber, 0 /* column_family_id */));
+
+    auto key = [](int t, int i) {
+      char buf[32];
+      snprintf(buf, sizeof(buf), "p%02d%d%04d", i % 8, t, i);
+      return std::string(buf);
+    };
+    std::vector<port::Thread> threads;
+    for (int t = 0; t < kNumThreads; t++) {
+      threads.emplace_back([&, t]() {
+        MemTablePostProcessInfo post_process_info;
+        for (int i = 0; i < kNumKeysPerThread; i++) {
+          SequenceNumber seq = t * kNumKeysPerThread + i + 1;
+          ASSERT_TRUE(mem->Add(seq, kTypeValue, key(t, i), key(t, i),
+                               true /* allow_concurrent */,
+                               &post_process_info));
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    for (int t = 0; t < kNumThreads; t++) {
+      for (int i = 0; i < kNumKeysPerThread; i++) {
+        std::string value;
+        Status s;
+        MergeContext merge_context;
+        SequenceNumber max_covering_tombstone_seq = 0;
+        LookupKey lkey(key(t, i), kMaxSequenceNumber);
+        ASSERT_TRUE(mem->Get(lkey, &value, /*timestamp=*/nullptr, &s,
+                             &merge_context, &max_covering_tombstone_seq,
+                             ReadOptions()));
+        ASSERT_OK(s);
+        ASSERT_EQ(value, key(t, i));
+      }
+    }
+
+    Arena arena;
+    ReadOptions ro;
+    ro.total_order_seek = true;
+    ScopedArenaIterator iter(mem->NewIterator(ro, &arena));
+    int count = 0;
+    std::string prev;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      std::string user_key = ExtractUserKey(iter->key()).ToString();
+      ASSERT_LT(prev, user_key);
+      prev = user_key;
+      count++;
+    }
+    ASSERT_EQ(count, kNumThreads * kNumKeysPerThread);
+  }
+}
+
+// Memtables of several column families and DBs take their arena blocks from
+// a shared pool, and the memtables created after a flush reuse the blocks of
+// the flushed ones.
+TEST_F(DBMemTableTest, ArenaBlockPool) {
+  Options options = CurrentOptions();
+  options.create_if_missing = true;
+  options.write_buffer_size = 256 << 10;
+  options.arena_block_size = 16 << 10;
+  options.arena_block_pool = NewArenaBlockPool(8 << 20);
+  CreateAndReopenWithCF({"pikachu"}, options);
+  std::string dbname2 = test::PerThreadDBPath("db_memtable_test2");
+  ASSERT_OK(DestroyDB(dbname2, options));
+  DB* db2 = nullptr;
+  ASSERT_OK(DB::Open(options, dbname2, &db2));
+
+  Random rnd(301);
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < 100; i++) {
+      ASSERT_OK(Put(0, Key(i), rnd.RandomString(100)));
+      ASSERT_OK(Put(1, Key(i), rnd.RandomString(100)));
+      ASSERT_OK(db2->Put(WriteOptions(), Key(i), rnd.RandomString(100)));
+    }
+    ASSERT_OK(Flush(0));
+    ASSERT_OK(Flush(1));
+    ASSERT_OK(db2->Flush(FlushOptions()));
+  }
+  ArenaBlockPoolStats stats = options.arena_block_pool->GetStats();
+  ASSERT_GT(stats.hits, 0U);
+  ASSERT_GT(stats.recycled, 0U);
+  ASSERT_EQ(stats.released, 0U);
+  ASSERT_EQ(stats.pooled_bytes, stats.pooled_blocks * (16 << 10));
+  ASSERT_EQ(100U, Get(1, Key(0)).size());
+
+  delete db2;
+  ASSERT_OK(DestroyDB(dbname2, options));
+  Close();
+  ASSERT_LT(stats.recycled, options.arena_block_pool->GetStats().recycled);
+}
+
+// An immutable vector large enough to be sorted by three threads, so that
+// the sorted runs are merged in two rounds.
+TEST_F(DBMemTableTest, VectorRepParallelSort) {
+  const int kNumThreads = 2;
+  const int kNumKeys = 200000;
+  Options options;
+  options.memtable_factory.reset(new VectorRepFactory(0, 4));
+  options.allow_concurrent_memtable_write = true;
+  InternalKeyComparator cmp(BytewiseComparator());
+  ImmutableCFOptions ioptions(options);
+  WriteBufferManager wb(options.db_write_buffer_size);
+  std::unique_ptr<MemTable> mem(
+      new MemTable(cmp, ioptions, MutableCFOptions(options), &wb,
+                   kMaxSequenceNumber, 0 /* column_family_id */));
+
+  std::vector<port::Thread> threads;
+  for (int t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&, t]() {
+      Random rnd(301 + t);
+      MemTablePostProcessInfo post_process_info;
+      for (int i = t; i < kNumKeys; i += kNumThreads) {
+        // Several versions of some user keys.
+        std::string user_key = Key(rnd.Uniform(kNumKeys));
+        ASSERT_TRUE(mem->Add(i + 1, kTypeValue, user_key, ToString(i),
+                             true /* allow_concurrent */,
+                             &post_process_info));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  mem->MarkImmutable();
+
+  Arena arena;
+  ScopedArenaIterator iter(mem->NewIterator(ReadOptions(), &arena));
+  int count = 0;
+  std::string prev;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    if (count > 0) {
+      ASSERT_LT(cmp.Compare(prev, iter->key()), 0);
+    }
+    prev = iter->key().ToString();
+    count++;
+  }
+  ASSERT_EQ(count, kNumKeys);
+}
+
+// The adaptive radix tree orders the keys like a skip list, also with user
+// keys that have zero bytes or are prefixes of each other, and with several
+// versions of a user key.
+TEST_F(DBMemTableTest, AdaptiveRadixTreeRep) {
+  InternalKeyComparator cmp(BytewiseComparator());
+  Options options;
+  options.memtable_factory.reset(NewAdaptiveRadixTreeRepFactory());
+  ImmutableCFOptions ioptions(options);
+  Options skiplist_options;
+  ImmutableCFOptions skiplist_ioptions(skiplist_options);
+  WriteBufferManager wb(options.db_write_buffer_size);
+  std::unique_ptr<MemTable> mem(
+      new MemTable(cmp, ioptions, MutableCFOptions(options), &wb,
+                   kMaxSequenceNumber, 0 /* column_family_id */));
+  std::unique_ptr<MemTable> expected(new MemTable(
+      cmp, skiplist_ioptions, MutableCFOptions(skiplist_options), &wb,
+      kMaxSequenceNumber, 0 /* column_family_id */));
+
+  Random rnd(301);
+  const std::string alphabet("\0\1ab\xff", 5);
+  auto random_user_key = [&]() {
+    std::string user_key;
+    for (uint32_t len = rnd.Uniform(6); len > 0; len--) {
+      user_key.push_back(alphabet[rnd.Uniform(5)]);
+    }
+    return user_key;
+  };
+  std::vector<std::string> user_keys;
+  SequenceNumber seq = 0;
+  for (int i = 0; i < 2000; i++) {
+    std::string user_key = random_user_key();
+    seq++;
+    ValueType type = rnd.OneIn(4) ? kTypeDeletion : kTypeValue;
+    ASSERT_TRUE(mem->Add(seq, type, user_key, ToString(seq)));
+    ASSERT_TRUE(expected->Add(seq, type, user_key, ToString(seq)));
+    user_keys.push_back(user_key);
+  }
+  // A <key, seq> that is already there is rejected, whatever its type.
+  ASSERT_FALSE(mem->Add(seq, kTypeMerge, user_keys.back(), "dup"));
+
+  for (const std::string& user_key : user_keys) {
+    for (SequenceNumber snapshot : {kMaxSequenceNumber, seq / 2}) {
+      std::string value;
+      std::string expected_value;
+      Status s;
+      Status expected_s;
+      MergeContext merge_context;
+      SequenceNumber max_covering_tombstone_seq = 0;
+      LookupKey lkey(user_key, snapshot);
+      bool found = mem->Get(lkey, &value, /*timestamp=*/nullptr, &s,
+                            &merge_context, &max_covering_tombstone_seq,
+                            ReadOptions());
+      bool expected_found = expected->Get(
+          lkey, &expected_value, /*timestamp=*/nullptr, &expected_s,
+          &merge_context, &max_covering_tombstone_seq, ReadOptions());
+      ASSERT_EQ(expected_found, found);
+      ASSERT_EQ(expected_s.code(), s.code());
+      ASSERT_EQ(expected_value, value);
+    }
+  }
+
+  Arena arena;
+  ScopedArenaIterator iter(mem->NewIterator(ReadOptions(), &arena));
+  ScopedArenaIterator expected_iter(
+      expected->NewIterator(ReadOptions(), &arena));
+  int count = 0;
+  for (iter->SeekToFirst(), expected_iter->SeekToFirst();
+       expected_iter->Valid(); iter->Next(), expected_iter->Next()) {
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(expected_iter->key().ToString(true), iter->key().ToString(true));
+    ASSERT_EQ(expected_iter->value(), iter->value());
+    count++;
+  }
+  ASSERT_FALSE(iter->Valid());
+  ASSERT_EQ(2000, count);
+  for (iter->SeekToLast(), expected_iter->SeekToLast(); expected_iter->Valid();
+       iter->Prev(), expected_iter->Prev()) {
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(expected_iter->key().ToString(true), iter->key().ToString(true));
+  }
+  ASSERT_FALSE(iter->Valid());
+
+  for (int i = 0; i < 1000; i++) {
+    std::string user_key = random_user_key();
+    SequenceNumber snapshot = rnd.Uniform(static_cast<int>(seq) + 2);
+    InternalKey target(user_key, snapshot, kValueTypeForSeek);
+    iter->Seek(target.Encode());
+    expected_iter->Seek(target.Encode());
+    ASSERT_EQ(expected_iter->Valid(), iter->Valid());
+    if (iter->Valid()) {
+      ASSERT_EQ(expected_iter->key().ToString(true),
+                iter->key().ToString(true));
+    }
+    InternalKey prev_target(user_key, snapshot, kValueTypeForSeekForPrev);
+    iter->SeekForPrev(prev_target.Encode());
+    expected_iter->SeekForPrev(prev_target.Encode());
+    ASSERT_EQ(expected_iter->Valid(), iter->Valid());
+    if (iter->Valid()) {
+      ASSERT_EQ(expected_iter->key().ToString(true),
+                iter->key().ToString(true));
+    }
+  }
+}
+
+// Only BytewiseComparator() is supported by the adaptive radix tree, other
+// comparators get a skip list.
+TEST_F(DBMemTableTest, AdaptiveRadixTreeRepComparators) {
+  for (const Comparator* comparator :
+       {BytewiseComparator(), ReverseBytewiseComparator()}) {
+    Options options = CurrentOptions();
+    options.memtable_factory.reset(NewAdaptiveRadixTreeRepFactory());
+    options.allow_concurrent_memtable_write = true;
+    options.comparator = comparator;
+    DestroyAndReopen(options);
+
+    ASSERT_OK(Put("a", "v1"));
+    ASSERT_OK(Put("ab", "v2"));
+    const Snapshot* snapshot = db_->GetSnapshot();
+    ASSERT_OK(Put("a", "v3"));
+    ASSERT_OK(Delete("ab"));
+    ASSERT_EQ("v3", Get("a"));
+    ASSERT_EQ("NOT_FOUND", Get("ab"));
+    ASSERT_EQ("v2", Get("ab", snapshot));
+    db_->ReleaseSnapshot(snapshot);
+    ASSERT_OK(Put("b", "v4"));
+
+    std::string expected = comparator == BytewiseComparator() ? "a,b" : "b,a";
+    std::string keys;
+    std::unique_ptr<Iterator> iter(db_->NewIterator(ReadOptions()));
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      keys += (keys.empty() ? "" : ",") + iter->key().ToString();
+    }
+    ASSERT_EQ(expected, keys);
+    iter.reset();
+
+    ASSERT_OK(Flush());
+    ASSERT_EQ("v3", Get("a"));
+    ASSERT_EQ("NOT_FOUND", Get("ab"));
+  }
+}
+
 TEST_F(DBMemTableTest, InsertWithHint) {
   Options options;
   options.allow_concurrent_memtable_write = false;
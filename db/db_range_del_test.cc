@@ -727,6 +727,59 @@ TEST_F(DBRangeDelTest, GetCoveredMergeOperandFromMemtable) {
   ASSERT_EQ(expected, actual);
 }
 
+TEST_F(DBRangeDelTest, MemtableReusesFragmentedTombstones) {
+  Options opts = CurrentOptions();
+  Reopen(opts);
+
+  int num_fragmentations = 0;
+  SyncPoint::GetInstance()->SetCallBack(
+      "MemTable::GetFragmentedRangeTombstones:Fragment",
+      [&](void* /*arg*/) { num_fragmentations++; });
+  SyncPoint::GetInstance()->EnableProcessing();
+
+  for (std::string key : {"a", "b", "c", "d"}) {
+    ASSERT_OK(Put(key, "val"));
+  }
+  ASSERT_OK(
+      db_->DeleteRange(WriteOptions(), db_->DefaultColumnFamily(), "b", "d"));
+  for (int i = 0; i < 3; i++) {
+    ASSERT_EQ("val", Get("a"));
+    ASSERT_EQ("NOT_FOUND", Get("b"));
+    ASSERT_EQ("NOT_FOUND", Get("c"));
+  }
+  {
+    std::unique_ptr<Iterator> iter(db_->NewIterator(ReadOptions()));
+    int num_keys = 0;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      num_keys++;
+    }
+    ASSERT_OK(iter->status());
+    ASSERT_EQ(2, num_keys);
+  }
+  ASSERT_EQ(1, num_fragmentations);
+
+  // Newer keys are not covered, and other writes keep the tombstones.
+  ASSERT_OK(Put("c", "val2"));
+  const Snapshot* snapshot = db_->GetSnapshot();
+  ASSERT_EQ("val2", Get("c"));
+  ASSERT_EQ(1, num_fragmentations);
+
+  // A new range deletion invalidates the fragmented tombstones once.
+  ASSERT_OK(
+      db_->DeleteRange(WriteOptions(), db_->DefaultColumnFamily(), "c", "e"));
+  for (int i = 0; i < 3; i++) {
+    ASSERT_EQ("NOT_FOUND", Get("c"));
+    ASSERT_EQ("NOT_FOUND", Get("d"));
+    ASSERT_EQ("val2", Get("c", snapshot));
+    ASSERT_EQ("val", Get("d", snapshot));
+  }
+  ASSERT_EQ(2, num_fragmentations);
+
+  db_->ReleaseSnapshot(snapshot);
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+}
+
 TEST_F(DBRangeDelTest, GetIgnoresRangeDeletions) {
   Options opts = CurrentOptions();
   opts.max_write_buffer_number = 4;
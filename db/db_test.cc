@@ -3858,6 +3858,11 @@ TEST_F(DBTest, TableOptionsSanitizeTest) {
 }
 
 TEST_F(DBTest, ConcurrentMemtableNotSupported) {
+  class NonConcurrentSkipListFactory : public SkipListFactory {
+   public:
+    bool IsInsertConcurrentlySupported() const override { return false; }
+  };
+
   Options options = CurrentOptions();
   options.allow_concurrent_memtable_write = true;
   options.soft_pending_compaction_bytes_limit = 0;
@@ -3865,15 +3870,14 @@ TEST_F(DBTest, ConcurrentMemtableNotSupported) {
   options.create_if_missing = true;
 
   DestroyDB(dbname_, options);
-  options.memtable_factory.reset(NewHashLinkListRepFactory(4, 0, 3, true, 4));
+  options.memtable_factory.reset(new NonConcurrentSkipListFactory);
   ASSERT_NOK(TryReopen(options));
 
   options.memtable_factory.reset(new SkipListFactory);
   ASSERT_OK(TryReopen(options));
 
   ColumnFamilyOptions cf_options(options);
-  cf_options.memtable_factory.reset(
-      NewHashLinkListRepFactory(4, 0, 3, true, 4));
+  cf_options.memtable_factory.reset(new NonConcurrentSkipListFactory);
   ColumnFamilyHandle* handle;
   ASSERT_NOK(db_->CreateColumnFamily(cf_options, "name", &handle));
 }
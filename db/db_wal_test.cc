@@ -595,6 +595,55 @@ TEST_F(DBWALTest, RecoveryWithEmptyLog) {
   } while (ChangeWalOptions());
 }
 
+TEST_F(DBWALTest, WalCompression) {
+  for (CompressionType type : {kZlibCompression, kLZ4Compression, kZSTD}) {
+    if (!StreamingCompressionTypeSupported(type)) {
+      continue;
+    }
+    for (size_t recycle_log_file_num : {0, 1}) {
+      Options options = CurrentOptions();
+      options.wal_compression = type;
+      options.recycle_log_file_num = recycle_log_file_num;
+      DestroyAndReopen(options);
+      const std::string value(1000, 'v');
+      for (int i = 0; i < 100; i++) {
+        ASSERT_OK(Put(Key(i), value + ToString(i)));
+      }
+      VectorLogPtr wal_files;
+      ASSERT_OK(dbfull()->GetSortedWalFiles(wal_files));
+      ASSERT_EQ(1, wal_files.size());
+      ASSERT_LT(wal_files[0]->SizeFileBytes(), 100 * value.size() / 4);
+
+      Reopen(options);
+      for (int i = 0; i < 100; i++) {
+        ASSERT_EQ(value + ToString(i), Get(Key(i)));
+      }
+
+      // Switch the WAL twice, so that the last WAL reuses the file of the
+      // first one if recycling. Its records then end with the compressed
+      // records of the previous log.
+      ASSERT_OK(Flush());
+      ASSERT_OK(Put("foo", "bar"));
+      ASSERT_OK(Flush());
+      for (int i = 0; i < 10; i++) {
+        ASSERT_OK(Put(Key(i), "new" + ToString(i)));
+      }
+      Reopen(options);
+      for (int i = 0; i < 100; i++) {
+        ASSERT_EQ(i < 10 ? "new" + ToString(i) : value + ToString(i),
+                  Get(Key(i)));
+      }
+    }
+  }
+}
+
+TEST_F(DBWALTest, WalCompressionNotSupported) {
+  Options options = CurrentOptions();
+  // Snappy has no streaming format.
+  options.wal_compression = kSnappyCompression;
+  ASSERT_TRUE(TryReopen(options).IsInvalidArgument());
+}
+
 #if !(defined NDEBUG) || !defined(OS_WIN)
 TEST_F(DBWALTest, PreallocateBlock) {
   Options options = CurrentOptions();
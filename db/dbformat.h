@@ -745,6 +745,85 @@ inline int InternalKeyComparator::Compare(const Slice& a,
   return r;
 }
 
+// The user comparators that have specialized code paths, see
+// BytewiseInternalKeyComparator.
+enum class UserComparatorKind : unsigned char {
+  kOther,
+  kBytewise,
+  kReverseBytewise,
+};
+
+inline UserComparatorKind GetUserComparatorKind(const Comparator* ucmp) {
+  if (ucmp == BytewiseComparator()) {
+    return UserComparatorKind::kBytewise;
+  } else if (ucmp == ReverseBytewiseComparator()) {
+    return UserComparatorKind::kReverseBytewise;
+  }
+  return UserComparatorKind::kOther;
+}
+
+// Orders internal keys like an InternalKeyComparator of BytewiseComparator(),
+// or of ReverseBytewiseComparator() if kReverse, with the user keys compared
+// inline by memcmp() instead of through the virtual Comparator::Compare().
+// The hot loops that compare keys of the default comparator, i.e. the skip
+// list of the memtable, the seeks in data blocks and the heap of
+// MergingIterator, are instantiated with it.
+template <bool kReverse>
+class BytewiseInternalKeyComparator {
+ public:
+  static int CompareUserKey(const Slice& a, const Slice& b) {
+    PERF_COUNTER_ADD(user_key_comparison_count, 1);
+    int r = a.compare(b);
+    return kReverse ? -r : r;
+  }
+
+  static int Compare(const Slice& a, const Slice& b) {
+    int r = CompareUserKey(ExtractUserKey(a), ExtractUserKey(b));
+    if (r == 0) {
+      r = CompareFooter(ExtractInternalKeyFooter(a),
+                        ExtractInternalKeyFooter(b));
+    }
+    return r;
+  }
+
+  // Same as Compare except that it excludes the value type from comparison
+  static int CompareKeySeq(const Slice& a, const Slice& b) {
+    int r = CompareUserKey(ExtractUserKey(a), ExtractUserKey(b));
+    if (r == 0) {
+      r = CompareFooter(ExtractInternalKeyFooter(a) >> 8,
+                        ExtractInternalKeyFooter(b) >> 8);
+    }
+    return r;
+  }
+
+  static int Compare(const Slice& a, SequenceNumber a_global_seqno,
+                     const Slice& b, SequenceNumber b_global_seqno) {
+    int r = CompareUserKey(ExtractUserKey(a), ExtractUserKey(b));
+    if (r == 0) {
+      uint64_t a_footer =
+          a_global_seqno == kDisableGlobalSequenceNumber
+              ? ExtractInternalKeyFooter(a)
+              : PackSequenceAndType(a_global_seqno, ExtractValueType(a));
+      uint64_t b_footer =
+          b_global_seqno == kDisableGlobalSequenceNumber
+              ? ExtractInternalKeyFooter(b)
+              : PackSequenceAndType(b_global_seqno, ExtractValueType(b));
+      r = CompareFooter(a_footer, b_footer);
+    }
+    return r;
+  }
+
+  static bool Equal(const Slice& a, const Slice& b) {
+    return Compare(a, b) == 0;
+  }
+
+ private:
+  // Decreasing sequence number, then decreasing type.
+  static int CompareFooter(uint64_t a, uint64_t b) {
+    return a > b ? -1 : (a < b ? +1 : 0);
+  }
+};
+
 // Wrap InternalKeyComparator as a comparator class for ParsedInternalKey.
 struct ParsedInternalKeyComparator {
   explicit ParsedInternalKeyComparator(const InternalKeyComparator* c)
@@ -199,6 +199,50 @@ TEST_F(FormatTest, RangeTombstoneSerializeEndKey) {
   ASSERT_LT(cmp.Compare(t.SerializeEndKey(), k), 0);
 }
 
+TEST_F(FormatTest, BytewiseInternalKeyComparator) {
+  const InternalKeyComparator cmp(BytewiseComparator());
+  const InternalKeyComparator rcmp(ReverseBytewiseComparator());
+  const std::vector<std::string> user_keys = {"", "a", "aa", "ab", "b",
+                                              std::string("a\0", 2),
+                                              std::string("\xff", 1)};
+  const std::vector<SequenceNumber> seqs = {0, 1, 100, kMaxSequenceNumber};
+  const std::vector<ValueType> types = {kTypeDeletion, kTypeValue,
+                                        kTypeMerge, kValueTypeForSeek};
+  std::vector<std::string> keys;
+  for (const auto& user_key : user_keys) {
+    for (SequenceNumber seq : seqs) {
+      for (ValueType type : types) {
+        keys.push_back(IKey(user_key, seq, type));
+      }
+    }
+  }
+  auto sign = [](int r) { return r < 0 ? -1 : (r > 0 ? 1 : 0); };
+  for (const auto& a : keys) {
+    for (const auto& b : keys) {
+      ASSERT_EQ(sign(cmp.Compare(a, b)),
+                sign(BytewiseInternalKeyComparator<false>::Compare(a, b)));
+      ASSERT_EQ(sign(rcmp.Compare(a, b)),
+                sign(BytewiseInternalKeyComparator<true>::Compare(a, b)));
+      ASSERT_EQ(
+          sign(cmp.CompareKeySeq(a, b)),
+          sign(BytewiseInternalKeyComparator<false>::CompareKeySeq(a, b)));
+      ASSERT_EQ(
+          sign(rcmp.CompareKeySeq(a, b)),
+          sign(BytewiseInternalKeyComparator<true>::CompareKeySeq(a, b)));
+      ASSERT_EQ(sign(cmp.Compare(a, 7, b, kDisableGlobalSequenceNumber)),
+                sign(BytewiseInternalKeyComparator<false>::Compare(
+                    a, 7, b, kDisableGlobalSequenceNumber)));
+      ASSERT_EQ(sign(rcmp.Compare(a, kDisableGlobalSequenceNumber, b, 7)),
+                sign(BytewiseInternalKeyComparator<true>::Compare(
+                    a, kDisableGlobalSequenceNumber, b, 7)));
+    }
+  }
+  ASSERT_EQ(UserComparatorKind::kBytewise,
+            GetUserComparatorKind(BytewiseComparator()));
+  ASSERT_EQ(UserComparatorKind::kReverseBytewise,
+            GetUserComparatorKind(ReverseBytewiseComparator()));
+}
+
 }  // namespace ROCKSDB_NAMESPACE
 
 int main(int argc, char** argv) {
@@ -15,6 +15,7 @@
 #include <vector>
 
 #include "db/builder.h"
+#include "db/compaction/compaction_iterator.h"
 #include "db/db_iter.h"
 #include "db/dbformat.h"
 #include "db/event_helpers.h"
@@ -23,6 +24,8 @@
 #include "db/memtable.h"
 #include "db/memtable_list.h"
 #include "db/merge_context.h"
+#include "db/merge_helper.h"
+#include "db/range_del_aggregator.h"
 #include "db/range_tombstone_fragmenter.h"
 #include "db/version_set.h"
 #include "file/file_util.h"
@@ -39,6 +42,7 @@
 #include "rocksdb/statistics.h"
 #include "rocksdb/status.h"
 #include "rocksdb/table.h"
+#include "table/format.h"
 #include "table/merging_iterator.h"
 #include "table/table_builder.h"
 #include "table/two_level_iterator.h"
@@ -122,6 +126,7 @@ FlushJob::FlushJob(
       edit_(nullptr),
       base_(nullptr),
       pick_memtable_called(false),
+      flush_requested_(false),
       thread_pri_(thread_pri),
       io_tracer_(io_tracer) {
   // Update the thread status to indicate flush.
@@ -165,6 +170,7 @@ void FlushJob::PickMemTable() {
   db_mutex_->AssertHeld();
   assert(!pick_memtable_called);
   pick_memtable_called = true;
+  flush_requested_ = cfd_->imm()->HasFlushRequested();
   // Save the contents of the earliest memtable as a new Table
   cfd_->imm()->PickMemtablesToFlush(max_memtable_id_, &mems_);
   if (mems_.empty()) {
@@ -223,18 +229,39 @@ Status FlushJob::Run(LogsWithPrepTracker* prep_tracker,
     prev_cpu_read_nanos = IOSTATS(cpu_read_nanos);
   }
 
-  // This will release and re-acquire the mutex.
-  Status s = WriteLevel0Table();
-
-  if (s.ok() && cfd_->IsDropped()) {
-    s = Status::ColumnFamilyDropped("Column family dropped during compaction");
+  Status s;
+  bool purged = false;
+  if (MemPurgeDecider()) {
+    // This will release and re-acquire the mutex.
+    s = MemPurge();
+    purged = s.ok();
+    if (!purged) {
+      ROCKS_LOG_BUFFER(log_buffer_,
+                       "[%s] [JOB %d] MemPurge failed, flushing instead: %s",
+                       cfd_->GetName().c_str(), job_context_->job_id,
+                       s.ToString().c_str());
+      s = Status::OK();
+    }
   }
-  if ((s.ok() || s.IsColumnFamilyDropped()) &&
-      shutting_down_->load(std::memory_order_acquire)) {
-    s = Status::ShutdownInProgress("Database shutdown");
+
+  if (!purged) {
+    // This will release and re-acquire the mutex.
+    s = WriteLevel0Table();
+
+    if (s.ok() && cfd_->IsDropped()) {
+      s = Status::ColumnFamilyDropped(
+          "Column family dropped during compaction");
+    }
+    if ((s.ok() || s.IsColumnFamilyDropped()) &&
+        shutting_down_->load(std::memory_order_acquire)) {
+      s = Status::ShutdownInProgress("Database shutdown");
+    }
   }
 
-  if (!s.ok()) {
+  if (purged) {
+    // mems_ are already replaced in the memtable list, and there is nothing
+    // to record in the MANIFEST.
+  } else if (!s.ok()) {
     cfd_->imm()->RollbackMemtableFlush(mems_, meta_.fd.GetNumber());
   } else if (write_manifest_) {
     TEST_SYNC_POINT("FlushJob::InstallResults");
@@ -301,6 +328,164 @@ void FlushJob::Cancel() {
   base_->Unref();
 }
 
+bool FlushJob::MemPurgeDecider() const {
+  // Only a flush of memtables that filled up can be turned into a MemPurge.
+  // An explicit flush request must persist the memtables, and an atomic flush
+  // must commit all of its column families to the MANIFEST together.
+  return mutable_cf_options_.mempurge_threshold > 0.0 && write_manifest_ &&
+         !db_options_.atomic_flush && !flush_requested_ &&
+         cfd_->GetFlushReason() == FlushReason::kWriteBufferFull &&
+         !cfd_->IsDropped() && !shutting_down_->load(std::memory_order_acquire);
+}
+
+Status FlushJob::MemPurge() {
+  db_mutex_->AssertHeld();
+  const uint64_t start_micros = db_options_.env->NowMicros();
+  Status s;
+  std::unique_ptr<MemTable> new_mem;
+  uint64_t input_entries = 0, output_entries = 0;
+  size_t input_memory_usage = 0;
+  uint64_t min_prep_log = 0;
+
+  db_mutex_->Unlock();
+  {
+    std::vector<InternalIterator*> memtables;
+    std::vector<std::unique_ptr<FragmentedRangeTombstoneIterator>>
+        range_del_iters;
+    ReadOptions ro;
+    ro.total_order_seek = true;
+    Arena arena;
+    SequenceNumber first_seqno = kMaxSequenceNumber;
+    SequenceNumber earliest_seqno = kMaxSequenceNumber;
+    for (MemTable* m : mems_) {
+      memtables.push_back(m->NewIterator(ro, &arena));
+      auto* range_del_iter =
+          m->NewRangeTombstoneIterator(ro, kMaxSequenceNumber);
+      if (range_del_iter != nullptr) {
+        range_del_iters.emplace_back(range_del_iter);
+      }
+      input_entries += m->num_entries();
+      input_memory_usage += m->ApproximateMemoryUsage();
+      first_seqno = std::min(first_seqno, m->GetFirstSequenceNumber());
+      earliest_seqno = std::min(earliest_seqno, m->GetEarliestSequenceNumber());
+      const uint64_t prep_log = m->GetMinLogContainingPrepSection();
+      if (prep_log > 0 && (min_prep_log == 0 || prep_log < min_prep_log)) {
+        min_prep_log = prep_log;
+      }
+    }
+    const size_t max_memory_usage = static_cast<size_t>(
+        mutable_cf_options_.mempurge_threshold * input_memory_usage);
+
+    const InternalKeyComparator& icmp = cfd_->internal_comparator();
+    const ImmutableCFOptions& ioptions = *cfd_->ioptions();
+    new_mem.reset(
+        cfd_->ConstructNewMemtable(mutable_cf_options_, earliest_seqno));
+    // The entries are not added in sequence order.
+    new_mem->SetFirstSequenceNumber(first_seqno);
+
+    std::unique_ptr<CompactionRangeDelAggregator> range_del_agg(
+        new CompactionRangeDelAggregator(&icmp, existing_snapshots_));
+    for (auto& range_del_iter : range_del_iters) {
+      range_del_agg->AddTombstones(std::move(range_del_iter));
+    }
+    ScopedArenaIterator iter(NewMergingIterator(
+        &icmp, &memtables[0], static_cast<int>(memtables.size()), &arena));
+    iter->SeekToFirst();
+    MergeHelper merge(
+        db_options_.env, icmp.user_comparator(), ioptions.merge_operator,
+        nullptr, ioptions.info_log, true /* internal key corruption is not ok */,
+        existing_snapshots_.empty() ? 0 : existing_snapshots_.back(),
+        snapshot_checker_);
+    // The same logic as a flush, without a blob file builder: large values
+    // stay in the memtable until it is really flushed.
+    CompactionIterator c_iter(
+        iter.get(), icmp.user_comparator(), &merge, kMaxSequenceNumber,
+        &existing_snapshots_, earliest_write_conflict_snapshot_,
+        snapshot_checker_, db_options_.env,
+        ShouldReportDetailedTime(db_options_.env, ioptions.statistics),
+        true /* internal key corruption is not ok */, range_del_agg.get(),
+        nullptr /* blob_file_builder */, ioptions.allow_data_in_errors);
+
+    for (c_iter.SeekToFirst(); c_iter.Valid(); c_iter.Next()) {
+      const ParsedInternalKey& ikey = c_iter.ikey();
+      if (!new_mem->Add(ikey.sequence, ikey.type, ikey.user_key,
+                        c_iter.value())) {
+        s = Status::Corruption("Duplicate key in MemPurge output");
+        break;
+      }
+      output_entries++;
+      if (new_mem->ApproximateMemoryUsage() > max_memory_usage) {
+        s = Status::Aborted("MemPurge output exceeds mempurge_threshold");
+        break;
+      }
+    }
+    if (!s.ok()) {
+      c_iter.status().PermitUncheckedError();
+    } else if (!c_iter.status().ok()) {
+      s = c_iter.status();
+    }
+    if (s.ok()) {
+      auto range_del_it = range_del_agg->NewIterator();
+      for (range_del_it->SeekToFirst(); range_del_it->Valid();
+           range_del_it->Next()) {
+        auto tombstone = range_del_it->Tombstone();
+        new_mem->Add(tombstone.seq_, kTypeRangeDeletion, tombstone.start_key_,
+                     tombstone.end_key_);
+        output_entries++;
+      }
+      if (new_mem->ApproximateMemoryUsage() > max_memory_usage) {
+        s = Status::Aborted("MemPurge output exceeds mempurge_threshold");
+      }
+    }
+    TEST_SYNC_POINT_CALLBACK("FlushJob::MemPurge:Output", &s);
+  }
+  db_mutex_->Lock();
+
+  if (s.ok() && (cfd_->IsDropped() ||
+                 shutting_down_->load(std::memory_order_acquire))) {
+    s = Status::Aborted("Column family dropped or database shutdown");
+  }
+  if (s.ok()) {
+    new_mem->SetID(mems_.back()->GetID());
+    new_mem->SetNextLogNumber(mems_.back()->GetNextLogNumber());
+    if (min_prep_log > 0) {
+      new_mem->RefLogContainingPrepSection(min_prep_log);
+    }
+    if (!cfd_->imm()->InstallMemPurgeResult(mems_, new_mem.get(),
+                                            &job_context_->memtables_to_free)) {
+      s = Status::Aborted("Another flush is in progress");
+    }
+  }
+
+  const size_t output_memory_usage = new_mem->ApproximateMemoryUsage();
+  if (s.ok()) {
+    // Owned by the memtable list now.
+    new_mem.release();
+    base_->Unref();
+  } else {
+    // Freed outside the mutex.
+    job_context_->memtables_to_free.push_back(new_mem.release());
+  }
+
+  ROCKS_LOG_INFO(db_options_.info_log,
+                 "[%s] [JOB %d] MemPurge of %" ROCKSDB_PRIszt
+                 " memtables: %" PRIu64 " entries, %" ROCKSDB_PRIszt
+                 " bytes -> %" PRIu64 " entries, %" ROCKSDB_PRIszt " bytes: %s",
+                 cfd_->GetName().c_str(), job_context_->job_id, mems_.size(),
+                 input_entries, input_memory_usage, output_entries,
+                 output_memory_usage, s.ToString().c_str());
+  event_logger_->Log() << "job" << job_context_->job_id << "event"
+                       << "mempurge"
+                       << "num_memtables" << mems_.size() << "input_entries"
+                       << input_entries << "input_memory_usage"
+                       << input_memory_usage << "output_entries"
+                       << output_entries << "output_memory_usage"
+                       << output_memory_usage << "micros"
+                       << db_options_.env->NowMicros() - start_micros
+                       << "status" << s.ToString();
+  return s;
+}
+
 Status FlushJob::WriteLevel0Table() {
   AutoThreadOperationStageUpdater stage_updater(
       ThreadStatus::STAGE_FLUSH_WRITE_L0);
@@ -100,6 +100,14 @@ class FlushJob {
   void ReportFlushInputSize(const autovector<MemTable*>& mems);
   void RecordFlushIOStats();
   Status WriteLevel0Table();
+  // Returns true if mems_ should be garbage collected in memory (MemPurge)
+  // before falling back to WriteLevel0Table().
+  bool MemPurgeDecider() const;
+  // Replaces mems_ in the immutable memtable list with a new memtable that
+  // holds only the entries a flush would write. This will release and
+  // re-acquire the mutex. If it fails, including when the new memtable
+  // would be too large, mems_ are left unchanged to be flushed.
+  Status MemPurge();
 #ifndef ROCKSDB_LITE
   std::unique_ptr<FlushJobInfo> GetFlushJobInfo() const;
 #endif  // !ROCKSDB_LITE
@@ -160,6 +168,9 @@ class FlushJob {
   VersionEdit* edit_;
   Version* base_;
   bool pick_memtable_called;
+  // True if the memtables were picked for an explicit flush request, rather
+  // than because they filled up.
+  bool flush_requested_;
   Env::Priority thread_pri_;
   IOStatus io_status_;
 
@@ -21,6 +21,7 @@
 #include "db/column_family.h"
 #include "db/db_impl/db_impl.h"
 #include "rocksdb/table.h"
+#include "rocksdb/utilities/sim_cache.h"
 #include "util/string_util.h"
 
 namespace ROCKSDB_NAMESPACE {
@@ -258,6 +259,9 @@ static const std::string estimate_oldest_key_time = "estimate-oldest-key-time";
 static const std::string block_cache_capacity = "block-cache-capacity";
 static const std::string block_cache_usage = "block-cache-usage";
 static const std::string block_cache_pinned_usage = "block-cache-pinned-usage";
+static const std::string block_cache_partitions = "block-cache-partitions";
+static const std::string block_cache_miss_ratio_curve =
+    "block-cache-miss-ratio-curve";
 static const std::string options_statistics = "options-statistics";
 
 const std::string DB::Properties::kNumFilesAtLevelPrefix =
@@ -346,6 +350,10 @@ const std::string DB::Properties::kBlockCacheUsage =
     rocksdb_prefix + block_cache_usage;
 const std::string DB::Properties::kBlockCachePinnedUsage =
     rocksdb_prefix + block_cache_pinned_usage;
+const std::string DB::Properties::kBlockCachePartitions =
+    rocksdb_prefix + block_cache_partitions;
+const std::string DB::Properties::kBlockCacheMissRatioCurve =
+    rocksdb_prefix + block_cache_miss_ratio_curve;
 const std::string DB::Properties::kOptionsStatistics =
     rocksdb_prefix + options_statistics;
 
@@ -484,6 +492,12 @@ const std::unordered_map<std::string, DBPropertyInfo>
         {DB::Properties::kBlockCachePinnedUsage,
          {false, nullptr, &InternalStats::HandleBlockCachePinnedUsage, nullptr,
           nullptr}},
+        {DB::Properties::kBlockCachePartitions,
+         {false, &InternalStats::HandleBlockCachePartitions, nullptr,
+          &InternalStats::HandleBlockCachePartitionsMap, nullptr}},
+        {DB::Properties::kBlockCacheMissRatioCurve,
+         {false, &InternalStats::HandleBlockCacheMissRatioCurve, nullptr,
+          &InternalStats::HandleBlockCacheMissRatioCurveMap, nullptr}},
         {DB::Properties::kOptionsStatistics,
          {false, nullptr, nullptr, nullptr,
           &DBImpl::GetPropertyHandleOptionsStatistics}},
@@ -946,6 +960,84 @@ bool InternalStats::HandleBlockCachePinnedUsage(uint64_t* value, DBImpl* /*db*/,
   return true;
 }
 
+bool InternalStats::HandleBlockCachePartitionsMap(
+    std::map<std::string, std::string>* value) {
+  Cache* block_cache;
+  bool ok = HandleBlockCacheStat(&block_cache);
+  if (!ok) {
+    return false;
+  }
+  std::vector<CachePartitionUsage> partitions;
+  block_cache->GetPartitionUsage(&partitions);
+  for (const CachePartitionUsage& p : partitions) {
+    (*value)[p.name + ".usage"] = ToString(p.usage);
+    (*value)[p.name + ".pinned-usage"] = ToString(p.pinned_usage);
+    (*value)[p.name + ".reserved-capacity"] = ToString(p.reserved_capacity);
+    (*value)[p.name + ".max-capacity"] = ToString(p.max_capacity);
+  }
+  return true;
+}
+
+bool InternalStats::HandleBlockCachePartitions(std::string* value,
+                                               Slice /*suffix*/) {
+  std::map<std::string, std::string> partitions;
+  if (!HandleBlockCachePartitionsMap(&partitions)) {
+    return false;
+  }
+  value->clear();
+  for (const auto& kv : partitions) {
+    value->append(kv.first);
+    value->append(": ");
+    value->append(kv.second);
+    value->append("\n");
+  }
+  return true;
+}
+
+bool InternalStats::HandleBlockCacheMissRatioCurveMap(
+    std::map<std::string, std::string>* value) {
+  Cache* block_cache;
+  bool ok = HandleBlockCacheStat(&block_cache);
+  if (!ok || strcmp(block_cache->Name(), "MissRatioCurveCache") != 0) {
+    return false;
+  }
+  std::vector<MissRatioCurvePoint> curve;
+  static_cast<MissRatioCurveCache*>(block_cache)->GetMissRatioCurve(&curve);
+  char buf[50];
+  for (const MissRatioCurvePoint& point : curve) {
+    snprintf(buf, sizeof(buf), "%gx", point.capacity_ratio);
+    std::string prefix = buf;
+    (*value)[prefix + ".capacity"] = ToString(point.capacity);
+    (*value)[prefix + ".lookups"] = ToString(point.lookups);
+    (*value)[prefix + ".hits"] = ToString(point.hits);
+    snprintf(buf, sizeof(buf), "%.4f", point.hit_ratio());
+    (*value)[prefix + ".hit-ratio"] = buf;
+  }
+  return true;
+}
+
+bool InternalStats::HandleBlockCacheMissRatioCurve(std::string* value,
+                                                   Slice /*suffix*/) {
+  Cache* block_cache;
+  bool ok = HandleBlockCacheStat(&block_cache);
+  if (!ok || strcmp(block_cache->Name(), "MissRatioCurveCache") != 0) {
+    return false;
+  }
+  std::vector<MissRatioCurvePoint> curve;
+  static_cast<MissRatioCurveCache*>(block_cache)->GetMissRatioCurve(&curve);
+  char buf[200];
+  value->clear();
+  for (const MissRatioCurvePoint& point : curve) {
+    snprintf(buf, sizeof(buf),
+             "%5gx capacity %12" ROCKSDB_PRIszt " hit ratio %.4f (%" PRIu64
+             " / %" PRIu64 " sampled lookups)\n",
+             point.capacity_ratio, point.capacity, point.hit_ratio(),
+             point.hits, point.lookups);
+    value->append(buf);
+  }
+  return true;
+}
+
 void InternalStats::DumpDBStats(std::string* value) {
   char buf[1000];
   // DB-level stats, only available from default column family
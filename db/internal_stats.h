@@ -587,6 +587,12 @@ class InternalStats {
   bool HandleBlockCacheUsage(uint64_t* value, DBImpl* db, Version* version);
   bool HandleBlockCachePinnedUsage(uint64_t* value, DBImpl* db,
                                    Version* version);
+  bool HandleBlockCachePartitions(std::string* value, Slice suffix);
+  bool HandleBlockCachePartitionsMap(
+      std::map<std::string, std::string>* value);
+  bool HandleBlockCacheMissRatioCurve(std::string* value, Slice suffix);
+  bool HandleBlockCacheMissRatioCurveMap(
+      std::map<std::string, std::string>* value);
   // Total number of background errors encountered. Every time a flush task
   // or compaction task fails, this counter is incremented. The failure can
   // be caused by any possible reason, including file system errors, out of
@@ -32,8 +32,21 @@ enum RecordType {
   kRecyclableFirstType = 6,
   kRecyclableMiddleType = 7,
   kRecyclableLastType = 8,
+
+  // Compression type of the records that follow, see
+  // DBOptions::wal_compression. Readers of older versions used the values 9
+  // to 14 internally, and would take them for the end of the file instead of
+  // failing on an unknown record type.
+  kSetCompressionType = 15,
+  kRecyclableSetCompressionType = 16,
 };
-static const int kMaxRecordType = kRecyclableLastType;
+static const int kMaxRecordType = kRecyclableSetCompressionType;
+
+// Returns true if records of the given type have the recyclable header.
+inline bool IsRecyclableRecordType(unsigned int type) {
+  return (type >= kRecyclableFullType && type <= kRecyclableLastType) ||
+         type == kRecyclableSetCompressionType;
+}
 
 static const unsigned int kBlockSize = 32768;
 
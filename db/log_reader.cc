@@ -15,6 +15,7 @@
 #include "rocksdb/env.h"
 #include "test_util/sync_point.h"
 #include "util/coding.h"
+#include "util/compression.h"
 #include "util/crc32c.h"
 
 namespace ROCKSDB_NAMESPACE {
@@ -38,7 +39,8 @@ Reader::Reader(std::shared_ptr<Logger> info_log,
       last_record_offset_(0),
       end_of_buffer_offset_(0),
       log_number_(log_num),
-      recycled_(false) {}
+      recycled_(false),
+      compression_type_(kNoCompression) {}
 
 Reader::~Reader() {
   delete[] backing_store_;
@@ -78,6 +80,10 @@ bool Reader::ReadRecord(Slice* record, std::string* scratch,
         prospective_record_offset = physical_record_offset;
         scratch->clear();
         *record = fragment;
+        if (!MaybeUncompressRecord(record)) {
+          in_fragmented_record = false;
+          break;
+        }
         last_record_offset_ = prospective_record_offset;
         return true;
 
@@ -113,11 +119,26 @@ bool Reader::ReadRecord(Slice* record, std::string* scratch,
         } else {
           scratch->append(fragment.data(), fragment.size());
           *record = Slice(*scratch);
+          if (!MaybeUncompressRecord(record)) {
+            in_fragmented_record = false;
+            scratch->clear();
+            break;
+          }
           last_record_offset_ = prospective_record_offset;
           return true;
         }
         break;
 
+      case kSetCompressionType:
+      case kRecyclableSetCompressionType:
+        if (in_fragmented_record) {
+          ReportCorruption(scratch->size(), "partial record without end(3)");
+          in_fragmented_record = false;
+          scratch->clear();
+        }
+        InitCompression(fragment);
+        break;
+
       case kBadHeader:
         if (wal_recovery_mode == WALRecoveryMode::kAbsoluteConsistency) {
           // in clean shutdown we don't expect any error in the log files
@@ -280,6 +301,41 @@ void Reader::ReportDrop(size_t bytes, const Status& reason) {
   }
 }
 
+void Reader::InitCompression(const Slice& payload) {
+  if (payload.empty()) {
+    ReportCorruption(payload.size(), "empty compression type record");
+    return;
+  }
+  compression_type_ = static_cast<CompressionType>(payload[0]);
+  uncompress_ = StreamingUncompress::Create(compression_type_);
+  if (uncompress_ == nullptr && compression_type_ != kNoCompression) {
+    const std::string type_name = CompressionTypeToString(compression_type_);
+    ReportDrop(payload.size(),
+               Status::NotSupported("WAL compression type not supported",
+                                    type_name));
+  }
+}
+
+bool Reader::MaybeUncompressRecord(Slice* record) {
+  if (compression_type_ == kNoCompression) {
+    return true;
+  }
+  if (uncompress_ == nullptr) {
+    const std::string type_name = CompressionTypeToString(compression_type_);
+    ReportDrop(record->size(),
+               Status::NotSupported("WAL compression type not supported",
+                                    type_name));
+    return false;
+  }
+  Status s = uncompress_->Uncompress(*record, &uncompressed_record_);
+  if (!s.ok()) {
+    ReportDrop(record->size(), s);
+    return false;
+  }
+  *record = Slice(uncompressed_record_);
+  return true;
+}
+
 bool Reader::ReadMore(size_t* drop_size, int *error) {
   if (!eof_ && !read_error_) {
     // Last read was a full read, so this is a trailer to skip
@@ -336,7 +392,7 @@ unsigned int Reader::ReadPhysicalRecord(Slice* result, size_t* drop_size) {
     const unsigned int type = header[6];
     const uint32_t length = a | (b << 8);
     int header_size = kHeaderSize;
-    if (type >= kRecyclableFullType && type <= kRecyclableLastType) {
+    if (IsRecyclableRecordType(type)) {
       if (end_of_buffer_offset_ - buffer_.size() == 0) {
         recycled_ = true;
       }
@@ -422,9 +478,12 @@ bool FragmentBufferedReader::ReadRecord(Slice* record, std::string* scratch,
         }
         fragments_.clear();
         *record = fragment;
+        in_fragmented_record_ = false;
+        if (!MaybeUncompressRecord(record)) {
+          break;
+        }
         prospective_record_offset = physical_record_offset;
         last_record_offset_ = prospective_record_offset;
-        in_fragmented_record_ = false;
         return true;
 
       case kFirstType:
@@ -457,12 +516,26 @@ bool FragmentBufferedReader::ReadRecord(Slice* record, std::string* scratch,
           scratch->assign(fragments_.data(), fragments_.size());
           fragments_.clear();
           *record = Slice(*scratch);
-          last_record_offset_ = prospective_record_offset;
           in_fragmented_record_ = false;
+          if (!MaybeUncompressRecord(record)) {
+            scratch->clear();
+            break;
+          }
+          last_record_offset_ = prospective_record_offset;
           return true;
         }
         break;
 
+      case kSetCompressionType:
+      case kRecyclableSetCompressionType:
+        if (in_fragmented_record_) {
+          ReportCorruption(fragments_.size(), "partial record without end(3)");
+          in_fragmented_record_ = false;
+          fragments_.clear();
+        }
+        InitCompression(fragment);
+        break;
+
       case kBadHeader:
       case kBadRecord:
       case kEof:
@@ -568,7 +641,7 @@ bool FragmentBufferedReader::TryReadFragment(
   const unsigned int type = header[6];
   const uint32_t length = a | (b << 8);
   int header_size = kHeaderSize;
-  if (type >= kRecyclableFullType && type <= kRecyclableLastType) {
+  if (IsRecyclableRecordType(type)) {
     if (end_of_buffer_offset_ - buffer_.size() == 0) {
       recycled_ = true;
     }
@@ -19,6 +19,7 @@
 
 namespace ROCKSDB_NAMESPACE {
 class Logger;
+class StreamingUncompress;
 
 namespace log {
 
@@ -128,6 +129,12 @@ class Reader {
   // Whether this is a recycled log file
   bool recycled_;
 
+  // Compression of the records, set by a kSetCompressionType record.
+  // uncompress_ is null if the compression type is not supported.
+  CompressionType compression_type_;
+  std::unique_ptr<StreamingUncompress> uncompress_;
+  std::string uncompressed_record_;
+
   // Extend record types with the following special values
   enum {
     kEof = kMaxRecordType + 1,
@@ -158,6 +165,15 @@ class Reader {
   // buffer_ must be updated to remove the dropped bytes prior to invocation.
   void ReportCorruption(size_t bytes, const char* reason);
   void ReportDrop(size_t bytes, const Status& reason);
+
+  // Sets the compression of the following records from the payload of a
+  // kSetCompressionType record.
+  void InitCompression(const Slice& payload);
+
+  // If the log is compressed, uncompresses *record into uncompressed_record_
+  // and points *record to it. Returns false, after reporting the drop, if the
+  // record cannot be uncompressed.
+  bool MaybeUncompressRecord(Slice* record);
 };
 
 class FragmentBufferedReader : public Reader {
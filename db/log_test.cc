@@ -16,6 +16,7 @@
 #include "test_util/testharness.h"
 #include "test_util/testutil.h"
 #include "util/coding.h"
+#include "util/compression.h"
 #include "util/crc32c.h"
 #include "util/random.h"
 
@@ -45,10 +46,12 @@ static std::string RandomSkewedString(int i, Random* rnd) {
   return BigString(NumberString(i), rnd->Skewed(17));
 }
 
-// Param type is tuple<int, bool>
+// Param type is tuple<int, bool, CompressionType>
 // get<0>(tuple): non-zero if recycling log, zero if regular log
 // get<1>(tuple): true if allow retry after read EOF, false otherwise
-class LogTest : public ::testing::TestWithParam<std::tuple<int, bool>> {
+// get<2>(tuple): compression type of the log
+class LogTest : public ::testing::TestWithParam<
+                    std::tuple<int, bool, CompressionType>> {
  private:
   class StringSource : public SequentialFile {
    public:
@@ -176,8 +179,10 @@ class LogTest : public ::testing::TestWithParam<std::tuple<int, bool>> {
         source_holder_(test::GetSequentialFileReader(
             new StringSource(reader_contents_, !std::get<1>(GetParam())),
             "" /* file name */)),
-        writer_(std::move(dest_holder_), 123, std::get<0>(GetParam())),
+        writer_(std::move(dest_holder_), 123, std::get<0>(GetParam()),
+                false /* manual_flush */, std::get<2>(GetParam())),
         allow_retry_read_(std::get<1>(GetParam())) {
+    EXPECT_OK(writer_.AddCompressionTypeRecord());
     if (allow_retry_read_) {
       reader_.reset(new FragmentBufferedReader(
           nullptr, std::move(source_holder_), &report_, true /* checksum */,
@@ -699,11 +704,146 @@ TEST_P(LogTest, Recycle) {
   ASSERT_EQ("EOF", Read());
 }
 
+TEST_P(LogTest, UnsupportedCompressionType) {
+  // Turn a one byte record into a compression type record of a type that no
+  // build can uncompress, as if written by a newer version.
+  bool recyclable_log = (std::get<0>(GetParam()) != 0);
+  int header_size = recyclable_log ? kRecyclableHeaderSize : kHeaderSize;
+  Write("x");
+  SetByte(6, static_cast<char>(recyclable_log ? kRecyclableSetCompressionType
+                                              : kSetCompressionType));
+  SetByte(header_size, static_cast<char>(kZSTDNotFinalCompression));
+  FixChecksum(0, 1, recyclable_log);
+  Write("foo");
+  Write("bar");
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ("OK", MatchError("WAL compression type not supported"));
+  ASSERT_GT(DroppedBytes(), 0U);
+}
+
 INSTANTIATE_TEST_CASE_P(bool, LogTest,
-                        ::testing::Values(std::make_tuple(0, false),
-                                          std::make_tuple(0, true),
-                                          std::make_tuple(1, false),
-                                          std::make_tuple(1, true)));
+                        ::testing::Combine(::testing::Values(0, 1),
+                                           ::testing::Bool(),
+                                           ::testing::Values(kNoCompression)));
+
+class CompressionLogTest : public LogTest {};
+
+TEST_P(CompressionLogTest, Empty) { ASSERT_EQ("EOF", Read()); }
+
+TEST_P(CompressionLogTest, ReadWrite) {
+  Write("foo");
+  Write("bar");
+  Write("");
+  Write("xxxx");
+  ASSERT_EQ("foo", Read());
+  ASSERT_EQ("bar", Read());
+  ASSERT_EQ("", Read());
+  ASSERT_EQ("xxxx", Read());
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ("EOF", Read());  // Make sure reads at eof work
+  ASSERT_EQ(0U, DroppedBytes());
+}
+
+TEST_P(CompressionLogTest, ManyBlocks) {
+  for (int i = 0; i < 100000; i++) {
+    Write(NumberString(i));
+  }
+  for (int i = 0; i < 100000; i++) {
+    ASSERT_EQ(NumberString(i), Read());
+  }
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ(0U, DroppedBytes());
+}
+
+TEST_P(CompressionLogTest, Fragmentation) {
+  // Incompressible records are compressed into as many fragments as they
+  // would take uncompressed.
+  Random rnd(301);
+  std::vector<std::string> records = {
+      "small", BigString("medium", 50000), rnd.RandomString(50000),
+      BigString("large", 100000), rnd.RandomString(3 * kBlockSize), ""};
+  for (const auto& record : records) {
+    Write(record);
+  }
+  for (const auto& record : records) {
+    ASSERT_EQ(record, Read());
+  }
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ(0U, DroppedBytes());
+}
+
+TEST_P(CompressionLogTest, CompressesRecords) {
+  if (std::get<2>(GetParam()) == kNoCompression) {
+    return;  // test is only valid for compressed logs
+  }
+  std::string record = BigString("compressible", 10 * kBlockSize);
+  Write(record);
+  ASSERT_LT(WrittenBytes(), record.size() / 10);
+  ASSERT_EQ(record, Read());
+  ASSERT_EQ("EOF", Read());
+}
+
+TEST_P(CompressionLogTest, Tailing) {
+  // The reader uncompresses the records appended after it reached the end
+  // of the log, as the tailing readers of secondary instances and
+  // TransactionLogIterator do.
+  Random rnd(301);
+  std::string foo = rnd.RandomString(2 * kBlockSize);
+  std::string bar = BigString("bar", 2 * kBlockSize);
+  Write("baz");
+  ASSERT_EQ("baz", Read());
+  ASSERT_EQ("EOF", Read());
+  ASSERT_TRUE(IsEOF());
+  Write(foo);
+  UnmarkEOF();
+  ASSERT_EQ(foo, Read());
+  ASSERT_EQ("EOF", Read());
+  Write(bar);
+  UnmarkEOF();
+  ASSERT_EQ(bar, Read());
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ(0U, DroppedBytes());
+}
+
+TEST_P(CompressionLogTest, Recycle) {
+  bool recyclable_log = (std::get<0>(GetParam()) != 0);
+  if (!recyclable_log) {
+    return;  // test is only valid for recycled logs
+  }
+  Random rnd(301);
+  Write("foo");
+  while (get_reader_contents()->size() < log::kBlockSize * 2) {
+    Write(rnd.RandomString(100));
+  }
+  std::unique_ptr<WritableFileWriter> dest_holder(test::GetWritableFileWriter(
+      new test::OverwritingStringSink(get_reader_contents()),
+      "" /* don't care */));
+  Writer recycle_writer(std::move(dest_holder), 123, true,
+                        false /* manual_flush */, std::get<2>(GetParam()));
+  ASSERT_OK(recycle_writer.AddCompressionTypeRecord());
+  recycle_writer.AddRecord(Slice("foooo"));
+  recycle_writer.AddRecord(Slice("bar"));
+  ASSERT_GE(get_reader_contents()->size(), log::kBlockSize * 2);
+  ASSERT_EQ("foooo", Read());
+  ASSERT_EQ("bar", Read());
+  ASSERT_EQ("EOF", Read());
+}
+
+std::vector<CompressionType> GetStreamingCompressions() {
+  std::vector<CompressionType> types;
+  for (CompressionType type :
+       {kNoCompression, kZlibCompression, kLZ4Compression, kZSTD}) {
+    if (StreamingCompressionTypeSupported(type)) {
+      types.push_back(type);
+    }
+  }
+  return types;
+}
+
+INSTANTIATE_TEST_CASE_P(
+    Compression, CompressionLogTest,
+    ::testing::Combine(::testing::Values(0, 1), ::testing::Bool(),
+                       ::testing::ValuesIn(GetStreamingCompressions())));
 
 class RetriableLogTest : public ::testing::TestWithParam<int> {
  private:
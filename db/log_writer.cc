@@ -13,18 +13,21 @@
 #include "file/writable_file_writer.h"
 #include "rocksdb/env.h"
 #include "util/coding.h"
+#include "util/compression.h"
 #include "util/crc32c.h"
 
 namespace ROCKSDB_NAMESPACE {
 namespace log {
 
 Writer::Writer(std::unique_ptr<WritableFileWriter>&& dest, uint64_t log_number,
-               bool recycle_log_files, bool manual_flush)
+               bool recycle_log_files, bool manual_flush,
+               CompressionType compression_type)
     : dest_(std::move(dest)),
       block_offset_(0),
       log_number_(log_number),
       recycle_log_files_(recycle_log_files),
-      manual_flush_(manual_flush) {
+      manual_flush_(manual_flush),
+      compression_type_(compression_type) {
   for (int i = 0; i <= kMaxRecordType; i++) {
     char t = static_cast<char>(i);
     type_crc_[i] = crc32c::Value(&t, 1);
@@ -56,11 +59,24 @@ IOStatus Writer::AddRecord(const Slice& slice) {
   const int header_size =
       recycle_log_files_ ? kRecyclableHeaderSize : kHeaderSize;
 
+  IOStatus s;
+  if (compress_ != nullptr) {
+    Status cs = compress_->Reset(slice);
+    if (!cs.ok()) {
+      return IOStatus::Corruption("WAL record compression failed",
+                                  cs.ToString());
+    }
+    ptr = compressed_buffer_.get();
+  } else if (compression_type_ != kNoCompression) {
+    // AddCompressionTypeRecord() was not called, or failed.
+    return IOStatus::InvalidArgument("WAL compression type record missing");
+  }
+
   // Fragment the record if necessary and emit it.  Note that if slice
   // is empty, we still want to iterate once to emit a single
   // zero-length record
-  IOStatus s;
   bool begin = true;
+  bool end = false;
   do {
     const int64_t leftover = kBlockSize - block_offset_;
     assert(leftover >= 0);
@@ -83,10 +99,22 @@ IOStatus Writer::AddRecord(const Slice& slice) {
     assert(static_cast<int64_t>(kBlockSize - block_offset_) >= header_size);
 
     const size_t avail = kBlockSize - block_offset_ - header_size;
-    const size_t fragment_length = (left < avail) ? left : avail;
+    size_t fragment_length;
+    if (compress_ != nullptr) {
+      // Compress as much of the record as fits in the rest of the block.
+      Status cs = compress_->Compress(compressed_buffer_.get(), avail,
+                                      &fragment_length, &end);
+      if (!cs.ok()) {
+        s = IOStatus::Corruption("WAL record compression failed",
+                                 cs.ToString());
+        break;
+      }
+    } else {
+      fragment_length = (left < avail) ? left : avail;
+      end = (left == fragment_length);
+    }
 
     RecordType type;
-    const bool end = (left == fragment_length);
     if (begin && end) {
       type = recycle_log_files_ ? kRecyclableFullType : kFullType;
     } else if (begin) {
@@ -98,10 +126,12 @@ IOStatus Writer::AddRecord(const Slice& slice) {
     }
 
     s = EmitPhysicalRecord(type, ptr, fragment_length);
-    ptr += fragment_length;
-    left -= fragment_length;
+    if (compress_ == nullptr) {
+      ptr += fragment_length;
+      left -= fragment_length;
+    }
     begin = false;
-  } while (s.ok() && left > 0);
+  } while (s.ok() && !end);
 
   if (s.ok()) {
     if (!manual_flush_) {
@@ -112,6 +142,30 @@ IOStatus Writer::AddRecord(const Slice& slice) {
   return s;
 }
 
+IOStatus Writer::AddCompressionTypeRecord() {
+  if (compression_type_ == kNoCompression) {
+    return IOStatus::OK();
+  }
+  assert(block_offset_ == 0);
+  compress_ = StreamingCompress::Create(compression_type_);
+  if (compress_ == nullptr) {
+    return IOStatus::NotSupported(
+        "WAL compression type not supported: " +
+        CompressionTypeToString(compression_type_));
+  }
+  compressed_buffer_.reset(new char[kBlockSize]);
+
+  const char payload = static_cast<char>(compression_type_);
+  IOStatus s = EmitPhysicalRecord(recycle_log_files_
+                                      ? kRecyclableSetCompressionType
+                                      : kSetCompressionType,
+                                  &payload, 1);
+  if (s.ok() && !manual_flush_) {
+    s = dest_->Flush();
+  }
+  return s;
+}
+
 bool Writer::TEST_BufferIsEmpty() { return dest_->TEST_BufferIsEmpty(); }
 
 IOStatus Writer::EmitPhysicalRecord(RecordType t, const char* ptr, size_t n) {
@@ -126,7 +180,7 @@ IOStatus Writer::EmitPhysicalRecord(RecordType t, const char* ptr, size_t n) {
   buf[6] = static_cast<char>(t);
 
   uint32_t crc = type_crc_[t];
-  if (t < kRecyclableFullType) {
+  if (!IsRecyclableRecordType(t)) {
     // Legacy record format
     assert(block_offset_ + kHeaderSize + n <= kBlockSize);
     header_size = kHeaderSize;
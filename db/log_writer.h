@@ -13,12 +13,14 @@
 #include <memory>
 
 #include "db/log_format.h"
+#include "rocksdb/compression_type.h"
 #include "rocksdb/io_status.h"
 #include "rocksdb/slice.h"
 #include "rocksdb/status.h"
 
 namespace ROCKSDB_NAMESPACE {
 
+class StreamingCompress;
 class WritableFileWriter;
 
 namespace log {
@@ -65,15 +67,23 @@ namespace log {
  * Same as above, with the addition of
  * Log number = 32bit log file number, so that we can distinguish between
  * records written by the most recent log writer vs a previous one.
+ *
+ * Compressed logs start with a kSetCompressionType (or
+ * kRecyclableSetCompressionType) record whose payload is the compression
+ * type. The payload of every following record is compressed independently
+ * of the other records, and then fragmented as above.
  */
 class Writer {
  public:
   // Create a writer that will append data to "*dest".
   // "*dest" must be initially empty.
   // "*dest" must remain live while this Writer is in use.
+  // If compression_type is not kNoCompression, AddCompressionTypeRecord()
+  // must be called before the first AddRecord().
   explicit Writer(std::unique_ptr<WritableFileWriter>&& dest,
                   uint64_t log_number, bool recycle_log_files,
-                  bool manual_flush = false);
+                  bool manual_flush = false,
+                  CompressionType compression_type = kNoCompression);
   // No copying allowed
   Writer(const Writer&) = delete;
   void operator=(const Writer&) = delete;
@@ -82,6 +92,12 @@ class Writer {
 
   IOStatus AddRecord(const Slice& slice);
 
+  // Writes the record that sets the compression type of the following
+  // records. Does nothing if the log is not compressed.
+  IOStatus AddCompressionTypeRecord();
+
+  CompressionType compression_type() const { return compression_type_; }
+
   WritableFileWriter* file() { return dest_.get(); }
   const WritableFileWriter* file() const { return dest_.get(); }
 
@@ -109,6 +125,11 @@ class Writer {
   // If true, it does not flush after each write. Instead it relies on the upper
   // layer to manually does the flush by calling ::WriteBuffer()
   bool manual_flush_;
+
+  CompressionType compression_type_;
+  std::unique_ptr<StreamingCompress> compress_;
+  // Holds the compressed fragment being emitted.
+  std::unique_ptr<char[]> compressed_buffer_;
 };
 
 }  // namespace log
@@ -34,6 +34,7 @@
 #include "table/internal_iterator.h"
 #include "table/iterator_wrapper.h"
 #include "table/merging_iterator.h"
+#include "test_util/sync_point.h"
 #include "util/autovector.h"
 #include "util/coding.h"
 #include "util/mutexlock.h"
@@ -77,7 +78,8 @@ MemTable::MemTable(const InternalKeyComparator& cmp,
                write_buffer_manager->cost_to_cache()))
                  ? &mem_tracker_
                  : nullptr,
-             mutable_cf_options.memtable_huge_page_size),
+             mutable_cf_options.memtable_huge_page_size,
+             mutable_cf_options.memtable_numa_aware, ioptions.arena_block_pool),
       table_(ioptions.memtable_factory->CreateMemTableRep(
           comparator_, &arena_, ioptions, mutable_cf_options,
           column_family_id)),
@@ -85,12 +87,14 @@ MemTable::MemTable(const InternalKeyComparator& cmp,
           comparator_, &arena_, nullptr /* transform */, ioptions.info_log,
           column_family_id)),
       is_range_del_table_empty_(true),
+      num_range_deletes_(0),
       data_size_(0),
       num_entries_(0),
       num_deletes_(0),
       write_buffer_size_(mutable_cf_options.write_buffer_size),
       flush_in_progress_(false),
       flush_completed_(false),
+      mempurge_output_(false),
       file_number_(0),
       first_seqno_(0),
       earliest_seqno_(latest_seq),
@@ -510,21 +514,57 @@ FragmentedRangeTombstoneIterator* MemTable::NewRangeTombstoneIterator(
       is_range_del_table_empty_.load(std::memory_order_relaxed)) {
     return nullptr;
   }
-  auto* unfragmented_iter = new MemTableIterator(
-      *this, read_options, nullptr /* arena */, true /* use_range_del_table */);
-  if (unfragmented_iter == nullptr) {
-    return nullptr;
-  }
-  auto fragmented_tombstone_list =
-      std::make_shared<FragmentedRangeTombstoneList>(
-          std::unique_ptr<InternalIterator>(unfragmented_iter),
-          comparator_.comparator);
-
   auto* fragmented_iter = new FragmentedRangeTombstoneIterator(
-      fragmented_tombstone_list, comparator_.comparator, read_seq);
+      GetFragmentedRangeTombstones(), comparator_.comparator, read_seq);
   return fragmented_iter;
 }
 
+std::shared_ptr<FragmentedRangeTombstoneList>
+MemTable::GetFragmentedRangeTombstones() {
+  // A range deletion is counted after it is added to range_del_table_, so
+  // a list fragmented from at least num_range_deletes range deletions has
+  // all the range deletions that a reader may see.
+  const uint64_t num_range_deletes =
+      num_range_deletes_.load(std::memory_order_acquire);
+  CachedRangeTombstones* core_cache = core_range_tombstones_.Access();
+  {
+    std::lock_guard<SpinMutex> lock(core_cache->mutex);
+    if (core_cache->list != nullptr &&
+        core_cache->num_range_deletes >= num_range_deletes) {
+      return core_cache->list;
+    }
+  }
+
+  std::shared_ptr<FragmentedRangeTombstoneList> list;
+  uint64_t list_num_range_deletes;
+  {
+    // Readers that miss at the same time wait for one fragmentation.
+    MutexLock l(&fragmented_range_tombstones_mutex_);
+    if (fragmented_range_tombstones_.list == nullptr ||
+        fragmented_range_tombstones_.num_range_deletes < num_range_deletes) {
+      TEST_SYNC_POINT("MemTable::GetFragmentedRangeTombstones:Fragment");
+      auto* unfragmented_iter =
+          new MemTableIterator(*this, ReadOptions(), nullptr /* arena */,
+                               true /* use_range_del_table */);
+      fragmented_range_tombstones_.list =
+          std::make_shared<FragmentedRangeTombstoneList>(
+              std::unique_ptr<InternalIterator>(unfragmented_iter),
+              comparator_.comparator);
+      fragmented_range_tombstones_.num_range_deletes = num_range_deletes;
+    }
+    list = fragmented_range_tombstones_.list;
+    list_num_range_deletes = fragmented_range_tombstones_.num_range_deletes;
+  }
+
+  std::lock_guard<SpinMutex> lock(core_cache->mutex);
+  if (core_cache->list == nullptr ||
+      core_cache->num_range_deletes < list_num_range_deletes) {
+    core_cache->list = list;
+    core_cache->num_range_deletes = list_num_range_deletes;
+  }
+  return list;
+}
+
 port::RWMutex* MemTable::GetLock(const Slice& key) {
   return &locks_[GetSliceRangedNPHash(key, locks_.size())];
 }
@@ -647,6 +687,7 @@ bool MemTable::Add(SequenceNumber s, ValueType type,
     }
   }
   if (type == kTypeRangeDeletion) {
+    num_range_deletes_.fetch_add(1, std::memory_order_release);
     is_range_del_table_empty_.store(false, std::memory_order_relaxed);
   }
   UpdateOldestKeyTime();
@@ -27,8 +27,10 @@
 #include "rocksdb/env.h"
 #include "rocksdb/memtablerep.h"
 #include "table/multiget_context.h"
+#include "util/core_local.h"
 #include "util/dynamic_bloom.h"
 #include "util/hash.h"
+#include "util/mutexlock.h"
 
 namespace ROCKSDB_NAMESPACE {
 
@@ -334,6 +336,15 @@ class MemTable {
     return first_seqno_.load(std::memory_order_relaxed);
   }
 
+  // Sets the sequence number returned by GetFirstSequenceNumber(), for a
+  // memtable whose entries are not added in sequence order, like the output
+  // of a MemPurge.
+  // REQUIRES: first_seqno is not larger than the sequence number of any
+  // entry added later.
+  void SetFirstSequenceNumber(SequenceNumber first_seqno) {
+    first_seqno_.store(first_seqno, std::memory_order_relaxed);
+  }
+
   // Returns the sequence number that is guaranteed to be smaller than or equal
   // to the sequence number of any key that could be inserted into this
   // memtable. It can then be assumed that any write with a larger(or equal)
@@ -437,6 +448,9 @@ class MemTable {
     flush_in_progress_ = in_progress;
   }
 
+  // True if this memtable is the output of a MemPurge.
+  bool IsMemPurgeOutput() const { return mempurge_output_; }
+
 #ifndef ROCKSDB_LITE
   void SetFlushJobInfo(std::unique_ptr<FlushJobInfo>&& info) {
     flush_job_info_ = std::move(info);
@@ -463,6 +477,22 @@ class MemTable {
   std::unique_ptr<MemTableRep> table_;
   std::unique_ptr<MemTableRep> range_del_table_;
   std::atomic_bool is_range_del_table_empty_;
+  // The number of range deletions added to range_del_table_.
+  std::atomic<uint64_t> num_range_deletes_;
+
+  // The range tombstones of range_del_table_, fragmented from the first
+  // num_range_deletes range deletions. They are fragmented again by the
+  // first reader that sees more range deletions, and shared by the other
+  // readers through core-local copies, see GetFragmentedRangeTombstones().
+  struct CachedRangeTombstones {
+    char padding[40] ROCKSDB_FIELD_UNUSED;
+    SpinMutex mutex;
+    std::shared_ptr<FragmentedRangeTombstoneList> list;
+    uint64_t num_range_deletes = 0;
+  };
+  port::Mutex fragmented_range_tombstones_mutex_;
+  CachedRangeTombstones fragmented_range_tombstones_;
+  CoreLocalArray<CachedRangeTombstones> core_range_tombstones_;
 
   // Total data size of all data inserted
   std::atomic<uint64_t> data_size_;
@@ -475,6 +505,7 @@ class MemTable {
   // These are used to manage memtable flushes to storage
   bool flush_in_progress_; // started the flush
   bool flush_completed_;   // finished the flush
+  bool mempurge_output_;   // replaced memtables garbage collected in memory
   uint64_t file_number_;    // filled up after flush is complete
 
   // The updates to be applied to the transaction log when this
@@ -542,6 +573,11 @@ class MemTable {
 
   void UpdateOldestKeyTime();
 
+  // Returns the fragmented range tombstones, which include at least the
+  // range deletions added before the call.
+  // REQUIRES: !is_range_del_table_empty_
+  std::shared_ptr<FragmentedRangeTombstoneList> GetFragmentedRangeTombstones();
+
   void GetFromTable(const LookupKey& key,
                     SequenceNumber max_covering_tombstone_seq, bool do_merge,
                     ReadCallback* callback, bool* is_blob_index,
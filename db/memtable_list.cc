@@ -5,6 +5,7 @@
 //
 #include "db/memtable_list.h"
 
+#include <algorithm>
 #include <cinttypes>
 #include <limits>
 #include <queue>
@@ -33,6 +34,11 @@ void MemTableListVersion::AddMemTable(MemTable* m) {
   *parent_memtable_list_memory_usage_ += m->ApproximateMemoryUsage();
 }
 
+void MemTableListVersion::AddOldestMemTable(MemTable* m) {
+  memlist_.push_back(m);
+  *parent_memtable_list_memory_usage_ += m->ApproximateMemoryUsage();
+}
+
 void MemTableListVersion::UnrefMemTable(autovector<MemTable*>* to_delete,
                                         MemTable* m) {
   if (m->Unref()) {
@@ -325,8 +331,18 @@ bool MemTableListVersion::TrimHistory(autovector<MemTable*>* to_delete,
 // Returns true if there is at least one memtable on which flush has
 // not yet started.
 bool MemTableList::IsFlushPending() const {
+  // The output of a MemPurge, which is always the oldest memtable, is not
+  // flushed on its own, or it would be purged or flushed again right away.
+  int num_purged_not_started = 0;
+  if (!current_->memlist_.empty()) {
+    const MemTable* oldest = current_->memlist_.back();
+    if (oldest->mempurge_output_ && !oldest->flush_in_progress_) {
+      num_purged_not_started = 1;
+    }
+  }
   if ((flush_requested_ && num_flush_not_started_ > 0) ||
-      (num_flush_not_started_ >= min_write_buffer_number_to_merge_)) {
+      (num_flush_not_started_ - num_purged_not_started >=
+       min_write_buffer_number_to_merge_)) {
     assert(imm_flush_needed.load(std::memory_order_relaxed));
     return true;
   }
@@ -518,6 +534,36 @@ void MemTableList::Add(MemTable* m, autovector<MemTable*>* to_delete) {
   ResetTrimHistoryNeeded();
 }
 
+bool MemTableList::InstallMemPurgeResult(const autovector<MemTable*>& mems,
+                                         MemTable* new_mem,
+                                         autovector<MemTable*>* to_delete) {
+  AutoThreadOperationStageUpdater stage_updater(
+      ThreadStatus::STAGE_MEMTABLE_INSTALL_FLUSH_RESULTS);
+  for (MemTable* m : current_->memlist_) {
+    if (m->flush_in_progress_ &&
+        std::find(mems.begin(), mems.end(), m) == mems.end()) {
+      return false;
+    }
+  }
+  // Since no other flush is in progress, mems were picked together with all
+  // the older memtables, and new_mem is older than the rest of the list.
+  InstallNewVersion();
+  for (MemTable* m : mems) {
+    assert(m->flush_in_progress_);
+    assert(!m->flush_completed_);
+    current_->Remove(m, to_delete);
+  }
+  new_mem->Ref();
+  new_mem->MarkImmutable();
+  new_mem->mempurge_output_ = true;
+  current_->AddOldestMemTable(new_mem);
+  num_flush_not_started_++;
+  imm_flush_needed.store(true, std::memory_order_release);
+  UpdateCachedValuesFromMemTableListVersion();
+  ResetTrimHistoryNeeded();
+  return true;
+}
+
 bool MemTableList::TrimHistory(autovector<MemTable*>* to_delete, size_t usage) {
   InstallNewVersion();
   bool ret = current_->TrimHistory(to_delete, usage);
@@ -161,6 +161,9 @@ class MemTableListVersion {
 
   void AddMemTable(MemTable* m);
 
+  // Inserts m at the back of memlist_, as the oldest memtable.
+  void AddOldestMemTable(MemTable* m);
+
   void UnrefMemTable(autovector<MemTable*>* to_delete, MemTable* m);
 
   // Calculate the total amount of memory used by memlist_ and memlist_history_
@@ -274,6 +277,18 @@ class MemTableList {
   // Takes ownership of the referenced held on *m by the caller of Add().
   void Add(MemTable* m, autovector<MemTable*>* to_delete);
 
+  // Replaces mems, the memtables picked by a flush job, with new_mem, the
+  // result of garbage collecting them in memory (MemPurge). new_mem becomes
+  // the oldest memtable of the list and is flushed later, together with
+  // newer memtables or on an explicit flush request. Nothing is written to
+  // the MANIFEST, so the WAL files of mems are kept until then.
+  // Returns false and leaves the list unchanged if another flush job is in
+  // progress, since flush results must be committed in order.
+  // Takes a reference on new_mem if it succeeds.
+  bool InstallMemPurgeResult(const autovector<MemTable*>& mems,
+                             MemTable* new_mem,
+                             autovector<MemTable*>* to_delete);
+
   // Returns an estimate of the number of bytes of data in use.
   size_t ApproximateMemoryUsage();
 
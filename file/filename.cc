@@ -239,6 +239,10 @@ std::string IdentityFileName(const std::string& dbname) {
   return dbname + "/IDENTITY";
 }
 
+std::string BlockCacheKeysFileName(const std::string& dbname) {
+  return dbname + "/BLOCK_CACHE_KEYS";
+}
+
 // Owned filenames have the form:
 //    dbname/IDENTITY
 //    dbname/CURRENT
@@ -325,6 +325,34 @@ struct AdvancedColumnFamilyOptions {
   // Dynamically changeable through SetOptions() API
   size_t memtable_huge_page_size = 0;
 
+  // If true, the per-core allocation shards of the arena used by the memtable
+  // are bound to the NUMA node of their core, so that concurrent writers on
+  // different nodes insert into node-local memory. It only takes effect if
+  // RocksDB is built with NUMA support, and not with memtable_huge_page_size.
+  //
+  // Dynamically changeable through SetOptions() API
+  bool memtable_numa_aware = false;
+
+  // If greater than 0, a flush triggered by a full memtable first garbage
+  // collects the immutable memtables in memory (MemPurge): their entries go
+  // through the same compaction logic as a flush, dropping overwritten and
+  // deleted versions that no snapshot can see. If the result fits in less
+  // than mempurge_threshold times the memory of the input memtables, it
+  // replaces them as a new immutable memtable instead of being written to
+  // L0, which saves write amplification for workloads that overwrite or
+  // delete a small set of hot keys. The WAL files of the purged memtables are
+  // kept until the data is actually flushed.
+  //
+  // The output of a MemPurge counts as an immutable memtable, so
+  // max_write_buffer_number should leave room for it. Explicit flushes
+  // (Flush(), WAL size limits, the write buffer manager) and atomic_flush
+  // always write SST files.
+  //
+  // Default: 0 (disabled)
+  //
+  // Dynamically changeable through SetOptions() API
+  double mempurge_threshold = 0.0;
+
   // If non-nullptr, memtable will use the specified function to extract
   // prefixes for keys, and for each prefix maintain a hint of insert location
   // to reduce CPU usage for inserting keys with the prefix. Keys out of
@@ -0,0 +1,69 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+
+#include "rocksdb/rocksdb_namespace.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+struct ArenaBlockPoolStats {
+  // Blocks that were taken from the pool.
+  uint64_t hits = 0;
+  // Blocks that were allocated because the pool had none of the requested
+  // size and kind.
+  uint64_t misses = 0;
+  // Freed blocks that were kept by the pool.
+  uint64_t recycled = 0;
+  // Freed blocks that were given back to the system because the pool was
+  // full.
+  uint64_t released = 0;
+  // Number and total size of the blocks currently kept by the pool.
+  uint64_t pooled_blocks = 0;
+  uint64_t pooled_bytes = 0;
+
+  std::string ToString() const;
+};
+
+// ArenaBlockPool allocates the blocks of the arenas that back memtables, and
+// keeps the blocks of freed memtables up to a capacity, so that new memtables
+// reuse memory that is already mapped and faulted in instead of allocating
+// and freeing a write buffer worth of memory per flush. Huge page blocks are
+// kept separately from the others.
+//
+// A pool can be shared by all column families and DB instances of a process
+// through DBOptions::arena_block_pool. All functions are thread-safe.
+class ArenaBlockPool {
+ public:
+  virtual ~ArenaBlockPool() {}
+
+  virtual const char* Name() const = 0;
+
+  // Returns a block of block_size bytes, from the pool if possible. If
+  // huge_page, the block is mapped on huge pages, and nullptr is returned if
+  // none are available.
+  virtual char* Allocate(size_t block_size, bool huge_page) = 0;
+
+  // Takes back a block returned by Allocate(block_size, huge_page).
+  virtual void Free(char* block, size_t block_size, bool huge_page) = 0;
+
+  // The maximum total size of the blocks kept by the pool. Lowering the
+  // capacity frees the blocks in excess.
+  virtual size_t GetCapacity() const = 0;
+  virtual void SetCapacity(size_t capacity) = 0;
+
+  virtual ArenaBlockPoolStats GetStats() const = 0;
+};
+
+// Creates a pool that keeps at most capacity bytes of free blocks.
+extern std::shared_ptr<ArenaBlockPool> NewArenaBlockPool(size_t capacity);
+
+}  // namespace ROCKSDB_NAMESPACE
@@ -23,8 +23,10 @@
 #pragma once
 
 #include <stdint.h>
+#include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 #include "rocksdb/enum_reflection.h"
 #include "rocksdb/memory_allocator.h"
 #include "rocksdb/slice.h"
@@ -35,6 +37,7 @@ namespace ROCKSDB_NAMESPACE {
 
 class Cache;
 struct ConfigOptions;
+class SecondaryCache;
 
 extern const bool kDefaultToAdaptiveMutex;
 
@@ -45,6 +48,47 @@ ROCKSDB_ENUM_PLAIN(CacheMetadataChargePolicy, int,
 const CacheMetadataChargePolicy kDefaultCacheMetadataChargePolicy =
     kFullChargeCacheMetadata;
 
+// A named part of the capacity of an LRUCache, so that the entries of one
+// user of the cache, e.g. the column families of one tenant, cannot evict all
+// the entries of the others. Entries are inserted into a partition through
+// the Cache returned by NewCachePartition(), all the other entries belong to
+// the default partition, named kDefaultCachePartitionName.
+//
+// When an insert needs to evict, the least recently used entry of the
+// partition that is the most over its max_capacity is evicted first, then
+// the one of the partition that is the most over its reserved_capacity, and
+// only then entries of partitions under their reserved_capacity.
+struct CachePartitionOptions {
+  std::string name;
+
+  // Capacity that entries of the other partitions cannot evict this
+  // partition below, unless all the partitions are under their reserve.
+  size_t reserved_capacity = 0;
+
+  // Soft limit on the usage of the partition: above it, its entries are the
+  // first to be evicted, but inserts still succeed if the cache has room.
+  // 0 means the capacity of the cache.
+  size_t max_capacity = 0;
+
+  CachePartitionOptions() {}
+  CachePartitionOptions(const std::string& _name, size_t _reserved_capacity,
+                        size_t _max_capacity)
+      : name(_name),
+        reserved_capacity(_reserved_capacity),
+        max_capacity(_max_capacity) {}
+};
+
+extern const std::string kDefaultCachePartitionName;
+
+// Usage of a cache partition, see Cache::GetPartitionUsage().
+struct CachePartitionUsage {
+  std::string name;
+  size_t reserved_capacity = 0;
+  size_t max_capacity = 0;
+  size_t usage = 0;
+  size_t pinned_usage = 0;
+};
+
 struct LRUCacheOptions {
   // Capacity of the cache.
   size_t capacity = 0;
@@ -88,6 +132,43 @@ struct LRUCacheOptions {
   CacheMetadataChargePolicy metadata_charge_policy =
       kDefaultCacheMetadataChargePolicy;
 
+  // A SecondaryCache instance to use as the non-volatile tier. Entries
+  // evicted from the cache are handed to it if they were inserted with a
+  // Cache::CacheItemHelper, and are promoted back on a Lookup() that misses
+  // in the cache but hits in the secondary cache.
+  // See include/rocksdb/secondary_cache.h.
+  std::shared_ptr<SecondaryCache> secondary_cache;
+
+  // If true, each shard keeps a frequency sketch (a count-min sketch with
+  // aging) of the recently looked up keys, and an insert that needs to evict
+  // is admitted only if the new key is estimated to be looked up more often
+  // than the least recently used entry. This keeps the hot working set in
+  // the cache when a scan or a compaction fills it with blocks that are read
+  // only once. High priority entries are always admitted.
+  //
+  // A rejected insert behaves as if the entry was inserted and evicted
+  // right away: without a handle it returns OK, and with a handle the entry
+  // is usable until released but cannot be found by Lookup(). If
+  // strict_capacity_limit is set, a rejected insert with a handle fails.
+  bool tiny_lfu_admission = false;
+
+  // Partitions of the capacity, in addition to the default partition. See
+  // CachePartitionOptions. The reserved and max capacities are split evenly
+  // among the shards, like the capacity. At most 255 partitions, with
+  // distinct non-empty names other than kDefaultCachePartitionName.
+  std::vector<CachePartitionOptions> partitions;
+
+  // If true and the system has several NUMA nodes (and RocksDB is built with
+  // NUMA support), the shards are split among the nodes and each shard is
+  // allocated on its node, through the allocator of NewNumaMemoryAllocator().
+  // Entries are inserted into the shards of the node of the inserting
+  // thread, and a lookup searches the shards of the node of the caller
+  // first, then the other nodes. A lookup that misses thus costs one probe
+  // per node, and an entry inserted concurrently on two nodes may be cached
+  // twice. See Cache::GetNumaHitCounts(). num_shard_bits is raised to cover
+  // the nodes if needed.
+  bool numa_aware = false;
+
   LRUCacheOptions() {}
   LRUCacheOptions(size_t _capacity, int _num_shard_bits,
                   bool _strict_capacity_limit, double _high_pri_pool_ratio,
@@ -122,16 +203,35 @@ extern std::shared_ptr<Cache> NewLRUCache(
 
 extern std::shared_ptr<Cache> NewLRUCache(const LRUCacheOptions& cache_opts);
 
+// Return a Cache sharing the entries and the capacity of cache, whose
+// inserts go to the partition of cache named name (see
+// LRUCacheOptions::partitions). Its GetUsage() and GetPinnedUsage() are those
+// of the partition. Entries promoted from a secondary cache go to the
+// default partition. Returns nullptr if cache has no such partition.
+extern std::shared_ptr<Cache> NewCachePartition(std::shared_ptr<Cache> cache,
+                                                const std::string& name);
+
+// Default for the estimated_entry_charge parameter of NewClockCache, which is
+// about the size of a data block with the default block_size.
+const size_t kDefaultClockCacheEstimatedEntryCharge = 4 << 10;
+
 // Similar to NewLRUCache, but create a cache based on CLOCK algorithm with
-// better concurrent performance in some cases. See util/clock_cache.cc for
-// more detail.
+// better concurrent performance in some cases. Lookup and Release never take
+// a lock. See cache/clock_cache.cc for more detail.
+//
+// Each shard is a fixed size hash table, sized when the cache is created so
+// that capacity / estimated_entry_charge entries fit. If the actual average
+// charge is much smaller, the cache will hold fewer entries than its
+// capacity allows; if it is much larger, some table memory is wasted.
+// estimated_entry_charge = 0 means kDefaultClockCacheEstimatedEntryCharge.
 //
 // Return nullptr if it is not supported.
 extern std::shared_ptr<Cache> NewClockCache(
     size_t capacity, int num_shard_bits = -1,
     bool strict_capacity_limit = false,
     CacheMetadataChargePolicy metadata_charge_policy =
-        kDefaultCacheMetadataChargePolicy);
+        kDefaultCacheMetadataChargePolicy,
+    size_t estimated_entry_charge = 0);
 class Cache {
  public:
   // Depending on implementation, cache entries with high priority could be less
@@ -168,6 +268,34 @@ class Cache {
   // Opaque handle to an entry stored in the cache.
   struct Handle {};
 
+  // Callbacks that allow an object in the cache to be saved to, and later
+  // recreated from, a SecondaryCache. The object is serialized as a flat
+  // buffer of size_cb(obj) bytes, which saveto_cb copies out (possibly in
+  // several pieces). del_cb is the same as the deleter passed to Insert().
+  typedef size_t (*SizeCallback)(void* obj);
+  typedef Status (*SaveToCallback)(void* from_obj, size_t from_offset,
+                                   size_t length, void* out);
+  typedef void (*DeleterFn)(const Slice& key, void* value);
+
+  struct CacheItemHelper {
+    SizeCallback size_cb;
+    SaveToCallback saveto_cb;
+    DeleterFn del_cb;
+
+    CacheItemHelper() : size_cb(nullptr), saveto_cb(nullptr), del_cb(nullptr) {}
+    CacheItemHelper(SizeCallback _size_cb, SaveToCallback _saveto_cb,
+                    DeleterFn _del_cb)
+        : size_cb(_size_cb), saveto_cb(_saveto_cb), del_cb(_del_cb) {}
+  };
+
+  // Recreates an object from a buffer previously written by
+  // CacheItemHelper::saveto_cb. On success, *out_obj must own a new object
+  // and *charge must be set to the charge to insert it with. The buffer is
+  // only valid during the call.
+  typedef std::function<Status(const void* buf, size_t size, void** out_obj,
+                               size_t* charge)>
+      CreateCallback;
+
   // The type of the Cache
   virtual const char* Name() const = 0;
 
@@ -191,6 +319,18 @@ class Cache {
                         Handle** handle = nullptr,
                         Priority priority = Priority::LOW) = 0;
 
+  // Same as above, but the entry may be saved to a secondary cache when it
+  // is evicted, using the callbacks in helper. helper->del_cb is used as the
+  // deleter. helper must outlive the entry, typically it is a static object.
+  // The default implementation ignores everything but the deleter.
+  virtual Status Insert(const Slice& key, void* value,
+                        const CacheItemHelper* helper, size_t charge,
+                        Handle** handle = nullptr,
+                        Priority priority = Priority::LOW) {
+    assert(helper != nullptr);
+    return Insert(key, value, charge, helper->del_cb, handle, priority);
+  }
+
   // If the cache has no mapping for "key", returns nullptr.
   //
   // Else return a handle that corresponds to the mapping.  The caller
@@ -200,6 +340,17 @@ class Cache {
   // function.
   virtual Handle* Lookup(const Slice& key, Statistics* stats = nullptr) = 0;
 
+  // Same as above, but if the key is not in the cache and the cache has a
+  // secondary cache, look it up there. On a secondary cache hit, the object
+  // is recreated by create_cb and inserted into the cache with helper and
+  // priority, then a handle to it is returned.
+  // The default implementation ignores the secondary cache.
+  virtual Handle* Lookup(const Slice& key, const CacheItemHelper* /*helper*/,
+                         const CreateCallback& /*create_cb*/,
+                         Priority /*priority*/, Statistics* stats = nullptr) {
+    return Lookup(key, stats);
+  }
+
   // Increments the reference count for the handle if it refers to an entry in
   // the cache. Returns true if refcount was incremented; otherwise, returns
   // false.
@@ -280,12 +431,39 @@ class Cache {
   virtual void ApplyToAllCacheEntries(void (*callback)(void*, size_t),
                                       bool thread_safe) = 0;
 
+  // Apply callback to the key, value and charge of all entries in the cache.
+  // The callback may run with a shard lock held, so it must be cheap and must
+  // not call back into the cache. The default implementation visits nothing.
+  virtual void ApplyToAllEntries(
+      const std::function<void(const Slice& key, void* value, size_t charge)>&
+      /*callback*/) {}
+
   // Remove all entries.
   // Prerequisite: no entry is referenced.
   virtual void EraseUnRefEntries() = 0;
 
   virtual std::string GetPrintableOptions() const { return ""; }
 
+  // Index of the partition named name, see LRUCacheOptions::partitions, or
+  // -1 if this cache has no such partition.
+  virtual int GetPartitionIndex(const std::string& /*name*/) const {
+    return -1;
+  }
+
+  // Append the usage of each partition, the default partition first, to
+  // *usage. Appends nothing if this cache has no partitions.
+  virtual void GetPartitionUsage(
+      std::vector<CachePartitionUsage>* /*usage*/) const {}
+
+  // For a cache with LRUCacheOptions::numa_aware, set *local_hits and
+  // *remote_hits to the number of lookups that found the entry in the shards
+  // of the NUMA node of the caller, or of another node, and return true.
+  // Return false if this cache is not NUMA aware.
+  virtual bool GetNumaHitCounts(uint64_t* /*local_hits*/,
+                                uint64_t* /*remote_hits*/) const {
+    return false;
+  }
+
   MemoryAllocator* memory_allocator() const { return memory_allocator_.get(); }
 
  private:
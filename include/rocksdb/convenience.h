@@ -198,8 +198,9 @@ struct ConfigOptions {
 //     * {"memtable", "hash_linkedlist:1000"} is equivalent to
 //       setting memtable to NewHashLinkListRepFactory(1000).
 //   - VectorRepFactory:
-//     Pass "vector:<count>" to config memtable to use VectorRepFactory,
-//     or simply "vector" to use the default Vector memtable.
+//     Pass "vector:<count>" or "vector:<count>:<sort_threads>" to config
+//     memtable to use VectorRepFactory, or simply "vector" to use the default
+//     Vector memtable.
 //     [Example]:
 //     * {"memtable", "vector:1024"} is equivalent to setting memtable
 //       to VectorRepFactory(1024).
@@ -924,6 +924,20 @@ class DB {
     //      entries being pinned.
     static const std::string kBlockCachePinnedUsage;
 
+    // "rocksdb.block-cache-partitions" - returns the usage of each partition
+    //      of the block cache (see LRUCacheOptions::partitions), as a map
+    //      from "<partition>.usage", "<partition>.pinned-usage",
+    //      "<partition>.reserved-capacity" and "<partition>.max-capacity" to
+    //      their values. Empty if the block cache has no partitions.
+    static const std::string kBlockCachePartitions;
+
+    // "rocksdb.block-cache-miss-ratio-curve" - returns the hit ratio that the
+    //      block cache is estimated to have at other capacities, when it is a
+    //      MissRatioCurveCache, as a map from "<ratio>x.capacity",
+    //      "<ratio>x.lookups", "<ratio>x.hits" and "<ratio>x.hit-ratio" to
+    //      their values, for each MissRatioCurveOptions::capacity_ratios.
+    static const std::string kBlockCacheMissRatioCurve;
+
     // "rocksdb.options-statistics" - returns multi-line string
     //      of options.statistics
     static const std::string kOptionsStatistics;
@@ -1647,6 +1661,19 @@ class DB {
     return Status::NotSupported("Supported only by secondary instance");
   }
 #endif  // !ROCKSDB_LITE
+
+  // Records which blocks of the live table files are in the block cache into
+  // the BLOCK_CACHE_KEYS file in the DB directory, to be read back by the
+  // next DB::Open() with DBOptions::persist_block_cache_keys. DB::Close()
+  // calls this when persist_block_cache_keys is set.
+  virtual Status DumpBlockCacheKeys() {
+    return Status::NotSupported("DumpBlockCacheKeys() not supported");
+  }
+
+  // Waits until the block cache warm-up started by DB::Open() (see
+  // DBOptions::persist_block_cache_keys) has finished. Returns immediately
+  // if there is none.
+  virtual Status WaitForBlockCacheWarmup() { return Status::OK(); }
 };
 
 // Destroy the contents of the specified database.
@@ -50,6 +50,11 @@ class FilterBitsBuilder {
   // The ownership of actual data is set to buf
   virtual Slice Finish(std::unique_ptr<const char[]>* buf) = 0;
 
+  // Approximate memory used by the keys added so far, which may be charged
+  // to the block cache (see BlockBasedTableOptions::
+  // reserve_table_builder_memory). 0 if unknown.
+  virtual size_t ApproximateMemoryUsage() const { return 0; }
+
   // Calculate num of keys that can be added and generate a filter
   // <= the specified number of bytes.
 #if defined(_MSC_VER)
@@ -74,4 +74,13 @@ extern Status NewJemallocNodumpAllocator(
     JemallocAllocatorOptions& options,
     std::shared_ptr<MemoryAllocator>* memory_allocator);
 
+// Generate a memory allocator which allocates memory on NUMA node numa_node.
+// Every allocation is a separate mapping, so it is meant for a few large and
+// long lived allocations, like the shards of a cache with
+// LRUCacheOptions::numa_aware, rather than for cache blocks. Returns
+// NotSupported if RocksDB is not built with NUMA support (libnuma) or the
+// system does not support NUMA.
+extern Status NewNumaMemoryAllocator(
+    int numa_node, std::shared_ptr<MemoryAllocator>* memory_allocator);
+
 }  // namespace ROCKSDB_NAMESPACE
@@ -414,15 +414,24 @@ class SkipListFactory : public MemTableRepFactory {
 // the vector is sorted. This is useful for workloads where iteration is very
 // rare and writes are generally not issued after reads begin.
 //
+// Concurrent inserts append to per-core vectors, which are concatenated when
+// the memtable becomes immutable. A large immutable vector is sorted by
+// several threads, so that flushing a bulk load is not bound by one core.
+//
 // Parameters:
 //   count: Passed to the constructor of the underlying std::vector of each
 //     VectorRep. On initialization, the underlying array will be at least count
 //     bytes reserved for usage.
+//   sort_threads: The maximum number of threads that sort a VectorRep,
+//     including the thread that iterates it first. 0 means the number of
+//     hardware threads.
 class VectorRepFactory : public MemTableRepFactory {
   const size_t count_;
+  const size_t sort_threads_;
 
  public:
-  explicit VectorRepFactory(size_t count = 0) : count_(count) {}
+  explicit VectorRepFactory(size_t count = 0, size_t sort_threads = 0)
+      : count_(count), sort_threads_(sort_threads) {}
 
   using MemTableRepFactory::CreateMemTableRep;
   virtual MemTableRep* CreateMemTableRep(const MemTableRep::KeyComparator&,
@@ -430,6 +439,8 @@ class VectorRepFactory : public MemTableRepFactory {
                                          Logger* logger) override;
 
   virtual const char* Name() const override { return "VectorRepFactory"; }
+
+  bool IsInsertConcurrentlySupported() const override { return true; }
 };
 
 // This class contains a fixed array of buckets, each
@@ -464,5 +475,11 @@ extern MemTableRepFactory* NewHashLinkListRepFactory(
     bool if_log_bucket_dist_when_flash = true,
     uint32_t threshold_use_skiplist = 256);
 
+// This creates MemTableReps that are backed by an adaptive radix tree, which
+// supports concurrent inserts. The tree orders the keys by their bytes, so it
+// only works with BytewiseComparator(); with any other comparator the
+// memtables use a skip list instead.
+extern MemTableRepFactory* NewAdaptiveRadixTreeRepFactory();
+
 #endif  // ROCKSDB_LITE
 }  // namespace ROCKSDB_NAMESPACE
@@ -34,6 +34,7 @@
 
 namespace ROCKSDB_NAMESPACE {
 
+class ArenaBlockPool;
 class Cache;
 class CompactionFilter;
 class CompactionFilterFactory;
@@ -757,6 +758,15 @@ struct DBOptions {
   // Default: null
   std::shared_ptr<WriteBufferManager> write_buffer_manager = nullptr;
 
+  // The memtables of all column families use this pool to allocate the blocks
+  // of their arenas, and give the blocks back to it when they are freed. The
+  // same pool can be passed into multiple DBs, so that new memtables reuse
+  // the memory of flushed ones instead of mapping and faulting in fresh
+  // memory for every write buffer. See NewArenaBlockPool().
+  //
+  // Default: null, every memtable allocates and frees its own blocks
+  std::shared_ptr<ArenaBlockPool> arena_block_pool = nullptr;
+
   // Specify the file access pattern once a compaction is started.
   // It will be applied to all input files of a compaction.
   // Default: NORMAL
@@ -1097,6 +1107,17 @@ struct DBOptions {
   // file.
   bool manual_wal_flush = false;
 
+  // Compresses the records of the WAL files created from now on with this
+  // compression type. The records are compressed one by one, so this mainly
+  // pays off for large write batches and compressible values. The WAL files
+  // start with a record of a new type, which makes older versions fail to
+  // recover them instead of misreading them. Only kNoCompression, kZSTD,
+  // kLZ4Compression and kZlibCompression are supported, when the library is
+  // built with them.
+  //
+  // Default: kNoCompression
+  CompressionType wal_compression = kNoCompression;
+
   // If true, RocksDB supports flushing multiple column families and committing
   // their results atomically to MANIFEST. Note that it is not
   // necessary to set atomic_flush to true if WAL is always enabled since WAL
@@ -1181,6 +1202,22 @@ struct DBOptions {
   //
   // Default: false
   bool allow_data_in_errors = false;
+
+  // If true, DB::Close() records which blocks of the live table files are in
+  // the block cache into a BLOCK_CACHE_KEYS file in the DB directory (see
+  // DB::DumpBlockCacheKeys()), and the next DB::Open() reads those blocks
+  // back into the block cache in background threads, so that reads do not
+  // have to refill a cold cache after a restart. DB::Open() deletes the file
+  // whether or not this option is set. Only block based tables support this.
+  //
+  // Default: false
+  bool persist_block_cache_keys = false;
+
+  // Number of background threads DB::Open() uses to read back the blocks
+  // recorded by persist_block_cache_keys.
+  //
+  // Default: 2
+  int block_cache_warmup_threads = 2;
 };
 
 // Options to control the behavior of a database (passed to DB::Open)
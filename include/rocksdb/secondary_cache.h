@@ -0,0 +1,94 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+
+#include "rocksdb/cache.h"
+#include "rocksdb/compression_type.h"
+#include "rocksdb/slice.h"
+#include "rocksdb/status.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+// SecondaryCache
+//
+// A second tier behind a Cache (currently only LRUCache). Entries evicted
+// from the cache are saved to the secondary cache in a serialized form by
+// the Cache::CacheItemHelper they were inserted with, and a Lookup() that
+// misses in the cache recreates them from it by a Cache::CreateCallback.
+// See LRUCacheOptions::secondary_cache.
+//
+// Implementations must be thread safe.
+class SecondaryCache {
+ public:
+  virtual ~SecondaryCache() {}
+
+  virtual const char* Name() const = 0;
+
+  // Save the object value, which is about to be evicted from the cache,
+  // under key. The object is still owned by the caller, only its serialized
+  // form obtained with helper->size_cb and helper->saveto_cb is kept.
+  virtual Status Insert(const Slice& key, void* value,
+                        const Cache::CacheItemHelper* helper) = 0;
+
+  // Lookup key and recreate the object from its serialized form with
+  // create_cb. On success, *value owns the new object and *charge is the
+  // charge returned by create_cb. Returns NotFound if key is not present.
+  // Since the object is going to be promoted to the cache, an
+  // implementation may drop its own copy on a successful lookup.
+  virtual Status Lookup(const Slice& key,
+                        const Cache::CreateCallback& create_cb, void** value,
+                        size_t* charge) = 0;
+
+  // Remove key from the secondary cache, if present.
+  virtual void Erase(const Slice& key) = 0;
+
+  virtual std::string GetPrintableOptions() const { return ""; }
+};
+
+struct CompressedSecondaryCacheOptions {
+  // Capacity of the secondary cache, charged by compressed size.
+  size_t capacity = 0;
+
+  // The secondary cache is sharded into 2^num_shard_bits shards, see
+  // LRUCacheOptions::num_shard_bits.
+  int num_shard_bits = -1;
+
+  // Compression used for the saved entries. If it is not supported by this
+  // build, or if an entry does not compress well, the entry is kept
+  // uncompressed.
+  CompressionType compression_type = kLZ4Compression;
+
+  // Allocator for the uncompressed buffers handed to the create callback.
+  std::shared_ptr<MemoryAllocator> memory_allocator;
+
+  CacheMetadataChargePolicy metadata_charge_policy =
+      kDefaultCacheMetadataChargePolicy;
+
+  CompressedSecondaryCacheOptions() {}
+  CompressedSecondaryCacheOptions(
+      size_t _capacity, int _num_shard_bits,
+      CompressionType _compression_type = kLZ4Compression,
+      std::shared_ptr<MemoryAllocator> _memory_allocator = nullptr,
+      CacheMetadataChargePolicy _metadata_charge_policy =
+          kDefaultCacheMetadataChargePolicy)
+      : capacity(_capacity),
+        num_shard_bits(_num_shard_bits),
+        compression_type(_compression_type),
+        memory_allocator(std::move(_memory_allocator)),
+        metadata_charge_policy(_metadata_charge_policy) {}
+};
+
+// Create an in-memory SecondaryCache that keeps entries compressed, so that
+// the same amount of memory holds a larger working set than the primary
+// cache, at the cost of uncompressing on a hit.
+extern std::shared_ptr<SecondaryCache> NewCompressedSecondaryCache(
+    const CompressedSecondaryCacheOptions& opts);
+
+}  // namespace ROCKSDB_NAMESPACE
@@ -374,6 +374,11 @@ enum Tickers : uint32_t {
   // # of files deleted immediately by sst file manger through delete scheduler.
   FILES_DELETED_IMMEDIATELY,
 
+  // # of lookups that missed the block cache and hit / missed its secondary
+  // cache.
+  SECONDARY_CACHE_HITS,
+  SECONDARY_CACHE_MISSES,
+
   TICKER_ENUM_MAX
 };
 
@@ -436,6 +436,54 @@ struct BlockBasedTableOptions {
 
   IndexShorteningMode index_shortening =
       IndexShorteningMode::kShortenSeparators;
+
+  // Insert the blocks of a new table file into `block_cache` while the file
+  // is being written, so that reads of recently written data do not miss
+  // the cache right after a flush or compaction installs the file. Data
+  // blocks are always inserted; index and filter blocks only when
+  // `cache_index_and_filter_blocks` is true. Blocks are inserted with low
+  // priority. This requires the file system to provide unique ids for
+  // files (see FSWritableFile::GetUniqueId), otherwise the blocks are
+  // inserted under keys the table reader will never look up.
+  ROCKSDB_ENUM_CLASS_INCLASS(PrepopulateBlockCache, char,
+    // Do not insert blocks while writing table files.
+    kDisable,
+    // Insert the blocks of the files written by flush.
+    kFlushOnly,
+    // Insert the blocks of the files written by flush, and of the files
+    // written by compaction to an output level of at most
+    // `prepopulate_block_cache_max_level`.
+    kUpToLevel
+  );
+
+  PrepopulateBlockCache prepopulate_block_cache =
+      PrepopulateBlockCache::kDisable;
+
+  // Highest compaction output level whose files are inserted into the block
+  // cache with `PrepopulateBlockCache::kUpToLevel`.
+  int prepopulate_block_cache_max_level = 0;
+
+  // Charge the memory used by a table builder for the filter under
+  // construction, and for the data blocks buffered to train a compression
+  // dictionary, to `block_cache`, by inserting dummy entries into it as
+  // WriteBufferManager does for memtables. With `strict_capacity_limit` the
+  // charge may fall short of the memory used, but the builder never fails
+  // because of it.
+  bool reserve_table_builder_memory = false;
+
+  // Charge the memory used by the table readers, including the index and
+  // filter blocks they hold outside of `block_cache`, and the memory of the
+  // process wide ZSTD decompression contexts, to `block_cache`. With
+  // `strict_capacity_limit`, opening a table file whose reader does not fit
+  // fails with Status::MemoryLimit.
+  bool reserve_table_reader_memory = false;
+
+  // If not empty, the name of the partition of `block_cache` that the blocks
+  // of the tables of this column family, and the memory they reserve, are
+  // charged to (see LRUCacheOptions::partitions). Column families of one
+  // tenant can then share a partition with a reserved and a max capacity.
+  // `block_cache` must have a partition with this name.
+  std::string block_cache_partition;
 };
 
 // Table Properties that are specific to block-based table properties.
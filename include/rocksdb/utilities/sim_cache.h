@@ -8,6 +8,7 @@
 #include <stdint.h>
 #include <memory>
 #include <string>
+#include <vector>
 #include "rocksdb/cache.h"
 #include "rocksdb/env.h"
 #include "rocksdb/slice.h"
@@ -91,4 +92,68 @@ class SimCache : public Cache {
   SimCache& operator=(const SimCache&);
 };
 
+struct MissRatioCurveOptions {
+  // Fraction of the keys whose accesses are simulated, chosen by hash. The
+  // simulated caches are scaled down by the same factor, so the memory and
+  // CPU overhead is about sampling_rate times that of a SimCache for each
+  // capacity ratio, but the estimate gets noisier for small caches.
+  double sampling_rate = 0.01;
+
+  // The simulated capacities, as multiples of the capacity of the cache.
+  std::vector<double> capacity_ratios = {0.25, 0.5, 1.0, 2.0, 4.0};
+};
+
+// The estimated hit ratio of a cache at one capacity.
+struct MissRatioCurvePoint {
+  double capacity_ratio = 0;
+  size_t capacity = 0;
+  // Sampled lookups, and the hits among them.
+  uint64_t lookups = 0;
+  uint64_t hits = 0;
+
+  double hit_ratio() const {
+    return lookups == 0 ? 0 : static_cast<double>(hits) / lookups;
+  }
+};
+
+class MissRatioCurveCache;
+
+// NewMissRatioCurveCache wraps cache to estimate, from its lookups and
+// inserts, what its hit ratio would be at other capacities, e.g. to size a
+// block cache without replaying a trace through block_cache_trace_analyzer.
+// Like SimCache it only keeps keys, but it samples them, so it can stay on
+// in production: the estimate is exposed by GetMissRatioCurve(), and by the
+// DB property "rocksdb.block-cache-miss-ratio-curve" when it wraps the block
+// cache.
+//
+// The entries and the capacity are those of cache, except that
+// SetCapacity() also rescales the simulated capacities.
+extern std::shared_ptr<MissRatioCurveCache> NewMissRatioCurveCache(
+    std::shared_ptr<Cache> cache,
+    const MissRatioCurveOptions& options = MissRatioCurveOptions());
+
+class MissRatioCurveCache : public Cache {
+ public:
+  MissRatioCurveCache() {}
+
+  ~MissRatioCurveCache() override {}
+
+  const char* Name() const override { return "MissRatioCurveCache"; }
+
+  // One point per MissRatioCurveOptions::capacity_ratios, in the same order.
+  virtual void GetMissRatioCurve(
+      std::vector<MissRatioCurvePoint>* curve) const = 0;
+
+  // Reset the lookup and hit counters of the simulated caches, e.g. after a
+  // warm up, but keep their contents.
+  virtual void reset_counter() = 0;
+
+  // The wrapped cache.
+  virtual const std::shared_ptr<Cache>& cache() const = 0;
+
+ private:
+  MissRatioCurveCache(const MissRatioCurveCache&);
+  MissRatioCurveCache& operator=(const MissRatioCurveCache&);
+};
+
 }  // namespace ROCKSDB_NAMESPACE
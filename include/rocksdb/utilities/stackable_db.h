@@ -482,6 +482,12 @@ class StackableDB : public DB {
   }
 #endif  // ROCKSDB_LITE
 
+  Status DumpBlockCacheKeys() override { return db_->DumpBlockCacheKeys(); }
+
+  Status WaitForBlockCacheWarmup() override {
+    return db_->WaitForBlockCacheWarmup();
+  }
+
  protected:
   DB* db_;
   std::shared_ptr<DB> shared_db_ptr_;
@@ -742,6 +742,16 @@ public enum TickerType {
     COMPACT_WRITE_BYTES_PERIODIC((byte) -0x14),
     COMPACT_WRITE_BYTES_TTL((byte) -0x15),
 
+    /**
+     * # of lookups that missed the block cache and hit its secondary cache.
+     */
+    SECONDARY_CACHE_HITS((byte) -0x16),
+
+    /**
+     * # of lookups that missed both the block cache and its secondary cache.
+     */
+    SECONDARY_CACHE_MISSES((byte) -0x17),
+
     TICKER_ENUM_MAX((byte) 0x5F);
 
     private final byte value;
@@ -12,9 +12,12 @@
 #include <sys/mman.h>
 #endif
 #include <algorithm>
+#include <cinttypes>
+#include <map>
 #include "logging/logging.h"
 #include "port/malloc.h"
 #include "port/port.h"
+#include "rocksdb/arena_block_pool.h"
 #include "rocksdb/env.h"
 #include "test_util/sync_point.h"
 
@@ -42,8 +45,11 @@ size_t OptimizeBlockSize(size_t block_size) {
   return block_size;
 }
 
-Arena::Arena(size_t block_size, AllocTracker* tracker, size_t huge_page_size)
-    : kBlockSize(OptimizeBlockSize(block_size)), tracker_(tracker) {
+Arena::Arena(size_t block_size, AllocTracker* tracker, size_t huge_page_size,
+             ArenaBlockPool* block_pool)
+    : kBlockSize(OptimizeBlockSize(block_size)),
+      tracker_(tracker),
+      block_pool_(block_pool) {
   assert(kBlockSize >= kMinBlockSize && kBlockSize <= kMaxBlockSize &&
          kBlockSize % kAlignUnit == 0);
   TEST_SYNC_POINT_CALLBACK("Arena::Arena:0", const_cast<size_t*>(&kBlockSize));
@@ -72,6 +78,11 @@ Arena::~Arena() {
   for (const auto& block : blocks_) {
     delete[] block;
   }
+  for (const auto& block : pooled_blocks_) {
+    if (block.addr_ != nullptr) {
+      block_pool_->Free(block.addr_, block.length_, block.huge_page_);
+    }
+  }
 
 #ifdef MAP_HUGETLB
   for (const auto& mmap_info : huge_blocks_) {
@@ -100,12 +111,14 @@ char* Arena::AllocateFallback(size_t bytes, bool aligned) {
 #ifdef MAP_HUGETLB
   if (hugetlb_size_) {
     size = hugetlb_size_;
-    block_head = AllocateFromHugePage(size);
+    block_head = block_pool_ != nullptr ? AllocateFromPool(size, true)
+                                        : AllocateFromHugePage(size);
   }
 #endif
   if (!block_head) {
     size = kBlockSize;
-    block_head = AllocateNewBlock(size);
+    block_head = block_pool_ != nullptr ? AllocateFromPool(size, false)
+                                        : AllocateNewBlock(size);
   }
   alloc_bytes_remaining_ = size - bytes;
 
@@ -230,4 +243,154 @@ char* Arena::AllocateNewBlock(size_t block_bytes) {
   return block;
 }
 
+char* Arena::AllocateFromPool(size_t block_bytes, bool huge_page) {
+  assert(block_pool_ != nullptr);
+  // Reserve space in `pooled_blocks_` first, like AllocateNewBlock().
+  pooled_blocks_.emplace_back(nullptr /* addr */, 0 /* length */, huge_page);
+  char* block = block_pool_->Allocate(block_bytes, huge_page);
+  if (block == nullptr) {
+    // Huge pages are not available.
+    pooled_blocks_.pop_back();
+    return nullptr;
+  }
+  pooled_blocks_.back() = PooledBlock(block, block_bytes, huge_page);
+  blocks_memory_ += block_bytes;
+  if (tracker_ != nullptr) {
+    tracker_->Allocate(block_bytes);
+  }
+  return block;
+}
+
+namespace {
+
+class ArenaBlockPoolImpl : public ArenaBlockPool {
+ public:
+  explicit ArenaBlockPoolImpl(size_t capacity) : capacity_(capacity) {}
+
+  ~ArenaBlockPoolImpl() override {
+    for (const auto& free_list : free_blocks_) {
+      for (char* block : free_list.second) {
+        DeleteBlock(block, free_list.first.first, free_list.first.second);
+      }
+    }
+  }
+
+  const char* Name() const override { return "ArenaBlockPool"; }
+
+  char* Allocate(size_t block_size, bool huge_page) override {
+    {
+      MutexLock l(&mutex_);
+      auto iter = free_blocks_.find(BlockKind(block_size, huge_page));
+      if (iter != free_blocks_.end() && !iter->second.empty()) {
+        // The most recently freed block is the most likely to be cached.
+        char* block = iter->second.back();
+        iter->second.pop_back();
+        stats_.hits++;
+        stats_.pooled_blocks--;
+        stats_.pooled_bytes -= block_size;
+        return block;
+      }
+      stats_.misses++;
+    }
+    return NewBlock(block_size, huge_page);
+  }
+
+  void Free(char* block, size_t block_size, bool huge_page) override {
+    {
+      MutexLock l(&mutex_);
+      if (stats_.pooled_bytes + block_size <= capacity_) {
+        free_blocks_[BlockKind(block_size, huge_page)].push_back(block);
+        stats_.recycled++;
+        stats_.pooled_blocks++;
+        stats_.pooled_bytes += block_size;
+        return;
+      }
+      stats_.released++;
+    }
+    DeleteBlock(block, block_size, huge_page);
+  }
+
+  size_t GetCapacity() const override {
+    MutexLock l(&mutex_);
+    return capacity_;
+  }
+
+  void SetCapacity(size_t capacity) override {
+    std::vector<std::pair<char*, BlockKind>> excess;
+    {
+      MutexLock l(&mutex_);
+      capacity_ = capacity;
+      for (auto& free_list : free_blocks_) {
+        while (stats_.pooled_bytes > capacity_ && !free_list.second.empty()) {
+          excess.emplace_back(free_list.second.back(), free_list.first);
+          free_list.second.pop_back();
+          stats_.released++;
+          stats_.pooled_blocks--;
+          stats_.pooled_bytes -= free_list.first.first;
+        }
+      }
+    }
+    for (const auto& block : excess) {
+      DeleteBlock(block.first, block.second.first, block.second.second);
+    }
+  }
+
+  ArenaBlockPoolStats GetStats() const override {
+    MutexLock l(&mutex_);
+    return stats_;
+  }
+
+ private:
+  // The size of a block, and whether it is on huge pages.
+  typedef std::pair<size_t, bool> BlockKind;
+
+  static char* NewBlock(size_t block_size, bool huge_page) {
+    if (!huge_page) {
+      return new char[block_size];
+    }
+#ifdef MAP_HUGETLB
+    void* addr = mmap(nullptr, block_size, (PROT_READ | PROT_WRITE),
+                      (MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB), -1, 0);
+    if (addr != MAP_FAILED) {
+      return reinterpret_cast<char*>(addr);
+    }
+#endif
+    return nullptr;
+  }
+
+  static void DeleteBlock(char* block, size_t block_size, bool huge_page) {
+    if (!huge_page) {
+      delete[] block;
+      return;
+    }
+#ifdef MAP_HUGETLB
+    munmap(block, block_size);
+#else
+    (void)block_size;
+    assert(false);
+#endif
+  }
+
+  mutable port::Mutex mutex_;
+  size_t capacity_;
+  std::map<BlockKind, std::vector<char*>> free_blocks_;
+  ArenaBlockPoolStats stats_;
+};
+
+}  // namespace
+
+std::string ArenaBlockPoolStats::ToString() const {
+  char buf[256];
+  snprintf(buf, sizeof(buf),
+           "hits: %" PRIu64 ", misses: %" PRIu64 ", recycled: %" PRIu64
+           ", released: %" PRIu64 ", pooled blocks: %" PRIu64
+           ", pooled bytes: %" PRIu64,
+           hits, misses, recycled, released, pooled_blocks, pooled_bytes);
+  return buf;
+}
+
+std::shared_ptr<ArenaBlockPool> NewArenaBlockPool(size_t capacity) {
+  return std::make_shared<ArenaBlockPoolImpl>(capacity);
+}
+
 }  // namespace ROCKSDB_NAMESPACE
@@ -25,6 +25,8 @@
 
 namespace ROCKSDB_NAMESPACE {
 
+class ArenaBlockPool;
+
 class Arena : public Allocator {
  public:
   // No copying allowed
@@ -38,8 +40,12 @@ class Arena : public Allocator {
   // huge_page_size: if 0, don't use huge page TLB. If > 0 (should set to the
   // supported hugepage size of the system), block allocation will try huge
   // page TLB first. If allocation fails, will fall back to normal case.
+  // block_pool: if not nullptr, the regular blocks are taken from the pool
+  // and given back to it by the destructor. Irregular blocks and the huge
+  // page allocations of AllocateAligned() do not use the pool.
   explicit Arena(size_t block_size = kMinBlockSize,
-                 AllocTracker* tracker = nullptr, size_t huge_page_size = 0);
+                 AllocTracker* tracker = nullptr, size_t huge_page_size = 0,
+                 ArenaBlockPool* block_pool = nullptr);
   ~Arena();
 
   char* Allocate(size_t bytes) override;
@@ -96,6 +102,17 @@ class Arena : public Allocator {
     MmapInfo(void* addr, size_t length) : addr_(addr), length_(length) {}
   };
   std::vector<MmapInfo> huge_blocks_;
+
+  // A block taken from block_pool_.
+  struct PooledBlock {
+    char* addr_;
+    size_t length_;
+    bool huge_page_;
+
+    PooledBlock(char* addr, size_t length, bool huge_page)
+        : addr_(addr), length_(length), huge_page_(huge_page) {}
+  };
+  std::vector<PooledBlock> pooled_blocks_;
   size_t irregular_block_num = 0;
 
   // Stats for current active block.
@@ -114,10 +131,12 @@ class Arena : public Allocator {
   char* AllocateFromHugePage(size_t bytes);
   char* AllocateFallback(size_t bytes, bool aligned);
   char* AllocateNewBlock(size_t block_bytes);
+  char* AllocateFromPool(size_t block_bytes, bool huge_page);
 
   // Bytes of memory in blocks allocated so far
   size_t blocks_memory_ = 0;
   AllocTracker* tracker_;
+  ArenaBlockPool* block_pool_;
 };
 
 inline char* Arena::Allocate(size_t bytes) {
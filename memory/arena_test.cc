@@ -8,6 +8,10 @@
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 
 #include "memory/arena.h"
+
+#include <set>
+
+#include "rocksdb/arena_block_pool.h"
 #include "test_util/testharness.h"
 #include "util/random.h"
 
@@ -196,6 +200,73 @@ TEST_F(ArenaTest, Simple) {
   SimpleTest(0);
   SimpleTest(kHugePageSize);
 }
+
+TEST_F(ArenaTest, BlockPool) {
+  const size_t kBlockSize = 4096;
+  const size_t kNumBlocks = 4;
+  std::shared_ptr<ArenaBlockPool> pool =
+      NewArenaBlockPool(kNumBlocks * kBlockSize);
+  std::set<char*> blocks;
+  {
+    Arena arena(kBlockSize, nullptr /* tracker */, 0 /* huge_page_size */,
+                pool.get());
+    // Fill the inline block first, then allocate a block per iteration.
+    arena.AllocateAligned(Arena::kInlineSize);
+    for (size_t i = 0; i < kNumBlocks; i++) {
+      blocks.insert(arena.AllocateAligned(kBlockSize / 4));
+      arena.AllocateAligned(kBlockSize - kBlockSize / 4);
+    }
+    ASSERT_EQ(blocks.size(), kNumBlocks);
+    ASSERT_EQ(arena.MemoryAllocatedBytes(),
+              Arena::kInlineSize + kNumBlocks * kBlockSize);
+    // Irregular blocks are not taken from the pool.
+    arena.Allocate(kBlockSize);
+  }
+  ArenaBlockPoolStats stats = pool->GetStats();
+  ASSERT_EQ(stats.hits, 0U);
+  ASSERT_EQ(stats.misses, kNumBlocks);
+  ASSERT_EQ(stats.recycled, kNumBlocks);
+  ASSERT_EQ(stats.released, 0U);
+  ASSERT_EQ(stats.pooled_blocks, kNumBlocks);
+  ASSERT_EQ(stats.pooled_bytes, kNumBlocks * kBlockSize);
+
+  // A new arena reuses the blocks, and the pool keeps at most its capacity
+  // of free blocks.
+  pool->SetCapacity(2 * kBlockSize);
+  stats = pool->GetStats();
+  ASSERT_EQ(stats.released, kNumBlocks - 2);
+  ASSERT_EQ(stats.pooled_bytes, 2 * kBlockSize);
+  {
+    Arena arena(kBlockSize, nullptr /* tracker */, 0 /* huge_page_size */,
+                pool.get());
+    arena.AllocateAligned(Arena::kInlineSize);
+    for (size_t i = 0; i < kNumBlocks; i++) {
+      char* block = arena.AllocateAligned(kBlockSize / 4);
+      arena.AllocateAligned(kBlockSize - kBlockSize / 4);
+      if (i < 2) {
+        ASSERT_EQ(blocks.count(block), 1U);
+      }
+    }
+  }
+  stats = pool->GetStats();
+  ASSERT_EQ(stats.hits, 2U);
+  ASSERT_EQ(stats.misses, kNumBlocks + 2);
+  ASSERT_EQ(stats.recycled, kNumBlocks + 2);
+  ASSERT_EQ(stats.released, kNumBlocks);
+  ASSERT_EQ(stats.pooled_blocks, 2U);
+
+  // Blocks of another size are kept apart.
+  {
+    Arena arena(2 * kBlockSize, nullptr /* tracker */, 0 /* huge_page_size */,
+                pool.get());
+    arena.AllocateAligned(Arena::kInlineSize);
+    arena.AllocateAligned(kBlockSize / 4);
+  }
+  stats = pool->GetStats();
+  ASSERT_EQ(stats.hits, 2U);
+  ASSERT_EQ(stats.misses, kNumBlocks + 3);
+  ASSERT_EQ(stats.released, kNumBlocks + 1);
+}
 }  // namespace ROCKSDB_NAMESPACE
 
 int main(int argc, char** argv) {
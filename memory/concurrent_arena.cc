@@ -27,10 +27,12 @@ const size_t kMaxShardBlockSize = size_t{128 * 1024};
 }  // namespace
 
 ConcurrentArena::ConcurrentArena(size_t block_size, AllocTracker* tracker,
-                                 size_t huge_page_size)
+                                 size_t huge_page_size, bool numa_aware,
+                                 ArenaBlockPool* block_pool)
     : shard_block_size_(std::min(kMaxShardBlockSize, block_size / 8)),
+      numa_aware_(numa_aware),
       shards_(),
-      arena_(block_size, tracker, huge_page_size) {
+      arena_(block_size, tracker, huge_page_size, block_pool) {
   Fixup();
 }
 
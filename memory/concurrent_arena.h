@@ -15,6 +15,7 @@
 #include "memory/arena.h"
 #include "port/lang.h"
 #include "port/likely.h"
+#include "port/port.h"
 #include "util/core_local.h"
 #include "util/mutexlock.h"
 #include "util/thread_local.h"
@@ -43,10 +44,15 @@ class ConcurrentArena : public Allocator {
   // block_size and huge_page_size are the same as for Arena (and are
   // in fact just passed to the constructor of arena_.  The core-local
   // shards compute their shard_block_size as a fraction of block_size
-  // that varies according to the hardware concurrency level.
+  // that varies according to the hardware concurrency level.  If
+  // numa_aware, the memory of a shard is bound to the NUMA node of the
+  // core that refills it, see port::BindMemoryToNumaNode().  block_pool
+  // is passed to arena_ too.
   explicit ConcurrentArena(size_t block_size = Arena::kMinBlockSize,
                            AllocTracker* tracker = nullptr,
-                           size_t huge_page_size = 0);
+                           size_t huge_page_size = 0,
+                           bool numa_aware = false,
+                           ArenaBlockPool* block_pool = nullptr);
 
   char* Allocate(size_t bytes) override {
     return AllocateImpl(bytes, false /*force_arena*/,
@@ -106,6 +112,7 @@ class ConcurrentArena : public Allocator {
   char padding0[56] ROCKSDB_FIELD_UNUSED;
 
   size_t shard_block_size_;
+  const bool numa_aware_;
 
   CoreLocalArray<Shard> shards_;
 
@@ -161,7 +168,7 @@ class ConcurrentArena : public Allocator {
     size_t avail = s->allocated_and_unused_.load(std::memory_order_relaxed);
     if (avail < bytes) {
       // reload
-      std::lock_guard<SpinMutex> reload_lock(arena_mutex_);
+      std::unique_lock<SpinMutex> reload_lock(arena_mutex_);
 
       // If the arena's current block is within a factor of 2 of the right
       // size, we adjust our request to avoid arena waste.
@@ -187,6 +194,11 @@ class ConcurrentArena : public Allocator {
                   : shard_block_size_;
       s->free_begin_ = arena_.AllocateAligned(avail);
       Fixup();
+      reload_lock.unlock();
+      if (numa_aware_) {
+        port::BindMemoryToNumaNode(s->free_begin_, avail,
+                                   port::GetCurrentNumaNode());
+      }
     }
     s->allocated_and_unused_.store(avail - bytes, std::memory_order_relaxed);
 
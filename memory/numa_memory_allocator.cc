@@ -0,0 +1,58 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "memory/numa_memory_allocator.h"
+
+#include <new>
+
+#include "util/string_util.h"
+
+#ifdef NUMA
+#include <numa.h>
+#endif
+
+namespace ROCKSDB_NAMESPACE {
+
+#ifdef NUMA
+void* NumaMemoryAllocator::Allocate(size_t size) {
+  char* p =
+      static_cast<char*>(numa_alloc_onnode(size + kHeaderSize, numa_node_));
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  *reinterpret_cast<size_t*>(p) = size + kHeaderSize;
+  return p + kHeaderSize;
+}
+
+void NumaMemoryAllocator::Deallocate(void* p) {
+  char* start = static_cast<char*>(p) - kHeaderSize;
+  numa_free(start, *reinterpret_cast<size_t*>(start));
+}
+#endif  // NUMA
+
+Status NewNumaMemoryAllocator(
+    int numa_node, std::shared_ptr<MemoryAllocator>* memory_allocator) {
+  if (memory_allocator == nullptr) {
+    return Status::InvalidArgument("memory_allocator must be non-null.");
+  }
+  *memory_allocator = nullptr;
+#ifndef NUMA
+  (void)numa_node;
+  return Status::NotSupported(
+      "NumaMemoryAllocator is only available when RocksDB is built with "
+      "NUMA support.");
+#else
+  if (numa_available() < 0) {
+    return Status::NotSupported("NUMA is not supported by the system.");
+  }
+  if (numa_node < 0 || numa_node > numa_max_node()) {
+    return Status::InvalidArgument("Invalid NUMA node", ToString(numa_node));
+  }
+  memory_allocator->reset(new NumaMemoryAllocator(numa_node));
+  return Status::OK();
+#endif  // NUMA
+}
+
+}  // namespace ROCKSDB_NAMESPACE
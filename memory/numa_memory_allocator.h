@@ -0,0 +1,36 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include "port/port.h"
+#include "rocksdb/memory_allocator.h"
+
+#ifdef NUMA
+
+namespace ROCKSDB_NAMESPACE {
+
+// Allocates memory on one NUMA node with numa_alloc_onnode(). See
+// NewNumaMemoryAllocator().
+class NumaMemoryAllocator : public MemoryAllocator {
+ public:
+  explicit NumaMemoryAllocator(int numa_node) : numa_node_(numa_node) {}
+
+  const char* Name() const override { return "NumaMemoryAllocator"; }
+  void* Allocate(size_t size) override;
+  void Deallocate(void* p) override;
+
+  int numa_node() const { return numa_node_; }
+
+ private:
+  // numa_free() needs the size of the allocation, which is kept in front of
+  // it in a header that keeps the allocation aligned to the cache line.
+  static const size_t kHeaderSize = CACHE_LINE_SIZE;
+
+  const int numa_node_;
+};
+
+}  // namespace ROCKSDB_NAMESPACE
+#endif  // NUMA
@@ -0,0 +1,773 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+//
+// An adaptive radix tree (Leis et al., "The Adaptive Radix Tree: ARTful
+// Indexing for Main-Memory Databases") of memtable keys, with the optimistic
+// lock coupling of "The ART of Practical Synchronization" for concurrent
+// inserts.
+//
+// The tree only grows. A node is never changed in a way that a reader could
+// observe half done: children are appended to a node and published by a
+// release store, and a node that has to change shape, because it is full or
+// its prefix has to be split, is copied and the copy replaces it in the
+// parent. The old node is marked obsolete and left in the arena, which is
+// only freed together with the tree. So readers take no locks and never
+// retry, they see every key that was inserted before they started.
+//
+// Writers lock the node they change, and also its parent when the node is
+// replaced. A node is locked by upgrading the version read on the way down,
+// so a writer restarts from the root if anything it decided on changed.
+
+#ifndef ROCKSDB_LITE
+#include "memtable/art_rep.h"
+
+#include <string.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "db/dbformat.h"
+#include "db/memtable.h"
+#include "memory/allocator.h"
+#include "memory/arena.h"
+#include "port/port.h"
+#include "rocksdb/comparator.h"
+#include "rocksdb/memtablerep.h"
+#include "util/coding.h"
+
+namespace ROCKSDB_NAMESPACE {
+namespace {
+
+// The tree keys are the memtable keys turned into strings that sort bytewise
+// in the order of MemTable::KeyComparator with BytewiseComparator(): the user
+// key with every 0x00 escaped as 0x00 0x01 and terminated by 0x00 0x00,
+// followed by kMaxSequenceNumber - sequence in 7 big endian bytes. The value
+// type is left out like in KeyComparator. No tree key is a prefix of another
+// one, so all keys are in the leaves.
+void EncodeTreeKey(const Slice& internal_key, std::string* dst) {
+  assert(internal_key.size() >= kNumInternalBytes);
+  dst->clear();
+  const char* p = internal_key.data();
+  const char* limit = p + internal_key.size() - kNumInternalBytes;
+  while (p < limit) {
+    const char* zero = static_cast<const char*>(memchr(p, 0, limit - p));
+    if (zero == nullptr) {
+      dst->append(p, limit - p);
+      break;
+    }
+    dst->append(p, zero - p + 1);
+    dst->push_back('\1');
+    p = zero + 1;
+  }
+  uint64_t inverted =
+      kMaxSequenceNumber - (ExtractInternalKeyFooter(internal_key) >> 8);
+  char trailer[9];
+  trailer[0] = trailer[1] = '\0';
+  for (int i = 0; i < 7; ++i) {
+    trailer[2 + i] = static_cast<char>(inverted >> (48 - 8 * i));
+  }
+  dst->append(trailer, sizeof(trailer));
+}
+
+inline void EncodeEntryTreeKey(const char* entry, std::string* dst) {
+  EncodeTreeKey(GetLengthPrefixedSlice(entry), dst);
+}
+
+// A child is either an inner node or a leaf, which is a memtable entry with
+// its lowest bit set. The entries are allocated aligned for that, see
+// ARTRep::Allocate().
+typedef void* Child;
+
+inline bool IsLeaf(Child child) {
+  return (reinterpret_cast<uintptr_t>(child) & 1) != 0;
+}
+inline Child MakeLeaf(const char* entry) {
+  return reinterpret_cast<Child>(reinterpret_cast<uintptr_t>(entry) | 1);
+}
+inline const char* LeafEntry(Child child) {
+  return reinterpret_cast<const char*>(reinterpret_cast<uintptr_t>(child) &
+                                       ~static_cast<uintptr_t>(1));
+}
+
+enum NodeType : uint8_t { kNode4, kNode16, kNode48, kNode256 };
+
+// The bits of Node::version.
+const uint64_t kObsolete = 1;
+const uint64_t kLocked = 2;
+
+struct Node {
+  Node(NodeType _type, const char* _prefix, uint32_t _prefix_len)
+      : version(0), type(_type), prefix_len(_prefix_len), prefix(_prefix) {}
+
+  std::atomic<uint64_t> version;
+  const NodeType type;
+  // The bytes that all keys below this node have in common after the byte
+  // that leads to it. Never changed, a node with a shorter prefix is a copy.
+  const uint32_t prefix_len;
+  const char* const prefix;
+};
+
+// Node4 and Node16 keep their children unsorted, in the order they were
+// added, so that a child is added without moving the others.
+template <uint8_t kCapacity>
+struct SmallNode : public Node {
+  SmallNode(const char* _prefix, uint32_t _prefix_len)
+      : Node(kCapacity == 4 ? kNode4 : kNode16, _prefix, _prefix_len),
+        count(0) {}
+
+  // keys[i] and children[i] are written before count is raised past i.
+  std::atomic<uint8_t> count;
+  uint8_t keys[kCapacity];
+  std::atomic<Child> children[kCapacity];
+};
+typedef SmallNode<4> Node4;
+typedef SmallNode<16> Node16;
+
+struct Node48 : public Node {
+  Node48(const char* _prefix, uint32_t _prefix_len)
+      : Node(kNode48, _prefix, _prefix_len), count(0) {
+    for (auto& i : index) {
+      i.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  std::atomic<uint8_t> count;
+  // 1 + the slot in children of each key byte, 0 if there is none.
+  std::atomic<uint8_t> index[256];
+  std::atomic<Child> children[48];
+};
+
+struct Node256 : public Node {
+  Node256(const char* _prefix, uint32_t _prefix_len)
+      : Node(kNode256, _prefix, _prefix_len) {
+    for (auto& c : children) {
+      c.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  std::atomic<Child> children[256];
+};
+
+template <uint8_t kCapacity>
+std::atomic<Child>* FindChild(SmallNode<kCapacity>* node, uint8_t b) {
+  uint8_t count = node->count.load(std::memory_order_acquire);
+  for (uint8_t i = 0; i < count; ++i) {
+    if (node->keys[i] == b) {
+      return &node->children[i];
+    }
+  }
+  return nullptr;
+}
+
+// Return the slot of the child for key byte b, or nullptr. The slot of a
+// Node256 is returned even if it is empty.
+std::atomic<Child>* FindChild(Node* node, uint8_t b) {
+  switch (node->type) {
+    case kNode4:
+      return FindChild(static_cast<Node4*>(node), b);
+    case kNode16:
+      return FindChild(static_cast<Node16*>(node), b);
+    case kNode48: {
+      auto n = static_cast<Node48*>(node);
+      uint8_t i = n->index[b].load(std::memory_order_acquire);
+      return i == 0 ? nullptr : &n->children[i - 1];
+    }
+    case kNode256:
+      return &static_cast<Node256*>(node)->children[b];
+  }
+  assert(false);
+  return nullptr;
+}
+
+bool IsFull(Node* node) {
+  switch (node->type) {
+    case kNode4:
+      return static_cast<Node4*>(node)->count.load(
+                 std::memory_order_relaxed) == 4;
+    case kNode16:
+      return static_cast<Node16*>(node)->count.load(
+                 std::memory_order_relaxed) == 16;
+    case kNode48:
+      return static_cast<Node48*>(node)->count.load(
+                 std::memory_order_relaxed) == 48;
+    case kNode256:
+      return false;
+  }
+  assert(false);
+  return true;
+}
+
+template <uint8_t kCapacity>
+void AddChild(SmallNode<kCapacity>* node, uint8_t b, Child child) {
+  uint8_t count = node->count.load(std::memory_order_relaxed);
+  assert(count < kCapacity);
+  node->keys[count] = b;
+  node->children[count].store(child, std::memory_order_relaxed);
+  node->count.store(count + 1, std::memory_order_release);
+}
+
+// REQUIRES: node is locked or not yet published, node is not full and has
+// no child for b.
+void AddChild(Node* node, uint8_t b, Child child) {
+  switch (node->type) {
+    case kNode4:
+      AddChild(static_cast<Node4*>(node), b, child);
+      break;
+    case kNode16:
+      AddChild(static_cast<Node16*>(node), b, child);
+      break;
+    case kNode48: {
+      auto n = static_cast<Node48*>(node);
+      uint8_t count = n->count.load(std::memory_order_relaxed);
+      assert(count < 48);
+      n->children[count].store(child, std::memory_order_relaxed);
+      n->index[b].store(count + 1, std::memory_order_release);
+      n->count.store(count + 1, std::memory_order_relaxed);
+      break;
+    }
+    case kNode256:
+      static_cast<Node256*>(node)->children[b].store(
+          child, std::memory_order_release);
+      break;
+  }
+}
+
+template <uint8_t kCapacity, class F>
+void ForEachChild(SmallNode<kCapacity>* node, const F& f) {
+  uint8_t count = node->count.load(std::memory_order_acquire);
+  for (uint8_t i = 0; i < count; ++i) {
+    f(node->keys[i], node->children[i].load(std::memory_order_acquire));
+  }
+}
+
+// Call f(key byte, child) for all children of node, not in order.
+template <class F>
+void ForEachChild(Node* node, const F& f) {
+  switch (node->type) {
+    case kNode4:
+      ForEachChild(static_cast<Node4*>(node), f);
+      break;
+    case kNode16:
+      ForEachChild(static_cast<Node16*>(node), f);
+      break;
+    case kNode48: {
+      auto n = static_cast<Node48*>(node);
+      for (int b = 0; b < 256; ++b) {
+        uint8_t i = n->index[b].load(std::memory_order_acquire);
+        if (i != 0) {
+          f(static_cast<uint8_t>(b),
+            n->children[i - 1].load(std::memory_order_acquire));
+        }
+      }
+      break;
+    }
+    case kNode256: {
+      auto n = static_cast<Node256*>(node);
+      for (int b = 0; b < 256; ++b) {
+        Child c = n->children[b].load(std::memory_order_acquire);
+        if (c != nullptr) {
+          f(static_cast<uint8_t>(b), c);
+        }
+      }
+      break;
+    }
+  }
+}
+
+// Return the child of node with the smallest key byte greater than b, or
+// nullptr. b may be -1.
+Child NextChild(Node* node, int b) {
+  if (node->type == kNode4 || node->type == kNode16) {
+    int best = 256;
+    Child next = nullptr;
+    ForEachChild(node, [&](uint8_t k, Child c) {
+      if (k > b && k < best) {
+        best = k;
+        next = c;
+      }
+    });
+    return next;
+  }
+  for (int k = b + 1; k < 256; ++k) {
+    if (node->type == kNode48) {
+      auto n = static_cast<Node48*>(node);
+      uint8_t i = n->index[k].load(std::memory_order_acquire);
+      if (i != 0) {
+        return n->children[i - 1].load(std::memory_order_acquire);
+      }
+    } else {
+      Child c = static_cast<Node256*>(node)->children[k].load(
+          std::memory_order_acquire);
+      if (c != nullptr) {
+        return c;
+      }
+    }
+  }
+  return nullptr;
+}
+
+// Return the child of node with the largest key byte less than b, or
+// nullptr. b may be 256.
+Child PrevChild(Node* node, int b) {
+  if (node->type == kNode4 || node->type == kNode16) {
+    int best = -1;
+    Child prev = nullptr;
+    ForEachChild(node, [&](uint8_t k, Child c) {
+      if (k < b && k > best) {
+        best = k;
+        prev = c;
+      }
+    });
+    return prev;
+  }
+  for (int k = b - 1; k >= 0; --k) {
+    if (node->type == kNode48) {
+      auto n = static_cast<Node48*>(node);
+      uint8_t i = n->index[k].load(std::memory_order_acquire);
+      if (i != 0) {
+        return n->children[i - 1].load(std::memory_order_acquire);
+      }
+    } else {
+      Child c = static_cast<Node256*>(node)->children[k].load(
+          std::memory_order_acquire);
+      if (c != nullptr) {
+        return c;
+      }
+    }
+  }
+  return nullptr;
+}
+
+// Wait until node is unlocked and read its version. Return false if node
+// is obsolete.
+bool ReadLock(Node* node, uint64_t* version) {
+  uint64_t v = node->version.load(std::memory_order_acquire);
+  for (uint32_t spins = 0; (v & kLocked) != 0; ++spins) {
+    if (spins < 100) {
+      port::AsmVolatilePause();
+    } else {
+      std::this_thread::yield();
+    }
+    v = node->version.load(std::memory_order_acquire);
+  }
+  *version = v;
+  return (v & kObsolete) == 0;
+}
+
+// Lock node if it is still at version.
+bool UpgradeToWriteLock(Node* node, uint64_t version) {
+  return node->version.compare_exchange_strong(version, version + kLocked,
+                                               std::memory_order_acquire);
+}
+
+// Adding kLocked again clears the bit and bumps the version.
+void WriteUnlock(Node* node) {
+  node->version.fetch_add(kLocked, std::memory_order_release);
+}
+
+void WriteUnlockObsolete(Node* node) {
+  node->version.fetch_add(kLocked | kObsolete, std::memory_order_release);
+}
+
+class ARTRep : public MemTableRep {
+ public:
+  explicit ARTRep(Allocator* allocator)
+      : MemTableRep(allocator), root_(NewNode(kNode256, nullptr, 0)) {}
+
+  // The entries are aligned so that the lowest bit of a child tells leaves
+  // from inner nodes.
+  KeyHandle Allocate(const size_t len, char** buf) override {
+    *buf = allocator_->AllocateAligned(len);
+    return static_cast<KeyHandle>(*buf);
+  }
+
+  void Insert(KeyHandle handle) override {
+    TreeInsert(static_cast<const char*>(handle));
+  }
+
+  bool InsertKey(KeyHandle handle) override {
+    return TreeInsert(static_cast<const char*>(handle));
+  }
+
+  void InsertConcurrently(KeyHandle handle) override {
+    TreeInsert(static_cast<const char*>(handle));
+  }
+
+  bool InsertKeyConcurrently(KeyHandle handle) override {
+    return TreeInsert(static_cast<const char*>(handle));
+  }
+
+  bool Contains(const Slice& internal_key) const override {
+    std::string target;
+    std::string scratch;
+    EncodeTreeKey(internal_key, &target);
+    const char* entry = FindGreater(root_, 0, target, true, &scratch);
+    if (entry == nullptr) {
+      return false;
+    }
+    EncodeEntryTreeKey(entry, &scratch);
+    return scratch == target;
+  }
+
+  size_t ApproximateMemoryUsage() override {
+    // All memory is allocated through allocator; nothing to report here
+    return 0;
+  }
+
+  void Get(const LookupKey& k, void* callback_args,
+           bool (*callback_func)(void* arg, const KeyValuePair*)) override {
+    Iterator iter(this);
+    EncodedKeyValuePair pair;
+    for (iter.Seek(Slice(), k.memtable_key().data());
+         iter.Valid() && callback_func(callback_args, pair.SetKey(iter.key()));
+         iter.Next()) {
+    }
+  }
+
+  ~ARTRep() override {}
+
+  // Every step of the iterator looks up the tree key of the current entry
+  // from the root, so that it never walks through nodes that were replaced
+  // since the previous step. The tree is totally ordered, so it is also the
+  // dynamic prefix iterator.
+  class Iterator : public MemTableRep::Iterator {
+   public:
+    explicit Iterator(const ARTRep* rep) : rep_(rep), entry_(nullptr) {}
+
+    ~Iterator() override {}
+
+    bool Valid() const override { return entry_ != nullptr; }
+
+    const char* key() const override {
+      assert(Valid());
+      return entry_;
+    }
+
+    void Next() override {
+      assert(Valid());
+      EncodeEntryTreeKey(entry_, &target_);
+      entry_ = rep_->FindGreater(rep_->root_, 0, target_, false, &scratch_);
+    }
+
+    void Prev() override {
+      assert(Valid());
+      EncodeEntryTreeKey(entry_, &target_);
+      entry_ = rep_->FindLess(rep_->root_, 0, target_, false, &scratch_);
+    }
+
+    void Seek(const Slice& internal_key, const char* memtable_key) override {
+      SetTarget(internal_key, memtable_key);
+      entry_ = rep_->FindGreater(rep_->root_, 0, target_, true, &scratch_);
+    }
+
+    void SeekForPrev(const Slice& internal_key,
+                     const char* memtable_key) override {
+      SetTarget(internal_key, memtable_key);
+      entry_ = rep_->FindLess(rep_->root_, 0, target_, true, &scratch_);
+    }
+
+    void SeekToFirst() override { entry_ = FindFirst(rep_->root_); }
+
+    void SeekToLast() override { entry_ = FindLast(rep_->root_); }
+
+   private:
+    void SetTarget(const Slice& internal_key, const char* memtable_key) {
+      if (memtable_key != nullptr) {
+        EncodeEntryTreeKey(memtable_key, &target_);
+      } else {
+        EncodeTreeKey(internal_key, &target_);
+      }
+    }
+
+    const ARTRep* rep_;
+    const char* entry_;
+    std::string target_;
+    std::string scratch_;
+  };
+
+  MemTableRep::Iterator* GetIterator(Arena* arena = nullptr) override {
+    void* mem = arena ? arena->AllocateAligned(sizeof(ARTRep::Iterator))
+                      : operator new(sizeof(ARTRep::Iterator));
+    return new (mem) ARTRep::Iterator(this);
+  }
+
+ private:
+  enum InsertResult { kInserted, kDuplicate, kRestart };
+
+  Node* NewNode(NodeType type, const char* prefix, uint32_t prefix_len) {
+    switch (type) {
+      case kNode4:
+        return new (allocator_->AllocateAligned(sizeof(Node4)))
+            Node4(prefix, prefix_len);
+      case kNode16:
+        return new (allocator_->AllocateAligned(sizeof(Node16)))
+            Node16(prefix, prefix_len);
+      case kNode48:
+        return new (allocator_->AllocateAligned(sizeof(Node48)))
+            Node48(prefix, prefix_len);
+      case kNode256:
+        return new (allocator_->AllocateAligned(sizeof(Node256)))
+            Node256(prefix, prefix_len);
+    }
+    assert(false);
+    return nullptr;
+  }
+
+  // A copy of node, which must be locked, as a node of type with the given
+  // prefix.
+  Node* CopyNode(Node* node, NodeType type, const char* prefix,
+                 uint32_t prefix_len) {
+    Node* copy = NewNode(type, prefix, prefix_len);
+    ForEachChild(node, [&](uint8_t b, Child c) { AddChild(copy, b, c); });
+    return copy;
+  }
+
+  bool TreeInsert(const char* entry) {
+    std::string key;
+    std::string scratch;
+    EncodeEntryTreeKey(entry, &key);
+    for (;;) {
+      InsertResult result = TryInsert(key, MakeLeaf(entry), &scratch);
+      if (result != kRestart) {
+        return result == kInserted;
+      }
+    }
+  }
+
+  InsertResult TryInsert(const std::string& key, Child leaf,
+                         std::string* scratch) {
+    Node* parent = nullptr;
+    uint64_t parent_version = 0;
+    uint8_t parent_byte = 0;
+    Node* node = root_;
+    uint64_t version;
+    if (!ReadLock(node, &version)) {
+      return kRestart;
+    }
+    size_t depth = 0;
+    for (;;) {
+      uint32_t i = 0;
+      while (i < node->prefix_len && node->prefix[i] == key[depth + i]) {
+        ++i;
+      }
+      if (i < node->prefix_len) {
+        // Split the prefix: a new Node4 with the common part replaces node
+        // in parent, with a copy of node with the rest of the prefix and the
+        // new leaf below it. The root has no prefix, so parent is set.
+        assert(parent != nullptr);
+        if (!UpgradeToWriteLock(parent, parent_version)) {
+          return kRestart;
+        }
+        if (!UpgradeToWriteLock(node, version)) {
+          WriteUnlock(parent);
+          return kRestart;
+        }
+        Node* split = NewNode(kNode4, node->prefix, i);
+        AddChild(split, static_cast<uint8_t>(node->prefix[i]),
+                 CopyNode(node, node->type, node->prefix + i + 1,
+                          node->prefix_len - i - 1));
+        AddChild(split, static_cast<uint8_t>(key[depth + i]), leaf);
+        FindChild(parent, parent_byte)
+            ->store(split, std::memory_order_release);
+        WriteUnlockObsolete(node);
+        WriteUnlock(parent);
+        return kInserted;
+      }
+      depth += node->prefix_len;
+      assert(depth < key.size());
+      uint8_t b = static_cast<uint8_t>(key[depth]);
+      std::atomic<Child>* slot = FindChild(node, b);
+      Child child =
+          slot == nullptr ? nullptr : slot->load(std::memory_order_acquire);
+
+      if (child == nullptr) {
+        if (!IsFull(node)) {
+          if (!UpgradeToWriteLock(node, version)) {
+            return kRestart;
+          }
+          AddChild(node, b, leaf);
+          WriteUnlock(node);
+          return kInserted;
+        }
+        // Grow: a larger copy of node with the new leaf replaces it.
+        assert(parent != nullptr);
+        if (!UpgradeToWriteLock(parent, parent_version)) {
+          return kRestart;
+        }
+        if (!UpgradeToWriteLock(node, version)) {
+          WriteUnlock(parent);
+          return kRestart;
+        }
+        Node* larger =
+            CopyNode(node, static_cast<NodeType>(node->type + 1),
+                     node->prefix, node->prefix_len);
+        AddChild(larger, b, leaf);
+        FindChild(parent, parent_byte)
+            ->store(larger, std::memory_order_release);
+        WriteUnlockObsolete(node);
+        WriteUnlock(parent);
+        return kInserted;
+      }
+
+      if (IsLeaf(child)) {
+        // Expand the leaf into a Node4 with both leaves below it, whose
+        // prefix is what the two keys have in common after b.
+        if (!UpgradeToWriteLock(node, version)) {
+          return kRestart;
+        }
+        EncodeEntryTreeKey(LeafEntry(child), scratch);
+        if (*scratch == key) {
+          WriteUnlock(node);
+          return kDuplicate;
+        }
+        size_t start = depth + 1;
+        size_t end = start;
+        while (key[end] == (*scratch)[end]) {
+          ++end;
+        }
+        char* prefix = nullptr;
+        if (end > start) {
+          prefix = allocator_->Allocate(end - start);
+          memcpy(prefix, key.data() + start, end - start);
+        }
+        Node* expanded =
+            NewNode(kNode4, prefix, static_cast<uint32_t>(end - start));
+        AddChild(expanded, static_cast<uint8_t>((*scratch)[end]), child);
+        AddChild(expanded, static_cast<uint8_t>(key[end]), leaf);
+        slot->store(expanded, std::memory_order_release);
+        WriteUnlock(node);
+        return kInserted;
+      }
+
+      parent = node;
+      parent_version = version;
+      parent_byte = b;
+      node = static_cast<Node*>(child);
+      if (!ReadLock(node, &version)) {
+        return kRestart;
+      }
+      depth++;
+    }
+  }
+
+  // Return the first entry below child whose tree key is greater than
+  // target, or equal to it if or_equal. The keys below child have the first
+  // depth bytes of target in common.
+  const char* FindGreater(Child child, size_t depth, const Slice& target,
+                          bool or_equal, std::string* scratch) const {
+    if (child == nullptr) {
+      return nullptr;
+    }
+    if (IsLeaf(child)) {
+      EncodeEntryTreeKey(LeafEntry(child), scratch);
+      int r = Slice(*scratch).compare(target);
+      return r > 0 || (r == 0 && or_equal) ? LeafEntry(child) : nullptr;
+    }
+    Node* node = static_cast<Node*>(child);
+    for (uint32_t i = 0; i < node->prefix_len; ++i, ++depth) {
+      if (depth >= target.size()) {
+        return FindFirst(child);
+      }
+      uint8_t p = static_cast<uint8_t>(node->prefix[i]);
+      uint8_t t = static_cast<uint8_t>(target[depth]);
+      if (p != t) {
+        return p > t ? FindFirst(child) : nullptr;
+      }
+    }
+    if (depth >= target.size()) {
+      return FindFirst(child);
+    }
+    uint8_t b = static_cast<uint8_t>(target[depth]);
+    std::atomic<Child>* slot = FindChild(node, b);
+    if (slot != nullptr) {
+      const char* entry =
+          FindGreater(slot->load(std::memory_order_acquire), depth + 1,
+                      target, or_equal, scratch);
+      if (entry != nullptr) {
+        return entry;
+      }
+    }
+    return FindFirst(NextChild(node, b));
+  }
+
+  // Like FindGreater(), for the last entry less than target.
+  const char* FindLess(Child child, size_t depth, const Slice& target,
+                       bool or_equal, std::string* scratch) const {
+    if (child == nullptr) {
+      return nullptr;
+    }
+    if (IsLeaf(child)) {
+      EncodeEntryTreeKey(LeafEntry(child), scratch);
+      int r = Slice(*scratch).compare(target);
+      return r < 0 || (r == 0 && or_equal) ? LeafEntry(child) : nullptr;
+    }
+    Node* node = static_cast<Node*>(child);
+    for (uint32_t i = 0; i < node->prefix_len; ++i, ++depth) {
+      if (depth >= target.size()) {
+        return nullptr;
+      }
+      uint8_t p = static_cast<uint8_t>(node->prefix[i]);
+      uint8_t t = static_cast<uint8_t>(target[depth]);
+      if (p != t) {
+        return p < t ? FindLast(child) : nullptr;
+      }
+    }
+    if (depth >= target.size()) {
+      return nullptr;
+    }
+    uint8_t b = static_cast<uint8_t>(target[depth]);
+    std::atomic<Child>* slot = FindChild(node, b);
+    if (slot != nullptr) {
+      const char* entry = FindLess(slot->load(std::memory_order_acquire),
+                                   depth + 1, target, or_equal, scratch);
+      if (entry != nullptr) {
+        return entry;
+      }
+    }
+    return FindLast(PrevChild(node, b));
+  }
+
+  static const char* FindFirst(Child child) {
+    while (child != nullptr && !IsLeaf(child)) {
+      child = NextChild(static_cast<Node*>(child), -1);
+    }
+    return child == nullptr ? nullptr : LeafEntry(child);
+  }
+
+  static const char* FindLast(Child child) {
+    while (child != nullptr && !IsLeaf(child)) {
+      child = PrevChild(static_cast<Node*>(child), 256);
+    }
+    return child == nullptr ? nullptr : LeafEntry(child);
+  }
+
+  // A Node256 without prefix, so it is never replaced.
+  Node* const root_;
+};
+
+}  // namespace
+
+MemTableRep* AdaptiveRadixTreeRepFactory::CreateMemTableRep(
+    const MemTableRep::KeyComparator& compare, Allocator* allocator,
+    const SliceTransform* /*transform*/, Logger* /*logger*/) {
+  const InternalKeyComparator* icmp = compare.icomparator();
+  if (icmp == nullptr) {
+    return nullptr;
+  }
+  const Comparator* ucmp = icmp->user_comparator();
+  if (ucmp->timestamp_size() != 0 ||
+      strcmp(ucmp->Name(), BytewiseComparator()->Name()) != 0) {
+    return nullptr;
+  }
+  return new ARTRep(allocator);
+}
+
+MemTableRepFactory* NewAdaptiveRadixTreeRepFactory() {
+  return new AdaptiveRadixTreeRepFactory;
+}
+
+}  // namespace ROCKSDB_NAMESPACE
+#endif  // ROCKSDB_LITE
@@ -0,0 +1,35 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+#ifndef ROCKSDB_LITE
+#include "rocksdb/memtablerep.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+class AdaptiveRadixTreeRepFactory : public MemTableRepFactory {
+ public:
+  AdaptiveRadixTreeRepFactory() {}
+
+  virtual ~AdaptiveRadixTreeRepFactory() {}
+
+  using MemTableRepFactory::CreateMemTableRep;
+  // Return nullptr unless the user comparator of compare is
+  // BytewiseComparator(), MemTable then uses a skip list instead.
+  virtual MemTableRep* CreateMemTableRep(
+      const MemTableRep::KeyComparator& compare, Allocator* allocator,
+      const SliceTransform* transform, Logger* logger) override;
+
+  virtual const char* Name() const override {
+    return "AdaptiveRadixTreeRepFactory";
+  }
+
+  bool IsInsertConcurrentlySupported() const override { return true; }
+
+  bool CanHandleDuplicatedKey() const override { return true; }
+};
+
+}  // namespace ROCKSDB_NAMESPACE
+#endif  // ROCKSDB_LITE
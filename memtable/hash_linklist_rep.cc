@@ -9,8 +9,10 @@
 
 #include <algorithm>
 #include <atomic>
+#include <thread>
 #include "db/memtable.h"
 #include "memory/arena.h"
+#include "memtable/key_pointer_skiplist.h"
 #include "memtable/skiplist.h"
 #include "monitoring/histogram.h"
 #include "port/port.h"
@@ -30,9 +32,12 @@ typedef std::atomic<void*> Pointer;
 struct BucketHeader {
   Pointer next;
   std::atomic<uint32_t> num_entries;
+  // The number of entries of the bucket, including the concurrent inserts
+  // that have not linked their node yet. See InsertConcurrently().
+  std::atomic<uint32_t> num_reserved;
 
   explicit BucketHeader(void* n, uint32_t count)
-      : next(n), num_entries(count) {}
+      : next(n), num_entries(count), num_reserved(count) {}
 
   bool IsSkipListBucket() {
     return next.load(std::memory_order_relaxed) == this;
@@ -47,13 +52,15 @@ struct BucketHeader {
     // Only one thread can do write at one time. No need to do atomic
     // incremental. Update it with relaxed load and store.
     num_entries.store(GetNumEntries() + 1, std::memory_order_relaxed);
+    num_reserved.store(num_reserved.load(std::memory_order_relaxed) + 1,
+                       std::memory_order_relaxed);
   }
 };
 
 // A data structure used as the header of a skip list of a hash bucket.
 struct SkipListBucketHeader {
   BucketHeader Counting_header;
-  MemtableSkipList skip_list;
+  KeyPointerSkipList skip_list;
 
   explicit SkipListBucketHeader(const MemTableRep::KeyComparator& cmp,
                                 Allocator* allocator, uint32_t count)
@@ -82,6 +89,11 @@ struct Node {
 
   void NoBarrier_SetNext(Node* x) { next_.store(x, std::memory_order_relaxed); }
 
+  // Set next to x if it is still expected.
+  bool CASNext(Node* expected, Node* x) {
+    return next_.compare_exchange_strong(expected, x);
+  }
+
   // Needed for placement new below which is fine
   Node() {}
 
@@ -155,6 +167,16 @@ struct Node {
 //     to itself, so no matter a reader sees any stale or newer value, it will
 //     be able to correctly distinguish case 3 and 4.
 //
+// Concurrent inserts change cases with a CAS of the bucket pointer from the
+// value they read, and start over if it fails. A reader of a bucket pointer
+// that sees a non-null next pointer checks that the bucket still points to
+// it before treating it as a header, because the node of case 2 gets a next
+// pointer once a header is in front of it. Nodes are linked with a CAS of the
+// next pointer of their predecessor. The insert that brings the count to
+// the threshold changes case 3 to 4: the inserts that reserved an entry
+// before it link their nodes first, it then copies the list, and the
+// inserts that come later wait for the skip list.
+//
 // The reason that we use case 2 is we want to make the format to be efficient
 // when the utilization of buckets is relatively low. If we use case 3 for
 // single entry bucket, we will need to waste 12 bytes for every entry,
@@ -172,6 +194,8 @@ class HashLinkListRep : public MemTableRep {
 
   void Insert(KeyHandle handle) override;
 
+  void InsertConcurrently(KeyHandle handle) override;
+
   bool Contains(const Slice& internal_key) const override;
 
   size_t ApproximateMemoryUsage() override;
@@ -421,7 +445,7 @@ class HashLinkListRep : public MemTableRep {
         // The bucket is organized as a skip list
         if (!skip_list_iter_) {
           skip_list_iter_.reset(
-              new MemtableSkipList::Iterator(&skip_list_header->skip_list));
+              new KeyPointerSkipList::Iterator(&skip_list_header->skip_list));
         } else {
           skip_list_iter_->SetList(&skip_list_header->skip_list);
         }
@@ -465,7 +489,7 @@ class HashLinkListRep : public MemTableRep {
    private:
     // the underlying memtable
     const HashLinkListRep& memtable_rep_;
-    std::unique_ptr<MemtableSkipList::Iterator> skip_list_iter_;
+    std::unique_ptr<KeyPointerSkipList::Iterator> skip_list_iter_;
   };
 
   class EmptyIterator : public MemTableRep::Iterator {
@@ -690,6 +714,126 @@ void HashLinkListRep::Insert(KeyHandle handle) {
   }
 }
 
+void HashLinkListRep::InsertConcurrently(KeyHandle handle) {
+  Node* x = static_cast<Node*>(handle);
+  Slice internal_key = GetLengthPrefixedSlice(x->key);
+  auto transformed = GetPrefix(internal_key);
+  auto& bucket = buckets_[GetHash(transformed)];
+
+  BucketHeader* header = nullptr;
+  uint32_t num_reserved = 0;
+  while (true) {
+    Pointer* first_next_pointer =
+        static_cast<Pointer*>(bucket.load(std::memory_order_acquire));
+
+    if (first_next_pointer == nullptr) {
+      x->NoBarrier_SetNext(nullptr);
+      void* expected = nullptr;
+      if (bucket.compare_exchange_strong(expected, x,
+                                         std::memory_order_release)) {
+        return;
+      }
+      continue;
+    }
+
+    if (first_next_pointer->load(std::memory_order_acquire) == nullptr) {
+      Node* first = reinterpret_cast<Node*>(first_next_pointer);
+      auto* mem = allocator_->AllocateAligned(sizeof(BucketHeader));
+      header = new (mem) BucketHeader(first, 1);
+      void* expected = first;
+      if (!bucket.compare_exchange_strong(expected, header,
+                                          std::memory_order_release)) {
+        // first is behind a header now, and the new one is left unused.
+        continue;
+      }
+    } else {
+      if (bucket.load(std::memory_order_acquire) != first_next_pointer) {
+        // A node of case 2 that got a header in front of it.
+        continue;
+      }
+      header = reinterpret_cast<BucketHeader*>(first_next_pointer);
+      if (header->IsSkipListBucket()) {
+        auto* skip_list_bucket_header =
+            reinterpret_cast<SkipListBucketHeader*>(header);
+        skip_list_bucket_header->Counting_header.num_entries.fetch_add(
+            1, std::memory_order_relaxed);
+        skip_list_bucket_header->skip_list.InsertConcurrently(x->key);
+        return;
+      }
+    }
+
+    num_reserved = header->num_reserved.fetch_add(1, std::memory_order_relaxed);
+    if (threshold_use_skiplist_ > 0 && num_reserved > threshold_use_skiplist_) {
+      // Another insert is changing the bucket into a skip list.
+      while (bucket.load(std::memory_order_acquire) == header) {
+        std::this_thread::yield();
+      }
+      continue;
+    }
+    break;
+  }
+
+  if (bucket_entries_logging_threshold_ > 0 &&
+      num_reserved ==
+          static_cast<uint32_t>(bucket_entries_logging_threshold_)) {
+    Info(logger_, "HashLinkedList bucket %" ROCKSDB_PRIszt
+                  " has more than %d "
+                  "entries. Key to insert: %s",
+         GetHash(transformed), num_reserved,
+         GetLengthPrefixedSlice(x->key).ToString(true).c_str());
+  }
+
+  if (num_reserved == threshold_use_skiplist_) {
+    // Wait for the inserts that reserved their entries before to link them.
+    while (header->num_entries.load(std::memory_order_acquire) !=
+           threshold_use_skiplist_) {
+      std::this_thread::yield();
+    }
+    LinkListIterator bucket_iter(
+        this, reinterpret_cast<Node*>(
+                  header->next.load(std::memory_order_acquire)));
+    auto mem = allocator_->AllocateAligned(sizeof(SkipListBucketHeader));
+    SkipListBucketHeader* new_skip_list_header = new (mem)
+        SkipListBucketHeader(compare_, allocator_, num_reserved + 1);
+    auto& skip_list = new_skip_list_header->skip_list;
+
+    for (bucket_iter.SeekToHead(); bucket_iter.Valid(); bucket_iter.Next()) {
+      skip_list.Insert(bucket_iter.key());
+    }
+
+    skip_list.Insert(x->key);
+    bucket.store(new_skip_list_header, std::memory_order_release);
+    return;
+  }
+
+  // Link x after the last node with a smaller key. Nodes are never removed,
+  // so a failed CAS only needs to move forward from prev.
+  Node* prev = nullptr;
+  while (true) {
+    Node* cur = prev != nullptr
+                    ? prev->Next()
+                    : reinterpret_cast<Node*>(
+                          header->next.load(std::memory_order_acquire));
+    while (KeyIsAfterNode(internal_key, cur)) {
+      prev = cur;
+      cur = cur->Next();
+    }
+    assert(cur == nullptr || !Equal(x->key, cur->key));
+    x->NoBarrier_SetNext(cur);
+    if (prev != nullptr) {
+      if (prev->CASNext(cur, x)) {
+        break;
+      }
+    } else {
+      void* expected = cur;
+      if (header->next.compare_exchange_strong(expected, x)) {
+        break;
+      }
+    }
+  }
+  header->num_entries.fetch_add(1, std::memory_order_release);
+}
+
 bool HashLinkListRep::Contains(const Slice& internal_key) const {
   auto transformed = GetPrefix(internal_key);
   auto bucket = GetBucket(transformed);
@@ -719,7 +863,7 @@ void HashLinkListRep::Get(const LookupKey& k, void* callback_args,
   auto* skip_list_header = GetSkipListBucketHeader(bucket);
   if (skip_list_header != nullptr) {
     // Is a skip list
-    MemtableSkipList::Iterator iter(&skip_list_header->skip_list);
+    KeyPointerSkipList::Iterator iter(&skip_list_header->skip_list);
     for (iter.Seek(k.memtable_key().data());
          iter.Valid() && callback_func(callback_args, pair.SetKey(iter.key()));
          iter.Next()) {
@@ -750,7 +894,7 @@ MemTableRep::Iterator* HashLinkListRep::GetIterator(Arena* alloc_arena) {
       auto* skip_list_header = GetSkipListBucketHeader(bucket);
       if (skip_list_header != nullptr) {
         // Is a skip list
-        MemtableSkipList::Iterator itr(&skip_list_header->skip_list);
+        KeyPointerSkipList::Iterator itr(&skip_list_header->skip_list);
         for (itr.SeekToFirst(); itr.Valid(); itr.Next()) {
           list->Insert(itr.key());
           count++;
@@ -11,7 +11,7 @@
 
 #include "db/memtable.h"
 #include "memory/arena.h"
-#include "memtable/skiplist.h"
+#include "memtable/key_pointer_skiplist.h"
 #include "port/port.h"
 #include "rocksdb/memtablerep.h"
 #include "rocksdb/slice.h"
@@ -30,6 +30,8 @@ class HashSkipListRep : public MemTableRep {
 
   void Insert(KeyHandle handle) override;
 
+  void InsertConcurrently(KeyHandle handle) override;
+
   bool Contains(const Slice& internal_key) const override;
 
   size_t ApproximateMemoryUsage() override;
@@ -46,7 +48,7 @@ class HashSkipListRep : public MemTableRep {
 
  private:
   friend class DynamicIterator;
-  typedef SkipList<const char*, const MemTableRep::KeyComparator&> Bucket;
+  typedef KeyPointerSkipList Bucket;
 
   size_t bucket_size_;
 
@@ -75,7 +77,7 @@ class HashSkipListRep : public MemTableRep {
     return GetBucket(GetHash(slice));
   }
   // Get a bucket from buckets_. If the bucket hasn't been initialized yet,
-  // initialize it before returning.
+  // initialize it before returning. Thread-safe if allocator_ is.
   Bucket* GetInitializedBucket(const Slice& transformed);
 
   class Iterator : public MemTableRep::Iterator {
@@ -258,9 +260,14 @@ HashSkipListRep::Bucket* HashSkipListRep::GetInitializedBucket(
   auto bucket = GetBucket(hash);
   if (bucket == nullptr) {
     auto addr = allocator_->AllocateAligned(sizeof(Bucket));
-    bucket = new (addr) Bucket(compare_, allocator_, skiplist_height_,
-                               skiplist_branching_factor_);
-    buckets_[hash].store(bucket, std::memory_order_release);
+    auto new_bucket = new (addr) Bucket(compare_, allocator_, skiplist_height_,
+                                        skiplist_branching_factor_);
+    // A concurrent insert may install the bucket first, then new_bucket is
+    // left unused in the allocator.
+    if (buckets_[hash].compare_exchange_strong(bucket, new_bucket,
+                                               std::memory_order_acq_rel)) {
+      bucket = new_bucket;
+    }
   }
   return bucket;
 }
@@ -274,6 +281,14 @@ void HashSkipListRep::Insert(KeyHandle handle) {
   bucket->Insert(key);
 }
 
+void HashSkipListRep::InsertConcurrently(KeyHandle handle) {
+  auto* key = static_cast<char*>(handle);
+  Slice internal_key = GetLengthPrefixedSlice(key);
+  auto transformed = transform_->Transform(ExtractUserKey(internal_key));
+  auto bucket = GetInitializedBucket(transformed);
+  bucket->InsertConcurrently(key);
+}
+
 bool HashSkipListRep::Contains(const Slice& internal_key) const {
   auto transformed = transform_->Transform(ExtractUserKey(internal_key));
   auto bucket = GetBucket(transformed);
@@ -0,0 +1,114 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+//
+// KeyPointerSkipList is a skip list of memtable keys that are allocated
+// elsewhere, like SkipList<const char*, const MemTableRep::KeyComparator&>,
+// with the same interface. It is an InlineSkipList whose inline keys are the
+// addresses of the memtable keys, so that it also supports concurrent
+// inserts, for the memtable reps that keep their keys in several lists.
+
+#pragma once
+#include <string.h>
+
+#include "memtable/inlineskiplist.h"
+#include "rocksdb/memtablerep.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+class KeyPointerSkipList {
+ public:
+  typedef const char* Key;
+
+ private:
+  // Compares the entries of list_ by the keys they point to.
+  struct Comparator {
+    typedef MemTableRep::KeyComparator::DecodedType DecodedType;
+
+    explicit Comparator(const MemTableRep::KeyComparator& c) : cmp(c) {}
+
+    static Key Deref(const char* entry) {
+      Key key;
+      memcpy(&key, entry, sizeof(Key));
+      return key;
+    }
+
+    DecodedType decode_key(const char* entry) const {
+      return cmp.decode_key(Deref(entry));
+    }
+    int operator()(const char* a, const char* b) const {
+      return cmp(Deref(a), Deref(b));
+    }
+    int operator()(const char* a, const DecodedType& b) const {
+      return cmp(Deref(a), b);
+    }
+
+    const MemTableRep::KeyComparator& cmp;
+  };
+
+ public:
+  KeyPointerSkipList(const MemTableRep::KeyComparator& cmp,
+                     Allocator* allocator, int32_t max_height = 12,
+                     int32_t branching_factor = 4)
+      : list_(Comparator(cmp), allocator, max_height, branching_factor) {}
+
+  // REQUIRES: nothing that compares equal to key is currently in the list.
+  // REQUIRES: no concurrent calls to any of inserts.
+  void Insert(Key key) { list_.Insert(NewEntry(key)); }
+
+  // Like Insert, but external synchronization is not required.
+  void InsertConcurrently(Key key) { list_.InsertConcurrently(NewEntry(key)); }
+
+  // Returns true iff an entry that compares equal to key is in the list.
+  bool Contains(Key key) const {
+    return list_.Contains(reinterpret_cast<const char*>(&key));
+  }
+
+  class Iterator {
+   public:
+    // list may be nullptr, then the iterator must be given a list with
+    // SetList() before it is positioned.
+    explicit Iterator(const KeyPointerSkipList* list) : iter_(Inner(list)) {}
+
+    void SetList(const KeyPointerSkipList* list) { iter_.SetList(Inner(list)); }
+
+    bool Valid() const { return iter_.Valid(); }
+
+    // REQUIRES: Valid()
+    Key key() const { return Comparator::Deref(iter_.key()); }
+
+    void Next() { iter_.Next(); }
+    void Prev() { iter_.Prev(); }
+
+    void Seek(Key target) {
+      iter_.Seek(reinterpret_cast<const char*>(&target));
+    }
+    void SeekForPrev(Key target) {
+      iter_.SeekForPrev(reinterpret_cast<const char*>(&target));
+    }
+    void SeekToFirst() { iter_.SeekToFirst(); }
+    void SeekToLast() { iter_.SeekToLast(); }
+
+   private:
+    static const InlineSkipList<Comparator>* Inner(
+        const KeyPointerSkipList* list) {
+      return list == nullptr ? nullptr : &list->list_;
+    }
+
+    InlineSkipList<Comparator>::Iterator iter_;
+  };
+
+ private:
+  // Allocate an entry of list_ pointing to key. This method is thread-safe
+  // if the allocator is thread-safe.
+  char* NewEntry(Key key) {
+    char* entry = list_.AllocateKey(sizeof(Key));
+    memcpy(entry, &key, sizeof(Key));
+    return entry;
+  }
+
+  InlineSkipList<Comparator> list_;
+};
+
+}  // namespace ROCKSDB_NAMESPACE
@@ -16,6 +16,8 @@ int main() {
 #else
 
 #include <atomic>
+#include <cmath>
+#include <fstream>
 #include <iostream>
 #include <memory>
 #include <thread>
@@ -24,18 +26,27 @@ int main() {
 
 #include "db/dbformat.h"
 #include "db/memtable.h"
+#include "db/write_batch_internal.h"
 #include "memory/arena.h"
+#include "memory/concurrent_arena.h"
+#include "monitoring/histogram.h"
+#include "options/cf_options.h"
 #include "port/port.h"
 #include "port/stack_trace.h"
 #include "rocksdb/comparator.h"
 #include "rocksdb/memtablerep.h"
 #include "rocksdb/options.h"
 #include "rocksdb/slice_transform.h"
+#include "rocksdb/write_batch.h"
 #include "rocksdb/write_buffer_manager.h"
+#include "table/scoped_arena_iterator.h"
 #include "test_util/testutil.h"
 #include "util/gflags_compat.h"
+#include "util/hash.h"
 #include "util/mutexlock.h"
 #include "util/stop_watch.h"
+#include "util/string_util.h"
+#include "utilities/json/json_plugin_factory.h"
 
 using GFLAGS_NAMESPACE::ParseCommandLineFlags;
 using GFLAGS_NAMESPACE::RegisterFlagValidator;
@@ -45,22 +56,47 @@ DEFINE_string(benchmarks, "fillrandom",
               "Comma-separated list of benchmarks to run. Options:\n"
               "\tfillrandom             -- write N random values\n"
               "\tfillseq                -- write N values in sequential order\n"
+              "\tfillrandomconcurrent   -- num_threads threads write N random "
+              "values\n"
+              "\t                          together with InsertConcurrently()\n"
               "\treadrandom             -- read N values in random order\n"
+              "\tseekrandom             -- seek to N keys in random order "
+              "with an\n"
+              "\t                          iterator\n"
               "\treadseq                -- scan the DB\n"
               "\treadwrite              -- 1 thread writes while N - 1 threads "
               "do random\n"
               "\t                          reads\n"
               "\tseqreadwrite           -- 1 thread writes while N - 1 threads "
-              "do scans\n");
+              "do scans\n"
+              "\tmemtablefill           -- num_writers threads write N entries "
+              "to a\n"
+              "\t                          MemTable with WriteBatch\n"
+              "\tmemtablereadrandom     -- num_readers threads do N random "
+              "MemTable::Get()\n"
+              "\tmemtableprefixseek     -- num_readers threads do N prefix "
+              "seeks, each\n"
+              "\t                          followed by seek_nexts Next()\n"
+              "\tmemtablereadwhilewriting -- num_readers threads do random "
+              "Get() while\n"
+              "\t                          num_writers threads write N "
+              "entries\n");
 
 DEFINE_string(memtablerep, "skiplist",
-              "Which implementation of memtablerep to use. See "
-              "include/memtablerep.h for\n"
-              "  more details. Options:\n"
+              "Comma-separated list of the memtablereps to benchmark, or "
+              "\"all\" for all\n"
+              "  the built-in ones. See include/memtablerep.h for more "
+              "details. Other\n"
+              "  names are looked up in the JSON plugin repo, and a JSON array "
+              "of class\n"
+              "  names or {\"class\": ..., \"params\": {...}} objects is also "
+              "accepted.\n"
+              "  Options:\n"
               "\tskiplist            -- backed by a skiplist\n"
               "\tvector              -- backed by an std::vector\n"
               "\thashskiplist        -- backed by a hash skip list\n"
               "\thashlinklist        -- backed by a hash linked list\n"
+              "\tart                 -- backed by an adaptive radix tree\n"
               "\tcuckoo              -- backed by a cuckoo hash table");
 
 DEFINE_int64(bucket_count, 1000000,
@@ -97,7 +133,8 @@ DEFINE_int64(write_buffer_size, 256,
 DEFINE_int32(
     num_threads, 1,
     "Number of concurrent threads to run. If the benchmark includes writes,\n"
-    "then at most one thread will be a writer");
+    "then at most one thread will be a writer, except for "
+    "fillrandomconcurrent");
 
 DEFINE_int32(num_operations, 1000000,
              "Number of operations to do for write and random read benchmarks");
@@ -120,6 +157,74 @@ DEFINE_int64(seed, 0,
              "Seed base for random number generators. "
              "When 0 it is deterministic.");
 
+DEFINE_string(json, "",
+              "JSON config file of the JSON plugin repo the memtablereps are "
+              "looked up in");
+
+/* MemTable benchmark settings */
+DEFINE_int32(num_writers, 1,
+             "Number of threads that write in the memtable* benchmarks. The "
+             "writes are\n"
+             "concurrent if the memtablerep supports concurrent inserts, and "
+             "serialized otherwise");
+
+DEFINE_int32(num_readers, 1,
+             "Number of threads that read in the memtable* benchmarks");
+
+DEFINE_int32(batch_size, 1, "Number of entries per WriteBatch");
+
+DEFINE_int32(key_size, 16,
+             "Size of the user keys of the memtable* benchmarks, at least 16");
+
+DEFINE_int32(key_size_max, 0,
+             "If larger than key_size, the key sizes are distributed between "
+             "key_size and\n"
+             "key_size_max according to key_size_distribution");
+
+DEFINE_string(key_size_distribution, "uniform",
+              "Distribution of the key sizes: fixed, uniform or normal");
+
+DEFINE_int32(item_size_max, 0,
+             "If larger than item_size, the value sizes of the memtable* "
+             "benchmarks are\n"
+             "distributed between item_size and item_size_max according to "
+             "item_size_distribution");
+
+DEFINE_string(item_size_distribution, "uniform",
+              "Distribution of the value sizes: fixed, uniform or normal");
+
+DEFINE_int32(keys_per_prefix, 1,
+             "Number of consecutive keys that share their first 8 bytes, "
+             "which are the\n"
+             "prefix of the default prefix_length");
+
+DEFINE_int32(seek_nexts, 10,
+             "Number of Next() after each seek of memtableprefixseek, within "
+             "the prefix");
+
+DEFINE_double(range_tombstone_ratio, 0,
+              "Fraction of the writes of the memtable* benchmarks that are "
+              "DeleteRange()");
+
+DEFINE_int32(range_tombstone_width, 10,
+             "Number of keys covered by each range tombstone");
+
+DEFINE_double(memtable_prefix_bloom_size_ratio, 0,
+              "memtable_prefix_bloom_size_ratio of the memtable* benchmarks");
+
+DEFINE_bool(memtable_whole_key_filtering, false,
+            "memtable_whole_key_filtering of the memtable* benchmarks");
+
+DEFINE_int64(arena_block_size, 1 << 20,
+             "arena_block_size of the memtable* benchmarks");
+
+DEFINE_string(json_output, "",
+              "If not empty, a JSON object with the throughput, latency "
+              "percentiles and\n"
+              "memory usage per entry of each memtable* benchmark is appended "
+              "to this file,\n"
+              "one per line, or printed to stdout for \"-\"");
+
 namespace ROCKSDB_NAMESPACE {
 
 namespace {
@@ -140,7 +245,8 @@ class RandomGenerator {
  public:
   RandomGenerator() {
     Random rnd(301);
-    auto size = (unsigned)std::max(1048576, FLAGS_item_size);
+    auto size =
+        (unsigned)std::max({1048576, FLAGS_item_size, FLAGS_item_size_max});
     data_ = rnd.RandomString(size);
     pos_ = 0;
   }
@@ -233,6 +339,17 @@ class FillBenchmarkThread : public BenchmarkThread {
                         num_ops, read_hits) {}
 
   void FillOne() {
+    table_->Insert(NewEntry(key_gen_->Next(), ++(*sequence_)));
+  }
+
+  void operator()() override {
+    for (unsigned int i = 0; i < num_ops_; ++i) {
+      FillOne();
+    }
+  }
+
+ protected:
+  KeyHandle NewEntry(uint64_t key, uint64_t sequence) {
     char* buf = nullptr;
     auto internal_key_size = 16;
     auto encoded_len =
@@ -240,24 +357,45 @@ class FillBenchmarkThread : public BenchmarkThread {
     KeyHandle handle = table_->Allocate(encoded_len, &buf);
     assert(buf != nullptr);
     char* p = EncodeVarint32(buf, internal_key_size);
-    auto key = key_gen_->Next();
     EncodeFixed64(p, key);
     p += 8;
-    EncodeFixed64(p, ++(*sequence_));
+    EncodeFixed64(p, sequence);
     p += 8;
     Slice bytes = generator_.Generate(FLAGS_item_size);
     memcpy(p, bytes.data(), FLAGS_item_size);
     p += FLAGS_item_size;
     assert(p == buf + encoded_len);
-    table_->Insert(handle);
     *bytes_written_ += encoded_len;
+    return handle;
   }
+};
+
+// One of several threads that insert into the table at the same time. The
+// key generator and bytes_written belong to the thread.
+class MultiWriterFillBenchmarkThread : public FillBenchmarkThread {
+ public:
+  MultiWriterFillBenchmarkThread(MemTableRep* table, KeyGenerator* key_gen,
+                                 uint64_t* bytes_written, uint64_t num_ops,
+                                 std::atomic<uint64_t>* sequence,
+                                 uint64_t key_offset, uint64_t key_stride)
+      : FillBenchmarkThread(table, key_gen, bytes_written, nullptr, nullptr,
+                            num_ops, nullptr),
+        atomic_sequence_(sequence),
+        key_offset_(key_offset),
+        key_stride_(key_stride) {}
 
   void operator()() override {
     for (unsigned int i = 0; i < num_ops_; ++i) {
-      FillOne();
+      uint64_t key = key_gen_->Next() * key_stride_ + key_offset_;
+      table_->InsertConcurrently(
+          NewEntry(key, atomic_sequence_->fetch_add(1) + 1));
     }
   }
+
+ private:
+  std::atomic<uint64_t>* atomic_sequence_;
+  uint64_t key_offset_;
+  uint64_t key_stride_;
 };
 
 class ConcurrentFillBenchmarkThread : public FillBenchmarkThread {
@@ -329,6 +467,31 @@ class ReadBenchmarkThread : public BenchmarkThread {
   }
 };
 
+class SeekBenchmarkThread : public BenchmarkThread {
+ public:
+  SeekBenchmarkThread(MemTableRep* table, KeyGenerator* key_gen,
+                      uint64_t* bytes_written, uint64_t* bytes_read,
+                      uint64_t* sequence, uint64_t num_ops, uint64_t* read_hits)
+      : BenchmarkThread(table, key_gen, bytes_written, bytes_read, sequence,
+                        num_ops, read_hits) {}
+
+  void operator()() override {
+    std::unique_ptr<MemTableRep::Iterator> iter(table_->GetIterator());
+    std::string user_key;
+    for (unsigned int i = 0; i < num_ops_; ++i) {
+      user_key.clear();
+      PutFixed64(&user_key, key_gen_->Next());
+      LookupKey lookup_key(user_key, *sequence_);
+      iter->Seek(Slice(), lookup_key.memtable_key().data());
+      if (iter->Valid() &&
+          ExtractUserKey(GetLengthPrefixedSlice(iter->key())) == user_key) {
+        *bytes_read_ += VarintLength(16) + 16 + FLAGS_item_size;
+        ++*read_hits_;
+      }
+    }
+  }
+};
+
 class SeqReadBenchmarkThread : public BenchmarkThread {
  public:
   SeqReadBenchmarkThread(MemTableRep* table, KeyGenerator* key_gen,
@@ -497,6 +660,31 @@ class ReadBenchmark : public Benchmark {
   }
 };
 
+class SeekBenchmark : public Benchmark {
+ public:
+  explicit SeekBenchmark(MemTableRep* table, KeyGenerator* key_gen,
+                         uint64_t* sequence)
+      : Benchmark(table, key_gen, sequence, FLAGS_num_threads) {
+    num_read_ops_per_thread_ = FLAGS_num_operations / FLAGS_num_threads;
+  }
+
+  void RunThreads(std::vector<port::Thread>* threads, uint64_t* bytes_written,
+                  uint64_t* bytes_read, bool /*write*/,
+                  uint64_t* read_hits) override {
+    for (int i = 0; i < FLAGS_num_threads; ++i) {
+      threads->emplace_back(
+          SeekBenchmarkThread(table_, key_gen_, bytes_written, bytes_read,
+                              sequence_, num_read_ops_per_thread_, read_hits));
+    }
+    for (auto& thread : *threads) {
+      thread.join();
+    }
+    std::cout << "seek hit%: "
+              << (static_cast<double>(*read_hits) / FLAGS_num_operations) * 100
+              << std::endl;
+  }
+};
+
 class SeqReadBenchmark : public Benchmark {
  public:
   explicit SeqReadBenchmark(MemTableRep* table, uint64_t* sequence)
@@ -518,6 +706,43 @@ class SeqReadBenchmark : public Benchmark {
   }
 };
 
+class ConcurrentFillBenchmark : public Benchmark {
+ public:
+  explicit ConcurrentFillBenchmark(MemTableRep* table, Random64* rng,
+                                   uint64_t* sequence)
+      : Benchmark(table, nullptr, sequence, FLAGS_num_threads), rng_(rng) {
+    num_write_ops_per_thread_ = FLAGS_num_operations / FLAGS_num_threads;
+  }
+
+  void RunThreads(std::vector<port::Thread>* threads, uint64_t* bytes_written,
+                  uint64_t* /*bytes_read*/, bool /*write*/,
+                  uint64_t* /*read_hits*/) override {
+    std::atomic<uint64_t> sequence(*sequence_);
+    // Thread i writes the keys i + k * num_threads in a random order.
+    std::vector<std::unique_ptr<KeyGenerator>> key_gens;
+    std::vector<uint64_t> thread_bytes_written(num_threads_, 0);
+    for (uint32_t i = 0; i < num_threads_; ++i) {
+      key_gens.emplace_back(new KeyGenerator(rng_, UNIQUE_RANDOM,
+                                             num_write_ops_per_thread_));
+    }
+    for (uint32_t i = 0; i < num_threads_; ++i) {
+      threads->emplace_back(MultiWriterFillBenchmarkThread(
+          table_, key_gens[i].get(), &thread_bytes_written[i],
+          num_write_ops_per_thread_, &sequence, i, num_threads_));
+    }
+    for (auto& thread : *threads) {
+      thread.join();
+    }
+    for (uint64_t b : thread_bytes_written) {
+      *bytes_written += b;
+    }
+    *sequence_ = sequence.load();
+  }
+
+ private:
+  Random64* rng_;
+};
+
 template <class ReadThreadType>
 class ReadWriteBenchmark : public Benchmark {
  public:
@@ -550,6 +775,420 @@ class ReadWriteBenchmark : public Benchmark {
   }
 };
 
+enum SizeDistribution { kFixedSize, kUniformSize, kNormalSize };
+
+SizeDistribution StringToSizeDistribution(const std::string& name) {
+  if (name == "fixed") {
+    return kFixedSize;
+  } else if (name == "uniform") {
+    return kUniformSize;
+  } else if (name == "normal") {
+    return kNormalSize;
+  }
+  fprintf(stderr, "Unknown size distribution: %s\n", name.c_str());
+  exit(1);
+}
+
+// Maps a number to a size between min_size and max_size. The same number
+// always gets the same size, so that the readers find the keys written by the
+// writers.
+class SizeGenerator {
+ public:
+  SizeGenerator(int min_size, int max_size, SizeDistribution distribution)
+      : min_size_(min_size),
+        max_size_(std::max(min_size, max_size)),
+        distribution_(distribution) {}
+
+  int Size(uint64_t x) const {
+    if (distribution_ == kFixedSize || max_size_ == min_size_) {
+      return min_size_;
+    }
+    uint64_t h = NPHash64(reinterpret_cast<const char*>(&x), sizeof(x));
+    double u = ToUnit(h);
+    double range = max_size_ - min_size_;
+    double size;
+    if (distribution_ == kUniformSize) {
+      size = min_size_ + u * (range + 1);
+    } else {
+      // Box-Muller, with the mean in the middle of the range and three
+      // standard deviations on each side of it.
+      const double kPi = 3.14159265358979323846;
+      double u2 =
+          ToUnit(NPHash64(reinterpret_cast<const char*>(&h), sizeof(h)));
+      double z = std::sqrt(-2.0 * std::log(1.0 - u)) * std::cos(2 * kPi * u2);
+      size = min_size_ + range / 2 + z * range / 6 + 0.5;
+    }
+    return std::min(max_size_, std::max(min_size_, static_cast<int>(size)));
+  }
+
+  double Average() const {
+    return distribution_ == kFixedSize ? min_size_
+                                       : (min_size_ + max_size_) / 2.0;
+  }
+
+  static double ToUnit(uint64_t h) {
+    return static_cast<double>(h >> 11) * (1.0 / (uint64_t{1} << 53));
+  }
+
+ private:
+  const int min_size_;
+  const int max_size_;
+  const SizeDistribution distribution_;
+};
+
+struct MemTableBenchThreadStats {
+  uint64_t write_ops = 0;
+  uint64_t range_deletions = 0;
+  uint64_t payload_bytes = 0;
+  uint64_t read_ops = 0;
+  uint64_t read_hits = 0;
+  // In nanoseconds, per WriteBatch and per read.
+  HistogramImpl write_latency;
+  HistogramImpl read_latency;
+};
+
+// Benchmarks of a memtablerep through the MemTable layer: the writes go
+// through WriteBatch and MemTableInserter, the reads through MemTable::Get()
+// with the memtable bloom filter and the range tombstones, and the seeks
+// through the prefix iterator of the MemTable.
+//
+// The user key of number k is 8 bytes of k / keys_per_prefix, 8 bytes of k,
+// both big-endian, and padding up to the size given by the key size
+// distribution.
+class MemTableBenchmark {
+ public:
+  MemTableBenchmark(const std::string& rep_name,
+                    const std::shared_ptr<MemTableRepFactory>& factory)
+      : rep_name_(rep_name),
+        options_(MakeOptions(factory)),
+        ioptions_(options_),
+        moptions_(options_),
+        icmp_(BytewiseComparator()),
+        wb_(0),
+        key_sizes_(std::max(FLAGS_key_size, 16),
+                   std::max(FLAGS_key_size_max, 16),
+                   StringToSizeDistribution(FLAGS_key_size_distribution)),
+        value_sizes_(FLAGS_item_size, FLAGS_item_size_max,
+                     StringToSizeDistribution(FLAGS_item_size_distribution)) {}
+
+  ~MemTableBenchmark() { ResetMemTable(false); }
+
+  static bool IsMemTableBenchmark(const Slice& name) {
+    return name == "memtablefill" || name == "memtablereadrandom" ||
+           name == "memtableprefixseek" || name == "memtablereadwhilewriting";
+  }
+
+  void Run(const Slice& name) {
+    size_t num_writers = 0;
+    size_t num_readers = 0;
+    bool seek = false;
+    if (name == "memtablefill") {
+      ResetMemTable(true);
+      num_writers = FLAGS_num_writers;
+    } else if (name == "memtablereadrandom") {
+      num_readers = FLAGS_num_readers;
+    } else if (name == "memtableprefixseek") {
+      num_readers = FLAGS_num_readers;
+      seek = true;
+    } else {
+      assert(name == "memtablereadwhilewriting");
+      ResetMemTable(true);
+      num_writers = FLAGS_num_writers;
+      num_readers = FLAGS_num_readers;
+    }
+    if (mem_ == nullptr) {
+      std::cout << "WARNING: skipping " << name.ToString()
+                << ", it reads the MemTable of memtablefill" << std::endl;
+      return;
+    }
+    concurrent_ = num_writers > 1 &&
+                  options_.memtable_factory->IsInsertConcurrentlySupported();
+
+    std::vector<MemTableBenchThreadStats> stats(num_writers + num_readers);
+    std::atomic<size_t> writers_running(num_writers);
+    std::vector<port::Thread> threads;
+    StopWatchNano timer(Env::Default(), true);
+    for (size_t i = 0; i < num_writers; ++i) {
+      threads.emplace_back([&, i] {
+        WriteThread(i, num_writers, &stats[i]);
+        writers_running.fetch_sub(1);
+      });
+    }
+    for (size_t i = 0; i < num_readers; ++i) {
+      threads.emplace_back([&, i] {
+        ReadThread(i, num_readers, seek,
+                   num_writers > 0 ? &writers_running : nullptr,
+                   &stats[num_writers + i]);
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    Report(name.ToString(), num_writers, num_readers, timer.ElapsedNanos(),
+           stats);
+  }
+
+ private:
+  static Options MakeOptions(
+      const std::shared_ptr<MemTableRepFactory>& factory) {
+    Options options;
+    options.memtable_factory = factory;
+    options.prefix_extractor.reset(
+        NewFixedPrefixTransform(FLAGS_prefix_length));
+    options.memtable_prefix_bloom_size_ratio =
+        FLAGS_memtable_prefix_bloom_size_ratio;
+    options.memtable_whole_key_filtering = FLAGS_memtable_whole_key_filtering;
+    options.arena_block_size = static_cast<size_t>(FLAGS_arena_block_size);
+    // Large enough for all the entries, as it also sizes the bloom filter.
+    options.write_buffer_size = std::max(
+        options.write_buffer_size,
+        static_cast<size_t>(FLAGS_num_operations) *
+            static_cast<size_t>(std::max(FLAGS_key_size, FLAGS_key_size_max) +
+                                std::max(FLAGS_item_size, FLAGS_item_size_max) +
+                                32));
+    return options;
+  }
+
+  void ResetMemTable(bool create) {
+    if (mem_ != nullptr) {
+      delete mem_->Unref();
+      mem_ = nullptr;
+    }
+    payload_bytes_ = 0;
+    last_sequence_ = 0;
+    if (create) {
+      mem_ = new MemTable(icmp_, ioptions_, moptions_, &wb_,
+                          kMaxSequenceNumber, 0 /* column_family_id */);
+      mem_->Ref();
+    }
+  }
+
+  void MakeKey(uint64_t k, std::string* key) const {
+    key->clear();
+    uint64_t prefix =
+        k / static_cast<uint64_t>(std::max(FLAGS_keys_per_prefix, 1));
+    for (int shift = 56; shift >= 0; shift -= 8) {
+      key->push_back(static_cast<char>(prefix >> shift));
+    }
+    for (int shift = 56; shift >= 0; shift -= 8) {
+      key->push_back(static_cast<char>(k >> shift));
+    }
+    key->resize(key_sizes_.Size(k), 'k');
+  }
+
+  // Writer i writes the keys i + j * num_writers in a random order.
+  void WriteThread(size_t index, size_t num_writers,
+                   MemTableBenchThreadStats* stats) {
+    const uint64_t num_ops = FLAGS_num_operations / num_writers;
+    Random64 rand(FLAGS_seed + index);
+    KeyGenerator key_gen(&rand, UNIQUE_RANDOM, num_ops);
+    RandomGenerator generator;
+    ColumnFamilyMemTablesDefault cf_mems(mem_);
+    WriteBatch batch;
+    std::string key;
+    std::string end_key;
+    uint64_t done = 0;
+    while (done < num_ops) {
+      batch.Clear();
+      for (int i = 0; i < FLAGS_batch_size && done < num_ops; ++i, ++done) {
+        uint64_t k = key_gen.Next() * num_writers + index;
+        MakeKey(k, &key);
+        if (FLAGS_range_tombstone_ratio > 0 &&
+            SizeGenerator::ToUnit(rand.Next()) < FLAGS_range_tombstone_ratio) {
+          MakeKey(k + FLAGS_range_tombstone_width, &end_key);
+          batch.DeleteRange(key, end_key);
+          stats->payload_bytes += key.size() + end_key.size();
+          ++stats->range_deletions;
+        } else {
+          Slice value = generator.Generate(value_sizes_.Size(rand.Next()));
+          batch.Put(key, value);
+          stats->payload_bytes += key.size() + value.size();
+        }
+      }
+      uint32_t count = WriteBatchInternal::Count(&batch);
+      uint64_t start = Env::Default()->NowNanos();
+      Status s;
+      if (concurrent_) {
+        WriteBatchInternal::SetSequence(&batch,
+                                        last_sequence_.fetch_add(count) + 1);
+        s = WriteBatchInternal::InsertInto(
+            &batch, &cf_mems, nullptr /* flush_scheduler */,
+            nullptr /* trim_history_scheduler */, false, 0, nullptr,
+            true /* concurrent_memtable_writes */);
+      } else {
+        // Like the write group leader, one writer at a time.
+        MutexLock l(&write_mutex_);
+        WriteBatchInternal::SetSequence(&batch,
+                                        last_sequence_.fetch_add(count) + 1);
+        s = WriteBatchInternal::InsertInto(&batch, &cf_mems, nullptr, nullptr);
+      }
+      stats->write_latency.Add(Env::Default()->NowNanos() - start);
+      if (!s.ok()) {
+        fprintf(stderr, "Write failed: %s\n", s.ToString().c_str());
+        exit(1);
+      }
+      stats->write_ops += count;
+    }
+  }
+
+  // Reads num_operations / num_readers keys, or until all the writers are
+  // done if writers_running is not nullptr.
+  void ReadThread(size_t index, size_t num_readers, bool seek,
+                  const std::atomic<size_t>* writers_running,
+                  MemTableBenchThreadStats* stats) {
+    const uint64_t num_ops = FLAGS_num_operations / num_readers;
+    Random64 rand(FLAGS_seed + 1000 + index);
+    ReadOptions read_options;
+    Arena arena;
+    ScopedArenaIterator iter;
+    if (seek) {
+      iter.set(mem_->NewIterator(read_options, &arena));
+    }
+    std::string key;
+    for (uint64_t i = 0;
+         writers_running != nullptr
+             ? writers_running->load(std::memory_order_relaxed) > 0
+             : i < num_ops;
+         ++i) {
+      uint64_t k = rand.Next() % FLAGS_num_operations;
+      bool hit;
+      uint64_t start = Env::Default()->NowNanos();
+      if (seek) {
+        k -= k % static_cast<uint64_t>(std::max(FLAGS_keys_per_prefix, 1));
+        MakeKey(k, &key);
+        Slice prefix(key.data(), 8);
+        InternalKey seek_key(key, kMaxSequenceNumber, kValueTypeForSeek);
+        iter->Seek(seek_key.Encode());
+        hit = iter->Valid() && ExtractUserKey(iter->key()).starts_with(prefix);
+        for (int n = 0; hit && n < FLAGS_seek_nexts; ++n) {
+          iter->Next();
+          if (!iter->Valid() ||
+              !ExtractUserKey(iter->key()).starts_with(prefix)) {
+            break;
+          }
+        }
+      } else {
+        MakeKey(k, &key);
+        LookupKey lookup_key(key, kMaxSequenceNumber);
+        std::string value;
+        Status s;
+        MergeContext merge_context;
+        SequenceNumber max_covering_tombstone_seq = 0;
+        hit = mem_->Get(lookup_key, &value, nullptr /* timestamp */, &s,
+                        &merge_context, &max_covering_tombstone_seq,
+                        read_options) &&
+              s.ok();
+      }
+      stats->read_latency.Add(Env::Default()->NowNanos() - start);
+      ++stats->read_ops;
+      if (hit) {
+        ++stats->read_hits;
+      }
+    }
+  }
+
+  static json LatencyToJson(const HistogramImpl& latency) {
+    json js;
+    js["p50"] = latency.Percentile(50);
+    js["p99"] = latency.Percentile(99);
+    js["p99.9"] = latency.Percentile(99.9);
+    js["max"] = latency.max();
+    return js;
+  }
+
+  void Report(const std::string& name, size_t num_writers, size_t num_readers,
+              uint64_t elapsed_nanos,
+              const std::vector<MemTableBenchThreadStats>& stats) {
+    MemTableBenchThreadStats total;
+    for (const auto& s : stats) {
+      total.write_ops += s.write_ops;
+      total.range_deletions += s.range_deletions;
+      total.payload_bytes += s.payload_bytes;
+      total.read_ops += s.read_ops;
+      total.read_hits += s.read_hits;
+      total.write_latency.Merge(s.write_latency);
+      total.read_latency.Merge(s.read_latency);
+    }
+    payload_bytes_ += total.payload_bytes;
+    double seconds = std::max(elapsed_nanos, uint64_t{1}) / 1e9;
+    uint64_t entries = mem_->num_entries();
+    size_t memory_usage = mem_->ApproximateMemoryUsage();
+    double bytes_per_entry =
+        entries == 0 ? 0 : static_cast<double>(memory_usage) / entries;
+    double overhead_per_entry =
+        entries == 0
+            ? 0
+            : (static_cast<double>(memory_usage) - payload_bytes_) / entries;
+
+    json js;
+    js["benchmark"] = name;
+    js["memtablerep"] = rep_name_;
+    js["writers"] = num_writers;
+    js["readers"] = num_readers;
+    js["concurrent_writes"] = concurrent_;
+    js["elapsed_us"] = elapsed_nanos / 1000;
+    js["write_ops"] = total.write_ops;
+    js["range_deletions"] = total.range_deletions;
+    js["write_ops_per_sec"] = total.write_ops / seconds;
+    js["write_batch_latency_ns"] = LatencyToJson(total.write_latency);
+    js["read_ops"] = total.read_ops;
+    js["read_hits"] = total.read_hits;
+    js["read_ops_per_sec"] = total.read_ops / seconds;
+    js["read_latency_ns"] = LatencyToJson(total.read_latency);
+    js["entries"] = entries;
+    js["memory_usage"] = memory_usage;
+    js["bytes_per_entry"] = bytes_per_entry;
+    js["overhead_per_entry"] = overhead_per_entry;
+
+    std::cout << "memtablerep: " << rep_name_ << ", writers: " << num_writers
+              << (concurrent_ ? " (concurrent)" : "")
+              << ", readers: " << num_readers << std::endl;
+    std::cout << "Elapsed time: " << elapsed_nanos / 1000 << " us" << std::endl;
+    if (total.write_ops > 0) {
+      std::cout << "Write ops/s: " << total.write_ops / seconds
+                << ", range deletions: " << total.range_deletions
+                << std::endl;
+      std::cout << "Write batch latency ns: "
+                << total.write_latency.ToString() << std::endl;
+    }
+    if (total.read_ops > 0) {
+      std::cout << "Read ops/s: " << total.read_ops / seconds << ", hit%: "
+                << 100.0 * total.read_hits / total.read_ops << std::endl;
+      std::cout << "Read latency ns: " << total.read_latency.ToString()
+                << std::endl;
+    }
+    std::cout << "Entries: " << entries << ", memory usage: " << memory_usage
+              << ", bytes/entry: " << bytes_per_entry
+              << ", overhead/entry: " << overhead_per_entry << std::endl;
+
+    if (FLAGS_json_output == "-") {
+      std::cout << js.dump() << std::endl;
+    } else if (!FLAGS_json_output.empty()) {
+      std::ofstream out(FLAGS_json_output, std::ios::app);
+      out << js.dump() << std::endl;
+      if (!out) {
+        fprintf(stderr, "Cannot write %s\n", FLAGS_json_output.c_str());
+        exit(1);
+      }
+    }
+  }
+
+  const std::string rep_name_;
+  const Options options_;
+  const ImmutableCFOptions ioptions_;
+  const MutableCFOptions moptions_;
+  const InternalKeyComparator icmp_;
+  WriteBufferManager wb_;
+  const SizeGenerator key_sizes_;
+  const SizeGenerator value_sizes_;
+  MemTable* mem_ = nullptr;
+  bool concurrent_ = false;
+  port::Mutex write_mutex_;
+  std::atomic<uint64_t> last_sequence_{0};
+  // User keys and values written to mem_.
+  uint64_t payload_bytes_ = 0;
+};
+
 }  // namespace ROCKSDB_NAMESPACE
 
 void PrintWarnings() {
@@ -563,45 +1202,68 @@ void PrintWarnings() {
 #endif
 }
 
-int main(int argc, char** argv) {
-  ROCKSDB_NAMESPACE::port::InstallStackTraceHandler();
-  SetUsageMessage(std::string("\nUSAGE:\n") + std::string(argv[0]) +
-                  " [OPTIONS]...");
-  ParseCommandLineFlags(&argc, &argv, true);
-
-  PrintWarnings();
+// Creates the built-in memtablerep named name, or looks it up in the JSON
+// plugin repo. Returns nullptr if it is unknown.
+std::shared_ptr<ROCKSDB_NAMESPACE::MemTableRepFactory> NewMemTableRepFactory(
+    const ROCKSDB_NAMESPACE::json& spec,
+    const ROCKSDB_NAMESPACE::JsonPluginRepo& repo, bool* needs_prefix) {
+  using ROCKSDB_NAMESPACE::MemTableRepFactory;
+  *needs_prefix = false;
+  std::string name = spec.is_string() ? spec.get<std::string>() : "";
+  if (name == "skiplist") {
+    return std::make_shared<ROCKSDB_NAMESPACE::SkipListFactory>();
+#ifndef ROCKSDB_LITE
+  } else if (name == "vector") {
+    return std::make_shared<ROCKSDB_NAMESPACE::VectorRepFactory>(
+        static_cast<size_t>(FLAGS_vectorrep_count));
+  } else if (name == "hashskiplist") {
+    *needs_prefix = true;
+    return std::shared_ptr<MemTableRepFactory>(
+        ROCKSDB_NAMESPACE::NewHashSkipListRepFactory(
+            FLAGS_bucket_count, FLAGS_hashskiplist_height,
+            FLAGS_hashskiplist_branching_factor));
+  } else if (name == "hashlinklist") {
+    *needs_prefix = true;
+    return std::shared_ptr<MemTableRepFactory>(
+        ROCKSDB_NAMESPACE::NewHashLinkListRepFactory(
+            FLAGS_bucket_count, FLAGS_huge_page_tlb_size,
+            FLAGS_bucket_entries_logging_threshold,
+            FLAGS_if_log_bucket_dist_when_flash,
+            FLAGS_threshold_use_skiplist));
+  } else if (name == "art") {
+    return std::shared_ptr<MemTableRepFactory>(
+        ROCKSDB_NAMESPACE::NewAdaptiveRadixTreeRepFactory());
+#endif  // ROCKSDB_LITE
+  }
+  // Plugins may be hash based as well.
+  *needs_prefix = true;
+  try {
+    return ROCKSDB_NAMESPACE::PluginFactorySP<
+        MemTableRepFactory>::AcquirePlugin(spec, repo);
+  } catch (const ROCKSDB_NAMESPACE::Status& s) {
+    fprintf(stdout, "%s\n", s.ToString().c_str());
+  } catch (const std::exception& e) {
+    fprintf(stdout, "%s\n", e.what());
+  }
+  return nullptr;
+}
 
+void RunBenchmarks(
+    const std::string& rep_name,
+    const std::shared_ptr<ROCKSDB_NAMESPACE::MemTableRepFactory>& factory,
+    bool needs_prefix) {
   ROCKSDB_NAMESPACE::Options options;
-
-  std::unique_ptr<ROCKSDB_NAMESPACE::MemTableRepFactory> factory;
-  if (FLAGS_memtablerep == "skiplist") {
-    factory.reset(new ROCKSDB_NAMESPACE::SkipListFactory);
-#ifndef ROCKSDB_LITE
-  } else if (FLAGS_memtablerep == "vector") {
-    factory.reset(new ROCKSDB_NAMESPACE::VectorRepFactory);
-  } else if (FLAGS_memtablerep == "hashskiplist") {
-    factory.reset(ROCKSDB_NAMESPACE::NewHashSkipListRepFactory(
-        FLAGS_bucket_count, FLAGS_hashskiplist_height,
-        FLAGS_hashskiplist_branching_factor));
-    options.prefix_extractor.reset(
-        ROCKSDB_NAMESPACE::NewFixedPrefixTransform(FLAGS_prefix_length));
-  } else if (FLAGS_memtablerep == "hashlinklist") {
-    factory.reset(ROCKSDB_NAMESPACE::NewHashLinkListRepFactory(
-        FLAGS_bucket_count, FLAGS_huge_page_tlb_size,
-        FLAGS_bucket_entries_logging_threshold,
-        FLAGS_if_log_bucket_dist_when_flash, FLAGS_threshold_use_skiplist));
+  if (needs_prefix) {
     options.prefix_extractor.reset(
         ROCKSDB_NAMESPACE::NewFixedPrefixTransform(FLAGS_prefix_length));
-#endif  // ROCKSDB_LITE
-  } else {
-    fprintf(stdout, "Unknown memtablerep: %s\n", FLAGS_memtablerep.c_str());
-    exit(1);
   }
 
   ROCKSDB_NAMESPACE::InternalKeyComparator internal_key_comp(
       ROCKSDB_NAMESPACE::BytewiseComparator());
   ROCKSDB_NAMESPACE::MemTable::KeyComparator key_comp(internal_key_comp);
-  ROCKSDB_NAMESPACE::Arena arena;
+  // Like the arena of MemTable, so that fillrandomconcurrent can allocate
+  // from several threads.
+  ROCKSDB_NAMESPACE::ConcurrentArena arena;
   ROCKSDB_NAMESPACE::WriteBufferManager wb(FLAGS_write_buffer_size);
   uint64_t sequence;
   auto createMemtableRep = [&] {
@@ -611,6 +1273,7 @@ int main(int argc, char** argv) {
                                       options.info_log.get());
   };
   std::unique_ptr<ROCKSDB_NAMESPACE::MemTableRep> memtablerep;
+  std::unique_ptr<ROCKSDB_NAMESPACE::MemTableBenchmark> memtable_benchmark;
   ROCKSDB_NAMESPACE::Random64 rng(FLAGS_seed);
   const char* benchmarks = FLAGS_benchmarks.c_str();
   while (benchmarks != nullptr) {
@@ -625,7 +1288,15 @@ int main(int argc, char** argv) {
       benchmarks = sep + 1;
     }
     std::unique_ptr<ROCKSDB_NAMESPACE::Benchmark> benchmark;
-    if (name == ROCKSDB_NAMESPACE::Slice("fillseq")) {
+    if (ROCKSDB_NAMESPACE::MemTableBenchmark::IsMemTableBenchmark(name)) {
+      if (memtable_benchmark == nullptr) {
+        memtable_benchmark.reset(
+            new ROCKSDB_NAMESPACE::MemTableBenchmark(rep_name, factory));
+      }
+      std::cout << "Running " << name.ToString() << std::endl;
+      memtable_benchmark->Run(name);
+      continue;
+    } else if (name == ROCKSDB_NAMESPACE::Slice("fillseq")) {
       memtablerep.reset(createMemtableRep());
       key_gen.reset(new ROCKSDB_NAMESPACE::KeyGenerator(
           &rng, ROCKSDB_NAMESPACE::SEQUENTIAL, FLAGS_num_operations));
@@ -637,11 +1308,26 @@ int main(int argc, char** argv) {
           &rng, ROCKSDB_NAMESPACE::UNIQUE_RANDOM, FLAGS_num_operations));
       benchmark.reset(new ROCKSDB_NAMESPACE::FillBenchmark(
           memtablerep.get(), key_gen.get(), &sequence));
+    } else if (name == ROCKSDB_NAMESPACE::Slice("fillrandomconcurrent")) {
+      if (!factory->IsInsertConcurrentlySupported()) {
+        std::cout << "WARNING: skipping fillrandomconcurrent, "
+                  << rep_name << " does not support concurrent inserts"
+                  << std::endl;
+        continue;
+      }
+      memtablerep.reset(createMemtableRep());
+      benchmark.reset(new ROCKSDB_NAMESPACE::ConcurrentFillBenchmark(
+          memtablerep.get(), &rng, &sequence));
     } else if (name == ROCKSDB_NAMESPACE::Slice("readrandom")) {
       key_gen.reset(new ROCKSDB_NAMESPACE::KeyGenerator(
           &rng, ROCKSDB_NAMESPACE::RANDOM, FLAGS_num_operations));
       benchmark.reset(new ROCKSDB_NAMESPACE::ReadBenchmark(
           memtablerep.get(), key_gen.get(), &sequence));
+    } else if (name == ROCKSDB_NAMESPACE::Slice("seekrandom")) {
+      key_gen.reset(new ROCKSDB_NAMESPACE::KeyGenerator(
+          &rng, ROCKSDB_NAMESPACE::RANDOM, FLAGS_num_operations));
+      benchmark.reset(new ROCKSDB_NAMESPACE::SeekBenchmark(
+          memtablerep.get(), key_gen.get(), &sequence));
     } else if (name == ROCKSDB_NAMESPACE::Slice("readseq")) {
       key_gen.reset(new ROCKSDB_NAMESPACE::KeyGenerator(
           &rng, ROCKSDB_NAMESPACE::SEQUENTIAL, FLAGS_num_operations));
@@ -669,6 +1355,59 @@ int main(int argc, char** argv) {
     std::cout << "Running " << name.ToString() << std::endl;
     benchmark->Run();
   }
+}
+
+int main(int argc, char** argv) {
+  ROCKSDB_NAMESPACE::port::InstallStackTraceHandler();
+  SetUsageMessage(std::string("\nUSAGE:\n") + std::string(argv[0]) +
+                  " [OPTIONS]...");
+  ParseCommandLineFlags(&argc, &argv, true);
+
+  PrintWarnings();
+
+  ROCKSDB_NAMESPACE::JsonPluginRepo repo;
+  if (!FLAGS_json.empty()) {
+    ROCKSDB_NAMESPACE::Status s = repo.ImportJsonFile(FLAGS_json);
+    if (!s.ok()) {
+      fprintf(stderr, "Cannot import %s: %s\n", FLAGS_json.c_str(),
+              s.ToString().c_str());
+      exit(1);
+    }
+  }
+
+  ROCKSDB_NAMESPACE::json reps = ROCKSDB_NAMESPACE::json::array();
+  if (FLAGS_memtablerep == "all") {
+    reps = {"skiplist", "vector", "hashskiplist", "hashlinklist", "art"};
+  } else if (!FLAGS_memtablerep.empty() &&
+             (FLAGS_memtablerep[0] == '[' || FLAGS_memtablerep[0] == '{')) {
+    try {
+      reps = ROCKSDB_NAMESPACE::json::parse(FLAGS_memtablerep);
+    } catch (const std::exception& e) {
+      fprintf(stderr, "Bad memtablerep: %s\n", e.what());
+      exit(1);
+    }
+    if (!reps.is_array()) {
+      reps = ROCKSDB_NAMESPACE::json::array({reps});
+    }
+  } else {
+    for (const std::string& name :
+         ROCKSDB_NAMESPACE::StringSplit(FLAGS_memtablerep, ',')) {
+      reps.push_back(name);
+    }
+  }
+
+  for (const auto& spec : reps) {
+    std::string rep_name =
+        spec.is_string() ? spec.get<std::string>() : spec.dump();
+    bool needs_prefix;
+    auto factory = NewMemTableRepFactory(spec, repo, &needs_prefix);
+    if (factory == nullptr) {
+      fprintf(stdout, "Unknown memtablerep: %s\n", rep_name.c_str());
+      exit(1);
+    }
+    std::cout << "memtablerep: " << rep_name << std::endl;
+    RunBenchmarks(rep_name, factory, needs_prefix);
+  }
 
   return 0;
 }
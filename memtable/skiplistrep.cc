@@ -10,17 +10,42 @@
 
 namespace ROCKSDB_NAMESPACE {
 namespace {
+// Compares the keys of the skip list like MemTable::KeyComparator of
+// BytewiseComparator() or ReverseBytewiseComparator(), but inline instead of
+// through two virtual calls per comparison.
+template <bool kReverse>
+struct BytewiseKeyComparator {
+  typedef Slice DecodedType;
+
+  DecodedType decode_key(const char* key) const {
+    return GetLengthPrefixedSlice(key);
+  }
+
+  int operator()(const char* prefix_len_key1,
+                 const char* prefix_len_key2) const {
+    return BytewiseInternalKeyComparator<kReverse>::CompareKeySeq(
+        GetLengthPrefixedSlice(prefix_len_key1),
+        GetLengthPrefixedSlice(prefix_len_key2));
+  }
+
+  int operator()(const char* prefix_len_key, const Slice& key) const {
+    return BytewiseInternalKeyComparator<kReverse>::CompareKeySeq(
+        GetLengthPrefixedSlice(prefix_len_key), key);
+  }
+};
+
+// Cmp is const MemTableRep::KeyComparator&, or a BytewiseKeyComparator.
+template <class Cmp>
 class SkipListRep : public MemTableRep {
-  InlineSkipList<const MemTableRep::KeyComparator&> skip_list_;
-  const MemTableRep::KeyComparator& cmp_;
+  InlineSkipList<Cmp> skip_list_;
+  Cmp cmp_;
   const SliceTransform* transform_;
   const size_t lookahead_;
 
   friend class LookaheadIterator;
 public:
- explicit SkipListRep(const MemTableRep::KeyComparator& compare,
-                      Allocator* allocator, const SliceTransform* transform,
-                      const size_t lookahead)
+ explicit SkipListRep(Cmp compare, Allocator* allocator,
+                      const SliceTransform* transform, const size_t lookahead)
      : MemTableRep(allocator),
        skip_list_(compare, allocator),
        cmp_(compare),
@@ -101,14 +126,12 @@ public:
 
   // Iteration over the contents of a skip list
   class Iterator : public MemTableRep::Iterator {
-    InlineSkipList<const MemTableRep::KeyComparator&>::Iterator iter_;
+    typename InlineSkipList<Cmp>::Iterator iter_;
 
    public:
     // Initialize an iterator over the specified list.
     // The returned iterator is not valid.
-    explicit Iterator(
-        const InlineSkipList<const MemTableRep::KeyComparator&>* list)
-        : iter_(list) {}
+    explicit Iterator(const InlineSkipList<Cmp>* list) : iter_(list) {}
 
     ~Iterator() override {}
 
@@ -253,8 +276,8 @@ public:
 
    private:
     const SkipListRep& rep_;
-    InlineSkipList<const MemTableRep::KeyComparator&>::Iterator iter_;
-    InlineSkipList<const MemTableRep::KeyComparator&>::Iterator prev_;
+    typename InlineSkipList<Cmp>::Iterator iter_;
+    typename InlineSkipList<Cmp>::Iterator prev_;
   };
 
   MemTableRep::Iterator* GetIterator(Arena* arena = nullptr) override {
@@ -276,7 +299,19 @@ public:
 MemTableRep* SkipListFactory::CreateMemTableRep(
     const MemTableRep::KeyComparator& compare, Allocator* allocator,
     const SliceTransform* transform, Logger* /*logger*/) {
-  return new SkipListRep(compare, allocator, transform, lookahead_);
+  const InternalKeyComparator* icmp = compare.icomparator();
+  switch (icmp != nullptr ? GetUserComparatorKind(icmp->user_comparator())
+                          : UserComparatorKind::kOther) {
+    case UserComparatorKind::kBytewise:
+      return new SkipListRep<BytewiseKeyComparator<false>>(
+          BytewiseKeyComparator<false>(), allocator, transform, lookahead_);
+    case UserComparatorKind::kReverseBytewise:
+      return new SkipListRep<BytewiseKeyComparator<true>>(
+          BytewiseKeyComparator<true>(), allocator, transform, lookahead_);
+    default:
+      return new SkipListRep<const MemTableRep::KeyComparator&>(
+          compare, allocator, transform, lookahead_);
+  }
 }
 
 }  // namespace ROCKSDB_NAMESPACE
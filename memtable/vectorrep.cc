@@ -10,12 +10,15 @@
 #include <set>
 #include <memory>
 #include <algorithm>
+#include <functional>
+#include <thread>
 #include <type_traits>
 
 #include "db/memtable.h"
 #include "memory/arena.h"
 #include "memtable/stl_wrappers.h"
 #include "port/port.h"
+#include "util/core_local.h"
 #include "util/mutexlock.h"
 
 namespace ROCKSDB_NAMESPACE {
@@ -23,9 +26,110 @@ namespace {
 
 using namespace stl_wrappers;
 
+typedef std::vector<const char*> Bucket;
+
+// Below this number of entries per thread, a bucket is sorted by the calling
+// thread alone.
+const size_t kMinEntriesPerSortThread = 64 << 10;
+
+// Runs task(0), ..., task(num_tasks - 1) on the calling thread and
+// num_tasks - 1 dedicated threads. The memtable rep has no access to the
+// background thread pools, and a flush thread waiting on tasks queued in its
+// own pool could deadlock.
+void RunInParallel(size_t num_tasks, const std::function<void(size_t)>& task) {
+  std::vector<port::Thread> threads;
+  threads.reserve(num_tasks - 1);
+  for (size_t i = 1; i < num_tasks; i++) {
+    threads.emplace_back(task, i);
+  }
+  task(0);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+// Merges the sorted ranges [a, a + na) and [b, b + nb) into out, taking the
+// entries of a first on ties like std::merge. Each of the num_threads threads
+// writes a slice of out, whose start in a and b is found by binary search.
+void ParallelMerge(const char* const* a, size_t na, const char* const* b,
+                   size_t nb, const char** out, const Compare& cmp,
+                   size_t num_threads) {
+  const size_t n = na + nb;
+  // Returns the number of entries of a among the first p entries of out.
+  auto split = [&](size_t p) {
+    size_t lo = p > nb ? p - nb : 0;
+    size_t hi = std::min(p, na);
+    while (lo < hi) {
+      size_t i = lo + (hi - lo) / 2;
+      if (cmp(b[p - i - 1], a[i])) {
+        hi = i;
+      } else {
+        lo = i + 1;
+      }
+    }
+    return lo;
+  };
+  RunInParallel(num_threads, [&](size_t t) {
+    const size_t begin = n * t / num_threads;
+    const size_t end = n * (t + 1) / num_threads;
+    const size_t a_begin = split(begin);
+    const size_t a_end = split(end);
+    std::merge(a + a_begin, a + a_end, b + (begin - a_begin),
+               b + (end - a_end), out + begin, cmp);
+  });
+}
+
+// Sorts bucket with up to sort_threads threads: each thread sorts a slice,
+// then the sorted slices are merged pairwise, each merge using all threads.
+void SortBucket(Bucket* bucket, const MemTableRep::KeyComparator& compare,
+                size_t sort_threads) {
+  Compare cmp(compare);
+  const size_t n = bucket->size();
+  const size_t num_threads = std::min(sort_threads, n / kMinEntriesPerSortThread);
+  if (num_threads <= 1) {
+    std::sort(bucket->begin(), bucket->end(), cmp);
+    return;
+  }
+
+  // bounds[i] is the start of the i-th sorted run.
+  std::vector<size_t> bounds;
+  for (size_t i = 0; i <= num_threads; i++) {
+    bounds.push_back(n * i / num_threads);
+  }
+  const char** src = bucket->data();
+  RunInParallel(num_threads, [&](size_t i) {
+    std::sort(src + bounds[i], src + bounds[i + 1], cmp);
+  });
+
+  Bucket tmp(n);
+  const char** dst = tmp.data();
+  while (bounds.size() > 2) {
+    std::vector<size_t> merged;
+    size_t r = 0;
+    for (; r + 2 < bounds.size(); r += 2) {
+      merged.push_back(bounds[r]);
+      ParallelMerge(src + bounds[r], bounds[r + 1] - bounds[r],
+                    src + bounds[r + 1], bounds[r + 2] - bounds[r + 1],
+                    dst + bounds[r], cmp, num_threads);
+    }
+    if (r + 1 < bounds.size()) {
+      // An odd run is left, it is merged in the next round.
+      merged.push_back(bounds[r]);
+      std::copy(src + bounds[r], src + n, dst + bounds[r]);
+    }
+    merged.push_back(n);
+    bounds.swap(merged);
+    std::swap(src, dst);
+  }
+  if (src != bucket->data()) {
+    bucket->swap(tmp);
+  }
+}
+
 class VectorRep : public MemTableRep {
  public:
-  VectorRep(const KeyComparator& compare, Allocator* allocator, size_t count);
+  VectorRep(const KeyComparator& compare, Allocator* allocator, size_t count,
+            size_t sort_threads);
 
   // Insert key into the collection. (The caller will pack key and value into a
   // single buffer and pass that in as the parameter to Insert)
@@ -33,6 +137,9 @@ class VectorRep : public MemTableRep {
   // collection.
   void Insert(KeyHandle handle) override;
 
+  // Like Insert(handle), but may be called concurrently with other inserts.
+  void InsertConcurrently(KeyHandle handle) override;
+
   // Returns true iff an entry that compares equal to key is in the collection.
   bool Contains(const Slice& internal_key) const override;
 
@@ -50,13 +157,14 @@ class VectorRep : public MemTableRep {
     std::shared_ptr<std::vector<const char*>> bucket_;
     std::vector<const char*>::const_iterator mutable cit_;
     const KeyComparator& compare_;
+    const size_t sort_threads_;
     std::string tmp_;       // For passing to EncodeKey
     bool mutable sorted_;
     void DoSort() const;
    public:
     explicit Iterator(class VectorRep* vrep,
       std::shared_ptr<std::vector<const char*>> bucket,
-      const KeyComparator& compare);
+      const KeyComparator& compare, size_t sort_threads);
 
     // Initialize an iterator over the specified collection.
     // The returned iterator is not valid.
@@ -98,19 +206,64 @@ class VectorRep : public MemTableRep {
 
  private:
   friend class Iterator;
-  typedef std::vector<const char*> Bucket;
+
+  // The per-core append buffers of a mutable VectorRep.
+  struct Shard {
+    char padding[40] ROCKSDB_FIELD_UNUSED;
+    mutable SpinMutex mutex;
+    Bucket bucket;
+    // bucket.size(), readable without the mutex.
+    std::atomic<size_t> num_entries;
+
+    Shard() : num_entries(0) {}
+  };
+
+  void Append(const char* key);
+
+  // Returns a copy of the entries of all shards.
+  // REQUIRES: !immutable_
+  std::shared_ptr<Bucket> CopyShards() const;
+
+  CoreLocalArray<Shard> shards_;
+  // All the entries once immutable_ is set.
   std::shared_ptr<Bucket> bucket_;
   mutable port::RWMutex rwlock_;
   bool immutable_;
   bool sorted_;
   const KeyComparator& compare_;
+  const size_t sort_threads_;
 };
 
-void VectorRep::Insert(KeyHandle handle) {
-  auto* key = static_cast<char*>(handle);
-  WriteLock l(&rwlock_);
+void VectorRep::Append(const char* key) {
   assert(!immutable_);
-  bucket_->push_back(key);
+  Shard* shard = shards_.Access();
+  std::lock_guard<SpinMutex> lock(shard->mutex);
+  shard->bucket.push_back(key);
+  shard->num_entries.store(shard->bucket.size(), std::memory_order_relaxed);
+}
+
+void VectorRep::Insert(KeyHandle handle) {
+  Append(static_cast<char*>(handle));
+}
+
+void VectorRep::InsertConcurrently(KeyHandle handle) {
+  Append(static_cast<char*>(handle));
+}
+
+std::shared_ptr<Bucket> VectorRep::CopyShards() const {
+  std::shared_ptr<Bucket> bucket(new Bucket());
+  size_t num_entries = 0;
+  for (size_t i = 0; i < shards_.Size(); i++) {
+    num_entries +=
+        shards_.AccessAtCore(i)->num_entries.load(std::memory_order_relaxed);
+  }
+  bucket->reserve(num_entries);
+  for (size_t i = 0; i < shards_.Size(); i++) {
+    Shard* shard = shards_.AccessAtCore(i);
+    std::lock_guard<SpinMutex> lock(shard->mutex);
+    bucket->insert(bucket->end(), shard->bucket.begin(), shard->bucket.end());
+  }
+  return bucket;
 }
 
 // Returns true iff an entry that compares equal to key is in the collection.
@@ -118,41 +271,78 @@ bool VectorRep::Contains(const Slice& internal_key) const {
   std::string memtable_key;
   EncodeKey(&memtable_key, internal_key);
   ReadLock l(&rwlock_);
-  return std::find(bucket_->begin(), bucket_->end(), memtable_key.data()) !=
-         bucket_->end();
+  if (immutable_) {
+    return std::find(bucket_->begin(), bucket_->end(), memtable_key.data()) !=
+           bucket_->end();
+  }
+  for (size_t i = 0; i < shards_.Size(); i++) {
+    Shard* shard = shards_.AccessAtCore(i);
+    std::lock_guard<SpinMutex> lock(shard->mutex);
+    if (std::find(shard->bucket.begin(), shard->bucket.end(),
+                  memtable_key.data()) != shard->bucket.end()) {
+      return true;
+    }
+  }
+  return false;
 }
 
 void VectorRep::MarkReadOnly() {
   WriteLock l(&rwlock_);
+  // Writes to the memtable are over, so the shards are not locked.
+  size_t num_entries = 0;
+  for (size_t i = 0; i < shards_.Size(); i++) {
+    num_entries += shards_.AccessAtCore(i)->bucket.size();
+  }
+  for (size_t i = 0; i < shards_.Size(); i++) {
+    Shard* shard = shards_.AccessAtCore(i);
+    if (shard->bucket.size() == num_entries) {
+      // All entries were appended on one core.
+      bucket_->swap(shard->bucket);
+    } else if (!shard->bucket.empty()) {
+      bucket_->reserve(num_entries);
+      bucket_->insert(bucket_->end(), shard->bucket.begin(),
+                      shard->bucket.end());
+    }
+    Bucket().swap(shard->bucket);
+  }
   immutable_ = true;
 }
 
 size_t VectorRep::ApproximateMemoryUsage() {
+  size_t num_entries = 0;
+  for (size_t i = 0; i < shards_.Size(); i++) {
+    num_entries +=
+        shards_.AccessAtCore(i)->num_entries.load(std::memory_order_relaxed);
+  }
   return
-    sizeof(bucket_) + sizeof(*bucket_) +
-    bucket_->size() *
+    sizeof(bucket_) + sizeof(*bucket_) + shards_.Size() * sizeof(Shard) +
+    num_entries *
     sizeof(
       std::remove_reference<decltype(*bucket_)>::type::value_type
     );
 }
 
 VectorRep::VectorRep(const KeyComparator& compare, Allocator* allocator,
-                     size_t count)
+                     size_t count, size_t sort_threads)
     : MemTableRep(allocator),
       bucket_(new Bucket()),
       immutable_(false),
       sorted_(false),
-      compare_(compare) {
-  bucket_.get()->reserve(count);
+      compare_(compare),
+      sort_threads_(sort_threads > 0 ? sort_threads
+                                     : std::thread::hardware_concurrency()) {
+  // Entries are usually appended from one core, unless inserted concurrently.
+  shards_.Access()->bucket.reserve(count);
 }
 
 VectorRep::Iterator::Iterator(class VectorRep* vrep,
                    std::shared_ptr<std::vector<const char*>> bucket,
-                   const KeyComparator& compare)
+                   const KeyComparator& compare, size_t sort_threads)
 : vrep_(vrep),
   bucket_(bucket),
   cit_(bucket_->end()),
   compare_(compare),
+  sort_threads_(sort_threads),
   sorted_(false) { }
 
 void VectorRep::Iterator::DoSort() const {
@@ -160,14 +350,14 @@ void VectorRep::Iterator::DoSort() const {
   if (!sorted_ && vrep_ != nullptr) {
     WriteLock l(&vrep_->rwlock_);
     if (!vrep_->sorted_) {
-      std::sort(bucket_->begin(), bucket_->end(), Compare(compare_));
+      SortBucket(bucket_.get(), compare_, sort_threads_);
       cit_ = bucket_->begin();
       vrep_->sorted_ = true;
     }
     sorted_ = true;
   }
   if (!sorted_) {
-    std::sort(bucket_->begin(), bucket_->end(), Compare(compare_));
+    SortBucket(bucket_.get(), compare_, sort_threads_);
     cit_ = bucket_->begin();
     sorted_ = true;
   }
@@ -263,9 +453,10 @@ void VectorRep::Get(const LookupKey& k, void* callback_args,
     vector_rep = this;
   } else {
     vector_rep = nullptr;
-    bucket.reset(new Bucket(*bucket_));  // make a copy
+    bucket = CopyShards();
   }
-  VectorRep::Iterator iter(vector_rep, immutable_ ? bucket_ : bucket, compare_);
+  VectorRep::Iterator iter(vector_rep, immutable_ ? bucket_ : bucket, compare_,
+                           sort_threads_);
   rwlock_.ReadUnlock();
 
   for (iter.Seek(k.user_key(), k.memtable_key().data());
@@ -283,17 +474,16 @@ MemTableRep::Iterator* VectorRep::GetIterator(Arena* arena) {
   // a Seek is performed on the iterator.
   if (immutable_) {
     if (arena == nullptr) {
-      return new Iterator(this, bucket_, compare_);
+      return new Iterator(this, bucket_, compare_, sort_threads_);
     } else {
-      return new (mem) Iterator(this, bucket_, compare_);
+      return new (mem) Iterator(this, bucket_, compare_, sort_threads_);
     }
   } else {
-    std::shared_ptr<Bucket> tmp;
-    tmp.reset(new Bucket(*bucket_)); // make a copy
+    std::shared_ptr<Bucket> tmp = CopyShards();
     if (arena == nullptr) {
-      return new Iterator(nullptr, tmp, compare_);
+      return new Iterator(nullptr, tmp, compare_, sort_threads_);
     } else {
-      return new (mem) Iterator(nullptr, tmp, compare_);
+      return new (mem) Iterator(nullptr, tmp, compare_, sort_threads_);
     }
   }
 }
@@ -302,7 +492,7 @@ MemTableRep::Iterator* VectorRep::GetIterator(Arena* arena) {
 MemTableRep* VectorRepFactory::CreateMemTableRep(
     const MemTableRep::KeyComparator& compare, Allocator* allocator,
     const SliceTransform*, Logger* /*logger*/) {
-  return new VectorRep(compare, allocator, count_);
+  return new VectorRep(compare, allocator, count_, sort_threads_);
 }
 }  // namespace ROCKSDB_NAMESPACE
 #endif  // ROCKSDB_LITE
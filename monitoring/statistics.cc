@@ -192,6 +192,8 @@ const std::vector<std::pair<Tickers, std::string>> TickersNameMap = {
      "rocksdb.block.cache.compression.dict.add.redundant"},
     {FILES_MARKED_TRASH, "rocksdb.files.marked.trash"},
     {FILES_DELETED_IMMEDIATELY, "rocksdb.files.deleted.immediately"},
+    {SECONDARY_CACHE_HITS, "rocksdb.secondary.cache.hits"},
+    {SECONDARY_CACHE_MISSES, "rocksdb.secondary.cache.misses"},
 };
 
 const std::vector<std::pair<Histograms, std::string>> HistogramsNameMap = {
@@ -113,6 +113,8 @@ struct ImmutableCFOptions {
 
   std::shared_ptr<Cache> row_cache;
 
+  ArenaBlockPool* arena_block_pool;
+
   const SliceTransform* memtable_insert_with_hint_prefix_extractor;
 
   std::vector<DbPath> cf_paths;
@@ -136,6 +138,8 @@ struct MutableCFOptions {
             options.memtable_prefix_bloom_size_ratio),
         memtable_whole_key_filtering(options.memtable_whole_key_filtering),
         memtable_huge_page_size(options.memtable_huge_page_size),
+        memtable_numa_aware(options.memtable_numa_aware),
+        mempurge_threshold(options.mempurge_threshold),
         max_successive_merges(options.max_successive_merges),
         inplace_update_num_locks(options.inplace_update_num_locks),
         prefix_extractor(options.prefix_extractor),
@@ -185,6 +189,8 @@ struct MutableCFOptions {
         memtable_prefix_bloom_size_ratio(0),
         memtable_whole_key_filtering(false),
         memtable_huge_page_size(0),
+        memtable_numa_aware(false),
+        mempurge_threshold(0.0),
         max_successive_merges(0),
         inplace_update_num_locks(0),
         prefix_extractor(nullptr),
@@ -240,6 +246,8 @@ struct MutableCFOptions {
   double memtable_prefix_bloom_size_ratio;
   bool memtable_whole_key_filtering;
   size_t memtable_huge_page_size;
+  bool memtable_numa_aware;
+  double mempurge_threshold;
   size_t max_successive_merges;
   size_t inplace_update_num_locks;
   std::shared_ptr<const SliceTransform> prefix_extractor;
@@ -106,6 +106,7 @@ DBOptions BuildDBOptions(const ImmutableDBOptions& immutable_db_options,
   options.advise_random_on_open = immutable_db_options.advise_random_on_open;
   options.db_write_buffer_size = immutable_db_options.db_write_buffer_size;
   options.write_buffer_manager = immutable_db_options.write_buffer_manager;
+  options.arena_block_pool = immutable_db_options.arena_block_pool;
   options.access_hint_on_compaction_start =
       immutable_db_options.access_hint_on_compaction_start;
   options.new_table_reader_for_compaction_inputs =
@@ -155,6 +156,7 @@ DBOptions BuildDBOptions(const ImmutableDBOptions& immutable_db_options,
       immutable_db_options.preserve_deletes;
   options.two_write_queues = immutable_db_options.two_write_queues;
   options.manual_wal_flush = immutable_db_options.manual_wal_flush;
+  options.wal_compression = immutable_db_options.wal_compression;
   options.atomic_flush = immutable_db_options.atomic_flush;
   options.avoid_unnecessary_blocking_io =
       immutable_db_options.avoid_unnecessary_blocking_io;
@@ -166,6 +168,10 @@ DBOptions BuildDBOptions(const ImmutableDBOptions& immutable_db_options,
       immutable_db_options.max_bgerror_resume_count;
   options.bgerror_resume_retry_interval =
       immutable_db_options.bgerror_resume_retry_interval;
+  options.persist_block_cache_keys =
+      immutable_db_options.persist_block_cache_keys;
+  options.block_cache_warmup_threads =
+      immutable_db_options.block_cache_warmup_threads;
   return options;
 }
 
@@ -183,6 +189,8 @@ ColumnFamilyOptions BuildColumnFamilyOptions(
   cf_opts.memtable_whole_key_filtering =
       mutable_cf_options.memtable_whole_key_filtering;
   cf_opts.memtable_huge_page_size = mutable_cf_options.memtable_huge_page_size;
+  cf_opts.memtable_numa_aware = mutable_cf_options.memtable_numa_aware;
+  cf_opts.mempurge_threshold = mutable_cf_options.mempurge_threshold;
   cf_opts.max_successive_merges = mutable_cf_options.max_successive_merges;
   cf_opts.inplace_update_num_locks =
       mutable_cf_options.inplace_update_num_locks;
@@ -25,6 +25,11 @@
 #include <sys/time.h>
 #include <unistd.h>
 #include <cstdlib>
+#include <vector>
+#ifdef NUMA
+#include <numa.h>
+#include <numaif.h>
+#endif
 #include "logging/logging.h"
 
 namespace ROCKSDB_NAMESPACE {
@@ -178,6 +183,68 @@ int PhysicalCoreID() {
 #endif
 }
 
+int GetNumaNodeCount() {
+#ifdef NUMA
+  static const int num_nodes =
+      numa_available() < 0 ? 1 : numa_max_node() + 1;
+  return num_nodes;
+#else
+  return 1;
+#endif
+}
+
+int GetCurrentNumaNode() {
+#if defined(NUMA) && defined(ROCKSDB_SCHED_GETCPU_PRESENT)
+  // numa_node_of_cpu() scans the CPU masks of the nodes, so map the CPUs to
+  // their node once.
+  static const std::vector<int> cpu_to_node = []() {
+    std::vector<int> nodes;
+    if (numa_available() >= 0) {
+      nodes.resize(static_cast<size_t>(numa_num_configured_cpus()), 0);
+      for (size_t cpu = 0; cpu < nodes.size(); cpu++) {
+        int node = numa_node_of_cpu(static_cast<int>(cpu));
+        nodes[cpu] = node < 0 ? 0 : node;
+      }
+    }
+    return nodes;
+  }();
+  int cpu = sched_getcpu();
+  if (cpu < 0 || static_cast<size_t>(cpu) >= cpu_to_node.size()) {
+    return 0;
+  }
+  return cpu_to_node[cpu];
+#else
+  return 0;
+#endif
+}
+
+void BindMemoryToNumaNode(void* p, size_t size, int numa_node) {
+#ifdef NUMA
+  if (GetNumaNodeCount() <= 1 || numa_node < 0) {
+    return;
+  }
+  const uintptr_t page_size = static_cast<uintptr_t>(getpagesize());
+  uintptr_t begin = reinterpret_cast<uintptr_t>(p);
+  uintptr_t end = begin + size;
+  begin = (begin + page_size - 1) & ~(page_size - 1);
+  end &= ~(page_size - 1);
+  if (begin >= end) {
+    return;
+  }
+  struct bitmask* nodes = numa_allocate_nodemask();
+  numa_bitmask_setbit(nodes, static_cast<unsigned int>(numa_node));
+  // Only a preference: the memory comes from other nodes when the node is
+  // full. Failures are ignored, the memory is just not bound.
+  mbind(reinterpret_cast<void*>(begin), end - begin, MPOL_PREFERRED,
+        nodes->maskp, nodes->size + 1, 0);
+  numa_free_nodemask(nodes);
+#else
+  (void)p;
+  (void)size;
+  (void)numa_node;
+#endif
+}
+
 void InitOnce(OnceType* once, void (*initializer)()) {
   PthreadCall("once", pthread_once(once, initializer));
 }
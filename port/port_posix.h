@@ -177,6 +177,18 @@ static inline void AsmVolatilePause() {
 // Returns -1 if not available on this platform
 extern int PhysicalCoreID();
 
+// The number of NUMA nodes, 1 unless RocksDB is built with NUMA support
+// (libnuma) and the system has several nodes.
+extern int GetNumaNodeCount();
+
+// The NUMA node of the CPU the calling thread runs on, 0 if unknown.
+extern int GetCurrentNumaNode();
+
+// Prefer NUMA node numa_node for the physical memory of the pages entirely
+// within [p, p + size) that are not allocated yet. Does nothing without NUMA
+// support.
+extern void BindMemoryToNumaNode(void* p, size_t size, int numa_node);
+
 typedef pthread_once_t OnceType;
 #define LEVELDB_ONCE_INIT PTHREAD_ONCE_INIT
 extern void InitOnce(OnceType* once, void (*initializer)());
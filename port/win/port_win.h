@@ -291,6 +291,12 @@ static inline void AsmVolatilePause() {
 
 extern int PhysicalCoreID();
 
+// NUMA is not supported on Windows: a single node.
+inline int GetNumaNodeCount() { return 1; }
+inline int GetCurrentNumaNode() { return 0; }
+inline void BindMemoryToNumaNode(void* /*p*/, size_t /*size*/,
+                                 int /*numa_node*/) {}
+
 // For Thread Local Storage abstraction
 typedef DWORD pthread_key_t;
 
@@ -241,14 +241,16 @@ void DataBlockIter::SeekImpl(const Slice& target) {
   if (data_ == nullptr) {  // Not init yet
     return;
   }
-  uint32_t index = 0;
-  bool skip_linear_scan = false;
-  bool ok = BinarySeek<DecodeKey>(seek_key, &index, &skip_linear_scan);
+  WithKeyComparator([&](const auto& cmp) {
+    uint32_t index = 0;
+    bool skip_linear_scan = false;
+    bool ok = BinarySeek<DecodeKey>(cmp, seek_key, &index, &skip_linear_scan);
 
-  if (!ok) {
-    return;
-  }
-  FindKeyAfterBinarySeek(seek_key, index, skip_linear_scan);
+    if (!ok) {
+      return;
+    }
+    FindKeyAfterBinarySeek(cmp, seek_key, index, skip_linear_scan);
+  });
 }
 
 // Optimized Seek for point lookup for an internal key `target`
@@ -398,15 +400,15 @@ void IndexBlockIter::SeekImpl(const Slice& target) {
     // search simply lands at the right place.
     skip_linear_scan = true;
   } else if (value_delta_encoded_) {
-    ok = BinarySeek<DecodeKeyV4>(seek_key, &index, &skip_linear_scan);
+    ok = BinarySeek<DecodeKeyV4>(icmp(), seek_key, &index, &skip_linear_scan);
   } else {
-    ok = BinarySeek<DecodeKey>(seek_key, &index, &skip_linear_scan);
+    ok = BinarySeek<DecodeKey>(icmp(), seek_key, &index, &skip_linear_scan);
   }
 
   if (!ok) {
     return;
   }
-  FindKeyAfterBinarySeek(seek_key, index, skip_linear_scan);
+  FindKeyAfterBinarySeek(icmp(), seek_key, index, skip_linear_scan);
 }
 
 void DataBlockIter::SeekForPrevImpl(const Slice& target) {
@@ -415,22 +417,24 @@ void DataBlockIter::SeekForPrevImpl(const Slice& target) {
   if (data_ == nullptr) {  // Not init yet
     return;
   }
-  uint32_t index = 0;
-  bool skip_linear_scan = false;
-  bool ok = BinarySeek<DecodeKey>(seek_key, &index, &skip_linear_scan);
+  WithKeyComparator([&](const auto& cmp) {
+    uint32_t index = 0;
+    bool skip_linear_scan = false;
+    bool ok = BinarySeek<DecodeKey>(cmp, seek_key, &index, &skip_linear_scan);
 
-  if (!ok) {
-    return;
-  }
-  FindKeyAfterBinarySeek(seek_key, index, skip_linear_scan);
+    if (!ok) {
+      return;
+    }
+    FindKeyAfterBinarySeek(cmp, seek_key, index, skip_linear_scan);
 
-  if (!Valid()) {
-    SeekToLastImpl();
-  } else {
-    while (Valid() && CompareCurrentKey(seek_key) > 0) {
-      PrevImpl();
+    if (!Valid()) {
+      SeekToLastImpl();
+    } else {
+      while (Valid() && CompareCurrentKey(cmp, seek_key) > 0) {
+        PrevImpl();
+      }
     }
-  }
+  });
 }
 
 void DataBlockIter::SeekToFirstImpl() {
@@ -637,7 +641,9 @@ void IndexBlockIter::DecodeCurrentValue(uint32_t shared) {
 }
 
 template <class TValue>
-void BlockIter<TValue>::FindKeyAfterBinarySeek(const Slice& target,
+template <class KeyComparator>
+void BlockIter<TValue>::FindKeyAfterBinarySeek(const KeyComparator& cmp,
+                                               const Slice& target,
                                                uint32_t index,
                                                bool skip_linear_scan) {
   // SeekToRestartPoint() only does the lookup in the restart block. We need
@@ -665,9 +671,9 @@ void BlockIter<TValue>::FindKeyAfterBinarySeek(const Slice& target,
         break;
       }
       if (current_ == max_offset) {
-        assert(CompareCurrentKey(target) > 0);
+        assert(CompareCurrentKey(cmp, target) > 0);
         break;
-      } else if (CompareCurrentKey(target) >= 0) {
+      } else if (CompareCurrentKey(cmp, target) >= 0) {
         break;
       }
     }
@@ -683,8 +689,9 @@ void BlockIter<TValue>::FindKeyAfterBinarySeek(const Slice& target,
 // `*index`th restart key is the final result so that key does not need to be
 // compared again later.
 template <class TValue>
-template <typename DecodeKeyFunc>
-bool BlockIter<TValue>::BinarySeek(const Slice& target, uint32_t* index,
+template <typename DecodeKeyFunc, class KeyComparator>
+bool BlockIter<TValue>::BinarySeek(const KeyComparator& cmp,
+                                   const Slice& target, uint32_t* index,
                                    bool* skip_linear_scan) {
   if (restarts_ == 0) {
     // SST files dedicated to range tombstones are written with index blocks
@@ -717,12 +724,12 @@ bool BlockIter<TValue>::BinarySeek(const Slice& target, uint32_t* index,
     }
     Slice mid_key(key_ptr, non_shared);
     raw_key_.SetKey(mid_key, false /* copy */);
-    int cmp = CompareCurrentKey(target);
-    if (cmp < 0) {
+    int c = CompareCurrentKey(cmp, target);
+    if (c < 0) {
       // Key at "mid" is smaller than "target". Therefore all
       // blocks before "mid" are uninteresting.
       left = mid;
-    } else if (cmp > 0) {
+    } else if (c > 0) {
       // Key at "mid" is >= "target". Therefore all blocks at or
       // after "mid" are uninteresting.
       right = mid - 1;
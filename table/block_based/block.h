@@ -161,6 +161,9 @@ class Block {
 
   size_t size() const { return size_; }
   const char* data() const { return data_; }
+  // The contents the block was created from. Unlike data() and size(), these
+  // are not adjusted for the data block hash index.
+  const Slice& ContentSlice() const { return contents_.data; }
   // The additional memory space taken by the block data.
   size_t usable_size() const { return contents_.usable_size(); }
   uint32_t NumRestarts() const;
@@ -258,6 +261,7 @@ class BlockIter : public InternalIteratorBase<TValue> {
     assert(num_restarts > 0);  // Ensure the param is valid
 
     raw_ucmp_ = raw_ucmp;
+    ucmp_kind_ = GetUserComparatorKind(raw_ucmp);
     data_ = data;
     restarts_ = restarts;
     num_restarts_ = num_restarts;
@@ -420,18 +424,44 @@ class BlockIter : public InternalIteratorBase<TValue> {
   // comparator is used for the block contents, the LHS argument is the current
   // key with global seqno applied, and the RHS argument is `other`.
   int CompareCurrentKey(const Slice& other) {
+    return CompareCurrentKey(icmp(), other);
+  }
+
+  // Same as above with cmp, an InternalKeyComparator or a
+  // BytewiseInternalKeyComparator, comparing the internal keys.
+  template <class KeyComparator>
+  int CompareCurrentKey(const KeyComparator& cmp, const Slice& other) {
     if (raw_key_.IsUserKey()) {
       assert(global_seqno_ == kDisableGlobalSequenceNumber);
       return ucmp().Compare(raw_key_.GetUserKey(), other);
     } else if (global_seqno_ == kDisableGlobalSequenceNumber) {
-      return icmp().Compare(raw_key_.GetInternalKey(), other);
+      return cmp.Compare(raw_key_.GetInternalKey(), other);
+    }
+    return cmp.Compare(raw_key_.GetInternalKey(), global_seqno_, other,
+                       kDisableGlobalSequenceNumber);
+  }
+
+  // Calls func with the comparator of the internal keys of the block, which
+  // is a BytewiseInternalKeyComparator for the bytewise user comparators so
+  // that the seeks instantiated with it make no virtual call per key.
+  template <class Func>
+  void WithKeyComparator(Func&& func) {
+    switch (ucmp_kind_) {
+      case UserComparatorKind::kBytewise:
+        func(BytewiseInternalKeyComparator<false>());
+        break;
+      case UserComparatorKind::kReverseBytewise:
+        func(BytewiseInternalKeyComparator<true>());
+        break;
+      default:
+        func(icmp());
+        break;
     }
-    return icmp().Compare(raw_key_.GetInternalKey(), global_seqno_, other,
-                          kDisableGlobalSequenceNumber);
   }
 
  private:
   const Comparator* raw_ucmp_;
+  UserComparatorKind ucmp_kind_;
   // Store the cache handle, if the block is cached. We need this since the
   // only other place the handle is stored is as an argument to the Cleanable
   // function callback, which is hard to retrieve. When multiple value
@@ -464,12 +494,13 @@ class BlockIter : public InternalIteratorBase<TValue> {
   void CorruptionError();
 
  protected:
-  template <typename DecodeKeyFunc>
-  inline bool BinarySeek(const Slice& target, uint32_t* index,
-                         bool* is_index_key_result);
+  template <typename DecodeKeyFunc, class KeyComparator>
+  inline bool BinarySeek(const KeyComparator& cmp, const Slice& target,
+                         uint32_t* index, bool* is_index_key_result);
 
-  void FindKeyAfterBinarySeek(const Slice& target, uint32_t index,
-                              bool is_index_key_result);
+  template <class KeyComparator>
+  void FindKeyAfterBinarySeek(const KeyComparator& cmp, const Slice& target,
+                              uint32_t index, bool is_index_key_result);
 };
 
 class DataBlockIter final : public BlockIter<Slice> {
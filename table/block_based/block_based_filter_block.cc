@@ -133,6 +133,12 @@ Slice BlockBasedFilterBlockBuilder::Finish(const BlockHandle& /*tmp*/,
   return Slice(result_);
 }
 
+size_t BlockBasedFilterBlockBuilder::ApproximateMemoryUsage() const {
+  return entries_.capacity() + start_.capacity() * sizeof(size_t) +
+         result_.capacity() + tmp_entries_.capacity() * sizeof(Slice) +
+         filter_offsets_.capacity() * sizeof(uint32_t);
+}
+
 void BlockBasedFilterBlockBuilder::GenerateFilter() {
   const size_t num_entries = start_.size();
   if (num_entries == 0) {
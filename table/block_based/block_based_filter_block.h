@@ -46,6 +46,7 @@ class BlockBasedFilterBlockBuilder : public FilterBlockBuilder {
   virtual void StartBlock(uint64_t block_offset) override;
   virtual void Add(const Slice& key) override;
   virtual size_t NumAdded() const override { return num_added_; }
+  virtual size_t ApproximateMemoryUsage() const override;
   virtual Slice Finish(const BlockHandle& tmp, Status* status) override;
   using FilterBlockBuilder::Finish;
 
@@ -19,6 +19,7 @@
 #include <unordered_map>
 #include <utility>
 
+#include "cache/cache_reservation_manager.h"
 #include "db/dbformat.h"
 #include "index_builder.h"
 #include "port/lang.h"
@@ -35,6 +36,7 @@
 #include "table/block_based/block_based_table_factory.h"
 #include "table/block_based/block_based_table_reader.h"
 #include "table/block_based/block_builder.h"
+#include "table/block_based/block_like_traits.h"
 #include "table/block_based/filter_block.h"
 #include "table/block_based/filter_policy_internal.h"
 #include "table/block_based/full_filter_block.h"
@@ -105,6 +107,25 @@ bool GoodCompressionRatio(size_t compressed_size, size_t raw_size) {
   return compressed_size < raw_size - (raw_size / 8u);
 }
 
+// Whether the blocks of a file created for `reason` on `level` are inserted
+// into the block cache while the file is written.
+bool ShouldPrepopulateBlockCache(const BlockBasedTableOptions& table_opt,
+                                 TableFileCreationReason reason, int level) {
+  if (table_opt.block_cache == nullptr) {
+    return false;
+  }
+  switch (table_opt.prepopulate_block_cache) {
+    case BlockBasedTableOptions::PrepopulateBlockCache::kFlushOnly:
+      return reason == TableFileCreationReason::kFlush;
+    case BlockBasedTableOptions::PrepopulateBlockCache::kUpToLevel:
+      return reason == TableFileCreationReason::kFlush ||
+             (reason == TableFileCreationReason::kCompaction && level >= 0 &&
+              level <= table_opt.prepopulate_block_cache_max_level);
+    default:
+      return false;
+  }
+}
+
 }  // namespace
 
 // format_version is the block format as defined in include/rocksdb/table.h
@@ -315,6 +336,15 @@ struct BlockBasedTableBuilder::Rep {
   std::unique_ptr<FilterBlockBuilder> filter_builder;
   char compressed_cache_key_prefix[BlockBasedTable::kMaxCacheKeyPrefixSize];
   size_t compressed_cache_key_prefix_size;
+  // Whether the blocks are inserted into table_options.block_cache, see
+  // BlockBasedTableOptions::prepopulate_block_cache.
+  const bool warm_cache;
+  char cache_key_prefix[BlockBasedTable::kMaxCacheKeyPrefixSize];
+  size_t cache_key_prefix_size;
+  // Charges the memory of the filter under construction and of the buffered
+  // data blocks to table_options.block_cache, see
+  // BlockBasedTableOptions::reserve_table_builder_memory.
+  std::unique_ptr<CacheReservationManager> cache_res_mgr;
 
   BlockHandle pending_handle;  // Handle to add to index block
 
@@ -337,6 +367,23 @@ struct BlockBasedTableBuilder::Rep {
   std::unique_ptr<ParallelCompressionRep> pc_rep;
 
   uint64_t get_offset() { return offset.load(std::memory_order_relaxed); }
+
+  // Called by the thread adding keys to filter_builder, once per data block.
+  void UpdateCacheReservation() {
+    if (cache_res_mgr == nullptr) {
+      return;
+    }
+    size_t memory_used = 0;
+    if (state == State::kBuffered) {
+      memory_used += static_cast<size_t>(data_begin_offset);
+    }
+    if (filter_builder != nullptr) {
+      memory_used += filter_builder->ApproximateMemoryUsage();
+    }
+    // A cache full of pinned entries with strict_capacity_limit only makes
+    // the reservation fall short of the memory used.
+    cache_res_mgr->UpdateCacheReservation(memory_used).PermitUncheckedError();
+  }
   void set_offset(uint64_t o) { offset.store(o, std::memory_order_relaxed); }
 
   const IOStatus& GetIOStatus() {
@@ -406,7 +453,8 @@ struct BlockBasedTableBuilder::Rep {
       const int _level_at_creation, const std::string& _column_family_name,
       const uint64_t _creation_time, const uint64_t _oldest_key_time,
       const uint64_t _target_file_size, const uint64_t _file_creation_time,
-      const std::string& _db_id, const std::string& _db_session_id)
+      const std::string& _db_id, const std::string& _db_session_id,
+      TableFileCreationReason _reason)
       : ioptions(_ioptions),
         moptions(_moptions),
         table_options(table_opt),
@@ -438,6 +486,9 @@ struct BlockBasedTableBuilder::Rep {
         use_delta_encoding_for_index_values(table_opt.format_version >= 4 &&
                                             !table_opt.block_align),
         compressed_cache_key_prefix_size(0),
+        warm_cache(ShouldPrepopulateBlockCache(table_opt, _reason,
+                                               _level_at_creation)),
+        cache_key_prefix_size(0),
         flush_block_policy(
             table_options.flush_block_policy_factory->NewFlushBlockPolicy(
                 table_options, data_block)),
@@ -491,6 +542,11 @@ struct BlockBasedTableBuilder::Rep {
         verify_ctxs[i].reset(new UncompressionContext(compression_type));
       }
     }
+    if (table_options.reserve_table_builder_memory &&
+        table_options.block_cache != nullptr) {
+      cache_res_mgr.reset(new CacheReservationManager(
+          table_options.block_cache, true /* delayed_decrease */));
+    }
   }
 
   Rep(const Rep&) = delete;
@@ -658,7 +714,8 @@ BlockBasedTableBuilder::BlockBasedTableBuilder(
     const std::string& column_family_name, const int level_at_creation,
     const uint64_t creation_time, const uint64_t oldest_key_time,
     const uint64_t target_file_size, const uint64_t file_creation_time,
-    const std::string& db_id, const std::string& db_session_id) {
+    const std::string& db_id, const std::string& db_session_id,
+    TableFileCreationReason reason) {
   BlockBasedTableOptions sanitized_table_options(table_options);
   if (sanitized_table_options.format_version == 0 &&
       sanitized_table_options.checksum != kCRC32c) {
@@ -676,7 +733,7 @@ BlockBasedTableBuilder::BlockBasedTableBuilder(
       int_tbl_prop_collector_factories, column_family_id, file,
       compression_type, sample_for_compression, compression_opts, skip_filters,
       level_at_creation, column_family_name, creation_time, oldest_key_time,
-      target_file_size, file_creation_time, db_id, db_session_id);
+      target_file_size, file_creation_time, db_id, db_session_id, reason);
 
   if (rep_->filter_builder != nullptr) {
     rep_->filter_builder->StartBlock(0);
@@ -687,6 +744,11 @@ BlockBasedTableBuilder::BlockBasedTableBuilder(
         &rep_->compressed_cache_key_prefix[0],
         &rep_->compressed_cache_key_prefix_size);
   }
+  if (rep_->warm_cache) {
+    BlockBasedTable::GenerateCachePrefix<Cache, FSWritableFile>(
+        table_options.block_cache.get(), file->writable_file(),
+        &rep_->cache_key_prefix[0], &rep_->cache_key_prefix_size);
+  }
 
   if (rep_->compression_opts.parallel_threads > 1) {
     rep_->pc_rep.reset(
@@ -868,21 +930,22 @@ void BlockBasedTableBuilder::Flush() {
                                        [r] { return !r->pc_rep->first_block; });
     }
   } else {
-    WriteBlock(&r->data_block, &r->pending_handle, true /* is_data_block */);
+    WriteBlock(&r->data_block, &r->pending_handle, BlockType::kData);
   }
 }
 
 void BlockBasedTableBuilder::WriteBlock(BlockBuilder* block,
                                         BlockHandle* handle,
-                                        bool is_data_block) {
-  WriteBlock(block->Finish(), handle, is_data_block);
+                                        BlockType block_type) {
+  WriteBlock(block->Finish(), handle, block_type);
   block->Reset();
 }
 
 void BlockBasedTableBuilder::WriteBlock(const Slice& raw_block_contents,
                                         BlockHandle* handle,
-                                        bool is_data_block) {
+                                        BlockType block_type) {
   Rep* r = rep_;
+  const bool is_data_block = block_type == BlockType::kData;
   Slice block_contents;
   CompressionType type;
   if (r->state == Rep::State::kBuffered) {
@@ -890,6 +953,7 @@ void BlockBasedTableBuilder::WriteBlock(const Slice& raw_block_contents,
     assert(!r->data_block_and_keys_buffers.empty());
     r->data_block_and_keys_buffers.back().first = raw_block_contents.ToString();
     r->data_begin_offset += r->data_block_and_keys_buffers.back().first.size();
+    r->UpdateCacheReservation();
     return;
   }
   Status compress_status;
@@ -901,7 +965,7 @@ void BlockBasedTableBuilder::WriteBlock(const Slice& raw_block_contents,
   if (!ok()) {
     return;
   }
-  WriteRawBlock(block_contents, type, handle, is_data_block);
+  WriteRawBlock(block_contents, type, handle, block_type, &raw_block_contents);
   r->compressed_output.clear();
   if (is_data_block) {
     if (r->filter_builder != nullptr) {
@@ -909,6 +973,7 @@ void BlockBasedTableBuilder::WriteBlock(const Slice& raw_block_contents,
     }
     r->props.data_size = r->get_offset();
     ++r->props.num_data_blocks;
+    r->UpdateCacheReservation();
   }
 }
 
@@ -1032,8 +1097,11 @@ void BlockBasedTableBuilder::CompressAndVerifyBlock(
 void BlockBasedTableBuilder::WriteRawBlock(const Slice& block_contents,
                                            CompressionType type,
                                            BlockHandle* handle,
-                                           bool is_data_block) {
+                                           BlockType block_type,
+                                           const Slice* raw_block_contents,
+                                           bool is_top_level_filter_block) {
   Rep* r = rep_;
+  const bool is_data_block = block_type == BlockType::kData;
   Status s = Status::OK();
   IOStatus io_s = IOStatus::OK();
   StopWatch sw(r->ioptions.env, r->ioptions.statistics, WRITE_RAW_BLOCK_MICROS);
@@ -1092,6 +1160,12 @@ void BlockBasedTableBuilder::WriteRawBlock(const Slice& block_contents,
       s = InsertBlockInCache(block_contents, type, handle);
       if (!s.ok()) {
         r->SetStatus(s);
+      } else if (r->warm_cache) {
+        assert(raw_block_contents != nullptr || type == kNoCompression);
+        InsertBlockInBlockCacheHelper(
+            raw_block_contents != nullptr ? *raw_block_contents
+                                          : block_contents,
+            handle, block_type, is_top_level_filter_block);
       }
     } else {
       r->SetIOStatus(io_s);
@@ -1189,7 +1263,7 @@ void BlockBasedTableBuilder::BGWorkWriteRawBlock() {
 
     r->pc_rep->raw_bytes_curr_block = block_rep->data->size();
     WriteRawBlock(block_rep->compressed_contents, block_rep->compression_type,
-                  &r->pending_handle, true /* is_data_block*/);
+                  &r->pending_handle, BlockType::kData, &block_rep->contents);
     if (!ok()) {
       break;
     }
@@ -1205,6 +1279,7 @@ void BlockBasedTableBuilder::BGWorkWriteRawBlock() {
     }
     r->props.data_size = r->get_offset();
     ++r->props.num_data_blocks;
+    r->UpdateCacheReservation();
 
     if (block_rep->first_key_in_next_block == nullptr) {
       r->index_builder->AddIndexEntry(&(block_rep->keys->Back()), nullptr,
@@ -1277,6 +1352,78 @@ Status BlockBasedTableBuilder::InsertBlockInCache(const Slice& block_contents,
   return Status::OK();
 }
 
+void BlockBasedTableBuilder::InsertBlockInBlockCacheHelper(
+    const Slice& block_contents, const BlockHandle* handle,
+    BlockType block_type, bool is_top_level_filter_block) {
+  switch (block_type) {
+    case BlockType::kData:
+      InsertBlockInBlockCache<Block>(block_contents, handle, block_type);
+      break;
+    case BlockType::kIndex:
+      if (rep_->table_options.cache_index_and_filter_blocks) {
+        InsertBlockInBlockCache<Block>(block_contents, handle, block_type);
+      }
+      break;
+    case BlockType::kFilter:
+      if (!rep_->table_options.cache_index_and_filter_blocks) {
+        break;
+      }
+      if (rep_->filter_builder->IsBlockBased()) {
+        InsertBlockInBlockCache<BlockContents>(block_contents, handle,
+                                               block_type);
+      } else if (is_top_level_filter_block) {
+        InsertBlockInBlockCache<Block>(block_contents, handle, block_type);
+      } else {
+        InsertBlockInBlockCache<ParsedFullFilterBlock>(block_contents, handle,
+                                                       block_type);
+      }
+      break;
+    default:
+      // Other blocks are read once when the table is opened.
+      break;
+  }
+}
+
+template <typename TBlocklike>
+void BlockBasedTableBuilder::InsertBlockInBlockCache(
+    const Slice& block_contents, const BlockHandle* handle,
+    BlockType block_type) {
+  Rep* r = rep_;
+  Cache* block_cache = r->table_options.block_cache.get();
+  assert(block_cache != nullptr);
+
+  size_t size = block_contents.size();
+  auto buf = AllocateBlock(size, block_cache->memory_allocator());
+  memcpy(buf.get(), block_contents.data(), size);
+  BlockContents results(std::move(buf), size);
+
+  char cache_key[BlockBasedTable::kMaxCacheKeyPrefixSize + kMaxVarint64Length];
+  Slice key = BlockBasedTable::GetCacheKey(
+      r->cache_key_prefix, r->cache_key_prefix_size, *handle, cache_key);
+
+  // Same as BlockBasedTable::PutDataBlockToCache, the read amplification
+  // bitmap only applies to data blocks.
+  const size_t read_amp_bytes_per_bit =
+      block_type == BlockType::kData ? r->table_options.read_amp_bytes_per_bit
+                                     : 0;
+  std::unique_ptr<TBlocklike> block_holder(BlocklikeTraits<TBlocklike>::Create(
+      std::move(results), read_amp_bytes_per_bit, r->ioptions.statistics,
+      false /* using_zstd */, r->table_options.filter_policy.get()));
+  const size_t charge = block_holder->ApproximateMemoryUsage();
+  Status s = block_cache->Insert(key, block_holder.get(),
+                                 GetCacheItemHelper<TBlocklike>(), charge,
+                                 nullptr /* handle */, Cache::Priority::LOW);
+  if (s.ok()) {
+    block_holder.release();
+    BlockBasedTable::UpdateCacheInsertionMetrics(
+        block_type, nullptr /* get_context */, charge, s.IsOkOverwritten(),
+        r->ioptions.statistics);
+  } else {
+    // A failure to warm the cache does not fail the table file.
+    RecordTick(r->ioptions.statistics, BLOCK_CACHE_ADD_FAILURES);
+  }
+}
+
 void BlockBasedTableBuilder::WriteFilterBlock(
     MetaIndexBuilder* meta_index_builder) {
   BlockHandle filter_block_handle;
@@ -1289,7 +1436,14 @@ void BlockBasedTableBuilder::WriteFilterBlock(
           rep_->filter_builder->Finish(filter_block_handle, &s);
       assert(s.ok() || s.IsIncomplete());
       rep_->props.filter_size += filter_content.size();
-      WriteRawBlock(filter_content, kNoCompression, &filter_block_handle);
+      // With partitioned filters, the last block written is the top-level
+      // index of the filter partitions.
+      bool is_top_level_filter_block =
+          s.ok() && rep_->table_options.partition_filters &&
+          !rep_->filter_builder->IsBlockBased();
+      WriteRawBlock(filter_content, kNoCompression, &filter_block_handle,
+                    BlockType::kFilter, nullptr /* raw_block_contents */,
+                    is_top_level_filter_block);
     }
   }
   if (ok() && !empty_filter_block) {
@@ -1323,7 +1477,10 @@ void BlockBasedTableBuilder::WriteIndexBlock(
   if (ok()) {
     for (const auto& item : index_blocks.meta_blocks) {
       BlockHandle block_handle;
-      WriteBlock(item.second, &block_handle, false /* is_data_block */);
+      WriteBlock(item.second, &block_handle,
+                 item.first == kHashIndexPrefixesBlock
+                     ? BlockType::kHashIndexPrefixes
+                     : BlockType::kHashIndexMetadata);
       if (!ok()) {
         break;
       }
@@ -1332,10 +1489,11 @@ void BlockBasedTableBuilder::WriteIndexBlock(
   }
   if (ok()) {
     if (rep_->table_options.enable_index_compression) {
-      WriteBlock(index_blocks.index_block_contents, index_block_handle, false);
+      WriteBlock(index_blocks.index_block_contents, index_block_handle,
+                 BlockType::kIndex);
     } else {
       WriteRawBlock(index_blocks.index_block_contents, kNoCompression,
-                    index_block_handle);
+                    index_block_handle, BlockType::kIndex);
     }
   }
   // If there are more index partitions, finish them and write them out
@@ -1347,10 +1505,11 @@ void BlockBasedTableBuilder::WriteIndexBlock(
       return;
     }
     if (rep_->table_options.enable_index_compression) {
-      WriteBlock(index_blocks.index_block_contents, index_block_handle, false);
+      WriteBlock(index_blocks.index_block_contents, index_block_handle,
+                 BlockType::kIndex);
     } else {
       WriteRawBlock(index_blocks.index_block_contents, kNoCompression,
-                    index_block_handle);
+                    index_block_handle, BlockType::kIndex);
     }
     // The last index_block_handle will be for the partition index block
   }
@@ -1615,8 +1774,7 @@ void BlockBasedTableBuilder::EnterUnbuffered() {
         }
         r->index_builder->OnKeyAdded(key);
       }
-      WriteBlock(Slice(data_block), &r->pending_handle,
-                 true /* is_data_block */);
+      WriteBlock(Slice(data_block), &r->pending_handle, BlockType::kData);
       if (ok() && i + 1 < r->data_block_and_keys_buffers.size()) {
         Slice first_key_in_next_block =
             r->data_block_and_keys_buffers[i + 1].second.front();
@@ -19,6 +19,7 @@
 #include "rocksdb/listener.h"
 #include "rocksdb/options.h"
 #include "rocksdb/status.h"
+#include "table/block_based/block_type.h"
 #include "table/meta_blocks.h"
 #include "table/table_builder.h"
 #include "util/compression.h"
@@ -52,7 +53,8 @@ class BlockBasedTableBuilder : public TableBuilder {
       const uint64_t creation_time = 0, const uint64_t oldest_key_time = 0,
       const uint64_t target_file_size = 0,
       const uint64_t file_creation_time = 0, const std::string& db_id = "",
-      const std::string& db_session_id = "");
+      const std::string& db_session_id = "",
+      TableFileCreationReason reason = TableFileCreationReason::kMisc);
 
   // No copying allowed
   BlockBasedTableBuilder(const BlockBasedTableBuilder&) = delete;
@@ -119,17 +121,32 @@ class BlockBasedTableBuilder : public TableBuilder {
 
   // Call block's Finish() method
   // and then write the compressed block contents to file.
-  void WriteBlock(BlockBuilder* block, BlockHandle* handle, bool is_data_block);
+  void WriteBlock(BlockBuilder* block, BlockHandle* handle,
+                  BlockType block_type);
 
   // Compress and write block content to the file.
   void WriteBlock(const Slice& block_contents, BlockHandle* handle,
-                  bool is_data_block);
-  // Directly write data to the file.
+                  BlockType block_type);
+  // Directly write data to the file. raw_data is the uncompressed content of
+  // the block when data is compressed, it is needed to insert the block into
+  // the block cache.
   void WriteRawBlock(const Slice& data, CompressionType, BlockHandle* handle,
-                     bool is_data_block = false);
+                     BlockType block_type = BlockType::kInvalid,
+                     const Slice* raw_data = nullptr,
+                     bool is_top_level_filter_block = false);
   Status InsertBlockInCache(const Slice& block_contents,
                             const CompressionType type,
                             const BlockHandle* handle);
+  // Insert the uncompressed block into the block cache, as the object the
+  // table reader keeps there for a block of this type.
+  void InsertBlockInBlockCacheHelper(const Slice& block_contents,
+                                     const BlockHandle* handle,
+                                     BlockType block_type,
+                                     bool is_top_level_filter_block);
+  template <typename TBlocklike>
+  void InsertBlockInBlockCache(const Slice& block_contents,
+                               const BlockHandle* handle,
+                               BlockType block_type);
 
   void WriteFilterBlock(MetaIndexBuilder* meta_index_builder);
   void WriteIndexBlock(MetaIndexBuilder* meta_index_builder,
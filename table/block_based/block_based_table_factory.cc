@@ -15,6 +15,7 @@
 #include <memory>
 #include <string>
 
+#include "cache/cache_reservation_manager.h"
 #include "options/configurable_helper.h"
 #include "port/port.h"
 #include "rocksdb/cache.h"
@@ -24,6 +25,7 @@
 #include "table/block_based/block_based_table_builder.h"
 #include "table/block_based/block_based_table_reader.h"
 #include "table/format.h"
+#include "util/compression_context_cache.h"
 #include "util/mutexlock.h"
 #include "util/string_util.h"
 
@@ -198,6 +200,15 @@ static std::unordered_map<std::string,
          BlockBasedTableOptions::IndexShorteningMode::
              kShortenSeparatorsAndSuccessor}};
 
+static std::unordered_map<std::string,
+                          BlockBasedTableOptions::PrepopulateBlockCache>
+    block_base_table_prepopulate_block_cache_string_map = {
+        {"kDisable", BlockBasedTableOptions::PrepopulateBlockCache::kDisable},
+        {"kFlushOnly",
+         BlockBasedTableOptions::PrepopulateBlockCache::kFlushOnly},
+        {"kUpToLevel",
+         BlockBasedTableOptions::PrepopulateBlockCache::kUpToLevel}};
+
 static std::unordered_map<std::string, OptionTypeInfo>
     metadata_cache_options_type_info = {
         {"top_level_index_pinning",
@@ -374,6 +385,28 @@ static std::unordered_map<std::string, OptionTypeInfo>
                    pin_top_level_index_and_filter),
           OptionType::kBoolean, OptionVerificationType::kNormal,
           OptionTypeFlags::kNone}},
+        {"prepopulate_block_cache",
+         OptionTypeInfo::Enum<BlockBasedTableOptions::PrepopulateBlockCache>(
+             offsetof(struct BlockBasedTableOptions, prepopulate_block_cache),
+             &block_base_table_prepopulate_block_cache_string_map)},
+        {"prepopulate_block_cache_max_level",
+         {offsetof(struct BlockBasedTableOptions,
+                   prepopulate_block_cache_max_level),
+          OptionType::kInt, OptionVerificationType::kNormal,
+          OptionTypeFlags::kNone}},
+        {"reserve_table_builder_memory",
+         {offsetof(struct BlockBasedTableOptions,
+                   reserve_table_builder_memory),
+          OptionType::kBoolean, OptionVerificationType::kNormal,
+          OptionTypeFlags::kNone}},
+        {"reserve_table_reader_memory",
+         {offsetof(struct BlockBasedTableOptions, reserve_table_reader_memory),
+          OptionType::kBoolean, OptionVerificationType::kNormal,
+          OptionTypeFlags::kNone}},
+        {"block_cache_partition",
+         {offsetof(struct BlockBasedTableOptions, block_cache_partition),
+          OptionType::kString, OptionVerificationType::kNormal,
+          OptionTypeFlags::kNone}},
         {kOptNameMetadataCacheOpts,
          OptionTypeInfo::Struct(
              kOptNameMetadataCacheOpts, &metadata_cache_options_type_info,
@@ -448,6 +481,26 @@ void BlockBasedTableFactory::InitializeOptions() {
     // We do not support partitioned filters without partitioning indexes
     table_options_.partition_filters = false;
   }
+  if (!table_options_.block_cache_partition.empty()) {
+    // nullptr if the block cache has no such partition, which
+    // ValidateOptions() reports.
+    block_cache_partition_ = NewCachePartition(
+        table_options_.block_cache, table_options_.block_cache_partition);
+  } else {
+    block_cache_partition_.reset();
+  }
+  const std::shared_ptr<Cache>& block_cache =
+      block_cache_partition_ != nullptr ? block_cache_partition_
+                                        : table_options_.block_cache;
+  if (table_options_.reserve_table_reader_memory && block_cache != nullptr) {
+    table_reader_cache_res_mgr_ =
+        std::make_shared<CacheReservationManager>(block_cache);
+    compression_ctx_cache_res_mgr_ = std::make_shared<CacheReservationManager>(
+        block_cache, true /* delayed_decrease */);
+  } else {
+    table_reader_cache_res_mgr_.reset();
+    compression_ctx_cache_res_mgr_.reset();
+  }
 }
 
 Status BlockBasedTableFactory::PrepareOptions(const ConfigOptions& opts) {
@@ -460,24 +513,41 @@ Status BlockBasedTableFactory::NewTableReader(
     std::unique_ptr<RandomAccessFileReader>&& file, uint64_t file_size,
     std::unique_ptr<TableReader>* table_reader,
     bool prefetch_index_and_filter_in_cache) const {
-  return BlockBasedTable::Open(
+  BlockBasedTableOptions partitioned_table_options;
+  const BlockBasedTableOptions& table_options =
+      GetEffectiveTableOptions(&partitioned_table_options);
+  Status s = BlockBasedTable::Open(
       ro, table_reader_options.ioptions, table_reader_options.env_options,
-      table_options_, table_reader_options.internal_comparator, std::move(file),
+      table_options, table_reader_options.internal_comparator, std::move(file),
       file_size, table_reader, table_reader_options.prefix_extractor,
       prefetch_index_and_filter_in_cache, table_reader_options.skip_filters,
       table_reader_options.level, table_reader_options.immortal,
       table_reader_options.largest_seqno,
       table_reader_options.force_direct_prefetch, &tail_prefetch_stats_,
       table_reader_options.block_cache_tracer,
-      table_reader_options.max_file_size_for_l0_meta_pin);
+      table_reader_options.max_file_size_for_l0_meta_pin,
+      table_reader_cache_res_mgr_);
+  if (s.ok() && compression_ctx_cache_res_mgr_ != nullptr) {
+    // The decompression contexts are shared by all the table readers of the
+    // process, so they may be charged more than once if several factories
+    // reserve table reader memory, which errs on the side of bounding memory.
+    compression_ctx_cache_res_mgr_
+        ->UpdateCacheReservation(
+            CompressionContextCache::Instance()->ApproximateMemoryUsage())
+        .PermitUncheckedError();
+  }
+  return s;
 }
 
 TableBuilder* BlockBasedTableFactory::NewTableBuilder(
     const TableBuilderOptions& table_builder_options, uint32_t column_family_id,
     WritableFileWriter* file) const {
+  BlockBasedTableOptions partitioned_table_options;
+  const BlockBasedTableOptions& table_options =
+      GetEffectiveTableOptions(&partitioned_table_options);
   auto table_builder = new BlockBasedTableBuilder(
       table_builder_options.ioptions, table_builder_options.moptions,
-      table_options_, table_builder_options.internal_comparator,
+      table_options, table_builder_options.internal_comparator,
       table_builder_options.int_tbl_prop_collector_factories, column_family_id,
       file, table_builder_options.compression_type,
       table_builder_options.sample_for_compression,
@@ -488,11 +558,21 @@ TableBuilder* BlockBasedTableFactory::NewTableBuilder(
       table_builder_options.oldest_key_time,
       table_builder_options.target_file_size,
       table_builder_options.file_creation_time, table_builder_options.db_id,
-      table_builder_options.db_session_id);
+      table_builder_options.db_session_id, table_builder_options.reason);
 
   return table_builder;
 }
 
+const BlockBasedTableOptions& BlockBasedTableFactory::GetEffectiveTableOptions(
+    BlockBasedTableOptions* partitioned_table_options) const {
+  if (block_cache_partition_ == nullptr) {
+    return table_options_;
+  }
+  *partitioned_table_options = table_options_;
+  partitioned_table_options->block_cache = block_cache_partition_;
+  return *partitioned_table_options;
+}
+
 Status BlockBasedTableFactory::ValidateOptions(
     const DBOptions& db_opts, const ColumnFamilyOptions& cf_opts) const {
   if (table_options_.index_type == BlockBasedTableOptions::kHashSearch &&
@@ -513,6 +593,12 @@ Status BlockBasedTableFactory::ValidateOptions(
         "Enable pin_l0_filter_and_index_blocks_in_cache, "
         ", but block cache is disabled");
   }
+  if (!table_options_.block_cache_partition.empty() &&
+      !table_options_.no_block_cache && block_cache_partition_ == nullptr) {
+    return Status::InvalidArgument(
+        "block_cache has no partition named block_cache_partition",
+        table_options_.block_cache_partition);
+  }
   if (!BlockBasedTableSupportedVersion(table_options_.format_version)) {
     return Status::InvalidArgument(
         "Unsupported BlockBasedTable format_version. Please check "
@@ -671,6 +757,21 @@ std::string BlockBasedTableFactory::GetPrintableOptions() const {
   snprintf(buffer, kBufferSize, "  block_align: %d\n",
            table_options_.block_align);
   ret.append(buffer);
+  snprintf(buffer, kBufferSize, "  prepopulate_block_cache: %d\n",
+           static_cast<int>(table_options_.prepopulate_block_cache));
+  ret.append(buffer);
+  snprintf(buffer, kBufferSize, "  prepopulate_block_cache_max_level: %d\n",
+           table_options_.prepopulate_block_cache_max_level);
+  ret.append(buffer);
+  snprintf(buffer, kBufferSize, "  reserve_table_builder_memory: %d\n",
+           table_options_.reserve_table_builder_memory);
+  ret.append(buffer);
+  snprintf(buffer, kBufferSize, "  reserve_table_reader_memory: %d\n",
+           table_options_.reserve_table_reader_memory);
+  ret.append(buffer);
+  snprintf(buffer, kBufferSize, "  block_cache_partition: %s\n",
+           table_options_.block_cache_partition.c_str());
+  ret.append(buffer);
   return ret;
 }
 
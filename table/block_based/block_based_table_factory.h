@@ -22,6 +22,7 @@ struct ConfigOptions;
 struct EnvOptions;
 
 class BlockBasedTableBuilder;
+class CacheReservationManager;
 
 // A class used to track actual bytes written from the tail in the recent SST
 // file opens, and provide a suggestion for following open.
@@ -83,8 +84,21 @@ class BlockBasedTableFactory : public TableFactory {
   void InitializeOptions();
 
  private:
+  // table_options_, or *partitioned_table_options set to table_options_ with
+  // the block cache replaced by block_cache_partition_.
+  const BlockBasedTableOptions& GetEffectiveTableOptions(
+      BlockBasedTableOptions* partitioned_table_options) const;
+
   BlockBasedTableOptions table_options_;
   mutable TailPrefetchStats tail_prefetch_stats_;
+  // Charge the memory of the table readers opened through this factory, and
+  // of the process wide ZSTD decompression contexts, to the block cache. Set
+  // only with BlockBasedTableOptions::reserve_table_reader_memory.
+  std::shared_ptr<CacheReservationManager> table_reader_cache_res_mgr_;
+  std::shared_ptr<CacheReservationManager> compression_ctx_cache_res_mgr_;
+  // The view of BlockBasedTableOptions::block_cache_partition of the block
+  // cache, used by the table readers and builders instead of the block cache.
+  std::shared_ptr<Cache> block_cache_partition_;
 };
 
 extern const std::string kHashIndexPrefixesBlock;
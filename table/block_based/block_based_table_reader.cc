@@ -39,6 +39,7 @@
 #include "table/block_based/block_based_filter_block.h"
 #include "table/block_based/block_based_table_factory.h"
 #include "table/block_based/block_based_table_iterator.h"
+#include "table/block_based/block_like_traits.h"
 #include "table/block_based/block_prefix_index.h"
 #include "table/block_based/filter_block.h"
 #include "table/block_based/full_filter_block.h"
@@ -82,72 +83,6 @@ BlockBasedTable::~BlockBasedTable() {
 
 std::atomic<uint64_t> BlockBasedTable::next_cache_key_id_(0);
 
-template <typename TBlocklike>
-class BlocklikeTraits;
-
-template <>
-class BlocklikeTraits<BlockContents> {
- public:
-  static BlockContents* Create(BlockContents&& contents,
-                               size_t /* read_amp_bytes_per_bit */,
-                               Statistics* /* statistics */,
-                               bool /* using_zstd */,
-                               const FilterPolicy* /* filter_policy */) {
-    return new BlockContents(std::move(contents));
-  }
-
-  static uint32_t GetNumRestarts(const BlockContents& /* contents */) {
-    return 0;
-  }
-};
-
-template <>
-class BlocklikeTraits<ParsedFullFilterBlock> {
- public:
-  static ParsedFullFilterBlock* Create(BlockContents&& contents,
-                                       size_t /* read_amp_bytes_per_bit */,
-                                       Statistics* /* statistics */,
-                                       bool /* using_zstd */,
-                                       const FilterPolicy* filter_policy) {
-    return new ParsedFullFilterBlock(filter_policy, std::move(contents));
-  }
-
-  static uint32_t GetNumRestarts(const ParsedFullFilterBlock& /* block */) {
-    return 0;
-  }
-};
-
-template <>
-class BlocklikeTraits<Block> {
- public:
-  static Block* Create(BlockContents&& contents, size_t read_amp_bytes_per_bit,
-                       Statistics* statistics, bool /* using_zstd */,
-                       const FilterPolicy* /* filter_policy */) {
-    return new Block(std::move(contents), read_amp_bytes_per_bit, statistics);
-  }
-
-  static uint32_t GetNumRestarts(const Block& block) {
-    return block.NumRestarts();
-  }
-};
-
-template <>
-class BlocklikeTraits<UncompressionDict> {
- public:
-  static UncompressionDict* Create(BlockContents&& contents,
-                                   size_t /* read_amp_bytes_per_bit */,
-                                   Statistics* /* statistics */,
-                                   bool using_zstd,
-                                   const FilterPolicy* /* filter_policy */) {
-    return new UncompressionDict(contents.data, std::move(contents.allocation),
-                                 using_zstd);
-  }
-
-  static uint32_t GetNumRestarts(const UncompressionDict& /* dict */) {
-    return 0;
-  }
-};
-
 namespace {
 // Read the block identified by "handle" from "file".
 // The only relevant option is options.verify_checksums for now.
@@ -182,13 +117,6 @@ Status ReadBlockFromFile(
   return s;
 }
 
-// Delete the entry resided in the cache.
-template <class Entry>
-void DeleteCachedEntry(const Slice& /*key*/, void* value) {
-  auto entry = reinterpret_cast<Entry*>(value);
-  delete entry;
-}
-
 // Release the cached entry and decrement its ref count.
 // Do not force erase
 void ReleaseCachedEntry(void* arg, void* h) {
@@ -338,12 +266,9 @@ void BlockBasedTable::UpdateCacheMissMetrics(BlockType block_type,
   }
 }
 
-void BlockBasedTable::UpdateCacheInsertionMetrics(BlockType block_type,
-                                                  GetContext* get_context,
-                                                  size_t usage,
-                                                  bool redundant) const {
-  Statistics* const statistics = rep_->ioptions.statistics;
-
+void BlockBasedTable::UpdateCacheInsertionMetrics(
+    BlockType block_type, GetContext* get_context, size_t usage,
+    bool redundant, Statistics* const statistics) {
   // TODO: introduce perf counters for block cache insertions
   if (get_context) {
     ++get_context->get_context_stats_.num_cache_add;
@@ -433,8 +358,10 @@ void BlockBasedTable::UpdateCacheInsertionMetrics(BlockType block_type,
 
 Cache::Handle* BlockBasedTable::GetEntryFromCache(
     Cache* block_cache, const Slice& key, BlockType block_type,
-    GetContext* get_context) const {
-  auto cache_handle = block_cache->Lookup(key, rep_->ioptions.statistics);
+    GetContext* get_context, const Cache::CacheItemHelper* cache_helper,
+    const Cache::CreateCallback& create_cb, Cache::Priority priority) const {
+  auto cache_handle = block_cache->Lookup(key, cache_helper, create_cb,
+                                          priority, rep_->ioptions.statistics);
 
   if (cache_handle != nullptr) {
     UpdateCacheHitMetrics(block_type, get_context,
@@ -588,7 +515,9 @@ Status BlockBasedTable::Open(
     const SequenceNumber largest_seqno, const bool force_direct_prefetch,
     TailPrefetchStats* tail_prefetch_stats,
     BlockCacheTracer* const block_cache_tracer,
-    size_t max_file_size_for_l0_meta_pin) {
+    size_t max_file_size_for_l0_meta_pin,
+    const std::shared_ptr<CacheReservationManager>&
+        table_reader_cache_res_mgr) {
   table_reader->reset();
 
   Status s;
@@ -701,6 +630,20 @@ Status BlockBasedTable::Open(
       prefetch_all, table_options, level, file_size,
       max_file_size_for_l0_meta_pin, &lookup_context);
 
+  if (s.ok() && table_reader_cache_res_mgr != nullptr) {
+    // Charge the index and filter readers, with whatever they pinned outside
+    // of the block cache, and the table reader itself.
+    size_t memory_used = new_table->ApproximateMemoryUsage() +
+                         sizeof(BlockBasedTable) + sizeof(Rep);
+    s = table_reader_cache_res_mgr->MakeCacheReservation(
+        memory_used, &rep->table_reader_cache_res_handle);
+    if (!s.ok()) {
+      return Status::MemoryLimit(
+          "Block cache cannot be charged with the table reader memory of",
+          rep->file->file_name());
+    }
+  }
+
   if (s.ok()) {
     // Update tail prefetch stats
     assert(prefetch_buffer.get() != nullptr);
@@ -1188,10 +1131,37 @@ Status BlockBasedTable::GetDataBlockFromCache(
   BlockContents* compressed_block = nullptr;
   Cache::Handle* block_cache_compressed_handle = nullptr;
 
+  const Cache::Priority priority =
+      rep_->table_options.cache_index_and_filter_blocks_with_high_priority &&
+              (block_type == BlockType::kFilter ||
+               block_type == BlockType::kCompressionDictionary ||
+               block_type == BlockType::kIndex)
+          ? Cache::Priority::HIGH
+          : Cache::Priority::LOW;
+
   // Lookup uncompressed cache first
   if (block_cache != nullptr) {
-    auto cache_handle = GetEntryFromCache(block_cache, block_cache_key,
-                                          block_type, get_context);
+    // Recreate the block from the contents saved by SaveCachedEntryTo().
+    // Only capture two words so that std::function does not allocate.
+    const Rep* rep = rep_;
+    Cache::CreateCallback create_cb =
+        [rep, read_amp_bytes_per_bit](const void* buf, size_t size,
+                                      void** out_obj, size_t* charge) {
+          CacheAllocationPtr allocation =
+              AllocateBlock(size, GetMemoryAllocator(rep->table_options));
+          memcpy(allocation.get(), buf, size);
+          TBlocklike* obj = BlocklikeTraits<TBlocklike>::Create(
+              BlockContents(std::move(allocation), size),
+              read_amp_bytes_per_bit, rep->ioptions.statistics,
+              rep->blocks_definitely_zstd_compressed,
+              rep->table_options.filter_policy.get());
+          *out_obj = obj;
+          *charge = obj->ApproximateMemoryUsage();
+          return Status::OK();
+        };
+    auto cache_handle = GetEntryFromCache(
+        block_cache, block_cache_key, block_type, get_context,
+        GetCacheItemHelper<TBlocklike>(), create_cb, priority);
     if (cache_handle != nullptr) {
       block->SetCachedValue(
           reinterpret_cast<TBlocklike*>(block_cache->Value(cache_handle)),
@@ -1248,15 +1218,16 @@ Status BlockBasedTable::GetDataBlockFromCache(
         read_options.fill_cache) {
       size_t charge = block_holder->ApproximateMemoryUsage();
       Cache::Handle* cache_handle = nullptr;
-      s = block_cache->Insert(block_cache_key, block_holder.get(), charge,
-                              &DeleteCachedEntry<TBlocklike>, &cache_handle);
+      s = block_cache->Insert(block_cache_key, block_holder.get(),
+                              GetCacheItemHelper<TBlocklike>(), charge,
+                              &cache_handle);
       if (s.ok()) {
         assert(cache_handle != nullptr);
         block->SetCachedValue(block_holder.release(), block_cache,
                               cache_handle);
 
         UpdateCacheInsertionMetrics(block_type, get_context, charge,
-                                    s.IsOkOverwritten());
+                                    s.IsOkOverwritten(), statistics);
       } else {
         RecordTick(statistics, BLOCK_CACHE_ADD_FAILURES);
       }
@@ -1353,16 +1324,16 @@ Status BlockBasedTable::PutDataBlockToCache(
   if (block_cache != nullptr && block_holder->own_bytes()) {
     size_t charge = block_holder->ApproximateMemoryUsage();
     Cache::Handle* cache_handle = nullptr;
-    s = block_cache->Insert(block_cache_key, block_holder.get(), charge,
-                            &DeleteCachedEntry<TBlocklike>, &cache_handle,
-                            priority);
+    s = block_cache->Insert(block_cache_key, block_holder.get(),
+                            GetCacheItemHelper<TBlocklike>(), charge,
+                            &cache_handle, priority);
     if (s.ok()) {
       assert(cache_handle != nullptr);
       cached_block->SetCachedValue(block_holder.release(), block_cache,
                                    cache_handle);
 
       UpdateCacheInsertionMetrics(block_type, get_context, charge,
-                                  s.IsOkOverwritten());
+                                  s.IsOkOverwritten(), statistics);
     } else {
       RecordTick(statistics, BLOCK_CACHE_ADD_FAILURES);
     }
@@ -3006,6 +2977,216 @@ Status BlockBasedTable::VerifyChecksumInMetaBlocks(
   return s;
 }
 
+Status BlockBasedTable::GetBlockCacheKeyPrefix(Cache** block_cache,
+                                               std::string* prefix) const {
+  *block_cache = rep_->table_options.block_cache.get();
+  prefix->assign(rep_->cache_key_prefix, rep_->cache_key_prefix_size);
+  return Status::OK();
+}
+
+BlockType BlockBasedTable::GetBlockTypeAt(uint64_t offset) const {
+  if (offset == rep_->footer.index_handle().offset()) {
+    return BlockType::kIndex;
+  }
+  if (!rep_->filter_handle.IsNull() &&
+      offset == rep_->filter_handle.offset()) {
+    return BlockType::kFilter;
+  }
+  if (!rep_->compression_dict_handle.IsNull() &&
+      offset == rep_->compression_dict_handle.offset()) {
+    return BlockType::kCompressionDictionary;
+  }
+  return BlockType::kData;
+}
+
+Status BlockBasedTable::LoadBlocksIntoCache(
+    const ReadOptions& read_options,
+    const std::vector<CachedBlockInfo>& blocks) {
+  // Upper bound of the bytes read by one MultiRead() call.
+  static const size_t kLoadBatchBytes = 4 << 20;
+
+  Cache* block_cache = rep_->table_options.block_cache.get();
+  if (block_cache == nullptr) {
+    return Status::OK();
+  }
+  std::vector<uint64_t> offsets;
+  for (const CachedBlockInfo& block : blocks) {
+    if (block.type == BlockType::kData) {
+      offsets.push_back(block.offset);
+    }
+  }
+  if (offsets.empty()) {
+    return Status::OK();
+  }
+  std::sort(offsets.begin(), offsets.end());
+
+  // The data blocks are laid out in index order, so one pass over the index
+  // maps the offsets to block handles. Blocks cached in the meantime are
+  // skipped.
+  BlockCacheLookupContext lookup_context{TableReaderCaller::kPrefetch};
+  std::vector<BlockHandle> handles;
+  {
+    IndexBlockIter iiter_on_stack;
+    auto iiter = NewIndexIterator(read_options,
+                                  /*need_upper_bound_check=*/false,
+                                  &iiter_on_stack, /*get_context=*/nullptr,
+                                  &lookup_context);
+    std::unique_ptr<InternalIteratorBase<IndexValue>> iiter_unique_ptr;
+    if (iiter != &iiter_on_stack) {
+      iiter_unique_ptr =
+          std::unique_ptr<InternalIteratorBase<IndexValue>>(iiter);
+    }
+    char cache_key[kMaxCacheKeyPrefixSize + kMaxVarint64Length];
+    size_t next = 0;
+    for (iiter->SeekToFirst(); iiter->Valid() && next < offsets.size();
+         iiter->Next()) {
+      const BlockHandle handle = iiter->value().handle;
+      while (next < offsets.size() && offsets[next] < handle.offset()) {
+        next++;
+      }
+      if (next == offsets.size() || offsets[next] != handle.offset()) {
+        continue;
+      }
+      next++;
+      Cache::Handle* cache_handle = block_cache->Lookup(
+          GetCacheKey(rep_->cache_key_prefix, rep_->cache_key_prefix_size,
+                      handle, cache_key));
+      if (cache_handle != nullptr) {
+        block_cache->Release(cache_handle);
+      } else {
+        handles.push_back(handle);
+      }
+    }
+    if (!iiter->status().ok()) {
+      return iiter->status();
+    }
+  }
+  if (handles.empty()) {
+    return Status::OK();
+  }
+
+  CachableEntry<UncompressionDict> uncompression_dict;
+  if (rep_->uncompression_dict_reader) {
+    Status s =
+        rep_->uncompression_dict_reader->GetOrReadUncompressionDictionary(
+            nullptr /* prefetch_buffer */, false /* no_io */,
+            nullptr /* get_context */, &lookup_context, &uncompression_dict);
+    if (!s.ok()) {
+      return s;
+    }
+  }
+  const UncompressionDict& dict = uncompression_dict.GetValue()
+                                      ? *uncompression_dict.GetValue()
+                                      : UncompressionDict::GetEmptyDict();
+
+  RandomAccessFileReader* file = rep_->file.get();
+  if (rep_->ioptions.allow_mmap_reads) {
+    for (const BlockHandle& handle : handles) {
+      CachableEntry<Block> block;
+      Status s = RetrieveBlock(nullptr /* prefetch_buffer */, read_options,
+                               handle, dict, &block, BlockType::kData,
+                               nullptr /* get_context */, &lookup_context,
+                               /* for_compaction */ false,
+                               /* use_cache */ true);
+      if (!s.ok()) {
+        return s;
+      }
+    }
+    return Status::OK();
+  }
+
+  for (size_t begin = 0; begin < handles.size();) {
+    // Build one batch, reading adjacent blocks with a single request.
+    std::vector<FSReadRequest> read_reqs;
+    // For each block of the batch, its request and its offset in it.
+    std::vector<std::pair<size_t, size_t>> block_reqs;
+    size_t batch_bytes = 0;
+    size_t end = begin;
+    for (; end < handles.size() && batch_bytes < kLoadBatchBytes; end++) {
+      const BlockHandle& handle = handles[end];
+      const size_t len = static_cast<size_t>(block_size(handle));
+      if (!read_reqs.empty() &&
+          read_reqs.back().offset + read_reqs.back().len == handle.offset()) {
+        block_reqs.emplace_back(read_reqs.size() - 1, read_reqs.back().len);
+        read_reqs.back().len += len;
+      } else {
+        FSReadRequest req;
+        req.offset = handle.offset();
+        req.len = len;
+        block_reqs.emplace_back(read_reqs.size(), 0);
+        read_reqs.push_back(req);
+      }
+      batch_bytes += len;
+    }
+    std::vector<std::unique_ptr<char[]>> scratches;
+    if (!file->use_direct_io()) {
+      for (FSReadRequest& req : read_reqs) {
+        scratches.emplace_back(new char[req.len]);
+        req.scratch = scratches.back().get();
+      }
+    }
+
+    AlignedBuf direct_io_buf;
+    IOOptions opts;
+    Status read_s = PrepareIOFromReadOptions(read_options, file->env(), opts);
+    if (read_s.ok()) {
+      read_s = file->MultiRead(opts, read_reqs.data(), read_reqs.size(),
+                               &direct_io_buf);
+    }
+    if (!read_s.ok()) {
+      return read_s;
+    }
+
+    for (size_t i = begin; i < end; i++) {
+      const BlockHandle& handle = handles[i];
+      const FSReadRequest& req = read_reqs[block_reqs[i - begin].first];
+      const size_t req_offset = block_reqs[i - begin].second;
+      Status s = req.status;
+      if (s.ok() && req_offset + block_size(handle) > req.result.size()) {
+        s = Status::Corruption(
+            "truncated block read from " + file->file_name() + " offset " +
+            ToString(handle.offset()) + ", expected " +
+            ToString(block_size(handle)) + " bytes, got " +
+            ToString(req.result.size() - req_offset));
+      }
+      if (s.ok() && read_options.verify_checksums) {
+        s = ROCKSDB_NAMESPACE::VerifyBlockChecksum(
+            rep_->footer.checksum(), req.result.data() + req_offset,
+            handle.size(), file->file_name(), handle.offset());
+      }
+      if (!s.ok()) {
+        return s;
+      }
+
+      // The read buffer is shared by the blocks of a request, uncompressed
+      // blocks are copied to the heap before they go into the cache.
+      const char* data = req.result.data() + req_offset;
+      BlockContents raw_block_contents;
+      if (static_cast<CompressionType>(data[handle.size()]) == kNoCompression) {
+        Slice raw(data, block_size(handle));
+        raw_block_contents = BlockContents(
+            CopyBufferToHeap(GetMemoryAllocator(rep_->table_options), raw),
+            handle.size());
+      } else {
+        raw_block_contents = BlockContents(Slice(data, handle.size()));
+      }
+#ifndef NDEBUG
+      raw_block_contents.is_raw_block = true;
+#endif
+      CachableEntry<Block> block;
+      s = MaybeReadBlockAndLoadToCache(
+          nullptr /* prefetch_buffer */, read_options, handle, dict, &block,
+          BlockType::kData, nullptr /* get_context */, &lookup_context,
+          &raw_block_contents);
+      if (!s.ok()) {
+        return s;
+      }
+    }
+    begin = end;
+  }
+  return Status::OK();
+}
+
 bool BlockBasedTable::TEST_BlockInCache(const BlockHandle& handle) const {
   assert(rep_ != nullptr);
 
@@ -9,6 +9,7 @@
 
 #pragma once
 
+#include "cache/cache_reservation_manager.h"
 #include "db/range_tombstone_fragmenter.h"
 #include "file/filename.h"
 #include "table/block_based/block_based_table_factory.h"
@@ -102,7 +103,9 @@ class BlockBasedTable : public TableReader {
                      bool force_direct_prefetch = false,
                      TailPrefetchStats* tail_prefetch_stats = nullptr,
                      BlockCacheTracer* const block_cache_tracer = nullptr,
-                     size_t max_file_size_for_l0_meta_pin = 0);
+                     size_t max_file_size_for_l0_meta_pin = 0,
+                     const std::shared_ptr<CacheReservationManager>&
+                         table_reader_cache_res_mgr = nullptr);
 
   bool PrefixMayMatch(const Slice& internal_key,
                       const ReadOptions& read_options,
@@ -178,6 +181,21 @@ class BlockBasedTable : public TableReader {
   Status VerifyChecksum(const ReadOptions& readOptions,
                         TableReaderCaller caller) override;
 
+  Status GetBlockCacheKeyPrefix(Cache** block_cache,
+                                std::string* prefix) const override;
+
+  // Blocks other than the index, filter and compression dictionary blocks
+  // are reported as data blocks. Partitions of a partitioned index or filter
+  // are therefore reported as data blocks too; LoadBlocksIntoCache() skips
+  // them since they are not referenced by the index.
+  BlockType GetBlockTypeAt(uint64_t offset) const override;
+
+  // Only data blocks are loaded. The index and filter blocks are loaded when
+  // the table is opened if they are cached at all.
+  Status LoadBlocksIntoCache(
+      const ReadOptions& read_options,
+      const std::vector<CachedBlockInfo>& blocks) override;
+
   ~BlockBasedTable();
 
   bool TEST_FilterBlockInCache() const;
@@ -268,12 +286,19 @@ class BlockBasedTable : public TableReader {
                              size_t usage) const;
   void UpdateCacheMissMetrics(BlockType block_type,
                               GetContext* get_context) const;
-  void UpdateCacheInsertionMetrics(BlockType block_type,
-                                   GetContext* get_context, size_t usage,
-                                   bool redundant) const;
+  // Also used by BlockBasedTableBuilder when it prepopulates the block cache.
+  static void UpdateCacheInsertionMetrics(BlockType block_type,
+                                          GetContext* get_context, size_t usage,
+                                          bool redundant,
+                                          Statistics* const statistics);
+  // On a miss, the block is looked up in the secondary cache of block_cache,
+  // if any, and recreated by create_cb.
   Cache::Handle* GetEntryFromCache(Cache* block_cache, const Slice& key,
                                    BlockType block_type,
-                                   GetContext* get_context) const;
+                                   GetContext* get_context,
+                                   const Cache::CacheItemHelper* cache_helper,
+                                   const Cache::CreateCallback& create_cb,
+                                   Cache::Priority priority) const;
 
   // Either Block::NewDataIterator() or Block::NewIndexIterator().
   template <typename TBlockIter>
@@ -602,6 +627,11 @@ struct BlockBasedTable::Rep {
 
   const bool immortal_table;
 
+  // The memory of this table reader charged to the block cache, see
+  // BlockBasedTableOptions::reserve_table_reader_memory.
+  std::unique_ptr<CacheReservationManager::CacheReservationHandle>
+      table_reader_cache_res_handle;
+
   SequenceNumber get_global_seqno(BlockType block_type) const {
     return (block_type == BlockType::kFilter ||
             block_type == BlockType::kCompressionDictionary)
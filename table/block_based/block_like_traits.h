@@ -0,0 +1,142 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include <cassert>
+#include <cstring>
+
+#include "rocksdb/cache.h"
+#include "table/block_based/block.h"
+#include "table/block_based/parsed_full_filter_block.h"
+#include "table/format.h"
+#include "util/compression.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+// How the objects kept in the block cache for the blocks of a block based
+// table are created from the block contents. Shared by the table reader and
+// the table builder, which may insert the blocks it writes into the block
+// cache (see BlockBasedTableOptions::prepopulate_block_cache).
+template <typename TBlocklike>
+class BlocklikeTraits;
+
+template <>
+class BlocklikeTraits<BlockContents> {
+ public:
+  static BlockContents* Create(BlockContents&& contents,
+                               size_t /* read_amp_bytes_per_bit */,
+                               Statistics* /* statistics */,
+                               bool /* using_zstd */,
+                               const FilterPolicy* /* filter_policy */) {
+    return new BlockContents(std::move(contents));
+  }
+
+  static uint32_t GetNumRestarts(const BlockContents& /* contents */) {
+    return 0;
+  }
+
+  static const Slice& GetRawContents(const BlockContents& contents) {
+    return contents.data;
+  }
+};
+
+template <>
+class BlocklikeTraits<ParsedFullFilterBlock> {
+ public:
+  static ParsedFullFilterBlock* Create(BlockContents&& contents,
+                                       size_t /* read_amp_bytes_per_bit */,
+                                       Statistics* /* statistics */,
+                                       bool /* using_zstd */,
+                                       const FilterPolicy* filter_policy) {
+    return new ParsedFullFilterBlock(filter_policy, std::move(contents));
+  }
+
+  static uint32_t GetNumRestarts(const ParsedFullFilterBlock& /* block */) {
+    return 0;
+  }
+
+  static const Slice& GetRawContents(const ParsedFullFilterBlock& block) {
+    return block.GetBlockContentsData();
+  }
+};
+
+template <>
+class BlocklikeTraits<Block> {
+ public:
+  static Block* Create(BlockContents&& contents, size_t read_amp_bytes_per_bit,
+                       Statistics* statistics, bool /* using_zstd */,
+                       const FilterPolicy* /* filter_policy */) {
+    return new Block(std::move(contents), read_amp_bytes_per_bit, statistics);
+  }
+
+  static uint32_t GetNumRestarts(const Block& block) {
+    return block.NumRestarts();
+  }
+
+  static const Slice& GetRawContents(const Block& block) {
+    return block.ContentSlice();
+  }
+};
+
+template <>
+class BlocklikeTraits<UncompressionDict> {
+ public:
+  static UncompressionDict* Create(BlockContents&& contents,
+                                   size_t /* read_amp_bytes_per_bit */,
+                                   Statistics* /* statistics */,
+                                   bool using_zstd,
+                                   const FilterPolicy* /* filter_policy */) {
+    return new UncompressionDict(contents.data, std::move(contents.allocation),
+                                 using_zstd);
+  }
+
+  static uint32_t GetNumRestarts(const UncompressionDict& /* dict */) {
+    return 0;
+  }
+
+  static const Slice& GetRawContents(const UncompressionDict& dict) {
+    return dict.GetRawDict();
+  }
+};
+
+// Delete the entry resided in the cache.
+template <class Entry>
+void DeleteCachedEntry(const Slice& /*key*/, void* value) {
+  auto entry = reinterpret_cast<Entry*>(value);
+  delete entry;
+}
+
+// Callbacks for saving a cached block to the secondary cache of the block
+// cache. The uncompressed contents are saved, so that recreating the block
+// is just a copy.
+template <class TBlocklike>
+size_t SizeOfCachedEntry(void* obj) {
+  assert(obj != nullptr);
+  return BlocklikeTraits<TBlocklike>::GetRawContents(
+             *reinterpret_cast<TBlocklike*>(obj))
+      .size();
+}
+
+template <class TBlocklike>
+Status SaveCachedEntryTo(void* from_obj, size_t from_offset, size_t length,
+                         void* out) {
+  assert(from_obj != nullptr);
+  const Slice& contents = BlocklikeTraits<TBlocklike>::GetRawContents(
+      *reinterpret_cast<TBlocklike*>(from_obj));
+  assert(from_offset + length <= contents.size());
+  memcpy(out, contents.data() + from_offset, length);
+  return Status::OK();
+}
+
+template <class TBlocklike>
+const Cache::CacheItemHelper* GetCacheItemHelper() {
+  static const Cache::CacheItemHelper helper(&SizeOfCachedEntry<TBlocklike>,
+                                             &SaveCachedEntryTo<TBlocklike>,
+                                             &DeleteCachedEntry<TBlocklike>);
+  return &helper;
+}
+
+}  // namespace ROCKSDB_NAMESPACE
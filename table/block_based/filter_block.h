@@ -62,6 +62,9 @@ class FilterBlockBuilder {
   virtual void StartBlock(uint64_t block_offset) = 0;  // Start new block filter
   virtual void Add(const Slice& key) = 0;      // Add a key to current filter
   virtual size_t NumAdded() const = 0;         // Number of keys added
+  // Approximate memory used by the filter under construction, which is
+  // charged to the block cache with reserve_table_builder_memory.
+  virtual size_t ApproximateMemoryUsage() const = 0;
   Slice Finish() {                             // Generate Filter
     const BlockHandle empty_handle;
     Status dont_care_status;
@@ -50,6 +50,10 @@ class FastLocalBloomBitsBuilder : public BuiltinFilterBitsBuilder {
     }
   }
 
+  virtual size_t ApproximateMemoryUsage() const override {
+    return hash_entries_.size() * sizeof(uint64_t);
+  }
+
   virtual Slice Finish(std::unique_ptr<const char[]>* buf) override {
     size_t num_entry = hash_entries_.size();
     std::unique_ptr<char[]> mutable_buf;
@@ -357,6 +361,10 @@ class LegacyBloomBitsBuilder : public BuiltinFilterBitsBuilder {
 
   Slice Finish(std::unique_ptr<const char[]>* buf) override;
 
+  size_t ApproximateMemoryUsage() const override {
+    return hash_entries_.capacity() * sizeof(uint32_t);
+  }
+
   int CalculateNumEntry(const uint32_t bytes) override;
 
   uint32_t CalculateSpace(const int num_entry) override {
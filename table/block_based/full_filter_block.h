@@ -52,6 +52,9 @@ class FullFilterBlockBuilder : public FilterBlockBuilder {
   virtual void StartBlock(uint64_t /*block_offset*/) override {}
   virtual void Add(const Slice& key) override;
   virtual size_t NumAdded() const override { return num_added_; }
+  virtual size_t ApproximateMemoryUsage() const override {
+    return filter_bits_builder_->ApproximateMemoryUsage();
+  }
   virtual Slice Finish(const BlockHandle& tmp, Status* status) override;
   using FilterBlockBuilder::Finish;
 
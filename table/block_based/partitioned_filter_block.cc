@@ -84,6 +84,7 @@ void PartitionedFilterBlockBuilder::MaybeCutAFilterBlock(
   Slice filter = filter_bits_builder_->Finish(&filter_gc.back());
   std::string& index_key = p_index_builder_->GetPartitionKey();
   filters.push_back({index_key, filter});
+  finished_filters_size_ += filter.size();
   keys_added_to_partition_ = 0;
   Reset();
 }
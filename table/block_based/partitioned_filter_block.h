@@ -33,6 +33,10 @@ class PartitionedFilterBlockBuilder : public FullFilterBlockBuilder {
 
   void AddKey(const Slice& key) override;
   void Add(const Slice& key) override;
+  size_t ApproximateMemoryUsage() const override {
+    return FullFilterBlockBuilder::ApproximateMemoryUsage() +
+           finished_filters_size_;
+  }
 
   virtual Slice Finish(const BlockHandle& last_partition_block_handle,
                        Status* status) override;
@@ -49,6 +53,7 @@ class PartitionedFilterBlockBuilder : public FullFilterBlockBuilder {
   std::list<FilterEntry> filters;  // list of partitioned indexes and their keys
   std::unique_ptr<IndexBuilder> value;
   std::vector<std::unique_ptr<const char[]>> filter_gc;
+  size_t finished_filters_size_ = 0;  // total size of the filters in filter_gc
   bool finishing_filters =
       false;  // true if Finish is called once but not complete yet.
   // The policy of when cut a filter block and Finish it
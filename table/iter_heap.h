@@ -12,31 +12,34 @@
 namespace ROCKSDB_NAMESPACE {
 
 // When used with std::priority_queue, this comparison functor puts the
-// iterator with the max/largest key on top.
+// iterator with the max/largest key on top. KeyComparator is
+// InternalKeyComparator or a BytewiseInternalKeyComparator.
+template <class KeyComparator>
 class MaxIteratorComparator {
  public:
-  MaxIteratorComparator(const InternalKeyComparator* comparator)
+  MaxIteratorComparator(const KeyComparator* comparator)
       : comparator_(comparator) {}
 
   bool operator()(IteratorWrapper* a, IteratorWrapper* b) const {
     return comparator_->Compare(a->key(), b->key()) < 0;
   }
  private:
-  const InternalKeyComparator* comparator_;
+  const KeyComparator* comparator_;
 };
 
 // When used with std::priority_queue, this comparison functor puts the
 // iterator with the min/smallest key on top.
+template <class KeyComparator>
 class MinIteratorComparator {
  public:
-  MinIteratorComparator(const InternalKeyComparator* comparator)
+  MinIteratorComparator(const KeyComparator* comparator)
       : comparator_(comparator) {}
 
   bool operator()(IteratorWrapper* a, IteratorWrapper* b) const {
     return comparator_->Compare(a->key(), b->key()) > 0;
   }
  private:
-  const InternalKeyComparator* comparator_;
+  const KeyComparator* comparator_;
 };
 
 }  // namespace ROCKSDB_NAMESPACE
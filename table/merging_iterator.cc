@@ -28,17 +28,36 @@
 namespace ROCKSDB_NAMESPACE {
 // Without anonymous namespace here, we fail the warning -Wmissing-prototypes
 namespace {
-typedef BinaryHeap<IteratorWrapper*, MaxIteratorComparator> MergerMaxIterHeap;
-typedef BinaryHeap<IteratorWrapper*, MinIteratorComparator> MergerMinIterHeap;
+template <class KeyComparator>
+using MergerMaxIterHeap =
+    BinaryHeap<IteratorWrapper*, MaxIteratorComparator<KeyComparator>>;
+template <class KeyComparator>
+using MergerMinIterHeap =
+    BinaryHeap<IteratorWrapper*, MinIteratorComparator<KeyComparator>>;
+
+const BytewiseInternalKeyComparator<false> kBytewiseInternalKeyComparator{};
+const BytewiseInternalKeyComparator<true>
+    kReverseBytewiseInternalKeyComparator{};
 }  // namespace
 
 const size_t kNumIterReserve = 4;
 
+// The interface of the merging iterator for MergeIteratorBuilder, whatever
+// the comparator the implementation is specialized for.
 class MergingIterator : public InternalIterator {
  public:
-  MergingIterator(const InternalKeyComparator* comparator,
-                  InternalIterator** children, int n, bool is_arena_mode,
-                  bool prefix_seek_mode)
+  virtual void AddIterator(InternalIterator* iter) = 0;
+};
+
+// KeyComparator is InternalKeyComparator, or BytewiseInternalKeyComparator
+// so that the heap operations of the default comparator make no virtual
+// call per key comparison.
+template <class KeyComparator>
+class MergingIteratorImpl final : public MergingIterator {
+ public:
+  MergingIteratorImpl(const KeyComparator* comparator,
+                      InternalIterator** children, int n, bool is_arena_mode,
+                      bool prefix_seek_mode)
       : is_arena_mode_(is_arena_mode),
         comparator_(comparator),
         current_(nullptr),
@@ -62,7 +81,7 @@ class MergingIterator : public InternalIterator {
     }
   }
 
-  virtual void AddIterator(InternalIterator* iter) {
+  void AddIterator(InternalIterator* iter) override {
     assert(direction_ == kForward);
     children_.emplace_back(iter);
     if (pinned_iters_mgr_) {
@@ -75,7 +94,7 @@ class MergingIterator : public InternalIterator {
     }
   }
 
-  ~MergingIterator() override {
+  ~MergingIteratorImpl() override {
     for (auto& child : children_) {
       child.DeleteIter(is_arena_mode_);
     }
@@ -294,7 +313,7 @@ class MergingIterator : public InternalIterator {
   void InitMaxHeap();
 
   bool is_arena_mode_;
-  const InternalKeyComparator* comparator_;
+  const KeyComparator* comparator_;
   autovector<IteratorWrapper, kNumIterReserve> children_;
 
   // Cached pointer to child iterator with the current key, or nullptr if no
@@ -309,12 +328,12 @@ class MergingIterator : public InternalIterator {
     kReverse
   };
   Direction direction_;
-  MergerMinIterHeap minHeap_;
+  MergerMinIterHeap<KeyComparator> minHeap_;
   bool prefix_seek_mode_;
 
   // Max heap is used for reverse iteration, which is way less common than
   // forward.  Lazily initialize it to save memory.
-  std::unique_ptr<MergerMaxIterHeap> maxHeap_;
+  std::unique_ptr<MergerMaxIterHeap<KeyComparator>> maxHeap_;
   PinnedIteratorsManager* pinned_iters_mgr_;
 
   // In forward direction, process a child that is not in the min heap.
@@ -343,7 +362,9 @@ class MergingIterator : public InternalIterator {
   }
 };
 
-void MergingIterator::AddToMinHeapOrCheckStatus(IteratorWrapper* child) {
+template <class KeyComparator>
+void MergingIteratorImpl<KeyComparator>::AddToMinHeapOrCheckStatus(
+    IteratorWrapper* child) {
   if (child->Valid()) {
     assert(child->status().ok());
     minHeap_.push(child);
@@ -352,7 +373,9 @@ void MergingIterator::AddToMinHeapOrCheckStatus(IteratorWrapper* child) {
   }
 }
 
-void MergingIterator::AddToMaxHeapOrCheckStatus(IteratorWrapper* child) {
+template <class KeyComparator>
+void MergingIteratorImpl<KeyComparator>::AddToMaxHeapOrCheckStatus(
+    IteratorWrapper* child) {
   if (child->Valid()) {
     assert(child->status().ok());
     maxHeap_->push(child);
@@ -361,7 +384,8 @@ void MergingIterator::AddToMaxHeapOrCheckStatus(IteratorWrapper* child) {
   }
 }
 
-void MergingIterator::SwitchToForward() {
+template <class KeyComparator>
+void MergingIteratorImpl<KeyComparator>::SwitchToForward() {
   // Otherwise, advance the non-current children.  We advance current_
   // just after the if-block.
   ClearHeaps();
@@ -379,7 +403,8 @@ void MergingIterator::SwitchToForward() {
   direction_ = kForward;
 }
 
-void MergingIterator::SwitchToBackward() {
+template <class KeyComparator>
+void MergingIteratorImpl<KeyComparator>::SwitchToBackward() {
   ClearHeaps();
   InitMaxHeap();
   Slice target = key();
@@ -405,16 +430,49 @@ void MergingIterator::SwitchToBackward() {
   assert(current_ == CurrentReverse());
 }
 
-void MergingIterator::ClearHeaps() {
+template <class KeyComparator>
+void MergingIteratorImpl<KeyComparator>::ClearHeaps() {
   minHeap_.clear();
   if (maxHeap_) {
     maxHeap_->clear();
   }
 }
 
-void MergingIterator::InitMaxHeap() {
+template <class KeyComparator>
+void MergingIteratorImpl<KeyComparator>::InitMaxHeap() {
   if (!maxHeap_) {
-    maxHeap_.reset(new MergerMaxIterHeap(comparator_));
+    maxHeap_.reset(new MergerMaxIterHeap<KeyComparator>(comparator_));
+  }
+}
+
+template <class KeyComparator>
+static MergingIterator* NewMergingIteratorImpl(const KeyComparator* cmp,
+                                               InternalIterator** list, int n,
+                                               Arena* arena,
+                                               bool prefix_seek_mode) {
+  typedef MergingIteratorImpl<KeyComparator> Impl;
+  if (arena == nullptr) {
+    return new Impl(cmp, list, n, false, prefix_seek_mode);
+  } else {
+    auto mem = arena->AllocateAligned(sizeof(Impl));
+    return new (mem) Impl(cmp, list, n, true, prefix_seek_mode);
+  }
+}
+
+static MergingIterator* NewMergingIteratorImpl(const InternalKeyComparator* cmp,
+                                               InternalIterator** list, int n,
+                                               Arena* arena,
+                                               bool prefix_seek_mode) {
+  switch (GetUserComparatorKind(cmp->user_comparator())) {
+    case UserComparatorKind::kBytewise:
+      return NewMergingIteratorImpl(&kBytewiseInternalKeyComparator, list, n,
+                                    arena, prefix_seek_mode);
+    case UserComparatorKind::kReverseBytewise:
+      return NewMergingIteratorImpl(&kReverseBytewiseInternalKeyComparator,
+                                    list, n, arena, prefix_seek_mode);
+    default:
+      return NewMergingIteratorImpl<InternalKeyComparator>(
+          cmp, list, n, arena, prefix_seek_mode);
   }
 }
 
@@ -427,21 +485,15 @@ InternalIterator* NewMergingIterator(const InternalKeyComparator* cmp,
   } else if (n == 1) {
     return list[0];
   } else {
-    if (arena == nullptr) {
-      return new MergingIterator(cmp, list, n, false, prefix_seek_mode);
-    } else {
-      auto mem = arena->AllocateAligned(sizeof(MergingIterator));
-      return new (mem) MergingIterator(cmp, list, n, true, prefix_seek_mode);
-    }
+    return NewMergingIteratorImpl(cmp, list, n, arena, prefix_seek_mode);
   }
 }
 
 MergeIteratorBuilder::MergeIteratorBuilder(
     const InternalKeyComparator* comparator, Arena* a, bool prefix_seek_mode)
     : first_iter(nullptr), use_merging_iter(false), arena(a) {
-  auto mem = arena->AllocateAligned(sizeof(MergingIterator));
   merge_iter =
-      new (mem) MergingIterator(comparator, nullptr, 0, true, prefix_seek_mode);
+      NewMergingIteratorImpl(comparator, nullptr, 0, arena, prefix_seek_mode);
 }
 
 MergeIteratorBuilder::~MergeIteratorBuilder() {
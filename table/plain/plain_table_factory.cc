@@ -190,8 +190,12 @@ Status GetMemTableRepFactoryFromString(
     }
   } else if (opts_list[0] == "vector" || opts_list[0] == "VectorRepFactory") {
     // Expecting format
-    // vector:<count>
-    if (2 == len) {
+    // vector:<count>[:<sort_threads>]
+    if (3 == len) {
+      size_t count = ParseSizeT(opts_list[1]);
+      size_t sort_threads = ParseSizeT(opts_list[2]);
+      mem_factory = new VectorRepFactory(count, sort_threads);
+    } else if (2 == len) {
       size_t count = ParseSizeT(opts_list[1]);
       mem_factory = new VectorRepFactory(count);
     } else if (1 == len) {
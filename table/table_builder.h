@@ -17,6 +17,7 @@
 #include "db/table_properties_collector.h"
 #include "file/writable_file_writer.h"
 #include "options/cf_options.h"
+#include "rocksdb/listener.h"
 #include "rocksdb/options.h"
 #include "rocksdb/table_properties.h"
 #include "trace_replay/block_cache_tracer.h"
@@ -98,7 +99,8 @@ struct TableBuilderOptions {
       const uint64_t _creation_time = 0, const int64_t _oldest_key_time = 0,
       const uint64_t _target_file_size = 0,
       const uint64_t _file_creation_time = 0, const std::string& _db_id = "",
-      const std::string& _db_session_id = "")
+      const std::string& _db_session_id = "",
+      TableFileCreationReason _reason = TableFileCreationReason::kMisc)
       : ioptions(_ioptions),
         moptions(_moptions),
         internal_comparator(_internal_comparator),
@@ -114,7 +116,8 @@ struct TableBuilderOptions {
         target_file_size(_target_file_size),
         file_creation_time(_file_creation_time),
         db_id(_db_id),
-        db_session_id(_db_session_id) {}
+        db_session_id(_db_session_id),
+        reason(_reason) {}
 
   const ImmutableCFOptions& ioptions;
   const MutableCFOptions& moptions;
@@ -133,6 +136,7 @@ struct TableBuilderOptions {
   const uint64_t file_creation_time;
   const std::string db_id;
   const std::string db_session_id;
+  const TableFileCreationReason reason;
 };
 
 // TableBuilder provides the interface used to build a Table
@@ -9,8 +9,11 @@
 
 #pragma once
 #include <memory>
+#include <string>
+#include <vector>
 #include "db/range_tombstone_fragmenter.h"
 #include "rocksdb/slice_transform.h"
+#include "table/block_based/block_type.h"
 #include "table/get_context.h"
 #include "table/internal_iterator.h"
 #include "table/multiget_context.h"
@@ -26,6 +29,14 @@ struct ReadOptions;
 struct TableProperties;
 class GetContext;
 class MultiGetContext;
+class Cache;
+
+// A block of a table file found in the block cache, recorded to warm up the
+// block cache after a restart (see DBOptions::persist_block_cache_keys).
+struct CachedBlockInfo {
+  uint64_t offset;
+  BlockType type;
+};
 
 // A Table (also referred to as SST) is a sorted map from strings to strings.
 // Tables are immutable and persistent.  A Table may be safely accessed from
@@ -142,6 +153,28 @@ class TableReader {
                                 TableReaderCaller /*caller*/) {
     return Status::NotSupported("VerifyChecksum() not supported");
   }
+
+  // Returns the block cache this table caches its blocks in, and the prefix
+  // of their cache keys. The rest of a cache key is the varint64 encoded
+  // offset of the block in the file.
+  virtual Status GetBlockCacheKeyPrefix(Cache** /*block_cache*/,
+                                        std::string* /*prefix*/) const {
+    return Status::NotSupported("GetBlockCacheKeyPrefix() not supported");
+  }
+
+  // Returns the type of the block at `offset`, which was found in the block
+  // cache under this table's key prefix.
+  virtual BlockType GetBlockTypeAt(uint64_t /*offset*/) const {
+    return BlockType::kInvalid;
+  }
+
+  // Reads the given blocks, as returned by GetBlockTypeAt(), with batched
+  // MultiRead() calls and inserts them into the block cache.
+  virtual Status LoadBlocksIntoCache(
+      const ReadOptions& /*read_options*/,
+      const std::vector<CachedBlockInfo>& /*blocks*/) {
+    return Status::NotSupported("LoadBlocksIntoCache() not supported");
+  }
 };
 
 }  // namespace ROCKSDB_NAMESPACE
@@ -21,6 +21,7 @@
 #include "monitoring/histogram.h"
 #include "util/gflags_compat.h"
 #include "util/string_util.h"
+#include "utilities/simulator_cache/cache_policy_simulator.h"
 
 using GFLAGS_NAMESPACE::ParseCommandLineFlags;
 
@@ -149,6 +150,20 @@ DEFINE_int32(analyze_correlation_coefficients_max_number_of_values, 1000000,
              "selects 'max' number of values.");
 DEFINE_string(human_readable_trace_file_path, "",
               "The filt path that saves human readable access records.");
+DEFINE_string(
+    cache_policy_sim_capacities, "",
+    "Simulate the cache policies of cache_policy_sim_policies at these "
+    "comma separated capacities, e.g. 64M,256M,1G, instead of analyzing the "
+    "trace. The miss ratios and byte miss ratios are written as CSV tables "
+    "to block_cache_analysis_result_dir.");
+DEFINE_string(
+    cache_policy_sim_policies, "lru,clock,arc,lirs,tinylfu,lru_priority",
+    "The comma separated cache policies to simulate. Supported policies are "
+    "lru, clock, arc, lirs, tinylfu and lru_priority, which is LRUCache with "
+    "its high priority pool.");
+DEFINE_int32(cache_policy_sim_threads, 4,
+             "The number of threads simulating the capacities of "
+             "cache_policy_sim_capacities. Each thread reads the trace.");
 
 namespace ROCKSDB_NAMESPACE {
 namespace {
@@ -2104,6 +2119,59 @@ std::vector<uint64_t> parse_buckets(const std::string& bucket_str) {
   return buckets;
 }
 
+int simulate_cache_policies(uint64_t warmup_seconds,
+                            uint32_t downsample_ratio) {
+  CachePolicySimulationOptions options;
+  options.policies.clear();
+  std::stringstream policies(FLAGS_cache_policy_sim_policies);
+  while (policies.good()) {
+    std::string policy;
+    getline(policies, policy, ',');
+    options.policies.push_back(policy);
+  }
+  std::stringstream capacities(FLAGS_cache_policy_sim_capacities);
+  while (capacities.good()) {
+    std::string capacity;
+    getline(capacities, capacity, ',');
+    options.capacities.push_back(ParseUint64(capacity));
+  }
+  options.num_threads = FLAGS_cache_policy_sim_threads > 0
+                            ? FLAGS_cache_policy_sim_threads
+                            : 1;
+  options.downsample_ratio = downsample_ratio > 0 ? downsample_ratio : 1;
+  options.warmup_seconds = warmup_seconds;
+
+  Env* env = Env::Default();
+  std::vector<CachePolicySimulationResult> results;
+  uint64_t start = env->NowMicros();
+  Status s = SimulateCachePolicies(env, FLAGS_block_cache_trace_path, options,
+                                   &results);
+  if (!s.ok()) {
+    fprintf(stderr, "Cannot simulate the cache policies %s\n",
+            s.ToString().c_str());
+    exit(1);
+  }
+  fprintf(stdout, "Simulated the cache policies in %" PRIu64 " seconds\n",
+          (env->NowMicros() - start) / kMicrosInSecond);
+  for (const auto& result : results) {
+    fprintf(stdout,
+            "%s capacity %" PRIu64 ": miss ratio %.2f byte miss ratio %.2f "
+            "accesses %" PRIu64 "\n",
+            result.policy.c_str(), result.capacity, result.miss_ratio(),
+            result.byte_miss_ratio(), result.num_accesses);
+  }
+  if (!FLAGS_block_cache_analysis_result_dir.empty()) {
+    s = WriteCachePolicySimulationResults(
+        env, FLAGS_block_cache_analysis_result_dir, results);
+    if (!s.ok()) {
+      fprintf(stderr, "Cannot write the simulation results %s\n",
+              s.ToString().c_str());
+      exit(1);
+    }
+  }
+  return 0;
+}
+
 int block_cache_trace_analyzer_tool(int argc, char** argv) {
   ParseCommandLineFlags(&argc, &argv, true);
   if (FLAGS_block_cache_trace_path.empty()) {
@@ -2115,6 +2183,9 @@ int block_cache_trace_analyzer_tool(int argc, char** argv) {
   uint32_t downsample_ratio = FLAGS_block_cache_trace_downsample_ratio > 0
                                   ? FLAGS_block_cache_trace_downsample_ratio
                                   : 0;
+  if (!FLAGS_cache_policy_sim_capacities.empty()) {
+    return simulate_cache_policies(warmup_seconds, downsample_ratio);
+  }
   std::vector<CacheConfiguration> cache_configs =
       parse_cache_config_file(FLAGS_block_cache_sim_config_path);
   std::unique_ptr<BlockCacheTraceSimulator> cache_simulator;
@@ -19,8 +19,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/types.h>
+#include <algorithm>
 #include <atomic>
 #include <cinttypes>
+#include <cmath>
 #include <condition_variable>
 #include <cstddef>
 #include <memory>
@@ -37,6 +39,7 @@
 #include "options/cf_options.h"
 #include "port/port.h"
 #include "port/stack_trace.h"
+#include "rocksdb/arena_block_pool.h"
 #include "rocksdb/cache.h"
 #include "rocksdb/db.h"
 #include "rocksdb/env.h"
@@ -46,6 +49,7 @@
 #include "rocksdb/perf_context.h"
 #include "rocksdb/persistent_cache.h"
 #include "rocksdb/rate_limiter.h"
+#include "rocksdb/secondary_cache.h"
 #include "rocksdb/slice.h"
 #include "rocksdb/slice_transform.h"
 #include "rocksdb/stats_history.h"
@@ -112,8 +116,10 @@ DEFINE_string(
     "readtocache,"
     "readreverse,"
     "readwhilewriting,"
+    "readwhiledeletingrange,"
     "readwhilemerging,"
     "readwhilescanning,"
+    "zipfreadwhilescanning,"
     "readrandomwriterandom,"
     "updaterandom,"
     "xorupdaterandom,"
@@ -156,10 +162,15 @@ DEFINE_string(
     "\treadmissing   -- read N missing keys in random order\n"
     "\treadwhilewriting      -- 1 writer, N threads doing random "
     "reads\n"
+    "\treadwhiledeletingrange -- 1 writer that also issues a DeleteRange "
+    "every --writes_per_range_tombstone writes (10 by default), N threads "
+    "doing random reads\n"
     "\treadwhilemerging      -- 1 merger, N threads doing random "
     "reads\n"
     "\treadwhilescanning     -- 1 thread doing full table scan, "
     "N threads doing random reads\n"
+    "\tzipfreadwhilescanning -- same as readwhilescanning with zipf "
+    "distributed reads, reports the block cache hit rate of the reads\n"
     "\treadrandomwriterandom -- N threads doing random-read, "
     "random-write\n"
     "\tupdaterandom  -- N threads doing read-modify-write for random "
@@ -196,6 +207,9 @@ DEFINE_string(
     "\tcompactall  -- Compact the entire DB\n"
     "\tstats       -- Print DB stats\n"
     "\tresetstats  -- Reset DB stats\n"
+    "\trestart     -- Close the DB, empty the block cache and reopen the DB, "
+    "reporting the time to open it and to warm up the block cache again "
+    "(see --persist_block_cache_keys)\n"
     "\tlevelstats  -- Print the number of files and bytes per level\n"
     "\tsstables    -- Print sstable info\n"
     "\theapprofile -- Dump a heap profile (if supported by this port)\n"
@@ -309,6 +323,12 @@ DEFINE_double(read_random_exp_range, 0.0,
               "The larger the number is, the more skewed the reads are. "
               "Only used in readrandom and multireadrandom benchmarks.");
 
+DEFINE_double(read_zipf_alpha, 0.0,
+              "If > 0, read random's key follows a Zipf distribution with "
+              "this exponent, the most popular keys being spread over the "
+              "key space. Used in place of read_random_exp_range. "
+              "zipfreadwhilescanning uses 0.99 if it is not set.");
+
 DEFINE_bool(histogram, false, "Print histogram of operation timings");
 
 DEFINE_bool(enable_numa, false,
@@ -326,6 +346,11 @@ DEFINE_int64(db_write_buffer_size,
 DEFINE_bool(cost_write_buffer_to_cache, false,
             "The usage of memtable is costed to the block cache");
 
+DEFINE_int64(arena_block_pool_capacity, 0,
+             "If positive, memtables allocate their arena blocks from an "
+             "ArenaBlockPool that keeps up to this many bytes of the blocks "
+             "of freed memtables");
+
 DEFINE_int64(write_buffer_size, ROCKSDB_NAMESPACE::Options().write_buffer_size,
              "Number of bytes to buffer in memtable before compacting");
 
@@ -455,6 +480,28 @@ DEFINE_double(cache_high_pri_pool_ratio, 0.0,
 DEFINE_bool(use_clock_cache, false,
             "Replace default LRU block cache with clock cache.");
 
+DEFINE_bool(cache_tiny_lfu_admission, false,
+            "Admit blocks into the LRU block cache only if they are estimated "
+            "to be read more often than the block they evict. See "
+            "LRUCacheOptions::tiny_lfu_admission.");
+
+DEFINE_bool(persist_block_cache_keys,
+            ROCKSDB_NAMESPACE::Options().persist_block_cache_keys,
+            "Record the cached blocks when the DB is closed and read them "
+            "back into the block cache when it is opened again.");
+
+DEFINE_int32(block_cache_warmup_threads,
+             ROCKSDB_NAMESPACE::Options().block_cache_warmup_threads,
+             "Number of threads reading back the blocks recorded by "
+             "--persist_block_cache_keys.");
+
+DEFINE_int64(secondary_cache_size, 0,
+             "Number of bytes to use as a compressed secondary cache behind "
+             "the LRU block cache. 0 disables the secondary cache.");
+
+DEFINE_string(secondary_cache_compression_type, "lz4",
+              "Algorithm used to compress blocks in the secondary cache");
+
 DEFINE_int64(simcache_size, -1,
              "Number of bytes to use as a simcache of "
              "uncompressed data. Nagative value disables simcache.");
@@ -462,6 +509,23 @@ DEFINE_int64(simcache_size, -1,
 DEFINE_bool(cache_index_and_filter_blocks, false,
             "Cache index/filter blocks in block cache.");
 
+DEFINE_int32(prepopulate_block_cache, 0,
+             "Insert the blocks of new table files into the block cache: "
+             "0 for never, 1 for the files written by flush, 2 for the files "
+             "written by flush and by compaction to a level of at most "
+             "--prepopulate_block_cache_max_level");
+
+DEFINE_int32(prepopulate_block_cache_max_level, 0,
+             "Highest compaction output level prepopulating the block cache "
+             "with --prepopulate_block_cache=2");
+
+DEFINE_bool(reserve_table_builder_memory, false,
+            "Charge the memory of the filters under construction by table "
+            "builders to the block cache");
+
+DEFINE_bool(reserve_table_reader_memory, false,
+            "Charge the memory of the table readers to the block cache");
+
 DEFINE_bool(use_cache_memkind_kmem_allocator, false,
             "Use memkind kmem allocator for block cache.");
 
@@ -581,6 +645,12 @@ DEFINE_bool(memtable_whole_key_filtering, false,
 DEFINE_bool(memtable_use_huge_page, false,
             "Try to use huge page in memtables.");
 
+DEFINE_double(mempurge_threshold,
+              ROCKSDB_NAMESPACE::Options().mempurge_threshold,
+              "Garbage collect full memtables in memory instead of flushing "
+              "them if the result is below this fraction of their size. 0 "
+              "disables it.");
+
 DEFINE_bool(use_existing_db, false, "If true, do not destroy the existing"
             " database.  If you set this flag and also specify a benchmark that"
             " wants a fresh database, that benchmark will fail.");
@@ -648,6 +718,10 @@ DEFINE_bool(disable_wal, false, "If true, do not write WAL for write.");
 
 DEFINE_string(wal_dir, "", "If not empty, use the given dir for WAL");
 
+DEFINE_string(wal_compression, "none",
+              "Algorithm used to compress the WAL records: none, zlib, lz4 "
+              "or zstd");
+
 DEFINE_string(truth_db, "/dev/shm/truth_db/dbbench",
               "Truth key/values used when using verify");
 
@@ -2376,6 +2450,9 @@ class Benchmark {
   int64_t reads_;
   int64_t deletes_;
   double read_random_exp_range_;
+  // Cumulative probabilities of the key ranks, if reads follow a Zipf
+  // distribution.
+  std::vector<double> zipf_cdf_;
   int64_t writes_;
   int64_t readwrites_;
   int64_t merge_keys_;
@@ -2654,7 +2731,8 @@ class Benchmark {
     const char* Name() const override { return "KeepFilter"; }
   };
 
-  std::shared_ptr<Cache> NewCache(int64_t capacity) {
+  std::shared_ptr<Cache> NewCache(int64_t capacity,
+                                  int64_t secondary_capacity = 0) {
     if (capacity <= 0) {
       return nullptr;
     }
@@ -2679,9 +2757,19 @@ class Benchmark {
         exit(1);
 #endif
       } else {
-        return NewLRUCache(
+        LRUCacheOptions opts(
             static_cast<size_t>(capacity), FLAGS_cache_numshardbits,
             false /*strict_capacity_limit*/, FLAGS_cache_high_pri_pool_ratio);
+        opts.tiny_lfu_admission = FLAGS_cache_tiny_lfu_admission;
+        if (secondary_capacity > 0) {
+          opts.secondary_cache = NewCompressedSecondaryCache(
+              CompressedSecondaryCacheOptions(
+                  static_cast<size_t>(secondary_capacity),
+                  FLAGS_cache_numshardbits,
+                  StringToCompressionType(
+                      FLAGS_secondary_cache_compression_type.c_str())));
+        }
+        return NewLRUCache(opts);
       }
     }
     return nullptr;
@@ -2689,7 +2777,7 @@ class Benchmark {
 
  public:
   Benchmark()
-      : cache_(NewCache(FLAGS_cache_size)),
+      : cache_(NewCache(FLAGS_cache_size, FLAGS_secondary_cache_size)),
         compressed_cache_(NewCache(FLAGS_compressed_cache_size)),
         filter_policy_(FLAGS_bloom_bits >= 0
                            ? NewBloomFilterPolicy(FLAGS_bloom_bits,
@@ -2950,6 +3038,7 @@ class Benchmark {
       max_num_range_tombstones_ = FLAGS_max_num_range_tombstones;
       write_options_ = WriteOptions();
       read_random_exp_range_ = FLAGS_read_random_exp_range;
+      InitZipf(FLAGS_read_zipf_alpha);
       if (FLAGS_sync) {
         write_options_.sync = true;
       }
@@ -3105,9 +3194,21 @@ class Benchmark {
       } else if (name == "readwhilewriting") {
         num_threads++;  // Add extra thread for writing
         method = &Benchmark::ReadWhileWriting;
+      } else if (name == "readwhiledeletingrange") {
+        num_threads++;  // Add extra thread for writing
+        if (writes_per_range_tombstone_ <= 0) {
+          writes_per_range_tombstone_ = 10;
+        }
+        method = &Benchmark::ReadWhileDeletingRange;
       } else if (name == "readwhilemerging") {
         num_threads++;  // Add extra thread for writing
         method = &Benchmark::ReadWhileMerging;
+      } else if (name == "zipfreadwhilescanning") {
+        num_threads++;  // Add extra thread for scanning
+        if (FLAGS_read_zipf_alpha <= 0) {
+          InitZipf(0.99);
+        }
+        method = &Benchmark::ZipfReadWhileScanning;
       } else if (name == "readwhilescanning") {
         num_threads++;  // Add extra thread for scaning
         method = &Benchmark::ReadWhileScanning;
@@ -3172,6 +3273,8 @@ class Benchmark {
         PrintStats("rocksdb.stats");
       } else if (name == "resetstats") {
         ResetStats();
+      } else if (name == "restart") {
+        Restart();
       } else if (name == "verify") {
         VerifyDBFromDB(FLAGS_truth_db);
       } else if (name == "levelstats") {
@@ -3347,6 +3450,10 @@ class Benchmark {
           stdout, "SIMULATOR CACHE STATISTICS:\n%s\n",
           static_cast_with_check<SimCache>(cache_.get())->ToString().c_str());
     }
+    if (open_options_.arena_block_pool) {
+      fprintf(stdout, "ARENA BLOCK POOL STATISTICS:\n%s\n",
+              open_options_.arena_block_pool->GetStats().ToString().c_str());
+    }
 
 #ifndef ROCKSDB_LITE
     if (FLAGS_use_secondary_db) {
@@ -3641,6 +3748,10 @@ class Benchmark {
       options.write_buffer_manager.reset(
           new WriteBufferManager(FLAGS_db_write_buffer_size, cache_));
     }
+    if (FLAGS_arena_block_pool_capacity > 0) {
+      options.arena_block_pool = NewArenaBlockPool(
+          static_cast<size_t>(FLAGS_arena_block_pool_capacity));
+    }
     options.write_buffer_size = FLAGS_write_buffer_size;
     options.max_write_buffer_number = FLAGS_max_write_buffer_number;
     options.min_write_buffer_number_to_merge =
@@ -3683,6 +3794,7 @@ class Benchmark {
     options.memtable_huge_page_size = FLAGS_memtable_use_huge_page ? 2048 : 0;
     options.memtable_prefix_bloom_size_ratio = FLAGS_memtable_bloom_size_ratio;
     options.memtable_whole_key_filtering = FLAGS_memtable_whole_key_filtering;
+    options.mempurge_threshold = FLAGS_mempurge_threshold;
     if (FLAGS_memtable_insert_with_hint_prefix_size > 0) {
       options.memtable_insert_with_hint_prefix_extractor.reset(
           NewCappedPrefixTransform(
@@ -3838,6 +3950,15 @@ class Benchmark {
       }
       block_based_options.cache_index_and_filter_blocks =
           FLAGS_cache_index_and_filter_blocks;
+      block_based_options.prepopulate_block_cache =
+          static_cast<BlockBasedTableOptions::PrepopulateBlockCache>(
+              FLAGS_prepopulate_block_cache);
+      block_based_options.prepopulate_block_cache_max_level =
+          FLAGS_prepopulate_block_cache_max_level;
+      block_based_options.reserve_table_builder_memory =
+          FLAGS_reserve_table_builder_memory;
+      block_based_options.reserve_table_reader_memory =
+          FLAGS_reserve_table_reader_memory;
       block_based_options.pin_l0_filter_and_index_blocks_in_cache =
           FLAGS_pin_l0_filter_and_index_blocks_in_cache;
       block_based_options.pin_top_level_index_and_filter =
@@ -3952,6 +4073,8 @@ class Benchmark {
     options.delayed_write_rate = FLAGS_delayed_write_rate;
     options.allow_concurrent_memtable_write =
         FLAGS_allow_concurrent_memtable_write;
+    options.persist_block_cache_keys = FLAGS_persist_block_cache_keys;
+    options.block_cache_warmup_threads = FLAGS_block_cache_warmup_threads;
     options.inplace_update_support = FLAGS_inplace_update_support;
     options.inplace_update_num_locks = FLAGS_inplace_update_num_locks;
     options.enable_write_thread_adaptive_yield =
@@ -4041,6 +4164,8 @@ class Benchmark {
     options.create_missing_column_families = FLAGS_num_column_families > 1;
     options.statistics = dbstats;
     options.wal_dir = FLAGS_wal_dir;
+    options.wal_compression =
+        StringToCompressionType(FLAGS_wal_compression.c_str());
     options.create_if_missing = !FLAGS_use_existing_db;
     options.dump_malloc_stats = FLAGS_dump_malloc_stats;
     options.stats_dump_period_sec =
@@ -5124,10 +5249,36 @@ class Benchmark {
     }
   }
 
+  // Precompute the CDF of a Zipf distribution over the FLAGS_num keys, so
+  // that drawing a key is a binary search. alpha <= 0 disables it.
+  void InitZipf(double alpha) {
+    zipf_cdf_.clear();
+    if (alpha <= 0 || FLAGS_num <= 0) {
+      return;
+    }
+    zipf_cdf_.resize(FLAGS_num);
+    double sum = 0;
+    for (int64_t i = 0; i < FLAGS_num; i++) {
+      sum += 1.0 / std::pow(static_cast<double>(i + 1), alpha);
+      zipf_cdf_[i] = sum;
+    }
+    for (int64_t i = 0; i < FLAGS_num; i++) {
+      zipf_cdf_[i] /= sum;
+    }
+  }
+
   int64_t GetRandomKey(Random64* rand) {
     uint64_t rand_int = rand->Next();
     int64_t key_rand;
-    if (read_random_exp_range_ == 0) {
+    if (!zipf_cdf_.empty()) {
+      double u = static_cast<double>(rand_int >> 11) * (1.0 / (1ULL << 53));
+      uint64_t rank = static_cast<uint64_t>(
+          std::lower_bound(zipf_cdf_.begin(), zipf_cdf_.end(), u) -
+          zipf_cdf_.begin());
+      // Map to a different number to avoid locality.
+      const uint64_t kBigPrime = 0x5bd1e995;
+      key_rand = static_cast<int64_t>((rank * kBigPrime) % FLAGS_num);
+    } else if (read_random_exp_range_ == 0) {
       key_rand = rand_int % FLAGS_num;
     } else {
       const uint64_t kBigInt = static_cast<uint64_t>(1U) << 62;
@@ -6019,6 +6170,21 @@ class Benchmark {
     }
   }
 
+  // Like ReadWhileWriting, except that the writer also deletes
+  // --range_tombstone_width keys with a DeleteRange after every
+  // --writes_per_range_tombstone writes, up to --max_num_range_tombstones
+  // range deletions if it is positive. The reads then have to check the
+  // range tombstones of the memtables.
+  void ReadWhileDeletingRange(ThreadState* thread) {
+    if (thread->tid > 0) {
+      ReadRandom(thread);
+    } else {
+      BGWriter(thread, kDelete);
+    }
+  }
+
+  // write_merge: kWrite or kMerge, or kDelete for writes mixed with range
+  // deletions.
   void BGWriter(ThreadState* thread, enum OperationType write_merge) {
     // Special thread that keeps writing until other threads are done.
     RandomGenerator gen;
@@ -6035,11 +6201,14 @@ class Benchmark {
 
     std::unique_ptr<const char[]> key_guard;
     Slice key = AllocateKey(&key_guard);
+    std::unique_ptr<const char[]> end_key_guard;
+    Slice end_key = AllocateKey(&end_key_guard);
     std::unique_ptr<char[]> ts_guard;
     if (user_timestamp_size_ > 0) {
       ts_guard.reset(new char[user_timestamp_size_]);
     }
     uint32_t written = 0;
+    int64_t range_tombstones = 0;
     bool hint_printed = false;
 
     while (true) {
@@ -6075,10 +6244,10 @@ class Benchmark {
         ts = mock_app_clock_->Allocate(ts_guard.get());
         write_options_.timestamp = &ts;
       }
-      if (write_merge == kWrite) {
-        s = db->Put(write_options_, key, val);
-      } else {
+      if (write_merge == kMerge) {
         s = db->Merge(write_options_, key, val);
+      } else {
+        s = db->Put(write_options_, key, val);
       }
       // Restore write_options_
       if (user_timestamp_size_ > 0) {
@@ -6093,6 +6262,23 @@ class Benchmark {
       bytes += key.size() + val.size() + user_timestamp_size_;
       thread->stats.FinishedOps(&db_, db_.db, 1, kWrite);
 
+      if (write_merge == kDelete && written % writes_per_range_tombstone_ == 0 &&
+          (max_num_range_tombstones_ <= 0 ||
+           range_tombstones < max_num_range_tombstones_)) {
+        int64_t begin_num = thread->rand.Next() % FLAGS_num;
+        GenerateKeyFromInt(begin_num, FLAGS_num, &key);
+        GenerateKeyFromInt(begin_num + range_tombstone_width_, FLAGS_num,
+                           &end_key);
+        s = db->DeleteRange(write_options_, db->DefaultColumnFamily(), key,
+                            end_key);
+        if (!s.ok()) {
+          fprintf(stderr, "delete range error: %s\n", s.ToString().c_str());
+          exit(1);
+        }
+        range_tombstones++;
+        thread->stats.FinishedOps(&db_, db_.db, 1, kDelete);
+      }
+
       if (FLAGS_benchmark_write_rate_limit > 0) {
         write_rate_limiter->Request(
             key.size() + val.size(), Env::IO_HIGH,
@@ -6110,6 +6296,35 @@ class Benchmark {
     }
   }
 
+  // Like ReadWhileScanning, except that the scan thread keeps filling the
+  // block cache with blocks it reads once, while the other threads read a
+  // zipf distributed, mostly cached, working set. Each reader reports the
+  // block cache hit rate of its own reads, which shows how well the cache
+  // resists the scan, e.g. with --cache_tiny_lfu_admission.
+  void ZipfReadWhileScanning(ThreadState* thread) {
+    if (thread->tid == 0) {
+      BGScan(thread);
+      return;
+    }
+    PerfLevel prev_perf_level = GetPerfLevel();
+    if (prev_perf_level < PerfLevel::kEnableCount) {
+      SetPerfLevel(PerfLevel::kEnableCount);
+    }
+    get_perf_context()->Reset();
+    ReadRandom(thread);
+    uint64_t hits = get_perf_context()->block_cache_hit_count;
+    uint64_t misses = get_perf_context()->block_read_count;
+    SetPerfLevel(prev_perf_level);
+
+    char msg[100];
+    snprintf(msg, sizeof(msg),
+             "(block cache hit rate %.2f%%, %" PRIu64 " hits %" PRIu64
+             " misses)\n",
+             hits + misses == 0 ? 0.0 : 100.0 * hits / (hits + misses), hits,
+             misses);
+    thread->stats.AddMessage(msg);
+  }
+
   void BGScan(ThreadState* thread) {
     if (FLAGS_num_multi_db > 0) {
       fprintf(stderr, "Not supporting multiple DBs.\n");
@@ -7200,6 +7415,37 @@ class Benchmark {
     }
   }
 
+  // Simulates a process restart: the block cache is emptied while the DB is
+  // closed. Time-to-warm is the time until the blocks recorded at close, if
+  // any, are back in the block cache.
+  void Restart() {
+    if (db_.db == nullptr || !multi_dbs_.empty()) {
+      fprintf(stdout, "%-12s : skipped (needs a single DB)\n", "restart");
+      return;
+    }
+    const size_t usage_before = cache_ ? cache_->GetUsage() : 0;
+    db_.DeleteDBs();
+    if (cache_) {
+      cache_->EraseUnRefEntries();
+    }
+    const uint64_t start = FLAGS_env->NowMicros();
+    Open(&open_options_);
+    const uint64_t opened = FLAGS_env->NowMicros();
+    Status s = db_.db->WaitForBlockCacheWarmup();
+    if (!s.ok()) {
+      fprintf(stderr, "WaitForBlockCacheWarmup: %s\n", s.ToString().c_str());
+      ErrorExit();
+    }
+    const uint64_t warm = FLAGS_env->NowMicros();
+    const size_t usage_after = cache_ ? cache_->GetUsage() : 0;
+    fprintf(stdout,
+            "%-12s : open %.3f ms, time-to-warm %.3f ms, block cache usage "
+            "%" ROCKSDB_PRIszt " bytes (%" ROCKSDB_PRIszt
+            " bytes before restart)\n",
+            "restart", (opened - start) / 1000.0, (warm - start) / 1000.0,
+            usage_after, usage_before);
+  }
+
   void ResetStats() {
     if (db_.db != nullptr) {
       db_.db->ResetStats();
@@ -0,0 +1,284 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+//
+// Measures the key comparisons of the memtable skip list, the data block
+// seeks and the merging iterator with BytewiseComparator(), whose code paths
+// are specialized to compare keys inline, against a comparator that orders
+// keys the same way but goes through the virtual Comparator::Compare().
+
+#ifndef GFLAGS
+#include <cstdio>
+int main() {
+  fprintf(stderr, "Please install gflags to run rocksdb tools\n");
+  return 1;
+}
+#else
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "db/dbformat.h"
+#include "db/memtable.h"
+#include "memory/arena.h"
+#include "port/port.h"
+#include "port/stack_trace.h"
+#include "rocksdb/comparator.h"
+#include "rocksdb/env.h"
+#include "rocksdb/memtablerep.h"
+#include "table/block_based/block.h"
+#include "table/block_based/block_builder.h"
+#include "table/format.h"
+#include "table/internal_iterator.h"
+#include "table/merging_iterator.h"
+#include "util/coding.h"
+#include "util/gflags_compat.h"
+#include "util/random.h"
+#include "util/string_util.h"
+#include "util/stop_watch.h"
+
+using GFLAGS_NAMESPACE::ParseCommandLineFlags;
+using GFLAGS_NAMESPACE::SetUsageMessage;
+
+DEFINE_string(benchmarks, "skiplist,block,merging",
+              "Comma-separated list of benchmarks to run. Options:\n"
+              "\tskiplist -- insert num_keys keys into a SkipListRep, then "
+              "seek num_ops\n"
+              "\t            random keys\n"
+              "\tblock    -- seek num_ops random keys in data blocks of "
+              "block_keys keys\n"
+              "\tmerging  -- scan num_children data blocks through a merging "
+              "iterator\n"
+              "\t            until num_ops keys are read");
+
+DEFINE_int32(num_keys, 1000000, "Number of keys of the skip list");
+
+DEFINE_int32(num_ops, 1000000, "Number of seeks or Next() per benchmark");
+
+DEFINE_int32(key_size, 16, "Size of the user keys, at least 8");
+
+DEFINE_int32(block_keys, 256, "Number of keys per data block");
+
+DEFINE_int32(block_restart_interval, 16, "Restart interval of data blocks");
+
+DEFINE_int32(num_children, 8, "Number of children of the merging iterator");
+
+DEFINE_int64(seed, 0, "Seed for random number generators");
+
+namespace ROCKSDB_NAMESPACE {
+
+// Orders keys like BytewiseComparator(), but is a different object, so that
+// the keys are compared through the generic, virtual code paths.
+class VirtualBytewiseComparator : public Comparator {
+ public:
+  const char* Name() const override { return "VirtualBytewiseComparator"; }
+  int Compare(const Slice& a, const Slice& b) const override {
+    return BytewiseComparator()->Compare(a, b);
+  }
+  void FindShortestSeparator(std::string* start,
+                             const Slice& limit) const override {
+    BytewiseComparator()->FindShortestSeparator(start, limit);
+  }
+  void FindShortSuccessor(std::string* key) const override {
+    BytewiseComparator()->FindShortSuccessor(key);
+  }
+};
+
+// The user key of number k: big-endian k padded to key_size.
+std::string MakeUserKey(uint64_t k) {
+  std::string key;
+  for (int shift = 56; shift >= 0; shift -= 8) {
+    key.push_back(static_cast<char>(k >> shift));
+  }
+  key.resize(std::max(FLAGS_key_size, 8), 'k');
+  return key;
+}
+
+std::string MakeInternalKey(uint64_t k) {
+  return InternalKey(MakeUserKey(k), k + 1, kTypeValue).Encode().ToString();
+}
+
+// Returns the nanoseconds per operation of num_ops calls of func.
+template <class Func>
+double TimeOps(uint64_t num_ops, Func&& func) {
+  StopWatchNano timer(Env::Default(), true);
+  for (uint64_t i = 0; i < num_ops; ++i) {
+    func(i);
+  }
+  return static_cast<double>(timer.ElapsedNanos()) /
+         std::max(num_ops, uint64_t{1});
+}
+
+void SkipListBenchmark(const Comparator* ucmp, double* insert_ns,
+                       double* seek_ns) {
+  InternalKeyComparator icmp(ucmp);
+  MemTable::KeyComparator key_cmp(icmp);
+  Arena arena;
+  SkipListFactory factory;
+  std::unique_ptr<MemTableRep> rep(
+      factory.CreateMemTableRep(key_cmp, &arena, nullptr, nullptr));
+
+  const uint64_t num_keys = FLAGS_num_keys;
+  std::vector<uint64_t> order(num_keys);
+  for (uint64_t i = 0; i < num_keys; ++i) {
+    order[i] = i;
+  }
+  RandomShuffle(order.begin(), order.end(),
+                static_cast<uint32_t>(FLAGS_seed));
+  std::vector<std::string> keys(num_keys);
+  for (uint64_t i = 0; i < num_keys; ++i) {
+    keys[i] = MakeInternalKey(order[i]);
+  }
+  *insert_ns = TimeOps(num_keys, [&](uint64_t i) {
+    const std::string& key = keys[i];
+    char* buf = nullptr;
+    uint32_t len = static_cast<uint32_t>(key.size());
+    KeyHandle handle = rep->Allocate(VarintLength(len) + len + 1, &buf);
+    char* p = EncodeVarint32(buf, len);
+    memcpy(p, key.data(), len);
+    p[len] = 0;  // empty value
+    rep->Insert(handle);
+  });
+
+  Random64 rnd(FLAGS_seed);
+  std::vector<std::string> targets(FLAGS_num_ops);
+  for (auto& target : targets) {
+    target.clear();
+    std::string ikey = MakeInternalKey(rnd.Next() % num_keys);
+    PutVarint32(&target, static_cast<uint32_t>(ikey.size()));
+    target.append(ikey);
+  }
+  std::unique_ptr<MemTableRep::Iterator> iter(rep->GetIterator());
+  uint64_t found = 0;
+  *seek_ns = TimeOps(targets.size(), [&](uint64_t i) {
+    iter->Seek(Slice(), targets[i].data());
+    found += iter->Valid();
+  });
+  if (found != targets.size()) {
+    fprintf(stderr, "skiplist: %" PRIu64 " of %zu keys found\n", found,
+            targets.size());
+    exit(1);
+  }
+}
+
+// Builds a data block of the keys first, first + stride, ...
+std::unique_ptr<Block> BuildBlock(uint64_t first, uint64_t stride,
+                                  uint64_t num) {
+  BlockBuilder builder(FLAGS_block_restart_interval);
+  for (uint64_t i = 0; i < num; ++i) {
+    builder.Add(MakeInternalKey(first + i * stride), "value");
+  }
+  Slice raw = builder.Finish();
+  std::unique_ptr<char[]> buf(new char[raw.size()]);
+  memcpy(buf.get(), raw.data(), raw.size());
+  return std::unique_ptr<Block>(
+      new Block(BlockContents(std::move(buf), raw.size())));
+}
+
+double BlockBenchmark(const Comparator* ucmp) {
+  const uint64_t num_keys = FLAGS_block_keys;
+  std::unique_ptr<Block> block = BuildBlock(0, 1, num_keys);
+  std::unique_ptr<DataBlockIter> iter(
+      block->NewDataIterator(ucmp, kDisableGlobalSequenceNumber));
+  Random64 rnd(FLAGS_seed);
+  std::vector<std::string> targets(FLAGS_num_ops);
+  for (auto& target : targets) {
+    target = InternalKey(MakeUserKey(rnd.Next() % num_keys),
+                         kMaxSequenceNumber, kValueTypeForSeek)
+                 .Encode()
+                 .ToString();
+  }
+  uint64_t found = 0;
+  double ns = TimeOps(targets.size(), [&](uint64_t i) {
+    iter->Seek(targets[i]);
+    found += iter->Valid();
+  });
+  if (found != targets.size()) {
+    fprintf(stderr, "block: %" PRIu64 " of %zu keys found\n", found,
+            targets.size());
+    exit(1);
+  }
+  return ns;
+}
+
+double MergingBenchmark(const Comparator* ucmp) {
+  const int num_children = std::max(FLAGS_num_children, 2);
+  InternalKeyComparator icmp(ucmp);
+  std::vector<std::unique_ptr<Block>> blocks;
+  std::vector<InternalIterator*> children;
+  for (int i = 0; i < num_children; ++i) {
+    blocks.push_back(BuildBlock(i, num_children, FLAGS_block_keys));
+    children.push_back(
+        blocks.back()->NewDataIterator(ucmp, kDisableGlobalSequenceNumber));
+  }
+  std::unique_ptr<InternalIterator> iter(
+      NewMergingIterator(&icmp, children.data(), num_children));
+  iter->SeekToFirst();
+  return TimeOps(FLAGS_num_ops, [&](uint64_t) {
+    if (!iter->Valid()) {
+      iter->SeekToFirst();
+    }
+    iter->Next();
+  });
+}
+
+void Report(const char* name, double bytewise_ns, double virtual_ns) {
+  fprintf(stdout,
+          "%-16s bytewise: %8.1f ns/op  virtual: %8.1f ns/op  speedup: "
+          "%.2fx\n",
+          name, bytewise_ns, virtual_ns, virtual_ns / bytewise_ns);
+}
+
+void RunBenchmarks() {
+  const Comparator* bytewise = BytewiseComparator();
+  VirtualBytewiseComparator virtual_bytewise;
+  for (const std::string& name : StringSplit(FLAGS_benchmarks, ',')) {
+    if (name == "skiplist") {
+      double insert_ns[2];
+      double seek_ns[2];
+      SkipListBenchmark(bytewise, &insert_ns[0], &seek_ns[0]);
+      SkipListBenchmark(&virtual_bytewise, &insert_ns[1], &seek_ns[1]);
+      Report("skiplist insert", insert_ns[0], insert_ns[1]);
+      Report("skiplist seek", seek_ns[0], seek_ns[1]);
+    } else if (name == "block") {
+      Report("block seek", BlockBenchmark(bytewise),
+             BlockBenchmark(&virtual_bytewise));
+    } else if (name == "merging") {
+      Report("merging next", MergingBenchmark(bytewise),
+             MergingBenchmark(&virtual_bytewise));
+    } else {
+      fprintf(stderr, "Unknown benchmark: %s\n", name.c_str());
+    }
+  }
+}
+
+}  // namespace ROCKSDB_NAMESPACE
+
+void PrintWarnings() {
+#if defined(__GNUC__) && !defined(__OPTIMIZE__)
+  fprintf(stdout,
+          "WARNING: Optimization is disabled: benchmarks unnecessarily slow\n");
+#endif
+#ifndef NDEBUG
+  fprintf(stdout,
+          "WARNING: Assertions are enabled; benchmarks unnecessarily slow\n");
+#endif
+}
+
+int main(int argc, char** argv) {
+  ROCKSDB_NAMESPACE::port::InstallStackTraceHandler();
+  SetUsageMessage(std::string("\nUSAGE:\n") + std::string(argv[0]) +
+                  " [OPTIONS]...");
+  ParseCommandLineFlags(&argc, &argv, true);
+
+  PrintWarnings();
+  ROCKSDB_NAMESPACE::RunBenchmarks();
+  return 0;
+}
+
+#endif  // GFLAGS
@@ -0,0 +1,431 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "util/compression.h"
+
+#if defined(LZ4)
+#include <lz4frame.h>
+#endif
+
+namespace ROCKSDB_NAMESPACE {
+
+#if defined(ZSTD) && ZSTD_VERSION_NUMBER >= 10400
+// ZSTD_compressStream2() and the context reset functions are stable since
+// v1.4.0.
+#define ROCKSDB_ZSTD_STREAMING
+#endif
+
+#if defined(LZ4) && LZ4_VERSION_NUMBER >= 10800
+// LZ4F_resetDecompressionContext() is available since v1.8.0.
+#define ROCKSDB_LZ4_STREAMING
+#endif
+
+bool StreamingCompressionTypeSupported(CompressionType compression_type) {
+  switch (compression_type) {
+    case kNoCompression:
+      return true;
+#ifdef ZLIB
+    case kZlibCompression:
+      return true;
+#endif
+#ifdef ROCKSDB_LZ4_STREAMING
+    case kLZ4Compression:
+      return true;
+#endif
+#ifdef ROCKSDB_ZSTD_STREAMING
+    case kZSTD:
+      return true;
+#endif
+    default:
+      return false;
+  }
+}
+
+namespace {
+
+// Makes room at the end of *output, which is full of uncompressed data, for
+// the next chunk of output.
+void GrowUncompressOutput(std::string* output) {
+  output->resize(std::max<size_t>(output->size() * 2, 256));
+}
+
+#ifdef ZLIB
+// Raw deflate streams, without the zlib header and trailer: the log records
+// carry their own checksums.
+const int kZlibStreamingWindowBits = -15;
+
+class ZlibStreamingCompress : public StreamingCompress {
+ public:
+  explicit ZlibStreamingCompress(int level)
+      : StreamingCompress(kZlibCompression) {
+    memset(&stream_, 0, sizeof(stream_));
+    init_status_ =
+        deflateInit2(&stream_,
+                     level == CompressionOptions::kDefaultCompressionLevel
+                         ? Z_DEFAULT_COMPRESSION
+                         : level,
+                     Z_DEFLATED, kZlibStreamingWindowBits, 8,
+                     Z_DEFAULT_STRATEGY);
+  }
+
+  ~ZlibStreamingCompress() override {
+    if (init_status_ == Z_OK) {
+      deflateEnd(&stream_);
+    }
+  }
+
+  Status Reset(const Slice& record) override {
+    if (init_status_ != Z_OK || deflateReset(&stream_) != Z_OK) {
+      return Status::Corruption("zlib deflate initialization failed");
+    }
+    stream_.next_in =
+        reinterpret_cast<Bytef*>(const_cast<char*>(record.data()));
+    stream_.avail_in = static_cast<uInt>(record.size());
+    return Status::OK();
+  }
+
+  Status Compress(char* output, size_t capacity, size_t* size,
+                  bool* done) override {
+    stream_.next_out = reinterpret_cast<Bytef*>(output);
+    stream_.avail_out = static_cast<uInt>(capacity);
+    int st = deflate(&stream_, Z_FINISH);
+    *size = capacity - stream_.avail_out;
+    if (st == Z_STREAM_END) {
+      *done = true;
+    } else if (st == Z_OK || st == Z_BUF_ERROR) {
+      // Z_BUF_ERROR only means that no progress was possible with an empty
+      // output.
+      *done = false;
+    } else {
+      return Status::Corruption("zlib deflate failed");
+    }
+    return Status::OK();
+  }
+
+ private:
+  z_stream stream_;
+  int init_status_;
+};
+
+class ZlibStreamingUncompress : public StreamingUncompress {
+ public:
+  ZlibStreamingUncompress() : StreamingUncompress(kZlibCompression) {
+    memset(&stream_, 0, sizeof(stream_));
+    init_status_ = inflateInit2(&stream_, kZlibStreamingWindowBits);
+  }
+
+  ~ZlibStreamingUncompress() override {
+    if (init_status_ == Z_OK) {
+      inflateEnd(&stream_);
+    }
+  }
+
+  Status Uncompress(const Slice& input, std::string* record) override {
+    if (init_status_ != Z_OK || inflateReset(&stream_) != Z_OK) {
+      return Status::Corruption("zlib inflate initialization failed");
+    }
+    stream_.next_in =
+        reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream_.avail_in = static_cast<uInt>(input.size());
+    record->clear();
+    record->resize(input.size() * 4);
+    size_t used = 0;
+    while (true) {
+      if (used == record->size()) {
+        GrowUncompressOutput(record);
+      }
+      stream_.next_out = reinterpret_cast<Bytef*>(&(*record)[used]);
+      stream_.avail_out = static_cast<uInt>(record->size() - used);
+      int st = inflate(&stream_, Z_NO_FLUSH);
+      used = record->size() - stream_.avail_out;
+      if (st == Z_STREAM_END) {
+        if (stream_.avail_in != 0) {
+          return Status::Corruption("trailing data after zlib stream");
+        }
+        record->resize(used);
+        return Status::OK();
+      } else if (st != Z_OK && st != Z_BUF_ERROR) {
+        return Status::Corruption("zlib inflate failed");
+      } else if (stream_.avail_out != 0) {
+        return Status::Corruption("truncated zlib stream");
+      }
+    }
+  }
+
+ private:
+  z_stream stream_;
+  int init_status_;
+};
+#endif  // ZLIB
+
+#ifdef ROCKSDB_LZ4_STREAMING
+// LZ4 frames are compressed whole into a buffer, since the frame API needs
+// an output of the compress bound, and handed out in chunks.
+class LZ4StreamingCompress : public StreamingCompress {
+ public:
+  explicit LZ4StreamingCompress(int level)
+      : StreamingCompress(kLZ4Compression), ctx_(nullptr), pos_(0) {
+    memset(&prefs_, 0, sizeof(prefs_));
+    prefs_.autoFlush = 1;
+    if (level != CompressionOptions::kDefaultCompressionLevel) {
+      prefs_.compressionLevel = level;
+    }
+    if (LZ4F_isError(LZ4F_createCompressionContext(&ctx_, LZ4F_VERSION))) {
+      ctx_ = nullptr;
+    }
+  }
+
+  ~LZ4StreamingCompress() override {
+    if (ctx_ != nullptr) {
+      LZ4F_freeCompressionContext(ctx_);
+    }
+  }
+
+  Status Reset(const Slice& record) override {
+    if (ctx_ == nullptr) {
+      return Status::Corruption("LZ4F context creation failed");
+    }
+    prefs_.frameInfo.contentSize = record.size();
+    buffer_.resize(LZ4F_HEADER_SIZE_MAX +
+                   LZ4F_compressBound(record.size(), &prefs_));
+    size_t size =
+        LZ4F_compressBegin(ctx_, &buffer_[0], buffer_.size(), &prefs_);
+    if (!LZ4F_isError(size)) {
+      size_t n =
+          LZ4F_compressUpdate(ctx_, &buffer_[size], buffer_.size() - size,
+                              record.data(), record.size(), nullptr);
+      size = LZ4F_isError(n) ? n : size + n;
+    }
+    if (!LZ4F_isError(size)) {
+      size_t n = LZ4F_compressEnd(ctx_, &buffer_[size], buffer_.size() - size,
+                                  nullptr);
+      size = LZ4F_isError(n) ? n : size + n;
+    }
+    if (LZ4F_isError(size)) {
+      buffer_.clear();
+      return Status::Corruption("LZ4F compression failed",
+                                LZ4F_getErrorName(size));
+    }
+    buffer_.resize(size);
+    pos_ = 0;
+    return Status::OK();
+  }
+
+  Status Compress(char* output, size_t capacity, size_t* size,
+                  bool* done) override {
+    *size = std::min(capacity, buffer_.size() - pos_);
+    memcpy(output, buffer_.data() + pos_, *size);
+    pos_ += *size;
+    *done = pos_ == buffer_.size();
+    return Status::OK();
+  }
+
+ private:
+  LZ4F_preferences_t prefs_;
+  LZ4F_cctx* ctx_;
+  std::string buffer_;
+  size_t pos_;
+};
+
+class LZ4StreamingUncompress : public StreamingUncompress {
+ public:
+  LZ4StreamingUncompress()
+      : StreamingUncompress(kLZ4Compression), ctx_(nullptr) {
+    if (LZ4F_isError(LZ4F_createDecompressionContext(&ctx_, LZ4F_VERSION))) {
+      ctx_ = nullptr;
+    }
+  }
+
+  ~LZ4StreamingUncompress() override {
+    if (ctx_ != nullptr) {
+      LZ4F_freeDecompressionContext(ctx_);
+    }
+  }
+
+  Status Uncompress(const Slice& input, std::string* record) override {
+    if (ctx_ == nullptr) {
+      return Status::Corruption("LZ4F context creation failed");
+    }
+    LZ4F_resetDecompressionContext(ctx_);
+    record->clear();
+    record->resize(input.size() * 4);
+    size_t in_pos = 0;
+    size_t used = 0;
+    while (true) {
+      if (used == record->size()) {
+        GrowUncompressOutput(record);
+      }
+      size_t in_size = input.size() - in_pos;
+      size_t out_size = record->size() - used;
+      size_t hint = LZ4F_decompress(ctx_, &(*record)[used], &out_size,
+                                    input.data() + in_pos, &in_size, nullptr);
+      if (LZ4F_isError(hint)) {
+        return Status::Corruption("LZ4F decompression failed",
+                                  LZ4F_getErrorName(hint));
+      }
+      in_pos += in_size;
+      used += out_size;
+      if (hint == 0) {
+        if (in_pos != input.size()) {
+          return Status::Corruption("trailing data after LZ4 frame");
+        }
+        record->resize(used);
+        return Status::OK();
+      } else if (in_pos == input.size() && used < record->size()) {
+        return Status::Corruption("truncated LZ4 frame");
+      }
+    }
+  }
+
+ private:
+  LZ4F_dctx* ctx_;
+};
+#endif  // ROCKSDB_LZ4_STREAMING
+
+#ifdef ROCKSDB_ZSTD_STREAMING
+class ZSTDStreamingCompress : public StreamingCompress {
+ public:
+  explicit ZSTDStreamingCompress(int level)
+      : StreamingCompress(kZSTD), ctx_(ZSTD_createCCtx()), input_() {
+    if (ctx_ != nullptr &&
+        level != CompressionOptions::kDefaultCompressionLevel) {
+      ZSTD_CCtx_setParameter(ctx_, ZSTD_c_compressionLevel, level);
+    }
+  }
+
+  ~ZSTDStreamingCompress() override { ZSTD_freeCCtx(ctx_); }
+
+  Status Reset(const Slice& record) override {
+    if (ctx_ == nullptr) {
+      return Status::Corruption("ZSTD context creation failed");
+    }
+    ZSTD_CCtx_reset(ctx_, ZSTD_reset_session_only);
+    ZSTD_CCtx_setPledgedSrcSize(ctx_, record.size());
+    input_ = {record.data(), record.size(), 0};
+    return Status::OK();
+  }
+
+  Status Compress(char* output, size_t capacity, size_t* size,
+                  bool* done) override {
+    ZSTD_outBuffer out = {output, capacity, 0};
+    size_t remaining = ZSTD_compressStream2(ctx_, &out, &input_, ZSTD_e_end);
+    if (ZSTD_isError(remaining)) {
+      return Status::Corruption("ZSTD compression failed",
+                                ZSTD_getErrorName(remaining));
+    }
+    *size = out.pos;
+    *done = remaining == 0;
+    return Status::OK();
+  }
+
+ private:
+  ZSTD_CCtx* ctx_;
+  ZSTD_inBuffer input_;
+};
+
+class ZSTDStreamingUncompress : public StreamingUncompress {
+ public:
+  ZSTDStreamingUncompress()
+      : StreamingUncompress(kZSTD), ctx_(ZSTD_createDCtx()) {}
+
+  ~ZSTDStreamingUncompress() override { ZSTD_freeDCtx(ctx_); }
+
+  Status Uncompress(const Slice& input, std::string* record) override {
+    if (ctx_ == nullptr) {
+      return Status::Corruption("ZSTD context creation failed");
+    }
+    ZSTD_DCtx_reset(ctx_, ZSTD_reset_session_only);
+    record->clear();
+    // The writer pledges the record size, so it is known unless the frame
+    // is corrupted.
+    unsigned long long content_size =
+        ZSTD_getFrameContentSize(input.data(), input.size());
+    if (content_size != ZSTD_CONTENTSIZE_UNKNOWN &&
+        content_size != ZSTD_CONTENTSIZE_ERROR &&
+        content_size <= std::numeric_limits<uint32_t>::max()) {
+      record->resize(static_cast<size_t>(content_size));
+    } else {
+      record->resize(input.size() * 4);
+    }
+    ZSTD_inBuffer in = {input.data(), input.size(), 0};
+    size_t used = 0;
+    while (true) {
+      if (used == record->size()) {
+        GrowUncompressOutput(record);
+      }
+      ZSTD_outBuffer out = {&(*record)[used], record->size() - used, 0};
+      size_t hint = ZSTD_decompressStream(ctx_, &out, &in);
+      if (ZSTD_isError(hint)) {
+        return Status::Corruption("ZSTD decompression failed",
+                                  ZSTD_getErrorName(hint));
+      }
+      used += out.pos;
+      if (hint == 0) {
+        if (in.pos != in.size) {
+          return Status::Corruption("trailing data after ZSTD frame");
+        }
+        record->resize(used);
+        return Status::OK();
+      } else if (in.pos == in.size && out.pos < out.size) {
+        return Status::Corruption("truncated ZSTD frame");
+      }
+    }
+  }
+
+ private:
+  ZSTD_DCtx* ctx_;
+};
+#endif  // ROCKSDB_ZSTD_STREAMING
+
+}  // namespace
+
+std::unique_ptr<StreamingCompress> StreamingCompress::Create(
+    CompressionType compression_type, int level) {
+  switch (compression_type) {
+#ifdef ZLIB
+    case kZlibCompression:
+      return std::unique_ptr<StreamingCompress>(
+          new ZlibStreamingCompress(level));
+#endif
+#ifdef ROCKSDB_LZ4_STREAMING
+    case kLZ4Compression:
+      return std::unique_ptr<StreamingCompress>(
+          new LZ4StreamingCompress(level));
+#endif
+#ifdef ROCKSDB_ZSTD_STREAMING
+    case kZSTD:
+      return std::unique_ptr<StreamingCompress>(
+          new ZSTDStreamingCompress(level));
+#endif
+    default:
+      (void)level;
+      return nullptr;
+  }
+}
+
+std::unique_ptr<StreamingUncompress> StreamingUncompress::Create(
+    CompressionType compression_type) {
+  switch (compression_type) {
+#ifdef ZLIB
+    case kZlibCompression:
+      return std::unique_ptr<StreamingUncompress>(
+          new ZlibStreamingUncompress());
+#endif
+#ifdef ROCKSDB_LZ4_STREAMING
+    case kLZ4Compression:
+      return std::unique_ptr<StreamingUncompress>(
+          new LZ4StreamingUncompress());
+#endif
+#ifdef ROCKSDB_ZSTD_STREAMING
+    case kZSTD:
+      return std::unique_ptr<StreamingUncompress>(
+          new ZSTDStreamingUncompress());
+#endif
+    default:
+      return nullptr;
+  }
+}
+
+}  // namespace ROCKSDB_NAMESPACE
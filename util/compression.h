@@ -11,6 +11,7 @@
 
 #include <algorithm>
 #include <limits>
+#include <memory>
 #ifdef ROCKSDB_MALLOC_USABLE_SIZE
 #ifdef OS_FREEBSD
 #include <malloc_np.h>
@@ -111,6 +112,13 @@ class ZSTDUncompressCachedData {
     zstd_ctx_ = o.zstd_ctx_;
     cache_idx_ = idx;
   }
+  size_t ApproximateMemoryUsage() const {
+#if ZSTD_VERSION_NUMBER >= 10400 || defined(ZSTD_STATIC_LINKING_ONLY)
+    return zstd_ctx_ == nullptr ? 0 : ZSTD_sizeof_DCtx(zstd_ctx_);
+#else
+    return 0;
+#endif
+  }
   ~ZSTDUncompressCachedData() {
     if (zstd_ctx_ != nullptr && cache_idx_ == -1) {
       ZSTD_freeDCtx(zstd_ctx_);
@@ -142,6 +150,7 @@ class ZSTDUncompressCachedData {
   int64_t GetCacheIndex() const { return -1; }
   void CreateIfNeeded() {}
   void InitFromCache(const ZSTDUncompressCachedData&, int64_t) {}
+  size_t ApproximateMemoryUsage() const { return 0; }
  private:
   void ignore_padding__() { padding = nullptr; }
 };
@@ -1489,4 +1498,65 @@ inline CacheAllocationPtr UncompressData(
   }
 }
 
+// Returns true if the records of a WAL can be compressed with
+// compression_type, see DBOptions::wal_compression.
+extern bool StreamingCompressionTypeSupported(
+    CompressionType compression_type);
+
+// Compresses the records of a WAL. Every record is compressed independently
+// of the previous ones, so that a reader can uncompress any complete record,
+// and comes out in chunks of bounded size, so that log::Writer can emit it
+// fragment by fragment into the space left in its blocks.
+class StreamingCompress {
+ public:
+  // Returns nullptr for kNoCompression and the types that are not
+  // StreamingCompressionTypeSupported(). level is as in CompressionOptions.
+  static std::unique_ptr<StreamingCompress> Create(
+      CompressionType compression_type,
+      int level = CompressionOptions::kDefaultCompressionLevel);
+
+  virtual ~StreamingCompress() {}
+
+  CompressionType type() const { return type_; }
+
+  // Starts compressing record, which must remain live until Compress() sets
+  // *done.
+  virtual Status Reset(const Slice& record) = 0;
+
+  // Writes the next at most capacity bytes of the compressed record to
+  // output, and their number to *size. Sets *done once the end of the
+  // compressed record has been written.
+  virtual Status Compress(char* output, size_t capacity, size_t* size,
+                          bool* done) = 0;
+
+ protected:
+  explicit StreamingCompress(CompressionType type) : type_(type) {}
+
+ private:
+  const CompressionType type_;
+};
+
+// Uncompresses the records compressed by StreamingCompress.
+class StreamingUncompress {
+ public:
+  // Returns nullptr for kNoCompression and the types that are not
+  // StreamingCompressionTypeSupported().
+  static std::unique_ptr<StreamingUncompress> Create(
+      CompressionType compression_type);
+
+  virtual ~StreamingUncompress() {}
+
+  CompressionType type() const { return type_; }
+
+  // Uncompresses input, which must be exactly one compressed record, into
+  // *record.
+  virtual Status Uncompress(const Slice& input, std::string* record) = 0;
+
+ protected:
+  explicit StreamingUncompress(CompressionType type) : type_(type) {}
+
+ private:
+  const CompressionType type_;
+};
+
 }  // namespace ROCKSDB_NAMESPACE
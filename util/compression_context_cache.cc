@@ -28,13 +28,17 @@ struct ZSTDCachedData {
   // cache use transparent for the user
   ZSTDUncompressCachedData uncomp_cached_data_;
   std::atomic<void*> zstd_uncomp_sentinel_;
+  // Only updated by the thread returning uncomp_cached_data_, which is the
+  // only one that may access it.
+  std::atomic<size_t> uncomp_memory_usage_;
 
-  char
-      padding[(CACHE_LINE_SIZE -
-               (sizeof(ZSTDUncompressCachedData) + sizeof(std::atomic<void*>)) %
-                   CACHE_LINE_SIZE)];  // unused padding field
+  char padding[(CACHE_LINE_SIZE -
+                (sizeof(ZSTDUncompressCachedData) + sizeof(std::atomic<void*>) +
+                 sizeof(std::atomic<size_t>)) %
+                    CACHE_LINE_SIZE)];  // unused padding field
 
-  ZSTDCachedData() : zstd_uncomp_sentinel_(&uncomp_cached_data_) {}
+  ZSTDCachedData()
+      : zstd_uncomp_sentinel_(&uncomp_cached_data_), uncomp_memory_usage_(0) {}
   ZSTDCachedData(const ZSTDCachedData&) = delete;
   ZSTDCachedData& operator=(const ZSTDCachedData&) = delete;
 
@@ -55,6 +59,8 @@ struct ZSTDCachedData {
   // This is executed only when we successfully obtained
   // in the first place
   void ReturnUncompressData() {
+    uncomp_memory_usage_.store(uncomp_cached_data_.ApproximateMemoryUsage(),
+                               std::memory_order_relaxed);
     if (zstd_uncomp_sentinel_.exchange(&uncomp_cached_data_) != SentinelValue) {
       // Means we are returning while not having it acquired.
       assert(false);
@@ -80,6 +86,14 @@ class CompressionContextCache::Rep {
     auto* cn = per_core_uncompr_.AccessAtCore(static_cast<size_t>(idx));
     cn->ReturnUncompressData();
   }
+  size_t ApproximateMemoryUsage() const {
+    size_t usage = per_core_uncompr_.Size() * sizeof(ZSTDCachedData);
+    for (size_t i = 0; i < per_core_uncompr_.Size(); ++i) {
+      usage += per_core_uncompr_.AccessAtCore(i)->uncomp_memory_usage_.load(
+          std::memory_order_relaxed);
+    }
+    return usage;
+  }
 
  private:
   CoreLocalArray<ZSTDCachedData> per_core_uncompr_;
@@ -103,6 +117,10 @@ void CompressionContextCache::ReturnCachedZSTDUncompressData(int64_t idx) {
   rep_->ReturnZSTDUncompressData(idx);
 }
 
+size_t CompressionContextCache::ApproximateMemoryUsage() const {
+  return rep_->ApproximateMemoryUsage();
+}
+
 CompressionContextCache::~CompressionContextCache() { delete rep_; }
 
 }  // namespace ROCKSDB_NAMESPACE
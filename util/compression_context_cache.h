@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include "rocksdb/rocksdb_namespace.h"
@@ -35,6 +36,10 @@ class CompressionContextCache {
   ZSTDUncompressCachedData GetCachedZSTDUncompressData();
   void ReturnCachedZSTDUncompressData(int64_t idx);
 
+  // Approximate memory used by the cached contexts, as of the last time each
+  // of them was returned.
+  size_t ApproximateMemoryUsage() const;
+
  private:
   // Singleton
   CompressionContextCache();
@@ -11,12 +11,20 @@ int main() {
 }
 #else
 
+#include <algorithm>
+#include <cinttypes>
+#include <vector>
+
+#include "db/log_writer.h"
+#include "env/composite_env_wrapper.h"
 #include "file/writable_file_writer.h"
 #include "monitoring/histogram.h"
 #include "rocksdb/env.h"
 #include "test_util/testharness.h"
 #include "test_util/testutil.h"
+#include "util/compression.h"
 #include "util/gflags_compat.h"
+#include "util/random.h"
 
 using GFLAGS_NAMESPACE::ParseCommandLineFlags;
 using GFLAGS_NAMESPACE::SetUsageMessage;
@@ -28,9 +36,42 @@ DEFINE_int32(record_size, 249, "Size of each record.");
 DEFINE_int32(record_interval, 10000, "Interval between records (microSec)");
 DEFINE_int32(bytes_per_sync, 0, "bytes_per_sync parameter in EnvOptions");
 DEFINE_bool(enable_sync, false, "sync after each write.");
+DEFINE_bool(use_log_writer, false,
+            "Write the records through log::Writer, with their headers and "
+            "block padding, instead of appending them to the file directly. "
+            "Implied by --wal_compression.");
+DEFINE_string(wal_compression, "none",
+              "Compression of the records written through log::Writer: none, "
+              "zlib, lz4 or zstd.");
+DEFINE_double(compression_ratio, 0.5,
+              "Arrange to have records compress to this fraction of their "
+              "size.");
 
 namespace ROCKSDB_NAMESPACE {
+CompressionType StringToWalCompression(const std::string& name) {
+  if (name == "zlib") {
+    return kZlibCompression;
+  } else if (name == "lz4") {
+    return kLZ4Compression;
+  } else if (name == "zstd") {
+    return kZSTD;
+  } else if (name != "none") {
+    fprintf(stderr, "Unknown WAL compression: %s\n", name.c_str());
+    exit(1);
+  }
+  return kNoCompression;
+}
+
 void RunBenchmark() {
+  CompressionType compression = StringToWalCompression(FLAGS_wal_compression);
+  if (!StreamingCompressionTypeSupported(compression)) {
+    fprintf(stderr, "WAL compression %s is not supported by this build\n",
+            FLAGS_wal_compression.c_str());
+    exit(1);
+  }
+  const bool use_log_writer =
+      FLAGS_use_log_writer || compression != kNoCompression;
+
   std::string file_name = test::PerThreadDBPath("log_write_benchmark.log");
   DBOptions options;
   Env* env = Env::Default();
@@ -39,22 +80,46 @@ void RunBenchmark() {
   std::unique_ptr<WritableFile> file;
   env->NewWritableFile(file_name, &file, env_options);
   std::unique_ptr<WritableFileWriter> writer;
-  writer.reset(new WritableFileWriter(std::move(file), file_name, env_options,
-                                      env, nullptr /* stats */,
-                                      options.listeners));
+  writer.reset(new WritableFileWriter(
+      NewLegacyWritableFileWrapper(std::move(file)), file_name, env_options,
+      env, nullptr /* io_tracer */, nullptr /* stats */, options.listeners));
+  std::unique_ptr<log::Writer> log_writer;
+  if (use_log_writer) {
+    log_writer.reset(new log::Writer(std::move(writer), 1 /* log_number */,
+                                     false /* recycle_log_files */,
+                                     false /* manual_flush */, compression));
+    IOStatus s = log_writer->AddCompressionTypeRecord();
+    if (!s.ok()) {
+      fprintf(stderr, "%s\n", s.ToString().c_str());
+      exit(1);
+    }
+  }
+  WritableFileWriter* file_writer =
+      use_log_writer ? log_writer->file() : writer.get();
 
-  std::string record;
-  record.assign(FLAGS_record_size, 'X');
+  // Distinct records, so that every record has to be compressed on its own.
+  Random rnd(301);
+  std::vector<std::string> records(
+      std::max(std::min(FLAGS_num_records, 1024), 1));
+  for (auto& record : records) {
+    test::CompressibleString(&rnd, FLAGS_compression_ratio, FLAGS_record_size,
+                             &record);
+  }
 
   HistogramImpl hist;
 
   uint64_t start_time = env->NowMicros();
   for (int i = 0; i < FLAGS_num_records; i++) {
+    const std::string& record = records[i % records.size()];
     uint64_t start_nanos = env->NowNanos();
-    writer->Append(record);
-    writer->Flush();
+    if (use_log_writer) {
+      log_writer->AddRecord(record);
+    } else {
+      writer->Append(record);
+      writer->Flush();
+    }
     if (FLAGS_enable_sync) {
-      writer->Sync(false);
+      file_writer->Sync(false);
     }
     hist.Add(env->NowNanos() - start_nanos);
 
@@ -68,9 +133,24 @@ void RunBenchmark() {
       env->SleepForMicroseconds(time_to_sleep);
     }
   }
+  const double elapsed_secs =
+      std::max<uint64_t>(env->NowMicros() - start_time, 1) / 1e6;
+  const uint64_t record_bytes =
+      static_cast<uint64_t>(FLAGS_num_records) * FLAGS_record_size;
+  const uint64_t file_bytes = file_writer->GetFileSize();
 
   fprintf(stderr, "Distribution of latency of append+flush: \n%s",
           hist.ToString().c_str());
+  fprintf(stderr,
+          "Compression: %s\n"
+          "Record bytes: %" PRIu64 " (%.1f MB/s)\n"
+          "File bytes: %" PRIu64 " (%.1f MB/s)\n"
+          "File bytes / record bytes: %.3f\n",
+          CompressionTypeToString(compression).c_str(), record_bytes,
+          record_bytes / 1048576.0 / elapsed_secs, file_bytes,
+          file_bytes / 1048576.0 / elapsed_secs,
+          static_cast<double>(file_bytes) /
+              std::max<uint64_t>(record_bytes, 1));
 }
 }  // namespace ROCKSDB_NAMESPACE
 
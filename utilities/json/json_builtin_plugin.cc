@@ -9,6 +9,7 @@
 #include <cinttypes>
 
 #include "rocksdb/db.h"
+#include "cache/clock_cache.h"
 #include "cache/lru_cache.h"
 #include "db/dbformat.h"
 #include "db/column_family.h"
@@ -16,15 +17,18 @@
 #include "rocksdb/env.h"
 #include "rocksdb/options.h"
 #include "options/db_options.h"
+#include "rocksdb/arena_block_pool.h"
 #include "rocksdb/compaction_filter.h"
 #include "rocksdb/concurrent_task_limiter.h"
 #include "rocksdb/utilities/db_ttl.h"
+#include "rocksdb/utilities/sim_cache.h"
 #include "rocksdb/utilities/transaction_db.h"
 #include "rocksdb/utilities/transaction_db_mutex.h"
 #include "rocksdb/utilities/optimistic_transaction_db.h"
 #include "rocksdb/flush_block_policy.h"
 #include "rocksdb/merge_operator.h"
 #include "rocksdb/rate_limiter.h"
+#include "rocksdb/secondary_cache.h"
 #include "rocksdb/slice_transform.h"
 #include "rocksdb/sst_file_manager.h"
 #include "rocksdb/wal_filter.h"
@@ -199,6 +203,15 @@ struct DBOptions_Json : DBOptions {
             buffer_size, cache);
       }
     }
+    {
+      auto iter = js.find("arena_block_pool");
+      if (js.end() != iter) {
+        auto& pool = iter.value();
+        size_t capacity = 0;
+        ROCKSDB_JSON_OPT_SIZE(pool, capacity);
+        arena_block_pool = NewArenaBlockPool(capacity);
+      }
+    }
     ROCKSDB_JSON_OPT_ENUM(js, access_hint_on_compaction_start);
     ROCKSDB_JSON_OPT_PROP(js, new_table_reader_for_compaction_inputs);
     ROCKSDB_JSON_OPT_SIZE(js, compaction_readahead_size);
@@ -242,6 +255,8 @@ struct DBOptions_Json : DBOptions {
     ROCKSDB_JSON_OPT_SIZE(js, log_readahead_size);
     ROCKSDB_JSON_OPT_FACT(js, file_checksum_gen_factory);
     ROCKSDB_JSON_OPT_PROP(js, best_efforts_recovery);
+    ROCKSDB_JSON_OPT_PROP(js, persist_block_cache_keys);
+    ROCKSDB_JSON_OPT_PROP(js, block_cache_warmup_threads);
   }
 
   void SaveToJson(json& js, const JsonPluginRepo& repo, bool html) const {
@@ -298,6 +313,11 @@ struct DBOptions_Json : DBOptions {
       ROCKSDB_JSON_SET_FACT(wbm, cache);
       JsonSetSize(wbm["buffer_size"], db_write_buffer_size);
     }
+    if (arena_block_pool) {
+      json& pool = js["arena_block_pool"];
+      JsonSetSize(pool["capacity"], arena_block_pool->GetCapacity());
+      pool["stats"] = arena_block_pool->GetStats().ToString();
+    }
     ROCKSDB_JSON_SET_ENUM(js, access_hint_on_compaction_start);
     ROCKSDB_JSON_SET_PROP(js, new_table_reader_for_compaction_inputs);
     ROCKSDB_JSON_SET_SIZE(js, compaction_readahead_size);
@@ -341,6 +361,8 @@ struct DBOptions_Json : DBOptions {
     ROCKSDB_JSON_SET_SIZE(js, log_readahead_size);
     ROCKSDB_JSON_SET_FACT(js, file_checksum_gen_factory);
     ROCKSDB_JSON_SET_PROP(js, best_efforts_recovery);
+    ROCKSDB_JSON_SET_PROP(js, persist_block_cache_keys);
+    ROCKSDB_JSON_SET_PROP(js, block_cache_warmup_threads);
   }
 };
 static shared_ptr<DBOptions>
@@ -459,6 +481,8 @@ struct ColumnFamilyOptions_Json : ColumnFamilyOptions {
     ROCKSDB_JSON_OPT_PROP(js, memtable_prefix_bloom_size_ratio);
     ROCKSDB_JSON_OPT_PROP(js, memtable_whole_key_filtering);
     ROCKSDB_JSON_OPT_PROP(js, memtable_huge_page_size);
+    ROCKSDB_JSON_OPT_PROP(js, memtable_numa_aware);
+    ROCKSDB_JSON_OPT_PROP(js, mempurge_threshold);
     ROCKSDB_JSON_OPT_FACT(js, memtable_insert_with_hint_prefix_extractor);
     ROCKSDB_JSON_OPT_PROP(js, bloom_locality);
     ROCKSDB_JSON_OPT_SIZE(js, arena_block_size);
@@ -565,6 +589,8 @@ struct ColumnFamilyOptions_Json : ColumnFamilyOptions {
     ROCKSDB_JSON_SET_PROP(js, memtable_prefix_bloom_size_ratio);
     ROCKSDB_JSON_SET_PROP(js, memtable_whole_key_filtering);
     ROCKSDB_JSON_SET_PROP(js, memtable_huge_page_size);
+    ROCKSDB_JSON_SET_PROP(js, memtable_numa_aware);
+    ROCKSDB_JSON_SET_PROP(js, mempurge_threshold);
     ROCKSDB_JSON_SET_FACX(js, memtable_insert_with_hint_prefix_extractor,
                           slice_transform);
     ROCKSDB_JSON_SET_PROP(js, bloom_locality);
@@ -797,6 +823,22 @@ JS_NewMemkindKmemAllocator(const json&, const JsonPluginRepo&) {
 ROCKSDB_FACTORY_REG("MemkindKmemAllocator", JS_NewMemkindKmemAllocator);
 #endif
 
+struct CompressedSecondaryCacheOptions_Json : CompressedSecondaryCacheOptions {
+  CompressedSecondaryCacheOptions_Json(const json& js, const JsonPluginRepo& repo) {
+    ROCKSDB_JSON_REQ_SIZE(js, capacity);
+    ROCKSDB_JSON_OPT_PROP(js, num_shard_bits);
+    ROCKSDB_JSON_OPT_ENUM(js, compression_type);
+    ROCKSDB_JSON_OPT_FACT(js, memory_allocator);
+    ROCKSDB_JSON_OPT_ENUM(js, metadata_charge_policy);
+  }
+};
+struct CachePartitionOptions_Json : CachePartitionOptions {
+  explicit CachePartitionOptions_Json(const json& js) {
+    ROCKSDB_JSON_REQ_PROP(js, name);
+    ROCKSDB_JSON_OPT_SIZE(js, reserved_capacity);
+    ROCKSDB_JSON_OPT_SIZE(js, max_capacity);
+  }
+};
 struct LRUCacheOptions_Json : LRUCacheOptions {
   LRUCacheOptions_Json(const json& js, const JsonPluginRepo& repo) {
     ROCKSDB_JSON_REQ_SIZE(js, capacity);
@@ -806,6 +848,27 @@ struct LRUCacheOptions_Json : LRUCacheOptions {
     ROCKSDB_JSON_OPT_FACT(js, memory_allocator);
     ROCKSDB_JSON_OPT_PROP(js, use_adaptive_mutex);
     ROCKSDB_JSON_OPT_ENUM(js, metadata_charge_policy);
+    ROCKSDB_JSON_OPT_PROP(js, tiny_lfu_admission);
+    ROCKSDB_JSON_OPT_PROP(js, numa_aware);
+    // secondary_cache is the params of a CompressedSecondaryCache
+    auto iter = js.find("secondary_cache");
+    if (js.end() != iter) {
+      secondary_cache = NewCompressedSecondaryCache(
+          CompressedSecondaryCacheOptions_Json(iter.value(), repo));
+      if (!secondary_cache) {
+        THROW_InvalidArgument("bad secondary_cache = " + iter.value().dump());
+      }
+    }
+    // partitions is an array of {name, reserved_capacity, max_capacity}
+    iter = js.find("partitions");
+    if (js.end() != iter) {
+      if (!iter.value().is_array()) {
+        THROW_InvalidArgument("partitions must be an array");
+      }
+      for (auto& item : iter.value()) {
+        partitions.push_back(CachePartitionOptions_Json(item));
+      }
+    }
   }
   json ToJson(const JsonPluginRepo& repo, bool html) const {
     json js;
@@ -816,6 +879,18 @@ struct LRUCacheOptions_Json : LRUCacheOptions {
     ROCKSDB_JSON_SET_FACT(js, memory_allocator);
     ROCKSDB_JSON_SET_PROP(js, use_adaptive_mutex);
     ROCKSDB_JSON_SET_ENUM(js, metadata_charge_policy);
+    ROCKSDB_JSON_SET_PROP(js, tiny_lfu_admission);
+    ROCKSDB_JSON_SET_PROP(js, numa_aware);
+    if (!partitions.empty()) {
+      json& jparts = js["partitions"];
+      for (auto& p : partitions) {
+        json jp;
+        jp["name"] = p.name;
+        JsonSetSize(jp["reserved_capacity"], p.reserved_capacity);
+        JsonSetSize(jp["max_capacity"], p.max_capacity);
+        jparts.push_back(std::move(jp));
+      }
+    }
     return js;
   }
 };
@@ -859,6 +934,25 @@ struct LRUCache_Manip : PluginManipFunc<Cache> {
       size_t cached_elem_num = const_cast<LRUCache*>(lru)->TEST_GetLRUSize();
       ROCKSDB_JSON_SET_PROP(js, cached_elem_num);
     }
+    std::vector<CachePartitionUsage> partitions;
+    r.GetPartitionUsage(&partitions);
+    if (!partitions.empty()) {
+      json& jparts = js["partition_usage"];
+      for (auto& p : partitions) {
+        json jp;
+        jp["name"] = p.name;
+        JsonSetSize(jp["usage"], p.usage);
+        JsonSetSize(jp["pined_usage"], p.pinned_usage);
+        JsonSetSize(jp["reserved_capacity"], p.reserved_capacity);
+        JsonSetSize(jp["max_capacity"], p.max_capacity);
+        jparts.push_back(std::move(jp));
+      }
+    }
+    uint64_t numa_local_hits, numa_remote_hits;
+    if (r.GetNumaHitCounts(&numa_local_hits, &numa_remote_hits)) {
+      ROCKSDB_JSON_SET_PROP(js, numa_local_hits);
+      ROCKSDB_JSON_SET_PROP(js, numa_remote_hits);
+    }
     return JsonToString(js, dump_options);
   }
 };
@@ -869,9 +963,12 @@ static std::shared_ptr<Cache>
 JS_NewClockCache(const json& js, const JsonPluginRepo& repo) {
 #ifdef SUPPORT_CLOCK_CACHE
   LRUCacheOptions_Json opt(js, repo); // similar with ClockCache param
+  size_t estimated_entry_charge = 0;
+  ROCKSDB_JSON_OPT_SIZE(js, estimated_entry_charge);
   auto p = NewClockCache(opt.capacity, opt.num_shard_bits,
-                         opt.strict_capacity_limit, opt.metadata_charge_policy);
-  if (nullptr != p) {
+                         opt.strict_capacity_limit, opt.metadata_charge_policy,
+                         estimated_entry_charge);
+  if (nullptr == p) {
 	THROW_InvalidArgument(
 		"SUPPORT_CLOCK_CACHE is defined but NewClockCache returns null");
   }
@@ -885,6 +982,62 @@ JS_NewClockCache(const json& js, const JsonPluginRepo& repo) {
 #endif
 }
 ROCKSDB_FACTORY_REG("ClockCache", JS_NewClockCache);
+ROCKSDB_REG_PluginManip("ClockCache", LRUCache_Manip);
+
+//////////////////////////////////////////////////////////////////////////////
+// "cache" is the wrapped cache, such as an LRUCache
+struct MissRatioCurveOptions_Json : MissRatioCurveOptions {
+  std::shared_ptr<Cache> cache;
+  MissRatioCurveOptions_Json(const json& js, const JsonPluginRepo& repo) {
+    ROCKSDB_JSON_OPT_FACT(js, cache);
+    if (!cache) {
+      THROW_InvalidArgument("missing required param \"cache\"");
+    }
+    ROCKSDB_JSON_OPT_PROP(js, sampling_rate);
+    ROCKSDB_JSON_OPT_PROP(js, capacity_ratios);
+  }
+};
+static std::shared_ptr<Cache>
+JS_NewMissRatioCurveCache(const json& js, const JsonPluginRepo& repo) {
+  MissRatioCurveOptions_Json opt(js, repo);
+  auto p = NewMissRatioCurveCache(opt.cache, opt);
+  if (!p) {
+    THROW_InvalidArgument("bad params = " + js.dump());
+  }
+  return p;
+}
+ROCKSDB_FACTORY_REG("MissRatioCurveCache", JS_NewMissRatioCurveCache);
+
+struct MissRatioCurveCache_Manip : PluginManipFunc<Cache> {
+  void Update(Cache* p, const json& js, const JsonPluginRepo& repo)
+  const override {
+    if (JsonSmartBool(js, "reset_counter")) {
+      static_cast<MissRatioCurveCache*>(p)->reset_counter();
+    }
+  }
+  string ToString(const Cache& r, const json& dump_options, const JsonPluginRepo& repo)
+  const override {
+    bool html = JsonSmartBool(dump_options, "html");
+    auto& mrc = static_cast<const MissRatioCurveCache&>(r);
+    auto& cache = mrc.cache();
+    json js;
+    ROCKSDB_JSON_SET_FACT(js, cache);
+    std::vector<MissRatioCurvePoint> curve;
+    mrc.GetMissRatioCurve(&curve);
+    json& jcurve = js["miss_ratio_curve"];
+    for (auto& point : curve) {
+      json jp;
+      jp["capacity_ratio"] = point.capacity_ratio;
+      JsonSetSize(jp["capacity"], point.capacity);
+      jp["sampled_lookups"] = point.lookups;
+      jp["sampled_hits"] = point.hits;
+      jp["hit_ratio"] = point.hit_ratio();
+      jcurve.push_back(std::move(jp));
+    }
+    return JsonToString(js, dump_options);
+  }
+};
+ROCKSDB_REG_PluginManip("MissRatioCurveCache", MissRatioCurveCache_Manip);
 
 //////////////////////////////////////////////////////////////////////////////
 static std::shared_ptr<const SliceTransform>
@@ -960,11 +1113,23 @@ ROCKSDB_FACTORY_REG("SkipListRep", NewSkipListMemTableRepFactoryJson);
 ROCKSDB_FACTORY_REG("SkipList", NewSkipListMemTableRepFactoryJson);
 ROCKSDB_FACTORY_REG("skiplist", NewSkipListMemTableRepFactoryJson);
 
+static shared_ptr<MemTableRepFactory>
+NewAdaptiveRadixTreeMemTableRepFactoryJson(const json&, const JsonPluginRepo&) {
+  return shared_ptr<MemTableRepFactory>(NewAdaptiveRadixTreeRepFactory());
+}
+ROCKSDB_FACTORY_REG("AdaptiveRadixTreeRep",
+                    NewAdaptiveRadixTreeMemTableRepFactoryJson);
+ROCKSDB_FACTORY_REG("AdaptiveRadixTree",
+                    NewAdaptiveRadixTreeMemTableRepFactoryJson);
+ROCKSDB_FACTORY_REG("art", NewAdaptiveRadixTreeMemTableRepFactoryJson);
+
 static shared_ptr<MemTableRepFactory>
 NewVectorMemTableRepFactoryJson(const json& js, const JsonPluginRepo&) {
   size_t count = 0;
+  size_t sort_threads = 0;
   ROCKSDB_JSON_OPT_PROP(js, count);
-  return std::make_shared<VectorRepFactory>(count);
+  ROCKSDB_JSON_OPT_PROP(js, sort_threads);
+  return std::make_shared<VectorRepFactory>(count, sort_threads);
 }
 ROCKSDB_FACTORY_REG("VectorRep", NewVectorMemTableRepFactoryJson);
 ROCKSDB_FACTORY_REG("Vector", NewVectorMemTableRepFactoryJson);
@@ -1802,6 +1967,24 @@ static void Json_DB_IntProps(const DB& db, ColumnFamilyHandle* cfh,
   }
 }
 
+static void Json_DB_MapProps(const DB& db, ColumnFamilyHandle* cfh,
+                             json& djs, bool showbad) {
+  static const std::string* aMapProps[] = {
+    &DB::Properties::kBlockCachePartitions,
+    &DB::Properties::kBlockCacheMissRatioCurve,
+  };
+  auto& mpjs = djs["MapProps"];
+  for (auto pName : aMapProps) {
+    std::map<std::string, std::string> value;
+    if (const_cast<DB&>(db).GetMapProperty(cfh, *pName, &value)) {
+      if (!value.empty())
+        mpjs[*pName] = value;
+    } else if (showbad) {
+      mpjs[*pName] = "GetProperty Fail";
+    }
+  }
+}
+
 static std::string Json_DB_OneSST(const DB& db, ColumnFamilyHandle* cfh0,
                                   const json& dump_options, int file_num) {
   auto cfh = static_cast<ColumnFamilyHandleImpl*>(cfh0);
@@ -1839,6 +2022,7 @@ struct CFPropertiesWebView_Manip : PluginManipFunc<CFPropertiesWebView> {
       bool showbad = JsonSmartBool(dump_options, "showbad");
       bool nozero = JsonSmartBool(dump_options, "nozero");
       Json_DB_IntProps(*cfp.db, cfp.cfh, djs, showbad, nozero);
+      Json_DB_MapProps(*cfp.db, cfp.cfh, djs, showbad);
     }
     Json_DB_Level_Stats(*cfp.db, cfp.cfh, djs, html, dump_options);
     return JsonToString(djs, dump_options);
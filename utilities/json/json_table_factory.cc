@@ -53,6 +53,11 @@ struct BlockBasedTableOptions_Json : BlockBasedTableOptions {
     ROCKSDB_JSON_OPT_PROP(js, format_version);
     ROCKSDB_JSON_OPT_PROP(js, enable_index_compression);
     ROCKSDB_JSON_OPT_PROP(js, block_align);
+    ROCKSDB_JSON_OPT_ENUM(js, prepopulate_block_cache);
+    ROCKSDB_JSON_OPT_PROP(js, prepopulate_block_cache_max_level);
+    ROCKSDB_JSON_OPT_PROP(js, reserve_table_builder_memory);
+    ROCKSDB_JSON_OPT_PROP(js, reserve_table_reader_memory);
+    ROCKSDB_JSON_OPT_PROP(js, block_cache_partition);
     ROCKSDB_JSON_OPT_FACT(js, block_cache);
     ROCKSDB_JSON_OPT_FACT(js, block_cache_compressed);
     ROCKSDB_JSON_OPT_FACT(js, persistent_cache);
@@ -89,6 +94,11 @@ struct BlockBasedTableOptions_Json : BlockBasedTableOptions {
     ROCKSDB_JSON_SET_PROP(js, format_version);
     ROCKSDB_JSON_SET_PROP(js, enable_index_compression);
     ROCKSDB_JSON_SET_PROP(js, block_align);
+    ROCKSDB_JSON_SET_ENUM(js, prepopulate_block_cache);
+    ROCKSDB_JSON_SET_PROP(js, prepopulate_block_cache_max_level);
+    ROCKSDB_JSON_SET_PROP(js, reserve_table_builder_memory);
+    ROCKSDB_JSON_SET_PROP(js, reserve_table_reader_memory);
+    ROCKSDB_JSON_SET_PROP(js, block_cache_partition);
     ROCKSDB_JSON_SET_FACX(js, block_cache, cache);
     ROCKSDB_JSON_SET_FACX(js, block_cache_compressed, cache);
     ROCKSDB_JSON_SET_FACT(js, persistent_cache);
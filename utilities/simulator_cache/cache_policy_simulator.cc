@@ -0,0 +1,760 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "utilities/simulator_cache/cache_policy_simulator.h"
+
+#include <algorithm>
+#include <list>
+#include <unordered_map>
+
+#include "cache/frequency_sketch.h"
+#include "port/port.h"
+#include "rocksdb/cache.h"
+#include "rocksdb/trace_reader_writer.h"
+#include "util/hash.h"
+#include "util/string_util.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+const std::vector<std::string> kSimulatedCachePolicyNames = {
+    "lru", "clock", "arc", "lirs", "tinylfu", "lru_priority"};
+
+namespace {
+
+// A block known to a simulated policy, which may be in up to two queues at a
+// time, e.g. the stack and the resident HIR queue of LIRS.
+struct SimBlock {
+  SimBlock(const Slice& k, uint64_t c) : key(k.ToString()), charge(c) {}
+
+  std::string key;
+  uint64_t charge;
+  // Which queue of the policy the block is in, for the policies that keep it
+  // in one queue at a time.
+  int queue = 0;
+  bool referenced = false;
+  std::list<SimBlock*>::iterator pos[2];
+};
+
+// Blocks in recency order, the most recent first, with their total charge.
+// A queue links the blocks through SimBlock::pos[link].
+class BlockQueue {
+ public:
+  explicit BlockQueue(int link = 0) : link_(link), charge_(0) {}
+
+  bool empty() const { return list_.empty(); }
+  uint64_t charge() const { return charge_; }
+  SimBlock* back() const { return list_.back(); }
+
+  void PushFront(SimBlock* block) {
+    list_.push_front(block);
+    block->pos[link_] = list_.begin();
+    charge_ += block->charge;
+  }
+
+  void Remove(SimBlock* block) {
+    list_.erase(block->pos[link_]);
+    charge_ -= block->charge;
+  }
+
+  // Move block from the queue from, which may be this queue, to the front of
+  // this queue.
+  void MoveToFront(SimBlock* block, BlockQueue* from) {
+    assert(from->link_ == link_);
+    list_.splice(list_.begin(), from->list_, block->pos[link_]);
+    from->charge_ -= block->charge;
+    charge_ += block->charge;
+  }
+
+ private:
+  const int link_;
+  std::list<SimBlock*> list_;
+  uint64_t charge_;
+};
+
+// The blocks known to a policy, resident or not.
+class BlockIndex {
+ public:
+  SimBlock* Find(const Slice& key) const {
+    auto iter = map_.find(key);
+    return iter == map_.end() ? nullptr : iter->second.get();
+  }
+
+  SimBlock* Add(const Slice& key, uint64_t charge) {
+    std::unique_ptr<SimBlock> block(new SimBlock(key, charge));
+    SimBlock* result = block.get();
+    map_.emplace(Slice(result->key), std::move(block));
+    return result;
+  }
+
+  void Erase(SimBlock* block) { map_.erase(Slice(block->key)); }
+
+  size_t size() const { return map_.size(); }
+
+ private:
+  std::unordered_map<Slice, std::unique_ptr<SimBlock>, SliceHasher> map_;
+};
+
+class LRUPolicy : public SimulatedCachePolicy {
+ public:
+  explicit LRUPolicy(uint64_t capacity) : capacity_(capacity) {}
+
+  const char* Name() const override { return "lru"; }
+
+  bool Access(const Slice& key, uint64_t charge, bool /*high_pri*/,
+              bool insert) override {
+    SimBlock* block = index_.Find(key);
+    if (block != nullptr) {
+      lru_.MoveToFront(block, &lru_);
+      return true;
+    }
+    if (!insert || charge > capacity_) {
+      return false;
+    }
+    while (lru_.charge() + charge > capacity_) {
+      SimBlock* victim = lru_.back();
+      lru_.Remove(victim);
+      index_.Erase(victim);
+    }
+    lru_.PushFront(index_.Add(key, charge));
+    return false;
+  }
+
+  uint64_t GetUsage() const override { return lru_.charge(); }
+
+ private:
+  const uint64_t capacity_;
+  BlockIndex index_;
+  BlockQueue lru_;
+};
+
+// The blocks are inserted behind the clock hand, which sweeps from the back
+// of the queue and gives the referenced blocks a second chance.
+class ClockPolicy : public SimulatedCachePolicy {
+ public:
+  explicit ClockPolicy(uint64_t capacity) : capacity_(capacity) {}
+
+  const char* Name() const override { return "clock"; }
+
+  bool Access(const Slice& key, uint64_t charge, bool /*high_pri*/,
+              bool insert) override {
+    SimBlock* block = index_.Find(key);
+    if (block != nullptr) {
+      block->referenced = true;
+      return true;
+    }
+    if (!insert || charge > capacity_) {
+      return false;
+    }
+    while (clock_.charge() + charge > capacity_) {
+      SimBlock* victim = clock_.back();
+      if (victim->referenced) {
+        victim->referenced = false;
+        clock_.MoveToFront(victim, &clock_);
+      } else {
+        clock_.Remove(victim);
+        index_.Erase(victim);
+      }
+    }
+    clock_.PushFront(index_.Add(key, charge));
+    return false;
+  }
+
+  uint64_t GetUsage() const override { return clock_.charge(); }
+
+ private:
+  const uint64_t capacity_;
+  BlockIndex index_;
+  BlockQueue clock_;
+};
+
+// ARC keeps the blocks seen once in T1 and the blocks seen at least twice in
+// T2, with the ghosts of the blocks evicted from them in B1 and B2. A ghost
+// hit moves the target size of T1 towards the list the ghost came from. The
+// sizes are counted in bytes.
+class ARCPolicy : public SimulatedCachePolicy {
+ public:
+  explicit ARCPolicy(uint64_t capacity) : capacity_(capacity), target_(0) {}
+
+  const char* Name() const override { return "arc"; }
+
+  bool Access(const Slice& key, uint64_t charge, bool /*high_pri*/,
+              bool insert) override {
+    SimBlock* block = index_.Find(key);
+    if (block != nullptr &&
+        (block->queue == kT1 || block->queue == kT2)) {
+      MoveTo(block, kT2);
+      return true;
+    }
+    if (!insert || charge > capacity_) {
+      return false;
+    }
+    if (block != nullptr) {
+      if (block->queue == kB1) {
+        uint64_t delta = std::max(
+            charge, static_cast<uint64_t>(static_cast<double>(charge) *
+                                          queues_[kB2].charge() /
+                                          queues_[kB1].charge()));
+        target_ = std::min(capacity_, target_ + delta);
+      } else {
+        uint64_t delta = std::max(
+            charge, static_cast<uint64_t>(static_cast<double>(charge) *
+                                          queues_[kB1].charge() /
+                                          queues_[kB2].charge()));
+        target_ -= std::min(target_, delta);
+      }
+      bool from_b2 = block->queue == kB2;
+      queues_[block->queue].Remove(block);
+      block->charge = charge;
+      Replace(charge, from_b2);
+      block->queue = kT2;
+      queues_[kT2].PushFront(block);
+    } else {
+      Replace(charge, false);
+      block = index_.Add(key, charge);
+      block->queue = kT1;
+      queues_[kT1].PushFront(block);
+    }
+    // Keep T1 and B1 within the capacity, and the ghosts within another
+    // capacity.
+    while (!queues_[kB1].empty() &&
+           queues_[kT1].charge() + queues_[kB1].charge() > capacity_) {
+      Drop(kB1);
+    }
+    while (!queues_[kB2].empty() && GetUsage() + queues_[kB1].charge() +
+                                            queues_[kB2].charge() >
+                                        2 * capacity_) {
+      Drop(kB2);
+    }
+    return false;
+  }
+
+  uint64_t GetUsage() const override {
+    return queues_[kT1].charge() + queues_[kT2].charge();
+  }
+
+ private:
+  enum Queue { kT1, kT2, kB1, kB2, kNumQueues };
+
+  // Evict from T1 or T2 into their ghosts until charge more bytes fit.
+  void Replace(uint64_t charge, bool from_b2) {
+    while (GetUsage() + charge > capacity_) {
+      uint64_t t1 = queues_[kT1].charge();
+      if (t1 > 0 && (t1 > target_ || (from_b2 && t1 >= target_) ||
+                     queues_[kT2].empty())) {
+        MoveTo(queues_[kT1].back(), kB1);
+      } else {
+        MoveTo(queues_[kT2].back(), kB2);
+      }
+    }
+  }
+
+  void MoveTo(SimBlock* block, int queue) {
+    queues_[queue].MoveToFront(block, &queues_[block->queue]);
+    block->queue = queue;
+  }
+
+  void Drop(int queue) {
+    SimBlock* block = queues_[queue].back();
+    queues_[queue].Remove(block);
+    index_.Erase(block);
+  }
+
+  const uint64_t capacity_;
+  // The target size of T1.
+  uint64_t target_;
+  BlockIndex index_;
+  BlockQueue queues_[kNumQueues];
+};
+
+// LIRS keeps the blocks of low inter-reference recency (LIR) resident, and
+// only 1% of the capacity for the others (HIR). The stack S holds the recent
+// blocks with a LIR block at the bottom, including the ghosts of evicted HIR
+// blocks, and the queue Q the resident HIR blocks. A HIR block accessed again
+// while in S becomes LIR, and the LIR block at the bottom of S becomes HIR.
+class LIRSPolicy : public SimulatedCachePolicy {
+ public:
+  explicit LIRSPolicy(uint64_t capacity)
+      : capacity_(capacity),
+        lir_capacity_(capacity - capacity / 100),
+        lir_charge_(0),
+        stack_(kStackLink),
+        hir_queue_(kQueueLink),
+        non_resident_(kQueueLink) {}
+
+  const char* Name() const override { return "lirs"; }
+
+  bool Access(const Slice& key, uint64_t charge, bool /*high_pri*/,
+              bool insert) override {
+    SimBlock* block = index_.Find(key);
+    if (block != nullptr && block->queue == kLIR) {
+      stack_.MoveToFront(block, &stack_);
+      Prune();
+      return true;
+    }
+    if (block != nullptr && block->queue == kResidentHIR) {
+      if (block->referenced) {
+        // In S: it becomes LIR.
+        stack_.MoveToFront(block, &stack_);
+        hir_queue_.Remove(block);
+        block->queue = kLIR;
+        lir_charge_ += block->charge;
+        while (lir_charge_ > lir_capacity_) {
+          DemoteBottomLIR();
+        }
+      } else {
+        block->referenced = true;
+        stack_.PushFront(block);
+        hir_queue_.MoveToFront(block, &hir_queue_);
+      }
+      return true;
+    }
+    if (!insert || charge > capacity_) {
+      return false;
+    }
+    while (lir_charge_ + hir_queue_.charge() + charge > capacity_) {
+      if (hir_queue_.empty()) {
+        DemoteBottomLIR();
+        continue;
+      }
+      SimBlock* victim = hir_queue_.back();
+      hir_queue_.Remove(victim);
+      if (victim->referenced) {
+        victim->queue = kNonResidentHIR;
+        non_resident_.PushFront(victim);
+      } else {
+        index_.Erase(victim);
+      }
+    }
+    // Making room may have pruned the ghost of the block from S.
+    block = index_.Find(key);
+    if (block != nullptr) {
+      assert(block->queue == kNonResidentHIR);
+      non_resident_.Remove(block);
+      stack_.Remove(block);
+      block->charge = charge;
+      block->queue = kLIR;
+      stack_.PushFront(block);
+      lir_charge_ += charge;
+      while (lir_charge_ > lir_capacity_) {
+        DemoteBottomLIR();
+      }
+    } else {
+      block = index_.Add(key, charge);
+      block->referenced = true;
+      stack_.PushFront(block);
+      if (lir_charge_ + charge <= lir_capacity_) {
+        block->queue = kLIR;
+        lir_charge_ += charge;
+      } else {
+        block->queue = kResidentHIR;
+        hir_queue_.PushFront(block);
+      }
+    }
+    // Bound the ghosts kept in S.
+    while (non_resident_.charge() > capacity_) {
+      SimBlock* ghost = non_resident_.back();
+      non_resident_.Remove(ghost);
+      stack_.Remove(ghost);
+      index_.Erase(ghost);
+    }
+    return false;
+  }
+
+  uint64_t GetUsage() const override {
+    return lir_charge_ + hir_queue_.charge();
+  }
+
+ private:
+  enum State { kLIR, kResidentHIR, kNonResidentHIR };
+  // S links the blocks through SimBlock::pos[0], and Q and the ghosts, which
+  // are never both, through SimBlock::pos[1]. SimBlock::referenced tells
+  // whether a block is in S.
+  static const int kStackLink = 0;
+  static const int kQueueLink = 1;
+
+  void DemoteBottomLIR() {
+    SimBlock* block = stack_.back();
+    assert(block->queue == kLIR);
+    stack_.Remove(block);
+    block->referenced = false;
+    block->queue = kResidentHIR;
+    lir_charge_ -= block->charge;
+    hir_queue_.PushFront(block);
+    Prune();
+  }
+
+  // Remove the HIR blocks from the bottom of S.
+  void Prune() {
+    while (!stack_.empty() && stack_.back()->queue != kLIR) {
+      SimBlock* block = stack_.back();
+      stack_.Remove(block);
+      block->referenced = false;
+      if (block->queue == kNonResidentHIR) {
+        non_resident_.Remove(block);
+        index_.Erase(block);
+      }
+    }
+  }
+
+  const uint64_t capacity_;
+  const uint64_t lir_capacity_;
+  uint64_t lir_charge_;
+  BlockIndex index_;
+  BlockQueue stack_;
+  BlockQueue hir_queue_;
+  BlockQueue non_resident_;
+};
+
+// W-TinyLFU: new blocks go to an LRU window of 1% of the capacity. A block
+// leaving the window enters the main segmented LRU only if it was accessed
+// more often recently than the block it would evict, as estimated by a
+// count-min sketch of all the accesses. A block hit in the probation segment
+// moves to the protected segment, which has 80% of the main capacity.
+class TinyLFUPolicy : public SimulatedCachePolicy {
+ public:
+  explicit TinyLFUPolicy(uint64_t capacity)
+      : capacity_(capacity),
+        window_capacity_(capacity / 100),
+        main_capacity_(capacity - capacity / 100),
+        protected_capacity_(main_capacity_ / 10 * 8),
+        sketch_entries_(64) {
+    sketch_.EnsureCapacity(sketch_entries_);
+  }
+
+  const char* Name() const override { return "tinylfu"; }
+
+  bool Access(const Slice& key, uint64_t charge, bool /*high_pri*/,
+              bool insert) override {
+    sketch_.Increment(GetSliceHash(key));
+    SimBlock* block = index_.Find(key);
+    if (block != nullptr) {
+      if (block->queue == kProbation) {
+        MoveTo(block, kProtected);
+        while (queues_[kProtected].charge() > protected_capacity_) {
+          MoveTo(queues_[kProtected].back(), kProbation);
+        }
+      } else {
+        MoveTo(block, block->queue);
+      }
+      return true;
+    }
+    if (!insert || charge > capacity_) {
+      return false;
+    }
+    block = index_.Add(key, charge);
+    block->queue = kWindow;
+    queues_[kWindow].PushFront(block);
+    while (queues_[kWindow].charge() > window_capacity_) {
+      SimBlock* candidate = queues_[kWindow].back();
+      queues_[kWindow].Remove(candidate);
+      Admit(candidate);
+    }
+    // Size the sketch for the number of blocks in the cache, doubling it so
+    // that the counters are rarely reset.
+    if (index_.size() > sketch_entries_) {
+      sketch_entries_ = 2 * index_.size();
+      sketch_.EnsureCapacity(sketch_entries_);
+    }
+    return false;
+  }
+
+  uint64_t GetUsage() const override {
+    return queues_[kWindow].charge() + MainCharge();
+  }
+
+ private:
+  enum Queue { kWindow, kProbation, kProtected, kNumQueues };
+
+  uint64_t MainCharge() const {
+    return queues_[kProbation].charge() + queues_[kProtected].charge();
+  }
+
+  SimBlock* NextVictim() const {
+    return queues_[kProbation].empty() ? queues_[kProtected].back()
+                                       : queues_[kProbation].back();
+  }
+
+  // candidate left the window. It replaces the blocks at the back of the
+  // main segments if it is more frequent than the first of them.
+  void Admit(SimBlock* candidate) {
+    if (candidate->charge > main_capacity_) {
+      index_.Erase(candidate);
+      return;
+    }
+    if (MainCharge() + candidate->charge > main_capacity_) {
+      SimBlock* victim = NextVictim();
+      if (sketch_.Frequency(GetSliceHash(candidate->key)) <=
+          sketch_.Frequency(GetSliceHash(victim->key))) {
+        index_.Erase(candidate);
+        return;
+      }
+      while (MainCharge() + candidate->charge > main_capacity_) {
+        victim = NextVictim();
+        queues_[victim->queue].Remove(victim);
+        index_.Erase(victim);
+      }
+    }
+    candidate->queue = kProbation;
+    queues_[kProbation].PushFront(candidate);
+  }
+
+  void MoveTo(SimBlock* block, int queue) {
+    queues_[queue].MoveToFront(block, &queues_[block->queue]);
+    block->queue = queue;
+  }
+
+  const uint64_t capacity_;
+  const uint64_t window_capacity_;
+  const uint64_t main_capacity_;
+  const uint64_t protected_capacity_;
+  FrequencySketch sketch_;
+  size_t sketch_entries_;
+  BlockIndex index_;
+  BlockQueue queues_[kNumQueues];
+};
+
+// LRUCache itself, as configured by default for the block cache except for
+// the high priority pool, which holds the index and filter blocks.
+class LRUPriorityPolicy : public SimulatedCachePolicy {
+ public:
+  explicit LRUPriorityPolicy(uint64_t capacity) {
+    LRUCacheOptions cache_options;
+    cache_options.capacity = static_cast<size_t>(capacity);
+    cache_options.num_shard_bits = 0;
+    cache_options.high_pri_pool_ratio = 0.5;
+    cache_options.metadata_charge_policy = kDontChargeCacheMetadata;
+    cache_ = NewLRUCache(cache_options);
+  }
+
+  const char* Name() const override { return "lru_priority"; }
+
+  bool Access(const Slice& key, uint64_t charge, bool high_pri,
+              bool insert) override {
+    Cache::Handle* handle = cache_->Lookup(key);
+    if (handle != nullptr) {
+      cache_->Release(handle);
+      return true;
+    }
+    if (insert) {
+      cache_
+          ->Insert(key, /*value=*/nullptr, static_cast<size_t>(charge),
+                   /*deleter=*/nullptr, /*handle=*/nullptr,
+                   high_pri ? Cache::Priority::HIGH : Cache::Priority::LOW)
+          .PermitUncheckedError();
+    }
+    return false;
+  }
+
+  uint64_t GetUsage() const override { return cache_->GetUsage(); }
+
+ private:
+  std::shared_ptr<Cache> cache_;
+};
+
+bool IsHighPriority(const BlockCacheTraceRecord& access) {
+  return access.block_type == TraceType::kBlockTraceFilterBlock ||
+         access.block_type == TraceType::kBlockTraceIndexBlock ||
+         access.block_type == TraceType::kBlockTraceUncompressionDictBlock;
+}
+
+// Simulate the capacities of options whose index is thread_id modulo
+// num_threads, filling their entries of *results.
+Status SimulateCapacities(Env* env, const std::string& trace_path,
+                          const CachePolicySimulationOptions& options,
+                          uint32_t thread_id, uint32_t num_threads,
+                          std::vector<CachePolicySimulationResult>* results) {
+  const size_t num_policies = options.policies.size();
+  std::vector<size_t> result_indexes;
+  std::vector<std::unique_ptr<SimulatedCachePolicy>> policies;
+  for (size_t i = thread_id; i < options.capacities.size();
+       i += num_threads) {
+    uint64_t capacity = options.capacities[i] / options.downsample_ratio;
+    for (size_t j = 0; j < num_policies; j++) {
+      result_indexes.push_back(i * num_policies + j);
+      policies.push_back(NewSimulatedCachePolicy(options.policies[j],
+                                                 capacity));
+    }
+  }
+  std::vector<CachePolicySimulationResult> stats(policies.size());
+
+  std::unique_ptr<TraceReader> trace_reader;
+  Status s = NewFileTraceReader(env, EnvOptions(), trace_path, &trace_reader);
+  if (!s.ok()) {
+    return s;
+  }
+  BlockCacheTraceReader reader(std::move(trace_reader));
+  BlockCacheTraceHeader header;
+  s = reader.ReadHeader(&header);
+  if (!s.ok()) {
+    return s;
+  }
+  uint64_t trace_start_time = 0;
+  bool warmup_complete = options.warmup_seconds == 0;
+  BlockCacheTraceRecord access;
+  while ((s = reader.ReadAccess(&access)).ok()) {
+    if (trace_start_time == 0) {
+      trace_start_time = access.access_timestamp;
+    }
+    if (!warmup_complete &&
+        (access.access_timestamp - trace_start_time) / kMicrosInSecond >=
+            options.warmup_seconds) {
+      for (auto& stat : stats) {
+        stat = CachePolicySimulationResult();
+      }
+      warmup_complete = true;
+    }
+    const bool high_pri = IsHighPriority(access);
+    const bool insert =
+        access.no_insert == Boolean::kFalse && access.block_size > 0;
+    for (size_t i = 0; i < policies.size(); i++) {
+      CachePolicySimulationResult& stat = stats[i];
+      stat.num_accesses++;
+      stat.accessed_bytes += access.block_size;
+      if (!policies[i]->Access(access.block_key, access.block_size, high_pri,
+                               insert)) {
+        stat.num_misses++;
+        stat.missed_bytes += access.block_size;
+      }
+    }
+  }
+  if (!s.IsIncomplete()) {
+    return s;
+  }
+  // The end of the trace.
+  for (size_t i = 0; i < policies.size(); i++) {
+    CachePolicySimulationResult& result = (*results)[result_indexes[i]];
+    result.num_accesses = stats[i].num_accesses;
+    result.num_misses = stats[i].num_misses;
+    result.accessed_bytes = stats[i].accessed_bytes;
+    result.missed_bytes = stats[i].missed_bytes;
+  }
+  return Status::OK();
+}
+
+std::string FormatRatio(double ratio) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%.4f", ratio);
+  return buf;
+}
+
+}  // namespace
+
+std::unique_ptr<SimulatedCachePolicy> NewSimulatedCachePolicy(
+    const std::string& policy, uint64_t capacity) {
+  std::unique_ptr<SimulatedCachePolicy> result;
+  if (policy == "lru") {
+    result.reset(new LRUPolicy(capacity));
+  } else if (policy == "clock") {
+    result.reset(new ClockPolicy(capacity));
+  } else if (policy == "arc") {
+    result.reset(new ARCPolicy(capacity));
+  } else if (policy == "lirs") {
+    result.reset(new LIRSPolicy(capacity));
+  } else if (policy == "tinylfu") {
+    result.reset(new TinyLFUPolicy(capacity));
+  } else if (policy == "lru_priority") {
+    result.reset(new LRUPriorityPolicy(capacity));
+  }
+  return result;
+}
+
+double CachePolicySimulationResult::miss_ratio() const {
+  if (num_accesses == 0) {
+    return -1;
+  }
+  return static_cast<double>(num_misses * 100.0 / num_accesses);
+}
+
+double CachePolicySimulationResult::byte_miss_ratio() const {
+  if (accessed_bytes == 0) {
+    return -1;
+  }
+  return static_cast<double>(missed_bytes * 100.0 / accessed_bytes);
+}
+
+Status SimulateCachePolicies(
+    Env* env, const std::string& trace_path,
+    const CachePolicySimulationOptions& options,
+    std::vector<CachePolicySimulationResult>* results) {
+  assert(results != nullptr);
+  if (options.policies.empty() || options.capacities.empty()) {
+    return Status::InvalidArgument("No policy or capacity to simulate");
+  }
+  for (const std::string& policy : options.policies) {
+    if (NewSimulatedCachePolicy(policy, 0) == nullptr) {
+      return Status::InvalidArgument("Unknown cache policy", policy);
+    }
+  }
+  if (options.downsample_ratio == 0) {
+    return Status::InvalidArgument("downsample_ratio must be positive");
+  }
+  results->clear();
+  for (uint64_t capacity : options.capacities) {
+    for (const std::string& policy : options.policies) {
+      CachePolicySimulationResult result;
+      result.policy = policy;
+      result.capacity = capacity;
+      results->push_back(result);
+    }
+  }
+  uint32_t num_threads = static_cast<uint32_t>(std::min<size_t>(
+      std::max<uint32_t>(options.num_threads, 1), options.capacities.size()));
+  std::vector<Status> statuses(num_threads);
+  std::vector<port::Thread> threads;
+  for (uint32_t i = 0; i < num_threads; i++) {
+    threads.emplace_back([&, i]() {
+      statuses[i] = SimulateCapacities(env, trace_path, options, i,
+                                       num_threads, results);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const Status& s : statuses) {
+    if (!s.ok()) {
+      return s;
+    }
+  }
+  return Status::OK();
+}
+
+Status WriteCachePolicySimulationResults(
+    Env* env, const std::string& output_dir,
+    const std::vector<CachePolicySimulationResult>& results) {
+  std::vector<std::string> policies;
+  for (const auto& result : results) {
+    if (std::find(policies.begin(), policies.end(), result.policy) ==
+        policies.end()) {
+      policies.push_back(result.policy);
+    }
+  }
+  std::string header = "capacity";
+  for (const std::string& policy : policies) {
+    header += "," + policy;
+  }
+  header += "\n";
+  std::string miss_ratios = header;
+  std::string byte_miss_ratios = header;
+  for (size_t i = 0; i < results.size(); i += policies.size()) {
+    miss_ratios += ToString(results[i].capacity);
+    byte_miss_ratios += ToString(results[i].capacity);
+    for (size_t j = i; j < i + policies.size() && j < results.size(); j++) {
+      assert(results[j].capacity == results[i].capacity);
+      miss_ratios += "," + FormatRatio(results[j].miss_ratio());
+      byte_miss_ratios += "," + FormatRatio(results[j].byte_miss_ratio());
+    }
+    miss_ratios += "\n";
+    byte_miss_ratios += "\n";
+  }
+  Status s = WriteStringToFile(env, miss_ratios,
+                               output_dir + "/cache_policy_miss_ratio.csv");
+  if (s.ok()) {
+    s = WriteStringToFile(env, byte_miss_ratios,
+                          output_dir + "/cache_policy_byte_miss_ratio.csv");
+  }
+  return s;
+}
+
+}  // namespace ROCKSDB_NAMESPACE
@@ -0,0 +1,98 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rocksdb/env.h"
+#include "rocksdb/slice.h"
+#include "rocksdb/status.h"
+#include "trace_replay/block_cache_tracer.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+// A cache replacement policy simulated over the accesses of a block cache
+// trace. Only the keys and the charges of the blocks are kept, and the
+// capacity is in bytes like the capacity of the block cache.
+//
+// This class is not thread-safe.
+class SimulatedCachePolicy {
+ public:
+  virtual ~SimulatedCachePolicy() {}
+
+  virtual const char* Name() const = 0;
+
+  // Access the block of the given key and charge. Return true on a hit. On a
+  // miss the block is inserted if insert is true, unless the policy does not
+  // admit it. high_pri is the priority the block would have in LRUCache.
+  virtual bool Access(const Slice& key, uint64_t charge, bool high_pri,
+                      bool insert) = 0;
+
+  // The charge of the blocks in the cache.
+  virtual uint64_t GetUsage() const = 0;
+};
+
+// The names of the policies supported by NewSimulatedCachePolicy():
+//   lru           least recently used.
+//   clock         the CLOCK approximation of LRU, with one reference bit.
+//   arc           Adaptive Replacement Cache, weighted by the block sizes.
+//   lirs          Low Inter-reference Recency Set, with 1% of the capacity
+//                 for the resident HIR blocks.
+//   tinylfu       W-TinyLFU: an LRU window of 1% of the capacity in front of
+//                 a segmented LRU, admitting from the window by frequency.
+//   lru_priority  LRUCache itself with one shard and half of the capacity in
+//                 the high priority pool, where index and filter blocks go.
+extern const std::vector<std::string> kSimulatedCachePolicyNames;
+
+// Return nullptr if policy is not one of kSimulatedCachePolicyNames.
+std::unique_ptr<SimulatedCachePolicy> NewSimulatedCachePolicy(
+    const std::string& policy, uint64_t capacity);
+
+// The results of simulating a policy at one capacity.
+struct CachePolicySimulationResult {
+  std::string policy;
+  uint64_t capacity = 0;
+  uint64_t num_accesses = 0;
+  uint64_t num_misses = 0;
+  uint64_t accessed_bytes = 0;
+  uint64_t missed_bytes = 0;
+
+  // In percent, as in MissRatioStats. -1 without accesses.
+  double miss_ratio() const;
+  double byte_miss_ratio() const;
+};
+
+struct CachePolicySimulationOptions {
+  std::vector<std::string> policies = kSimulatedCachePolicyNames;
+  std::vector<uint64_t> capacities;
+  // The capacities are split among up to this many threads. Each thread reads
+  // the trace on its own and feeds all the policies at its capacities.
+  uint32_t num_threads = 4;
+  // The trace collected accesses on one in every downsample_ratio blocks, so
+  // the simulated capacities are scaled down by this ratio.
+  uint32_t downsample_ratio = 1;
+  // The counters are reset once the trace reaches this many seconds.
+  uint64_t warmup_seconds = 0;
+};
+
+// Replay the block cache trace at trace_path through every policy at every
+// capacity of options. *results is ordered by capacity, then by policy in the
+// order of options.policies.
+Status SimulateCachePolicies(Env* env, const std::string& trace_path,
+                             const CachePolicySimulationOptions& options,
+                             std::vector<CachePolicySimulationResult>* results);
+
+// Write the miss ratios and the byte miss ratios of results as two CSV tables
+// in output_dir, cache_policy_miss_ratio.csv and
+// cache_policy_byte_miss_ratio.csv, with one row per capacity and one column
+// per policy.
+Status WriteCachePolicySimulationResults(
+    Env* env, const std::string& output_dir,
+    const std::vector<CachePolicySimulationResult>& results);
+
+}  // namespace ROCKSDB_NAMESPACE
@@ -282,4 +282,74 @@ void BlockCacheTraceSimulator::Access(const BlockCacheTraceRecord& access) {
   }
 }
 
+MissRatioCurveSimulator::MissRatioCurveSimulator(
+    size_t capacity, double sampling_rate,
+    const std::vector<double>& capacity_ratios)
+    : sampling_rate_(sampling_rate),
+      sampling_threshold_(
+          sampling_rate >= 1.0
+              ? port::kMaxUint64
+              : static_cast<uint64_t>(sampling_rate *
+                                      static_cast<double>(port::kMaxUint64))),
+      capacity_ratios_(capacity_ratios),
+      capacity_(capacity) {
+  for (double ratio : capacity_ratios_) {
+    caches_.push_back(NewLRUCache(
+        static_cast<size_t>(capacity * ratio * sampling_rate_),
+        /*num_shard_bits=*/0, /*strict_capacity_limit=*/false,
+        /*high_pri_pool_ratio=*/0));
+    sim_caches_.emplace_back(new CacheSimulator(nullptr, caches_.back()));
+  }
+}
+
+void MissRatioCurveSimulator::Lookup(const Slice& key, size_t charge) {
+  BlockCacheTraceRecord access;
+  access.block_key = key.ToString();
+  access.block_size = charge;
+  access.caller = TableReaderCaller::kUserGet;
+  // The timestamp only buckets the timelines of MissRatioStats, which then
+  // stay at one entry.
+  access.access_timestamp = 0;
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  for (auto& sim_cache : sim_caches_) {
+    sim_cache->Access(access);
+  }
+}
+
+void MissRatioCurveSimulator::Insert(const Slice& key, size_t charge,
+                                     Cache::Priority priority) {
+  for (auto& cache : caches_) {
+    Cache::Handle* handle = cache->Lookup(key);
+    if (handle != nullptr) {
+      cache->Release(handle);
+      continue;
+    }
+    // Ignore errors on insert
+    cache->Insert(key, /*value=*/nullptr, charge, /*deleter=*/nullptr,
+                  /*handle=*/nullptr, priority)
+        .PermitUncheckedError();
+  }
+}
+
+void MissRatioCurveSimulator::Erase(const Slice& key) {
+  for (auto& cache : caches_) {
+    cache->Erase(key);
+  }
+}
+
+void MissRatioCurveSimulator::SetCapacity(size_t capacity) {
+  capacity_.store(capacity, std::memory_order_relaxed);
+  for (size_t i = 0; i < caches_.size(); i++) {
+    caches_[i]->SetCapacity(
+        static_cast<size_t>(capacity * capacity_ratios_[i] * sampling_rate_));
+  }
+}
+
+void MissRatioCurveSimulator::reset_counter() {
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  for (auto& sim_cache : sim_caches_) {
+    sim_cache->reset_counter();
+  }
+}
+
 }  // namespace ROCKSDB_NAMESPACE
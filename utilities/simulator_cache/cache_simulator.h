@@ -5,10 +5,13 @@
 
 #pragma once
 
+#include <atomic>
+#include <mutex>
 #include <unordered_map>
 
 #include "cache/lru_cache.h"
 #include "trace_replay/block_cache_tracer.h"
+#include "util/hash.h"
 
 namespace ROCKSDB_NAMESPACE {
 
@@ -228,4 +231,72 @@ class BlockCacheTraceSimulator {
   uint64_t trace_start_time_ = 0;
 };
 
+// Estimates the miss ratio curve of a live cache, i.e. its hit ratio at
+// several multiples of its capacity, with spatial sampling (SHARDS): only the
+// keys whose hash falls below sampling_rate are simulated, by LRU caches whose
+// capacities are scaled down by sampling_rate. Unlike
+// BlockCacheTraceSimulator, it is fed by the lookups and inserts of the cache
+// itself, not by a trace.
+//
+// Thread safe.
+class MissRatioCurveSimulator {
+ public:
+  MissRatioCurveSimulator(size_t capacity, double sampling_rate,
+                          const std::vector<double>& capacity_ratios);
+  ~MissRatioCurveSimulator() = default;
+  // No copy and move.
+  MissRatioCurveSimulator(const MissRatioCurveSimulator&) = delete;
+  MissRatioCurveSimulator& operator=(const MissRatioCurveSimulator&) = delete;
+  MissRatioCurveSimulator(MissRatioCurveSimulator&&) = delete;
+  MissRatioCurveSimulator& operator=(MissRatioCurveSimulator&&) = delete;
+
+  // Returns true if the accesses to key are simulated.
+  bool IsSampled(const Slice& key) const {
+    return Hash64(key.data(), key.size(), kSamplingSeed) <
+           sampling_threshold_;
+  }
+
+  // A lookup of a sampled key in the cache. charge is the charge of the
+  // entry if the cache hit, in which case the simulated caches that miss
+  // insert the entry. Otherwise it is 0, and they insert the entry if the
+  // cache does, on Insert().
+  void Lookup(const Slice& key, size_t charge);
+
+  // An insert of a sampled key into the cache.
+  void Insert(const Slice& key, size_t charge, Cache::Priority priority);
+
+  // An erase of a sampled key from the cache.
+  void Erase(const Slice& key);
+
+  // Follow a change of the capacity of the cache.
+  void SetCapacity(size_t capacity);
+
+  void reset_counter();
+
+  size_t capacity() const { return capacity_.load(std::memory_order_relaxed); }
+  double sampling_rate() const { return sampling_rate_; }
+  const std::vector<double>& capacity_ratios() const {
+    return capacity_ratios_;
+  }
+
+  // The hit counters of the simulated cache for capacity_ratios()[i].
+  const MissRatioStats& miss_ratio_stats(size_t i) const {
+    return sim_caches_[i]->miss_ratio_stats();
+  }
+
+  // Lock the counters while reading them through miss_ratio_stats().
+  std::mutex* stats_mutex() const { return &stats_mutex_; }
+
+ private:
+  static const uint64_t kSamplingSeed = 0x5348415244530000;  // "SHARDS"
+
+  const double sampling_rate_;
+  const uint64_t sampling_threshold_;
+  const std::vector<double> capacity_ratios_;
+  std::atomic<size_t> capacity_;
+  std::vector<std::shared_ptr<Cache>> caches_;
+  std::vector<std::unique_ptr<CacheSimulator>> sim_caches_;
+  mutable std::mutex stats_mutex_;
+};
+
 }  // namespace ROCKSDB_NAMESPACE
@@ -7,8 +7,10 @@
 
 #include <cstdlib>
 #include "rocksdb/env.h"
+#include "rocksdb/trace_reader_writer.h"
 #include "test_util/testharness.h"
 #include "test_util/testutil.h"
+#include "utilities/simulator_cache/cache_policy_simulator.h"
 
 namespace ROCKSDB_NAMESPACE {
 namespace {
@@ -451,6 +453,52 @@ TEST_F(CacheSimulatorTest, HybridRowBlockNoInsertCacheSimulator) {
   }
 }
 
+TEST_F(CacheSimulatorTest, MissRatioCurveSimulator) {
+  // About 1% of the keys are sampled.
+  MissRatioCurveSimulator sampled(kCacheSize, 0.01, {1.0});
+  int num_sampled = 0;
+  for (int i = 0; i < 100000; i++) {
+    if (sampled.IsSampled(kBlockKeyPrefix + std::to_string(i))) {
+      num_sampled++;
+    }
+  }
+  ASSERT_GT(num_sampled, 800);
+  ASSERT_LT(num_sampled, 1200);
+
+  // Cycle over 6 blocks, that the simulated caches of 0.5x and 1x the
+  // capacity cannot both hold, as a cache inserting on a miss would.
+  const size_t kBlockSize = 4096;
+  MissRatioCurveSimulator simulator(8 * kBlockSize, 1.0, {0.5, 1.0, 2.0});
+  for (int round = 0; round < 4; round++) {
+    for (int i = 0; i < 6; i++) {
+      std::string key = kBlockKeyPrefix + std::to_string(i);
+      ASSERT_TRUE(simulator.IsSampled(key));
+      simulator.Lookup(key, 0);
+      simulator.Insert(key, kBlockSize, Cache::Priority::LOW);
+    }
+  }
+  ASSERT_EQ(24, simulator.miss_ratio_stats(0).total_accesses());
+  ASSERT_EQ(24, simulator.miss_ratio_stats(0).total_misses());
+  ASSERT_EQ(24, simulator.miss_ratio_stats(1).total_accesses());
+  ASSERT_EQ(6, simulator.miss_ratio_stats(1).total_misses());
+  ASSERT_EQ(6, simulator.miss_ratio_stats(2).total_misses());
+
+  // A hit of the cache inserts into the simulated caches that miss.
+  std::string key = kBlockKeyPrefix + "hit";
+  simulator.Lookup(key, kBlockSize);
+  simulator.Lookup(key, kBlockSize);
+  ASSERT_EQ(7, simulator.miss_ratio_stats(2).total_misses());
+
+  // Shrinking the cache shrinks the simulated caches.
+  simulator.SetCapacity(2 * kBlockSize);
+  simulator.reset_counter();
+  ASSERT_EQ(0, simulator.miss_ratio_stats(2).total_accesses());
+  for (int i = 0; i < 6; i++) {
+    simulator.Lookup(kBlockKeyPrefix + std::to_string(i), 0);
+  }
+  ASSERT_GE(simulator.miss_ratio_stats(2).total_misses(), 2);
+}
+
 TEST_F(CacheSimulatorTest, GhostHybridRowBlockCacheSimulator) {
   std::unique_ptr<GhostCache> ghost_cache(new GhostCache(
       NewLRUCache(/*capacity=*/kGhostCacheSize, /*num_shard_bits=*/1,
@@ -486,6 +534,127 @@ TEST_F(CacheSimulatorTest, GhostHybridRowBlockCacheSimulator) {
                     cache_simulator->miss_ratio_stats().user_miss_ratio()));
 }
 
+TEST_F(CacheSimulatorTest, SimulatedCachePolicies) {
+  const uint64_t kBlockSize = 4096;
+  ASSERT_EQ(nullptr, NewSimulatedCachePolicy("fifo", kCacheSize));
+  for (const std::string& name : kSimulatedCachePolicyNames) {
+    std::unique_ptr<SimulatedCachePolicy> policy =
+        NewSimulatedCachePolicy(name, 8 * kBlockSize);
+    ASSERT_NE(nullptr, policy);
+    ASSERT_EQ(name, policy->Name());
+    // Not inserted without insert.
+    ASSERT_FALSE(policy->Access("no-insert", kBlockSize, false, false));
+    ASSERT_FALSE(policy->Access("no-insert", kBlockSize, false, false));
+    ASSERT_FALSE(policy->Access("block", kBlockSize, false, true));
+    ASSERT_TRUE(policy->Access("block", kBlockSize, false, true));
+    ASSERT_EQ(kBlockSize, policy->GetUsage());
+
+    // Warm up two hot blocks, then scan cold blocks between their
+    // accesses, too many for an LRU list to keep the hot blocks.
+    for (int i = 0; i < 2; i++) {
+      policy->Access("hot-0", kBlockSize, true, true);
+      policy->Access("hot-1", kBlockSize, true, true);
+    }
+    int hot_hits = 0;
+    for (int round = 0; round < 10; round++) {
+      for (int i = 0; i < 10; i++) {
+        std::string cold = kBlockKeyPrefix + std::to_string(round * 10 + i);
+        ASSERT_FALSE(policy->Access(cold, kBlockSize, false, true)) << name;
+      }
+      hot_hits += policy->Access("hot-0", kBlockSize, true, true);
+      hot_hits += policy->Access("hot-1", kBlockSize, true, true);
+      ASSERT_LE(policy->GetUsage(), 8 * kBlockSize) << name;
+    }
+    if (name == "lru") {
+      ASSERT_EQ(0, hot_hits);
+    } else if (name != "clock") {
+      // Scan resistant, or with the hot blocks in the high priority pool.
+      ASSERT_EQ(20, hot_hits) << name;
+    }
+    // Larger than the cache.
+    ASSERT_FALSE(policy->Access("huge", 16 * kBlockSize, false, true));
+    ASSERT_LE(policy->GetUsage(), 8 * kBlockSize) << name;
+  }
+}
+
+TEST_F(CacheSimulatorTest, SimulateCachePolicies) {
+  const uint64_t kBlockSize = 4096;
+  const int kNumBlocks = 20;
+  const std::string trace_path =
+      test::PerThreadDBPath(env_, "cache_policy_simulator_trace");
+  const std::string output_dir =
+      test::PerThreadDBPath(env_, "cache_policy_simulator_results");
+  ASSERT_OK(env_->CreateDirIfMissing(output_dir));
+  {
+    std::unique_ptr<TraceWriter> trace_writer;
+    ASSERT_OK(
+        NewFileTraceWriter(env_, EnvOptions(), trace_path, &trace_writer));
+    BlockCacheTraceWriter writer(env_, TraceOptions(),
+                                 std::move(trace_writer));
+    ASSERT_OK(writer.WriteHeader());
+    for (int round = 0; round < 3; round++) {
+      for (int i = 0; i < kNumBlocks; i++) {
+        BlockCacheTraceRecord record = GenerateGetRecord(i);
+        record.block_key = kBlockKeyPrefix + std::to_string(i);
+        record.block_size = kBlockSize;
+        record.access_timestamp =
+            (round * kNumBlocks + i + 1) * kMicrosInSecond;
+        ASSERT_OK(writer.WriteBlockAccess(record, record.block_key,
+                                          record.cf_name,
+                                          record.referenced_key));
+      }
+    }
+  }
+
+  CachePolicySimulationOptions options;
+  options.capacities = {4 * kBlockSize, 64 * kBlockSize};
+  options.num_threads = 2;
+  std::vector<CachePolicySimulationResult> results;
+  ASSERT_OK(SimulateCachePolicies(env_, trace_path, options, &results));
+  ASSERT_EQ(2 * kSimulatedCachePolicyNames.size(), results.size());
+  for (size_t i = 0; i < results.size(); i++) {
+    const CachePolicySimulationResult& result = results[i];
+    size_t num_policies = kSimulatedCachePolicyNames.size();
+    ASSERT_EQ(kSimulatedCachePolicyNames[i % num_policies], result.policy);
+    ASSERT_EQ(options.capacities[i / num_policies], result.capacity);
+    ASSERT_EQ(3 * kNumBlocks, result.num_accesses);
+    ASSERT_EQ(3 * kNumBlocks * kBlockSize, result.accessed_bytes);
+    ASSERT_EQ(result.num_misses * kBlockSize, result.missed_bytes);
+    if (result.capacity == 4 * kBlockSize && result.policy == "lru") {
+      // Looping over more blocks than fit.
+      ASSERT_EQ(3 * kNumBlocks, result.num_misses);
+    } else if (result.capacity == 64 * kBlockSize) {
+      // Only the first accesses miss.
+      ASSERT_EQ(kNumBlocks, result.num_misses) << result.policy;
+    }
+  }
+  // With the warmup, the first round is not counted.
+  options.warmup_seconds = kNumBlocks;
+  ASSERT_OK(SimulateCachePolicies(env_, trace_path, options, &results));
+  ASSERT_EQ(2 * kNumBlocks, results.back().num_accesses);
+  ASSERT_EQ(0, results.back().num_misses);
+
+  ASSERT_OK(WriteCachePolicySimulationResults(env_, output_dir, results));
+  std::string csv;
+  ASSERT_OK(ReadFileToString(
+      env_, output_dir + "/cache_policy_miss_ratio.csv", &csv));
+  ASSERT_EQ(
+      "capacity,lru,clock,arc,lirs,tinylfu,lru_priority\n"
+      "16384,100.0000,",
+      csv.substr(0, 64));
+  ASSERT_OK(ReadFileToString(
+      env_, output_dir + "/cache_policy_byte_miss_ratio.csv", &csv));
+  ASSERT_NE(std::string::npos,
+            csv.find("\n262144,0.0000,0.0000,0.0000,0.0000,0.0000,0.0000\n"));
+
+  options.policies = {"lru", "fifo"};
+  ASSERT_TRUE(SimulateCachePolicies(env_, trace_path, options, &results)
+                  .IsInvalidArgument());
+  options.policies = {"lru"};
+  ASSERT_NOK(SimulateCachePolicies(env_, trace_path + ".missing", options,
+                                   &results));
+}
+
 }  // namespace ROCKSDB_NAMESPACE
 
 int main(int argc, char** argv) {
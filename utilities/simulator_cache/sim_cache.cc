@@ -12,6 +12,7 @@
 #include "rocksdb/env.h"
 #include "util/mutexlock.h"
 #include "util/string_util.h"
+#include "utilities/simulator_cache/cache_simulator.h"
 
 namespace ROCKSDB_NAMESPACE {
 
@@ -162,6 +163,12 @@ class SimCacheImpl : public SimCache {
         stats_(nullptr) {}
 
   ~SimCacheImpl() override {}
+
+  // The overloads taking a Cache::CacheItemHelper fall back to the ones
+  // below, so the secondary cache of cache_ is not used.
+  using Cache::Insert;
+  using Cache::Lookup;
+
   void SetCapacity(size_t capacity) override { cache_->SetCapacity(capacity); }
 
   void SetStrictCapacityLimit(bool strict_capacity_limit) override {
@@ -256,6 +263,12 @@ class SimCacheImpl : public SimCache {
     cache_->ApplyToAllCacheEntries(callback, thread_safe);
   }
 
+  void ApplyToAllEntries(
+      const std::function<void(const Slice& key, void* value, size_t charge)>&
+          callback) override {
+    cache_->ApplyToAllEntries(callback);
+  }
+
   void EraseUnRefEntries() override {
     cache_->EraseUnRefEntries();
     key_only_cache_->EraseUnRefEntries();
@@ -332,6 +345,158 @@ class SimCacheImpl : public SimCache {
   void inc_hit_counter() { hit_times_.fetch_add(1, std::memory_order_relaxed); }
 };
 
+class MissRatioCurveCacheImpl : public MissRatioCurveCache {
+ public:
+  MissRatioCurveCacheImpl(std::shared_ptr<Cache> cache,
+                          const MissRatioCurveOptions& options)
+      : cache_(std::move(cache)),
+        simulator_(cache_->GetCapacity(), options.sampling_rate,
+                   options.capacity_ratios) {}
+
+  ~MissRatioCurveCacheImpl() override {}
+
+  void SetCapacity(size_t capacity) override {
+    cache_->SetCapacity(capacity);
+    simulator_.SetCapacity(capacity);
+  }
+
+  void SetStrictCapacityLimit(bool strict_capacity_limit) override {
+    cache_->SetStrictCapacityLimit(strict_capacity_limit);
+  }
+
+  Status Insert(const Slice& key, void* value, size_t charge,
+                void (*deleter)(const Slice& key, void* value), Handle** handle,
+                Priority priority) override {
+    if (simulator_.IsSampled(key)) {
+      simulator_.Insert(key, charge, priority);
+    }
+    return cache_->Insert(key, value, charge, deleter, handle, priority);
+  }
+
+  Status Insert(const Slice& key, void* value, const CacheItemHelper* helper,
+                size_t charge, Handle** handle, Priority priority) override {
+    if (simulator_.IsSampled(key)) {
+      simulator_.Insert(key, charge, priority);
+    }
+    return cache_->Insert(key, value, helper, charge, handle, priority);
+  }
+
+  Handle* Lookup(const Slice& key, Statistics* stats) override {
+    Handle* h = cache_->Lookup(key, stats);
+    if (simulator_.IsSampled(key)) {
+      simulator_.Lookup(key, h != nullptr ? cache_->GetCharge(h) : 0);
+    }
+    return h;
+  }
+
+  Handle* Lookup(const Slice& key, const CacheItemHelper* helper,
+                 const CreateCallback& create_cb, Priority priority,
+                 Statistics* stats) override {
+    Handle* h = cache_->Lookup(key, helper, create_cb, priority, stats);
+    if (simulator_.IsSampled(key)) {
+      simulator_.Lookup(key, h != nullptr ? cache_->GetCharge(h) : 0);
+    }
+    return h;
+  }
+
+  bool Ref(Handle* handle) override { return cache_->Ref(handle); }
+
+  bool Release(Handle* handle, bool force_erase = false) override {
+    return cache_->Release(handle, force_erase);
+  }
+
+  void Erase(const Slice& key) override {
+    cache_->Erase(key);
+    if (simulator_.IsSampled(key)) {
+      simulator_.Erase(key);
+    }
+  }
+
+  void* Value(Handle* handle) override { return cache_->Value(handle); }
+
+  uint64_t NewId() override { return cache_->NewId(); }
+
+  size_t GetCapacity() const override { return cache_->GetCapacity(); }
+
+  bool HasStrictCapacityLimit() const override {
+    return cache_->HasStrictCapacityLimit();
+  }
+
+  size_t GetUsage() const override { return cache_->GetUsage(); }
+
+  size_t GetUsage(Handle* handle) const override {
+    return cache_->GetUsage(handle);
+  }
+
+  size_t GetCharge(Handle* handle) const override {
+    return cache_->GetCharge(handle);
+  }
+
+  size_t GetPinnedUsage() const override { return cache_->GetPinnedUsage(); }
+
+  void DisownData() override { cache_->DisownData(); }
+
+  void ApplyToAllCacheEntries(void (*callback)(void*, size_t),
+                              bool thread_safe) override {
+    cache_->ApplyToAllCacheEntries(callback, thread_safe);
+  }
+
+  void ApplyToAllEntries(
+      const std::function<void(const Slice& key, void* value, size_t charge)>&
+          callback) override {
+    cache_->ApplyToAllEntries(callback);
+  }
+
+  void EraseUnRefEntries() override { cache_->EraseUnRefEntries(); }
+
+  void GetPartitionUsage(
+      std::vector<CachePartitionUsage>* usage) const override {
+    cache_->GetPartitionUsage(usage);
+  }
+
+  std::string GetPrintableOptions() const override {
+    std::string ret;
+    ret.reserve(20000);
+    ret.append("    cache_options:\n");
+    ret.append(cache_->GetPrintableOptions());
+    char buffer[200];
+    snprintf(buffer, sizeof(buffer), "    sampling_rate: %.4f\n",
+             simulator_.sampling_rate());
+    ret.append(buffer);
+    ret.append("    capacity_ratios:");
+    for (double ratio : simulator_.capacity_ratios()) {
+      snprintf(buffer, sizeof(buffer), " %g", ratio);
+      ret.append(buffer);
+    }
+    ret.append("\n");
+    return ret;
+  }
+
+  void GetMissRatioCurve(
+      std::vector<MissRatioCurvePoint>* curve) const override {
+    const std::vector<double>& ratios = simulator_.capacity_ratios();
+    size_t capacity = simulator_.capacity();
+    curve->resize(ratios.size());
+    std::lock_guard<std::mutex> lock(*simulator_.stats_mutex());
+    for (size_t i = 0; i < ratios.size(); i++) {
+      MissRatioCurvePoint& point = (*curve)[i];
+      const MissRatioStats& stats = simulator_.miss_ratio_stats(i);
+      point.capacity_ratio = ratios[i];
+      point.capacity = static_cast<size_t>(capacity * ratios[i]);
+      point.lookups = stats.total_accesses();
+      point.hits = stats.total_accesses() - stats.total_misses();
+    }
+  }
+
+  void reset_counter() override { simulator_.reset_counter(); }
+
+  const std::shared_ptr<Cache>& cache() const override { return cache_; }
+
+ private:
+  std::shared_ptr<Cache> cache_;
+  MissRatioCurveSimulator simulator_;
+};
+
 }  // end anonymous namespace
 
 // For instrumentation purpose, use NewSimCache instead
@@ -353,4 +518,18 @@ std::shared_ptr<SimCache> NewSimCache(std::shared_ptr<Cache> sim_cache,
   return std::make_shared<SimCacheImpl>(sim_cache, cache);
 }
 
+std::shared_ptr<MissRatioCurveCache> NewMissRatioCurveCache(
+    std::shared_ptr<Cache> cache, const MissRatioCurveOptions& options) {
+  if (cache == nullptr || options.sampling_rate <= 0 ||
+      options.sampling_rate > 1 || options.capacity_ratios.empty()) {
+    return nullptr;
+  }
+  for (double ratio : options.capacity_ratios) {
+    if (ratio <= 0) {
+      return nullptr;
+    }
+  }
+  return std::make_shared<MissRatioCurveCacheImpl>(std::move(cache), options);
+}
+
 }  // namespace ROCKSDB_NAMESPACE
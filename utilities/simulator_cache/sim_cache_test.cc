@@ -215,6 +215,79 @@ TEST_F(SimCacheTest, SimCacheLogging) {
   ASSERT_GT(fsize, max_size - 100);
 }
 
+TEST_F(SimCacheTest, MissRatioCurveCache) {
+  auto table_options = GetTableOptions();
+  auto options = GetOptions(table_options);
+  options.disable_auto_compactions = true;
+  LRUCacheOptions co;
+  co.capacity = 1024 * 1024;
+  co.metadata_charge_policy = kDontChargeCacheMetadata;
+  MissRatioCurveOptions mrc_options;
+  // Simulate all the keys, so that the counts are exact.
+  mrc_options.sampling_rate = 1.0;
+  mrc_options.capacity_ratios = {0.0001, 1, 4};
+  std::shared_ptr<MissRatioCurveCache> mrc_cache =
+      NewMissRatioCurveCache(NewLRUCache(co), mrc_options);
+  ASSERT_NE(mrc_cache, nullptr);
+  table_options.block_cache = mrc_cache;
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  Reopen(options);
+
+  std::map<std::string, std::string> props;
+  ASSERT_TRUE(
+      db_->GetMapProperty(DB::Properties::kBlockCacheMissRatioCurve, &props));
+  ASSERT_EQ(12, props.size());
+  ASSERT_EQ("0", props["1x.lookups"]);
+  ASSERT_EQ(ToString(4 * co.capacity), props["4x.capacity"]);
+
+  const int kNumBlocks = 20;
+  for (int i = 0; i < kNumBlocks; i++) {
+    ASSERT_OK(Put(Key(i), "val"));
+    ASSERT_OK(Flush());
+  }
+  RecordCacheCounters(options);
+  for (int round = 0; round < 2; round++) {
+    for (int i = 0; i < kNumBlocks; i++) {
+      ASSERT_EQ(Get(Key(i)), "val");
+    }
+  }
+  CheckCacheCounters(options, kNumBlocks, kNumBlocks, kNumBlocks, 0);
+
+  // The simulated cache of the same capacity hits like the cache, a larger
+  // one cannot do better here, and a tiny one never hits.
+  std::vector<MissRatioCurvePoint> curve;
+  mrc_cache->GetMissRatioCurve(&curve);
+  ASSERT_EQ(3, curve.size());
+  for (const MissRatioCurvePoint& point : curve) {
+    ASSERT_EQ(2 * kNumBlocks, point.lookups);
+  }
+  ASSERT_EQ(0, curve[0].hits);
+  ASSERT_EQ(kNumBlocks, curve[1].hits);
+  ASSERT_EQ(kNumBlocks, curve[2].hits);
+  ASSERT_DOUBLE_EQ(0.5, curve[1].hit_ratio());
+
+  ASSERT_TRUE(
+      db_->GetMapProperty(DB::Properties::kBlockCacheMissRatioCurve, &props));
+  ASSERT_EQ(ToString(2 * kNumBlocks), props["1x.lookups"]);
+  ASSERT_EQ(ToString(kNumBlocks), props["1x.hits"]);
+  ASSERT_EQ("0.5000", props["1x.hit-ratio"]);
+  ASSERT_EQ("0.0000", props["0.0001x.hit-ratio"]);
+  std::string value;
+  ASSERT_TRUE(
+      db_->GetProperty(DB::Properties::kBlockCacheMissRatioCurve, &value));
+
+  mrc_cache->reset_counter();
+  mrc_cache->GetMissRatioCurve(&curve);
+  ASSERT_EQ(0, curve[1].lookups);
+
+  // Without a MissRatioCurveCache there is no curve.
+  table_options.block_cache = NewLRUCache(co);
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  Reopen(options);
+  ASSERT_FALSE(
+      db_->GetMapProperty(DB::Properties::kBlockCacheMissRatioCurve, &props));
+}
+
 }  // namespace ROCKSDB_NAMESPACE
 
 int main(int argc, char** argv) {